@@ -0,0 +1,321 @@
+/*algorithmcomparison.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the AlgorithmComparison class
+ *     Runs several order-matching algorithms side by side on the same parsed orders and
+ *     reports how their fills and remaining order books differ
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+#include "algorithmcomparison.h"
+#include "tracer.h"
+
+namespace {
+    const int FIFOCHOICE = 1;
+    const int PRORATACHOICE = 2;
+
+    /**--------------------------------------------------------------------------------------
+     * getAlgorithmName()
+     * 
+     * @param[in] algorithm Choice of algorithm (1 for FIFO, 2 for Pro-Rata, 4 for a batch
+     *                      auction)
+     * @return the name printed for the algorithm
+     * --------------------------------------------------------------------------------------
+    */
+    const char* getAlgorithmName(int algorithm)
+    {
+        return (FIFOCHOICE == algorithm) ? "FIFO" : (PRORATACHOICE == algorithm) ? "Pro-Rata" : "Auction";
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * sumFillsByPair()
+     * 
+     * @param[in] fills Order history of a run
+     * @return the total amount filled between every pair of buy and sell order IDs
+     * --------------------------------------------------------------------------------------
+    */
+    std::map<std::pair<int, int>, long long> sumFillsByPair(const std::vector<ProcessedOrder>& fills)
+    {
+        std::map<std::pair<int, int>, long long> fillsByPair;
+
+        for(const ProcessedOrder& curFill : fills)
+        {
+            fillsByPair[std::make_pair(curFill.buyID, curFill.sellID)] += curFill.fillAmount;
+        }
+
+        return fillsByPair;
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * Constructor
+ * 
+ * Creates a comparison of the given orders
+ * 
+ * @param[in] ticker    Ticker of the financial instrument the orders are for
+ * @param[in] orders    Parsed orders, only read (from every thread at once) and never
+ *                      modified, must outlive the comparison
+ * --------------------------------------------------------------------------------------
+*/
+AlgorithmComparison::AlgorithmComparison(std::string ticker, const std::vector<Order>& orders)
+    : m_ticker(ticker), m_orders(orders)
+{}
+
+/**--------------------------------------------------------------------------------------
+ * run()
+ * 
+ * Matches the orders with every algorithm in parallel, returning once all of them are
+ * done
+ * 
+ * @param[in] algorithms    Choices of algorithm (1 for FIFO, 2 for Pro-Rata, 4 for a batch
+ *                          auction), the first one is the baseline the others are
+ *                          compared to
+ * --------------------------------------------------------------------------------------
+*/
+void AlgorithmComparison::run(const std::vector<int>& algorithms)
+{
+    m_runs.clear();
+    m_runs.resize(algorithms.size());
+
+    std::vector<std::thread> workers;
+    for(size_t i = 0; i < algorithms.size(); i++)
+    {
+        m_runs[i].algorithm = algorithms[i];
+        workers.emplace_back(&AlgorithmComparison::runAlgorithm, this, std::ref(m_runs[i]));
+    }
+
+    for(std::thread& curWorker : workers)
+    {
+        curWorker.join();
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * printReport()
+ * 
+ * Prints the fills and remaining order book of every algorithm, their differences to
+ * the baseline, and the fill rate of every owner under each algorithm
+ * --------------------------------------------------------------------------------------
+*/
+void AlgorithmComparison::printReport() const
+{
+    std::cout << "Comparison of " << m_runs.size() << " algorithms on " << m_orders.size() << " " << m_ticker << " orders\n" << std::endl;
+
+    std::cout << "    Algorithm   Fills       Filled      Resting     Time(ms)\n" \
+              << "    ----------+-----------+-----------+-----------+-----------" << std::endl;
+
+    for(const AlgorithmRun& curRun : m_runs)
+    {
+        long long filledAmount = 0;
+        for(const ProcessedOrder& curFill : curRun.fills)
+        {
+            filledAmount += curFill.fillAmount;
+        }
+
+        std::cout << "    " << std::left << std::setw(10) << getAlgorithmName(curRun.algorithm) << "  " << std::setw(10) << curRun.fills.size() << "  " \
+                  << std::setw(10) << filledAmount << "  " << std::setw(10) << curRun.numResting << "  " \
+                  << std::fixed << std::setprecision(2) << curRun.milliseconds << std::right << std::endl;
+    }
+
+    if(m_runs.size() > 1)
+    {
+        printFillDifferences();
+    }
+
+    printOwnerFillRates();
+}
+
+/**--------------------------------------------------------------------------------------
+ * runAlgorithm()
+ * 
+ * Loads every order into a fresh order book and matches it with the algorithm of a run
+ * 
+ * @param[in,out] curRun    Run to be executed, its results are filled in
+ * --------------------------------------------------------------------------------------
+*/
+void AlgorithmComparison::runAlgorithm(AlgorithmRun& curRun) const
+{
+    TRACE_SCOPE("compare", getAlgorithmName(curRun.algorithm));
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    Orderbook runOrderbook(m_ticker);
+    runOrderbook.reserve(m_orders.size(), m_orders.size());
+    runOrderbook.bulkLoad(m_orders);
+
+    if(FIFOCHOICE == curRun.algorithm)
+    {
+        runOrderbook.matchOrdersFIFO();
+    }
+    else if(PRORATACHOICE == curRun.algorithm)
+    {
+        runOrderbook.matchOrdersProRata();
+    }
+    else    // Every order was loaded at once, so they all take part in a single auction
+    {
+        runOrderbook.matchOrdersAuction();
+    }
+
+    curRun.fills = runOrderbook.getOrderHistory();
+    curRun.numResting = runOrderbook.getNumRestingOrders();
+
+    // Attributing every fill to both of its orders, by position in the order buffer
+    std::unordered_map<int, size_t> indexByID;
+    indexByID.reserve(m_orders.size());
+    for(size_t i = 0; i < m_orders.size(); i++)
+    {
+        indexByID.emplace(m_orders[i].getID(), i);
+    }
+
+    curRun.filledAmounts.assign(m_orders.size(), 0);
+    for(const ProcessedOrder& curFill : curRun.fills)
+    {
+        curRun.filledAmounts[indexByID[curFill.buyID]] += curFill.fillAmount;
+        curRun.filledAmounts[indexByID[curFill.sellID]] += curFill.fillAmount;
+    }
+
+    curRun.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+/**--------------------------------------------------------------------------------------
+ * printFillDifferences()
+ * 
+ * Prints how the fills and remaining amounts of every run differ from the baseline run
+ * --------------------------------------------------------------------------------------
+*/
+void AlgorithmComparison::printFillDifferences() const
+{
+    const AlgorithmRun& baseline = m_runs.front();
+    std::map<std::pair<int, int>, long long> baselineFills = sumFillsByPair(baseline.fills);
+
+    std::cout << "\nDifferences to " << getAlgorithmName(baseline.algorithm) << " (pairs of buy and sell orders filled against each other, orders left with a different amount):\n" \
+              << "    Algorithm   Same        Changed     Missing     Extra       Orders" << "\n" \
+              << "    ----------+-----------+-----------+-----------+-----------+-----------" << std::endl;
+
+    for(size_t i = 1; i < m_runs.size(); i++)
+    {
+        const AlgorithmRun& curRun = m_runs[i];
+        std::map<std::pair<int, int>, long long> curFills = sumFillsByPair(curRun.fills);
+
+        size_t numSame = 0;
+        size_t numChanged = 0;
+        size_t numMissing = 0;
+        for(const auto& baselinePair : baselineFills)
+        {
+            auto curPair = curFills.find(baselinePair.first);
+
+            if(curPair == curFills.end())
+            {
+                numMissing++;
+            }
+            else if(curPair->second == baselinePair.second)
+            {
+                numSame++;
+            }
+            else
+            {
+                numChanged++;
+            }
+        }
+        size_t numExtra = curFills.size() - numSame - numChanged;
+
+        size_t numDifferentOrders = 0;
+        for(size_t j = 0; j < m_orders.size(); j++)
+        {
+            if(curRun.filledAmounts[j] != baseline.filledAmounts[j])
+            {
+                numDifferentOrders++;
+            }
+        }
+
+        std::cout << "    " << std::left << std::setw(10) << getAlgorithmName(curRun.algorithm) << "  " << std::setw(10) << numSame << "  " \
+                  << std::setw(10) << numChanged << "  " << std::setw(10) << numMissing << "  " << std::setw(10) << numExtra << "  " \
+                  << numDifferentOrders << std::right << std::endl;
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * printOwnerFillRates()
+ * 
+ * Prints the amount submitted by every owner and the share of it filled by each run
+ * --------------------------------------------------------------------------------------
+*/
+void AlgorithmComparison::printOwnerFillRates() const
+{
+    std::map<unsigned int, long long> submittedByOwner;
+    std::vector<std::map<unsigned int, long long>> filledByOwner(m_runs.size());
+
+    for(size_t i = 0; i < m_orders.size(); i++)
+    {
+        unsigned int owner = m_orders[i].getOwner();
+        submittedByOwner[owner] += m_orders[i].getAmount();
+
+        for(size_t j = 0; j < m_runs.size(); j++)
+        {
+            filledByOwner[j][owner] += m_runs[j].filledAmounts[i];
+        }
+    }
+
+    std::cout << "\nFill rate per owner (amount filled / amount submitted):\n" \
+              << "    Owner       Submitted   ";
+    for(const AlgorithmRun& curRun : m_runs)
+    {
+        std::cout << std::left << std::setw(10) << getAlgorithmName(curRun.algorithm) << "  ";
+    }
+    std::cout << "\n    ----------+-----------";
+    for(size_t j = 0; j < m_runs.size(); j++)
+    {
+        std::cout << "+-----------";
+    }
+    std::cout << std::endl;
+
+    for(const auto& curOwner : submittedByOwner)
+    {
+        std::cout << "    " << std::setw(10) << curOwner.first << "  " << std::setw(10) << curOwner.second << "  ";
+
+        for(size_t j = 0; j < m_runs.size(); j++)
+        {
+            double fillRate = (curOwner.second > 0) ? 100.0 * filledByOwner[j].at(curOwner.first) / curOwner.second : 0.0;
+            std::ostringstream fillRateText;
+            fillRateText << std::fixed << std::setprecision(2) << fillRate << "%";
+            std::cout << std::setw(10) << fillRateText.str() << "  ";
+        }
+
+        std::cout << std::endl;
+    }
+
+    std::cout << std::right;
+}
@@ -0,0 +1,127 @@
+/*algorithmcomparison.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the AlgorithmComparison class
+ *     Runs several order-matching algorithms side by side on the same parsed orders and
+ *     reports how their fills and remaining order books differ
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "order.h"
+#include "orderbook.h"
+
+/**--------------------------------------------------------------------------------------
+ * AlgorithmComparison class
+ * 
+ * Loads one buffer of parsed orders into a separate order book per algorithm, matches every
+ * book on its own thread, and compares each algorithm to the first one: fills between the
+ * same buy and sell orders, orders left with a different remaining amount, and the share of
+ * its submitted amount each owner got filled
+ * --------------------------------------------------------------------------------------
+*/
+class AlgorithmComparison
+{
+public:
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Creates a comparison of the given orders
+     * 
+     * @param[in] ticker    Ticker of the financial instrument the orders are for
+     * @param[in] orders    Parsed orders, only read (from every thread at once) and never
+     *                      modified, must outlive the comparison
+     * --------------------------------------------------------------------------------------
+    */
+    AlgorithmComparison(std::string ticker, const std::vector<Order>& orders);
+
+    /**--------------------------------------------------------------------------------------
+     * run()
+     * 
+     * Matches the orders with every algorithm in parallel, returning once all of them are
+     * done
+     * 
+     * @param[in] algorithms    Choices of algorithm (1 for FIFO, 2 for Pro-Rata, 4 for a batch
+     *                          auction), the first one is the baseline the others are
+     *                          compared to
+     * --------------------------------------------------------------------------------------
+    */
+    void run(const std::vector<int>& algorithms);
+
+    /**--------------------------------------------------------------------------------------
+     * printReport()
+     * 
+     * Prints the fills and remaining order book of every algorithm, their differences to
+     * the baseline, and the fill rate of every owner under each algorithm
+     * --------------------------------------------------------------------------------------
+    */
+    void printReport() const;
+
+private:
+    typedef struct AlgorithmRun
+    {
+        int algorithm;
+        std::vector<ProcessedOrder> fills;  // Order history of the run, oldest first
+        std::vector<long long> filledAmounts;   // Amount filled of every order, in the order of m_orders
+        size_t numResting = 0;
+        double milliseconds = 0;
+    } AlgorithmRun;
+
+    /**--------------------------------------------------------------------------------------
+     * runAlgorithm()
+     * 
+     * Loads every order into a fresh order book and matches it with the algorithm of a run
+     * 
+     * @param[in,out] curRun    Run to be executed, its results are filled in
+     * --------------------------------------------------------------------------------------
+    */
+    void runAlgorithm(AlgorithmRun& curRun) const;
+
+    /**--------------------------------------------------------------------------------------
+     * printFillDifferences()
+     * 
+     * Prints how the fills and remaining amounts of every run differ from the baseline run
+     * --------------------------------------------------------------------------------------
+    */
+    void printFillDifferences() const;
+
+    /**--------------------------------------------------------------------------------------
+     * printOwnerFillRates()
+     * 
+     * Prints the amount submitted by every owner and the share of it filled by each run
+     * --------------------------------------------------------------------------------------
+    */
+    void printOwnerFillRates() const;
+
+    std::string m_ticker;
+    const std::vector<Order>& m_orders;
+    std::vector<AlgorithmRun> m_runs;
+};
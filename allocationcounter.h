@@ -0,0 +1,55 @@
+/*allocationcounter.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the AllocationCounter namespace
+ *     Counts heap allocations made by each thread when built with -DCOUNT_ALLOCATIONS, used to
+ *     verify that the matching hot path does not allocate once warmed up
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+namespace AllocationCounter
+{
+    /**--------------------------------------------------------------------------------------
+     * isEnabled()
+     * 
+     * @return true if the program was built with -DCOUNT_ALLOCATIONS, i.e. if the global
+     *         operator new is replaced by the counting one
+     * --------------------------------------------------------------------------------------
+    */
+    bool isEnabled();
+
+    /**--------------------------------------------------------------------------------------
+     * getThreadAllocations()
+     * 
+     * @return the number of heap allocations made so far by the calling thread, always 0 if
+     *         counting is not enabled
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned long long getThreadAllocations();
+}
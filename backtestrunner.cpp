@@ -0,0 +1,351 @@
+/*backtestrunner.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the BacktestRunner class
+ *     Replays a manifest of order files through the order-matching algorithms on a
+ *     work-stealing pool of threads, and summarizes the results of every replay
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include "backtestrunner.h"
+#include "orderbook.h"
+#include "orderreader.h"
+#include "tracer.h"
+#include "logger.h"
+
+namespace {
+    const int FIFOCHOICE = 1;
+    const int PRORATACHOICE = 2;
+    const int AUCTIONCHOICE = 4;
+
+    /**--------------------------------------------------------------------------------------
+     * millisecondsSince()
+     * 
+     * @param[in] begin Earlier time of the monotonic clock
+     * @return the milliseconds elapsed since begin
+     * --------------------------------------------------------------------------------------
+    */
+    double millisecondsSince(std::chrono::steady_clock::time_point begin)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * Constructor
+ * 
+ * Creates a runner without any job
+ * 
+ * @param[in] numWorkers    Number of worker threads, 0 to use one per hardware thread
+ * --------------------------------------------------------------------------------------
+*/
+BacktestRunner::BacktestRunner(unsigned int numWorkers)
+    : m_numWorkers(numWorkers)
+{
+    if(m_numWorkers == 0)
+    {
+        m_numWorkers = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for(unsigned int i = 0; i < m_numWorkers; i++)
+    {
+        m_queues.emplace_back(new WorkerQueue());
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * readManifest()
+ * 
+ * Reads the jobs listed in a manifest CSV file with the columns File, Ticker, Algorithm
+ * (1 for FIFO, 2 for Pro-Rata), one job per row after the column headers
+ * 
+ * @param[in] manifestPath  Path of the manifest file
+ * @return true if the manifest could be read and every row is a valid job
+ * --------------------------------------------------------------------------------------
+*/
+bool BacktestRunner::readManifest(const std::string& manifestPath)
+{
+    std::fstream infile(manifestPath, std::fstream::in);
+
+    if(!infile.is_open())
+    {
+        std::cerr << "ERROR: Could not open the given manifest" << std::endl;
+        return false;
+    }
+
+    std::string line;
+    std::string orderFile = "";
+    std::string ticker = "";
+    std::string algorithm = "";
+
+    // Skipping first line of CSV (contains column headers)
+    std::getline(infile, line);
+
+    while(std::getline(infile, line))
+    {
+        if(line.empty())
+        {
+            continue;
+        }
+
+        std::istringstream curString(line);
+
+        std::getline(curString, orderFile, ',');
+        std::getline(curString, ticker, ',');
+        std::getline(curString, algorithm, ',');
+
+        int choice = atoi(algorithm.c_str());
+        if(choice != FIFOCHOICE && choice != PRORATACHOICE && choice != AUCTIONCHOICE)
+        {
+            std::cerr << "ERROR: Invalid choice of algorithm in manifest row \"" << line << "\", please pick from the following (FIFO: 1, Pro-Rata: 2, Auction: 4)" << std::endl;
+            return false;
+        }
+
+        m_jobs.push_back({orderFile, ticker, choice});
+    }
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * run()
+ * 
+ * Runs every job on the worker threads, returning once all of them are done
+ * --------------------------------------------------------------------------------------
+*/
+void BacktestRunner::run()
+{
+    m_results.assign(m_jobs.size(), BacktestResult());
+    m_numStolen = 0;
+
+    // Dealing the jobs out round-robin, each worker then starts on the last job it was dealt
+    for(size_t i = 0; i < m_jobs.size(); i++)
+    {
+        m_queues[i % m_numWorkers]->jobs.push_back(i);
+    }
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for(unsigned int i = 0; i < m_numWorkers; i++)
+    {
+        workers.emplace_back(&BacktestRunner::runWorker, this, i);
+    }
+
+    for(std::thread& curWorker : workers)
+    {
+        curWorker.join();
+    }
+
+    m_wallMilliseconds = millisecondsSince(begin);
+}
+
+/**--------------------------------------------------------------------------------------
+ * printSummary()
+ * 
+ * Prints the result of every job, in manifest order, followed by their totals
+ * --------------------------------------------------------------------------------------
+*/
+void BacktestRunner::printSummary() const
+{
+    size_t totalOrders = 0;
+    size_t totalFills = 0;
+    long long totalFilledAmount = 0;
+    size_t totalResting = 0;
+    size_t numFailed = 0;
+    double totalMilliseconds = 0;
+
+    std::cout << "    Algorithm   Ticker    Orders      Fills       Filled      Resting     Time(ms)    Worker  File\n" \
+              << "    ----------+---------+-----------+-----------+-----------+-----------+-----------+-------+----------------" << std::endl;
+
+    for(size_t i = 0; i < m_jobs.size(); i++)
+    {
+        const BacktestJob& curJob = m_jobs[i];
+        const BacktestResult& curResult = m_results[i];
+
+        std::cout << "    " << std::left << std::setw(10) << ((FIFOCHOICE == curJob.algorithm) ? "FIFO" : (PRORATACHOICE == curJob.algorithm) ? "Pro-Rata" : "Auction") << "  " << std::setw(8) << curJob.ticker << "  ";
+
+        if(!curResult.isCompleted)
+        {
+            std::cout << std::setw(68) << "could not read the order file" << curJob.orderFile << std::endl;
+            numFailed++;
+            continue;
+        }
+
+        std::cout << std::setw(10) << curResult.numOrders << "  " << std::setw(10) << curResult.numFills << "  " \
+                  << std::setw(10) << curResult.filledAmount << "  " << std::setw(10) << curResult.numResting << "  " \
+                  << std::setw(10) << std::fixed << std::setprecision(2) << curResult.milliseconds << "  " \
+                  << std::setw(6) << curResult.worker << "  " << curJob.orderFile << std::endl;
+
+        totalOrders += curResult.numOrders;
+        totalFills += curResult.numFills;
+        totalFilledAmount += curResult.filledAmount;
+        totalResting += curResult.numResting;
+        totalMilliseconds += curResult.milliseconds;
+    }
+
+    std::cout << "    " << std::setw(10) << "Total" << "  " << std::setw(8) << "" << "  " << std::setw(10) << totalOrders << "  " \
+              << std::setw(10) << totalFills << "  " << std::setw(10) << totalFilledAmount << "  " << std::setw(10) << totalResting << "  " \
+              << std::setw(10) << totalMilliseconds << std::right << std::endl;
+
+    std::cout << "\n" << m_jobs.size() << " jobs (" << numFailed << " failed, " << m_numStolen << " stolen) on " << m_numWorkers << " workers in " \
+              << m_wallMilliseconds << " ms";
+    if(m_wallMilliseconds > 0)
+    {
+        std::cout << ", " << std::setprecision(0) << totalOrders / (m_wallMilliseconds / 1000.0) << " orders/s";
+    }
+    std::cout << std::endl;
+}
+
+/**--------------------------------------------------------------------------------------
+ * runWorker()
+ * 
+ * Runs jobs from the worker's own deque, then steals from the other workers until no job
+ * is left anywhere
+ * 
+ * @param[in] worker    Index of the worker thread
+ * --------------------------------------------------------------------------------------
+*/
+void BacktestRunner::runWorker(unsigned int worker)
+{
+    size_t jobIndex = 0;
+
+    // No job is added once the workers start, so every deque being empty means the backtest is done
+    while(takeJob(worker, jobIndex))
+    {
+        runJob(jobIndex, worker);
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * takeJob()
+ * 
+ * Takes the next job for a worker, from the back of its own deque if it has any left,
+ * otherwise from the front of another worker's deque
+ * 
+ * @param[in]   worker      Index of the worker thread
+ * @param[out]  jobIndex    Index of the job taken
+ * @return true if a job was taken, false if every deque is empty
+ * --------------------------------------------------------------------------------------
+*/
+bool BacktestRunner::takeJob(unsigned int worker, size_t& jobIndex)
+{
+    {
+        WorkerQueue& ownQueue = *m_queues[worker];
+        std::lock_guard<std::mutex> lock(ownQueue.mutex);
+
+        if(!ownQueue.jobs.empty())
+        {
+            jobIndex = ownQueue.jobs.back();
+            ownQueue.jobs.pop_back();
+            return true;
+        }
+    }
+
+    // Starting with the next worker, so that idle workers do not all steal from the same victim
+    for(unsigned int i = 1; i < m_numWorkers; i++)
+    {
+        WorkerQueue& victimQueue = *m_queues[(worker + i) % m_numWorkers];
+        std::lock_guard<std::mutex> lock(victimQueue.mutex);
+
+        if(!victimQueue.jobs.empty())
+        {
+            jobIndex = victimQueue.jobs.front();
+            victimQueue.jobs.pop_front();
+            m_numStolen++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**--------------------------------------------------------------------------------------
+ * runJob()
+ * 
+ * Reads the order file of a job into a fresh order book, matches it and records the
+ * result
+ * 
+ * @param[in] jobIndex  Index of the job to be run
+ * @param[in] worker    Index of the worker thread running it
+ * --------------------------------------------------------------------------------------
+*/
+void BacktestRunner::runJob(size_t jobIndex, unsigned int worker)
+{
+    TRACE_SCOPE("backtest", "job");
+
+    const BacktestJob& job = m_jobs[jobIndex];
+    BacktestResult& result = m_results[jobIndex];
+    result.worker = worker;
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    std::vector<Order> parsedOrders;
+    if(!OrderReader::readOrderFile(job.orderFile, parsedOrders))
+    {
+        return;
+    }
+
+    // Every job owns its order book, so its pools live and die with the job and are never shared between threads
+    Orderbook jobOrderbook(job.ticker);
+    jobOrderbook.reserve(parsedOrders.size(), parsedOrders.size());
+    jobOrderbook.bulkLoad(parsedOrders);
+
+    if(FIFOCHOICE == job.algorithm)
+    {
+        jobOrderbook.matchOrdersFIFO();
+    }
+    else if(PRORATACHOICE == job.algorithm)
+    {
+        jobOrderbook.matchOrdersProRata();
+    }
+    else    // Every order of the file was loaded at once, so they all take part in a single auction
+    {
+        jobOrderbook.matchOrdersAuction();
+    }
+
+    for(const ProcessedOrder& curFill : jobOrderbook.getOrderHistory())
+    {
+        result.filledAmount += curFill.fillAmount;
+    }
+
+    result.numOrders = parsedOrders.size();
+    result.numFills = jobOrderbook.getOrderHistory().size();
+    result.numResting = jobOrderbook.getNumRestingOrders();
+    result.milliseconds = millisecondsSince(begin);
+    result.isCompleted = true;
+
+    LOG_DEBUG("runJob(): worker " << worker << " finished " << job.orderFile);
+}
@@ -0,0 +1,161 @@
+/*backtestrunner.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the BacktestRunner class
+ *     Replays a manifest of order files through the order-matching algorithms on a
+ *     work-stealing pool of threads, and summarizes the results of every replay
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <atomic>
+
+/**--------------------------------------------------------------------------------------
+ * BacktestRunner class
+ * 
+ * Runs backtest jobs, each replaying one order file for one ticker through one
+ * order-matching algorithm on its own order book, inside a single process. Jobs are dealt
+ * out to a deque per worker thread. A worker takes jobs from the back of its own deque and,
+ * once it is empty, steals from the front of the other workers' deques, so that a few long
+ * days do not leave the other workers idle
+ * --------------------------------------------------------------------------------------
+*/
+class BacktestRunner
+{
+public:
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Creates a runner without any job
+     * 
+     * @param[in] numWorkers    Number of worker threads, 0 to use one per hardware thread
+     * --------------------------------------------------------------------------------------
+    */
+    BacktestRunner(unsigned int numWorkers);
+
+    /**--------------------------------------------------------------------------------------
+     * readManifest()
+     * 
+     * Reads the jobs listed in a manifest CSV file with the columns File, Ticker, Algorithm
+     * (1 for FIFO, 2 for Pro-Rata), one job per row after the column headers
+     * 
+     * @param[in] manifestPath  Path of the manifest file
+     * @return true if the manifest could be read and every row is a valid job
+     * --------------------------------------------------------------------------------------
+    */
+    bool readManifest(const std::string& manifestPath);
+
+    /**--------------------------------------------------------------------------------------
+     * run()
+     * 
+     * Runs every job on the worker threads, returning once all of them are done
+     * --------------------------------------------------------------------------------------
+    */
+    void run();
+
+    /**--------------------------------------------------------------------------------------
+     * printSummary()
+     * 
+     * Prints the result of every job, in manifest order, followed by their totals
+     * --------------------------------------------------------------------------------------
+    */
+    void printSummary() const;
+
+private:
+    typedef struct BacktestJob
+    {
+        std::string orderFile;
+        std::string ticker;
+        int algorithm;
+    } BacktestJob;
+
+    typedef struct BacktestResult
+    {
+        bool isCompleted = false;   // False if the order file could not be read
+        size_t numOrders = 0;
+        size_t numFills = 0;
+        long long filledAmount = 0;
+        size_t numResting = 0;      // Orders left in the order book after matching
+        double milliseconds = 0;
+        unsigned int worker = 0;
+    } BacktestResult;
+
+    typedef struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<size_t> jobs;    // Indices into m_jobs
+    } WorkerQueue;
+
+    /**--------------------------------------------------------------------------------------
+     * runWorker()
+     * 
+     * Runs jobs from the worker's own deque, then steals from the other workers until no job
+     * is left anywhere
+     * 
+     * @param[in] worker    Index of the worker thread
+     * --------------------------------------------------------------------------------------
+    */
+    void runWorker(unsigned int worker);
+
+    /**--------------------------------------------------------------------------------------
+     * takeJob()
+     * 
+     * Takes the next job for a worker, from the back of its own deque if it has any left,
+     * otherwise from the front of another worker's deque
+     * 
+     * @param[in]   worker      Index of the worker thread
+     * @param[out]  jobIndex    Index of the job taken
+     * @return true if a job was taken, false if every deque is empty
+     * --------------------------------------------------------------------------------------
+    */
+    bool takeJob(unsigned int worker, size_t& jobIndex);
+
+    /**--------------------------------------------------------------------------------------
+     * runJob()
+     * 
+     * Reads the order file of a job into a fresh order book, matches it and records the
+     * result
+     * 
+     * @param[in] jobIndex  Index of the job to be run
+     * @param[in] worker    Index of the worker thread running it
+     * --------------------------------------------------------------------------------------
+    */
+    void runJob(size_t jobIndex, unsigned int worker);
+
+    unsigned int m_numWorkers;
+    std::vector<BacktestJob> m_jobs;
+    std::vector<BacktestResult> m_results;              // One per job, each written only by the worker that ran it
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues; // One per worker
+    std::atomic<size_t> m_numStolen{0};
+    double m_wallMilliseconds = 0;
+};
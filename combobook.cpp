@@ -0,0 +1,293 @@
+/*combobook.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the ComboBook class
+ *     Multi-leg combo orders executed all-or-none against the order books of their legs
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdlib>
+
+#include "combobook.h"
+#include "logger.h"
+
+/**--------------------------------------------------------------------------------------
+ * Constructor
+ * 
+ * Creates a combo book without any combo order
+ * --------------------------------------------------------------------------------------
+*/
+ComboBook::ComboBook()
+{
+}
+
+/**--------------------------------------------------------------------------------------
+ * addOrder()
+ * 
+ * Executes a new combo order against the order books of its legs if it can be filled in
+ * full, otherwise rests it until it can
+ * 
+ * @param[in] newOrder  Combo order, its price is the largest net price paid per unit when
+ *                      buying, or the smallest received when selling, and a market order
+ *                      accepts any net price
+ * @param[in] legs      Instruments of the combo, each with its own order book
+ * @return true if the combo was added, false if it has no legs, a leg with a ratio of 0
+ *         or two legs in the same order book, or a combo with the same ID is resting
+ * --------------------------------------------------------------------------------------
+*/
+bool ComboBook::addOrder(const Order& newOrder, const std::vector<ComboLeg>& legs)
+{
+    const int orderID = newOrder.getID();
+
+    if(legs.empty() || newOrder.getAmount() <= 0)
+    {
+        std::cerr << "ERROR - addOrder(): combo " << orderID << " has no legs or no amount" << std::endl;
+        return false;
+    }
+
+    for(size_t i = 0; i < legs.size(); i++)
+    {
+        // Two legs in one order book would both be priced from the same price levels
+        auto isSameBook = [&](const ComboLeg& leg) { return leg.book == legs[i].book; };
+        if(legs[i].book == nullptr || legs[i].ratio == 0 || std::any_of(legs.begin() + i + 1, legs.end(), isSameBook))
+        {
+            std::cerr << "ERROR - addOrder(): leg " << i << " of combo " << orderID << " has no order book, a ratio of 0 or the order book of another leg" << std::endl;
+            return false;
+        }
+    }
+
+    if(std::any_of(m_combos.begin(), m_combos.end(), [orderID](const ComboOrder& combo) { return combo.orderID == orderID; }))
+    {
+        std::cerr << "ERROR - addOrder(): a combo with ID " << orderID << " is already resting" << std::endl;
+        return false;
+    }
+
+    ComboOrder combo;
+    combo.orderID = orderID;
+    combo.isBuy = newOrder.checkIsBuy();
+    combo.isMarket = newOrder.checkIsMarket();
+    combo.priceTicks = newOrder.getPriceTicks();
+    combo.time = newOrder.getTime();
+    combo.amount = newOrder.getAmount();
+    combo.legs = legs;
+
+    if(!tryExecute(combo))
+    {
+        LOG_DEBUG("NOTE - addOrder(): Combo " << orderID << " cannot be filled in full yet, resting");
+        m_combos.push_back(std::move(combo));
+    }
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * cancelOrder()
+ * 
+ * Removes a resting combo order
+ * 
+ * @param[in] orderID   ID of the combo to be cancelled
+ * @return true if the combo was removed, false if no combo with that ID is resting
+ * --------------------------------------------------------------------------------------
+*/
+bool ComboBook::cancelOrder(int orderID)
+{
+    auto found = std::find_if(m_combos.begin(), m_combos.end(), [orderID](const ComboOrder& combo) { return combo.orderID == orderID; });
+    if(found == m_combos.end())
+    {
+        LOG_DEBUG("NOTE - cancelOrder(): No resting combo with ID " << orderID);
+        return false;
+    }
+
+    m_combos.erase(found);
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * onLegUpdate()
+ * 
+ * Executes, in time priority, every resting combo with a leg in an order book that
+ * changed, as far as they can now be filled. Called after every change to an order
+ * book combos may have legs in
+ * 
+ * @param[in] book  Order book that changed
+ * @return the number of combos executed
+ * --------------------------------------------------------------------------------------
+*/
+size_t ComboBook::onLegUpdate(const Orderbook& book)
+{
+    size_t numExecuted = 0;
+
+    // Executing a combo only takes liquidity away, so the combos before it that could not execute still cannot
+    for(size_t i = 0; i < m_combos.size();)
+    {
+        const std::vector<ComboLeg>& legs = m_combos[i].legs;
+        bool hasLegInBook = std::any_of(legs.begin(), legs.end(), [&book](const ComboLeg& leg) { return leg.book == &book; });
+
+        if(hasLegInBook && tryExecute(m_combos[i]))
+        {
+            m_combos.erase(m_combos.begin() + i);
+            numExecuted++;
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    return numExecuted;
+}
+
+/**--------------------------------------------------------------------------------------
+ * printFills()
+ * 
+ * Prints every combo executed since the last call, oldest first, and discards them
+ * --------------------------------------------------------------------------------------
+*/
+void ComboBook::printFills()
+{
+    for(const ComboFill& curFill : m_fills)
+    {
+        std::cout << "    COMBO FILLED:      Combo ID: " << curFill.comboID << ",   Amount filled: " << curFill.fillAmount << ",   Net price: " \
+                  << std::fixed << std::setprecision(2) << curFill.netPriceTicks / ((double)Order::TICKS_PER_UNIT * curFill.fillAmount);
+
+        for(size_t leg = curFill.legsBegin; leg < curFill.legsEnd; leg++)
+        {
+            const FilledLeg& curLeg = m_filledLegs[leg];
+            std::cout << ",   " << curLeg.book->getTicker() << (curLeg.isBuy ? " BUY " : " SELL ") << curLeg.amount << " (";
+            for(size_t orderFill = (leg == 0) ? 0 : m_filledLegs[leg - 1].ordersEnd; orderFill < curLeg.ordersEnd; orderFill++)
+            {
+                std::cout << "#" << m_orderFills[orderFill].first << ": " << m_orderFills[orderFill].second << ((orderFill + 1 < curLeg.ordersEnd) ? ", " : "");
+            }
+            std::cout << ")";
+        }
+        std::cout << std::endl;
+    }
+
+    m_fills.clear();
+    m_filledLegs.clear();
+    m_orderFills.clear();
+}
+
+/**--------------------------------------------------------------------------------------
+ * printBookContents()
+ * 
+ * Prints the resting combo orders in time priority
+ * --------------------------------------------------------------------------------------
+*/
+void ComboBook::printBookContents() const
+{
+    std::cout << "    Id   Side    Time   Qty   Net price   Legs" << std::endl;
+
+    for(const ComboOrder& curCombo : m_combos)
+    {
+        std::cout << "    #" << curCombo.orderID << (curCombo.isBuy ? "   BUY    " : "   SELL   ") << Order::formatTime(curCombo.time) << "   " << curCombo.amount << "   ";
+        if(curCombo.isMarket)
+        {
+            std::cout << "MKT";
+        }
+        else
+        {
+            std::cout << std::fixed << std::setprecision(2) << Order::ticksToPrice(curCombo.priceTicks);
+        }
+
+        for(size_t leg = 0; leg < curCombo.legs.size(); leg++)
+        {
+            std::cout << ((leg == 0) ? "   " : ", ") << curCombo.legs[leg].ratio << "x " << curCombo.legs[leg].book->getTicker();
+        }
+        std::cout << std::endl;
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * tryExecute()
+ * 
+ * Prices every leg of a combo from the total amount of the price levels it would fill,
+ * and if every leg can be filled in full within the combo's limit, fills them all
+ * 
+ * @param[in] combo Combo order
+ * @return true if the combo was executed
+ * --------------------------------------------------------------------------------------
+*/
+bool ComboBook::tryExecute(const ComboOrder& combo)
+{
+    // Every leg is checked before any order book is changed, so that either all legs fill or none does
+    long long netCostTicks = 0;
+    for(const ComboLeg& curLeg : combo.legs)
+    {
+        const bool isLegBuy = (curLeg.ratio > 0) == combo.isBuy;
+        long long legCostTicks = 0;
+
+        if(curLeg.book->isHalted() || !curLeg.book->getFillCost(!isLegBuy, (long long)std::abs(curLeg.ratio) * combo.amount, legCostTicks))
+        {
+            return false;
+        }
+        netCostTicks += isLegBuy ? legCostTicks : -legCostTicks;
+    }
+
+    // A buyer pays the net cost of the legs, a seller receives it with the opposite sign
+    const long long netPriceTicks = combo.isBuy ? netCostTicks : -netCostTicks;
+    const long long limitTicks = (long long)combo.priceTicks * combo.amount;
+    if(!combo.isMarket && (combo.isBuy ? netPriceTicks > limitTicks : netPriceTicks < limitTicks))
+    {
+        return false;
+    }
+
+    ComboFill newFill;
+    newFill.comboID = combo.orderID;
+    newFill.fillAmount = combo.amount;
+    newFill.netPriceTicks = netPriceTicks;
+    newFill.legsBegin = m_filledLegs.size();
+
+    for(const ComboLeg& curLeg : combo.legs)
+    {
+        const bool isLegBuy = (curLeg.ratio > 0) == combo.isBuy;
+        const int legAmount = std::abs(curLeg.ratio) * combo.amount;
+
+        for(int remainingAmount = legAmount; remainingAmount > 0;)
+        {
+            int amountFilled = (int)std::min<long long>(remainingAmount, curLeg.book->getBestAmount(!isLegBuy));
+            curLeg.book->fillBestLevel(!isLegBuy, amountFilled, m_orderFills);
+            remainingAmount -= amountFilled;
+        }
+
+        FilledLeg filledLeg;
+        filledLeg.book = curLeg.book;
+        filledLeg.isBuy = isLegBuy;
+        filledLeg.amount = legAmount;
+        filledLeg.ordersEnd = m_orderFills.size();
+        m_filledLegs.push_back(filledLeg);
+    }
+
+    newFill.legsEnd = m_filledLegs.size();
+    m_fills.push_back(newFill);
+
+    return true;
+}
@@ -0,0 +1,210 @@
+/*combobook.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the ComboBook class
+ *     Multi-leg combo orders executed all-or-none against the order books of their legs
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "order.h"
+#include "orderbook.h"
+
+/**--------------------------------------------------------------------------------------
+ * ComboLeg struct
+ * 
+ * One instrument of a combo order and how many units of it one unit of the combo trades
+ * --------------------------------------------------------------------------------------
+*/
+typedef struct ComboLeg
+{
+    Orderbook* book;    // Order book of the instrument, it must outlive the combo book
+    int ratio;          // Units bought per unit of the combo when buying it, negative if sold
+
+    ComboLeg(Orderbook* legBook, int legRatio)
+        : book(legBook), ratio(legRatio)
+    {}
+} ComboLeg;
+
+/**--------------------------------------------------------------------------------------
+ * ComboFill struct
+ * 
+ * Records the execution of a combo order: every leg filled together from its order book
+ * --------------------------------------------------------------------------------------
+*/
+typedef struct ComboFill
+{
+    int comboID;
+    int fillAmount;             // Units of the combo
+    long long netPriceTicks;    // Net price in ticks of all units, paid when buying the combo and received when selling it
+    size_t legsBegin;           // First leg of the combo among the combo book's filled legs
+    size_t legsEnd;
+} ComboFill;
+
+/**--------------------------------------------------------------------------------------
+ * ComboBook class
+ * 
+ * Combo orders trading several instruments at once, in fixed ratios, for a net price.
+ * A combo only executes if every leg can be filled in full from the limit orders of its
+ * order book at a net price within the combo's limit, which is checked from the total
+ * amount of each price level before any order book is changed. It then fills all legs
+ * at once, or it rests (all-or-none) until a change to one of its legs' order books lets
+ * it execute. Buying a combo buys the legs with a positive ratio and sells the others,
+ * selling it does the opposite
+ * --------------------------------------------------------------------------------------
+*/
+class ComboBook
+{
+public:
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Creates a combo book without any combo order
+     * --------------------------------------------------------------------------------------
+    */
+    ComboBook();
+
+    /**--------------------------------------------------------------------------------------
+     * addOrder()
+     * 
+     * Executes a new combo order against the order books of its legs if it can be filled in
+     * full, otherwise rests it until it can
+     * 
+     * @param[in] newOrder  Combo order, its price is the largest net price paid per unit when
+     *                      buying, or the smallest received when selling, and a market order
+     *                      accepts any net price
+     * @param[in] legs      Instruments of the combo, each with its own order book
+     * @return true if the combo was added, false if it has no legs, a leg with a ratio of 0
+     *         or two legs in the same order book, or a combo with the same ID is resting
+     * --------------------------------------------------------------------------------------
+    */
+    bool addOrder(const Order& newOrder, const std::vector<ComboLeg>& legs);
+
+    /**--------------------------------------------------------------------------------------
+     * cancelOrder()
+     * 
+     * Removes a resting combo order
+     * 
+     * @param[in] orderID   ID of the combo to be cancelled
+     * @return true if the combo was removed, false if no combo with that ID is resting
+     * --------------------------------------------------------------------------------------
+    */
+    bool cancelOrder(int orderID);
+
+    /**--------------------------------------------------------------------------------------
+     * onLegUpdate()
+     * 
+     * Executes, in time priority, every resting combo with a leg in an order book that
+     * changed, as far as they can now be filled. Called after every change to an order
+     * book combos may have legs in
+     * 
+     * @param[in] book  Order book that changed
+     * @return the number of combos executed
+     * --------------------------------------------------------------------------------------
+    */
+    size_t onLegUpdate(const Orderbook& book);
+
+    /**--------------------------------------------------------------------------------------
+     * printFills()
+     * 
+     * Prints every combo executed since the last call, oldest first, and discards them
+     * --------------------------------------------------------------------------------------
+    */
+    void printFills();
+
+    /**--------------------------------------------------------------------------------------
+     * printBookContents()
+     * 
+     * Prints the resting combo orders in time priority
+     * --------------------------------------------------------------------------------------
+    */
+    void printBookContents() const;
+
+    /**--------------------------------------------------------------------------------------
+     * getFills()
+     * 
+     * @return every combo executed since printFills() was last called, oldest first
+     * --------------------------------------------------------------------------------------
+    */
+    const std::vector<ComboFill>& getFills() const
+    {
+        return m_fills;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getNumRestingOrders()
+     * 
+     * @return the number of combo orders currently resting
+     * --------------------------------------------------------------------------------------
+    */
+    size_t getNumRestingOrders() const
+    {
+        return m_combos.size();
+    }
+
+private:
+    typedef struct ComboOrder
+    {
+        int orderID;
+        bool isBuy;
+        bool isMarket;
+        int priceTicks;     // Limit on the net price per unit
+        int time;
+        int amount;         // Units of the combo, all filled at once
+        std::vector<ComboLeg> legs;
+    } ComboOrder;
+
+    typedef struct FilledLeg
+    {
+        const Orderbook* book;
+        bool isBuy;         // Side the leg traded, the opposite of the orders it filled
+        int amount;
+        size_t ordersEnd;   // End of the orders filled by the leg, they begin where the previous leg's end
+    } FilledLeg;
+
+    /**--------------------------------------------------------------------------------------
+     * tryExecute()
+     * 
+     * Prices every leg of a combo from the total amount of the price levels it would fill,
+     * and if every leg can be filled in full within the combo's limit, fills them all
+     * 
+     * @param[in] combo Combo order
+     * @return true if the combo was executed
+     * --------------------------------------------------------------------------------------
+    */
+    bool tryExecute(const ComboOrder& combo);
+
+    std::vector<ComboOrder> m_combos;   // Resting combo orders in time priority
+    std::vector<ComboFill> m_fills;     // Every combo executed since the last printFills(), oldest first
+    std::vector<FilledLeg> m_filledLegs;    // Legs of those combos
+    std::vector<std::pair<int, int>> m_orderFills;  // ID and amount of every order filled by those legs
+};
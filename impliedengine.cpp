@@ -0,0 +1,574 @@
+/*impliedengine.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the ImpliedEngine class
+ *     Outright and calendar spread order books linked by implied prices, matched across
+ *     books whenever the implied prices cross
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <climits>
+#include <iterator>
+
+#include "impliedengine.h"
+#include "logger.h"
+
+namespace {
+    /**--------------------------------------------------------------------------------------
+     * isSameTop()
+     * 
+     * @param[in] first     Best prices and amounts of an order book
+     * @param[in] second    Best prices and amounts of an order book
+     * @return true if both have the same prices and amounts on both sides
+     * --------------------------------------------------------------------------------------
+    */
+    bool isSameTop(const TopOfBook& first, const TopOfBook& second)
+    {
+        return first.bidTicks == second.bidTicks && first.bidAmount == second.bidAmount && first.askTicks == second.askTicks && first.askAmount == second.askAmount;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * addImpliedPrice()
+     * 
+     * Merges the price implied by the best price levels of two other order books into the
+     * best implied price of one side, adding up the amounts implied at the same price
+     * 
+     * @param[in]       isBid       Side of the implied price
+     * @param[in]       ticks       Implied price in ticks, computed wide so that empty sides
+     *                              and far prices cannot overflow
+     * @param[in]       firstAmount Amount of the first price level it is implied from
+     * @param[in]       secondAmount    Amount of the second price level it is implied from
+     * @param[in,out]   bestTicks   Best implied price of the side
+     * @param[in,out]   bestAmount  Amount implied at the best price, 0 if there is none
+     * --------------------------------------------------------------------------------------
+    */
+    void addImpliedPrice(bool isBid, long long ticks, long long firstAmount, long long secondAmount, int& bestTicks, long long& bestAmount)
+    {
+        if(firstAmount <= 0 || secondAmount <= 0)
+        {
+            return;
+        }
+
+        // An implied price the ladders cannot hold is not tradable
+        if(ticks <= PriceLadder::NO_PRICE || ticks > INT_MAX)
+        {
+            return;
+        }
+
+        // Every unit implied needs one unit of both price levels
+        const long long amount = std::min(firstAmount, secondAmount);
+        if(bestAmount == 0 || (isBid ? ticks > bestTicks : ticks < bestTicks))
+        {
+            bestTicks = ticks;
+            bestAmount = amount;
+        }
+        else if(ticks == bestTicks)
+        {
+            bestAmount += amount;
+        }
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * printImpliedSide()
+     * 
+     * Prints one side of an implied top of book as amount at price, or - if there is none
+     * 
+     * @param[in] ticks     Implied price in ticks
+     * @param[in] amount    Amount implied at that price
+     * --------------------------------------------------------------------------------------
+    */
+    void printImpliedSide(int ticks, long long amount)
+    {
+        if(amount == 0)
+        {
+            std::cout << "-";
+        }
+        else
+        {
+            std::cout << amount << " at " << std::fixed << std::setprecision(2) << Order::ticksToPrice(ticks);
+        }
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * Constructor
+ * 
+ * Creates an engine without any order book
+ * --------------------------------------------------------------------------------------
+*/
+ImpliedEngine::ImpliedEngine()
+{
+}
+
+/**--------------------------------------------------------------------------------------
+ * addOutright()
+ * 
+ * Adds the order book of an outright instrument
+ * 
+ * @param[in] ticker    Ticker symbol of the instrument
+ * @return the index of the new order book, or -1 if the ticker already has one
+ * --------------------------------------------------------------------------------------
+*/
+int ImpliedEngine::addOutright(const std::string& ticker)
+{
+    return addBook(ticker);
+}
+
+/**--------------------------------------------------------------------------------------
+ * addSpread()
+ * 
+ * Adds the order book of a calendar spread between two outrights
+ * 
+ * @param[in] ticker    Ticker symbol of the spread
+ * @param[in] buyLeg    Index of the outright bought when buying the spread
+ * @param[in] sellLeg   Index of the outright sold when buying the spread
+ * @return the index of the new order book, or -1 if the ticker already has one or the
+ *         legs are not two different outrights
+ * --------------------------------------------------------------------------------------
+*/
+int ImpliedEngine::addSpread(const std::string& ticker, int buyLeg, int sellLeg)
+{
+    const int numBooks = (int)m_books.size();
+    if(buyLeg < 0 || buyLeg >= numBooks || sellLeg < 0 || sellLeg >= numBooks || buyLeg == sellLeg || m_spreadOfBook[buyLeg] != -1 || m_spreadOfBook[sellLeg] != -1)
+    {
+        std::cerr << "ERROR - addSpread(): the legs of spread " << ticker << " are not two different outrights" << std::endl;
+        return -1;
+    }
+
+    const int book = addBook(ticker);
+    if(book == -1)
+    {
+        return -1;
+    }
+
+    Spread newSpread;
+    newSpread.books[SPREAD_BOOK] = book;
+    newSpread.books[BUY_LEG] = buyLeg;
+    newSpread.books[SELL_LEG] = sellLeg;
+
+    const int spread = (int)m_spreads.size();
+    m_spreads.push_back(newSpread);
+    m_spreadOfBook[book] = spread;
+    for(int linkedBook : newSpread.books)
+    {
+        m_linkedSpreads[linkedBook].push_back(spread);
+    }
+
+    // The legs may already hold orders, which imply prices into the new spread
+    computeImpliedTop(book);
+
+    return book;
+}
+
+/**--------------------------------------------------------------------------------------
+ * findBook()
+ * 
+ * @param[in] ticker    Ticker symbol of an instrument
+ * @return the index of its order book, or -1 if it has none
+ * --------------------------------------------------------------------------------------
+*/
+int ImpliedEngine::findBook(const std::string& ticker) const
+{
+    auto found = std::find(m_tickers.begin(), m_tickers.end(), ticker);
+    return (found == m_tickers.end()) ? -1 : (int)(found - m_tickers.begin());
+}
+
+/**--------------------------------------------------------------------------------------
+ * findOrAddBook()
+ * 
+ * Finds the order book of an instrument, adding it if it has none yet. A ticker of the
+ * form A-B is the calendar spread buying A and selling B, whose legs are added as well
+ * 
+ * @param[in] ticker    Ticker symbol of an instrument
+ * @return the index of its order book, or -1 if it could not be added
+ * --------------------------------------------------------------------------------------
+*/
+int ImpliedEngine::findOrAddBook(const std::string& ticker)
+{
+    int book = findBook(ticker);
+    if(book != -1)
+    {
+        return book;
+    }
+
+    size_t separator = ticker.find('-');
+    if(separator == std::string::npos || separator == 0 || separator + 1 == ticker.size())
+    {
+        return addOutright(ticker);
+    }
+
+    int buyLeg = findOrAddBook(ticker.substr(0, separator));
+    int sellLeg = findOrAddBook(ticker.substr(separator + 1));
+    return addSpread(ticker, buyLeg, sellLeg);
+}
+
+/**--------------------------------------------------------------------------------------
+ * addOrder()
+ * 
+ * Adds an order to one of the order books and matches it with FIFO against the orders
+ * of that book, then executes any implied match its new best prices allow and updates
+ * the implied prices of the linked books
+ * 
+ * @param[in] book      Index of the order book
+ * @param[in] newOrder  New order to be added
+ * @return true if the order was added
+ * --------------------------------------------------------------------------------------
+*/
+bool ImpliedEngine::addOrder(int book, const Order& newOrder)
+{
+    if(book < 0 || book >= (int)m_books.size())
+    {
+        std::cerr << "ERROR - addOrder(): there is no order book with index " << book << " for order " << newOrder.getID() << std::endl;
+        return false;
+    }
+
+    if(!m_books[book]->addOrder(newOrder))
+    {
+        return false;
+    }
+
+    // Outright liquidity of the book trades first, the implied matches only see what is left of the order
+    m_books[book]->matchOrdersFIFO();
+    onBookUpdate(book);
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * cancelOrder()
+ * 
+ * Removes a resting order from one of the order books and updates the implied prices of
+ * the linked books
+ * 
+ * @param[in] book      Index of the order book
+ * @param[in] orderID   ID of the order to be cancelled
+ * @return true if the order was removed
+ * --------------------------------------------------------------------------------------
+*/
+bool ImpliedEngine::cancelOrder(int book, int orderID)
+{
+    if(book < 0 || book >= (int)m_books.size() || !m_books[book]->cancelOrder(orderID))
+    {
+        return false;
+    }
+
+    onBookUpdate(book);
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * printFills()
+ * 
+ * Prints every outright fill of each order book, then every implied match since the
+ * last call, oldest first, and discards them
+ * --------------------------------------------------------------------------------------
+*/
+void ImpliedEngine::printFills()
+{
+    for(size_t book = 0; book < m_books.size(); book++)
+    {
+        if(!m_books[book]->getOrderHistory().empty())
+        {
+            std::cout << "    " << m_tickers[book] << ":" << std::endl;
+            m_books[book]->printOrderHistory();
+        }
+    }
+
+    for(const ImpliedFill& curFill : m_fills)
+    {
+        const Spread& curSpread = m_spreads[curFill.spread];
+        const bool isBuySide[NUM_ROLES] = { curFill.isSpreadBuy, !curFill.isSpreadBuy, curFill.isSpreadBuy };
+
+        std::cout << "    IMPLIED MATCH:     Amount filled: " << curFill.fillAmount;
+        size_t orderFill = curFill.orderFillsBegin;
+        for(int role = SPREAD_BOOK; role < NUM_ROLES; role++)
+        {
+            std::cout << ",   " << m_tickers[curSpread.books[role]] << (isBuySide[role] ? " BUY at " : " SELL at ") << std::fixed << std::setprecision(2) \
+                      << Order::ticksToPrice(curFill.ticks[role]) << " (";
+            for(; orderFill < curFill.orderFillsEnd[role]; orderFill++)
+            {
+                std::cout << "#" << m_orderFills[orderFill].first << ": " << m_orderFills[orderFill].second << ((orderFill + 1 < curFill.orderFillsEnd[role]) ? ", " : "");
+            }
+            std::cout << ")";
+        }
+        std::cout << std::endl;
+    }
+
+    m_fills.clear();
+    m_orderFills.clear();
+}
+
+/**--------------------------------------------------------------------------------------
+ * printBookContents()
+ * 
+ * Prints the resting orders of every order book, followed by its implied top of book
+ * --------------------------------------------------------------------------------------
+*/
+void ImpliedEngine::printBookContents() const
+{
+    for(size_t book = 0; book < m_books.size(); book++)
+    {
+        std::cout << "\n" << m_tickers[book] << ":" << std::endl;
+        m_books[book]->printOrderbookContents();
+
+        std::cout << "    Implied bid: ";
+        printImpliedSide(m_impliedTops[book].bidTicks, m_impliedTops[book].bidAmount);
+        std::cout << ",   Implied ask: ";
+        printImpliedSide(m_impliedTops[book].askTicks, m_impliedTops[book].askAmount);
+        std::cout << std::endl;
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * addBook()
+ * 
+ * @param[in] ticker    Ticker symbol of a new instrument
+ * @return the index of its new order book, or -1 if the ticker already has one
+ * --------------------------------------------------------------------------------------
+*/
+int ImpliedEngine::addBook(const std::string& ticker)
+{
+    if(findBook(ticker) != -1)
+    {
+        std::cerr << "ERROR - addBook(): " << ticker << " already has an order book" << std::endl;
+        return -1;
+    }
+
+    m_books.emplace_back(new Orderbook(ticker));
+    m_tickers.push_back(ticker);
+    m_spreadOfBook.push_back(-1);
+    m_linkedSpreads.emplace_back();
+    m_outrightTops.emplace_back();
+    m_impliedTops.emplace_back();
+
+    return (int)m_books.size() - 1;
+}
+
+/**--------------------------------------------------------------------------------------
+ * onBookUpdate()
+ * 
+ * Handles a change to an order book, and to every book an implied match changes in
+ * turn: executes the implied matches of its spreads and recomputes the implied top of
+ * book of their other books, if its best prices or amounts changed
+ * 
+ * @param[in] book  Index of the order book that changed
+ * --------------------------------------------------------------------------------------
+*/
+void ImpliedEngine::onBookUpdate(int book)
+{
+    m_pendingBooks.push_back(book);
+
+    while(!m_pendingBooks.empty())
+    {
+        const int curBook = m_pendingBooks.back();
+        m_pendingBooks.pop_back();
+
+        // Changes deeper in the book than the best price levels imply nothing new
+        TopOfBook curTop = readTop(curBook);
+        if(isSameTop(curTop, m_outrightTops[curBook]))
+        {
+            continue;
+        }
+        m_outrightTops[curBook] = curTop;
+
+        bool hasCrossed = false;
+        for(int spread : m_linkedSpreads[curBook])
+        {
+            if(crossSpread(spread))
+            {
+                hasCrossed = true;
+                m_pendingBooks.insert(m_pendingBooks.end(), std::begin(m_spreads[spread].books), std::end(m_spreads[spread].books));
+            }
+        }
+
+        // Every book of the crossed spreads, this one included, is handled again with its new best prices
+        if(hasCrossed)
+        {
+            continue;
+        }
+
+        for(int spread : m_linkedSpreads[curBook])
+        {
+            for(int linkedBook : m_spreads[spread].books)
+            {
+                if(linkedBook != curBook)
+                {
+                    computeImpliedTop(linkedBook);
+                }
+            }
+        }
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * readTop()
+ * 
+ * @param[in] book  Index of an order book
+ * @return the current best prices and amounts of its resting limit orders
+ * --------------------------------------------------------------------------------------
+*/
+TopOfBook ImpliedEngine::readTop(int book) const
+{
+    const Orderbook& curBook = *m_books[book];
+
+    TopOfBook top;
+    top.bidTicks = curBook.getBestBuyTicks();
+    top.bidAmount = curBook.getBestAmount(true);
+    top.askTicks = curBook.getBestSellTicks();
+    top.askAmount = curBook.getBestAmount(false);
+
+    return top;
+}
+
+/**--------------------------------------------------------------------------------------
+ * crossSpread()
+ * 
+ * Executes implied matches between a spread and its legs for as long as their best
+ * prices cross, each match filling the smallest of the three best price levels. A best
+ * price outside of its book's price bands halts that book and ends the matches
+ * 
+ * @param[in] spread    Index of the spread
+ * @return true if anything was executed
+ * --------------------------------------------------------------------------------------
+*/
+bool ImpliedEngine::crossSpread(int spread)
+{
+    const Spread& curSpread = m_spreads[spread];
+    Orderbook* books[NUM_ROLES];
+    for(int role = SPREAD_BOOK; role < NUM_ROLES; role++)
+    {
+        books[role] = m_books[curSpread.books[role]].get();
+        if(books[role]->isHalted())
+        {
+            return false;
+        }
+    }
+
+    bool hasCrossed = false;
+    while(true)
+    {
+        const TopOfBook spreadTop = readTop(curSpread.books[SPREAD_BOOK]);
+        const TopOfBook buyLegTop = readTop(curSpread.books[BUY_LEG]);
+        const TopOfBook sellLegTop = readTop(curSpread.books[SELL_LEG]);
+
+        // Buying the spread takes the buy leg's sellers and the sell leg's buyers, selling it the opposite
+        bool isSpreadBuy = false;
+        if(spreadTop.bidAmount > 0 && buyLegTop.askAmount > 0 && sellLegTop.bidAmount > 0 && spreadTop.bidTicks >= (long long)buyLegTop.askTicks - sellLegTop.bidTicks)
+        {
+            isSpreadBuy = true;
+        }
+        else if(!(spreadTop.askAmount > 0 && buyLegTop.bidAmount > 0 && sellLegTop.askAmount > 0 && spreadTop.askTicks <= (long long)buyLegTop.bidTicks - sellLegTop.askTicks))
+        {
+            break;
+        }
+
+        const bool isBuySide[NUM_ROLES] = { isSpreadBuy, !isSpreadBuy, isSpreadBuy };
+        long long amount = INT_MAX;
+        for(int role = SPREAD_BOOK; role < NUM_ROLES; role++)
+        {
+            amount = std::min(amount, books[role]->getBestAmount(isBuySide[role]));
+        }
+
+        // A best price outside of its price bands halts that book and stops the match before any book is filled
+        int ticks[NUM_ROLES];
+        bool canTrade = true;
+        for(int role = SPREAD_BOOK; role < NUM_ROLES && canTrade; role++)
+        {
+            ticks[role] = isBuySide[role] ? books[role]->getBestBuyTicks() : books[role]->getBestSellTicks();
+            canTrade = books[role]->canTradeAt(ticks[role]);
+        }
+
+        if(!canTrade)
+        {
+            break;
+        }
+
+        // Every level was checked to hold the amount and trade at its price, so all three books are filled or none is
+        ImpliedFill newFill;
+        newFill.spread = spread;
+        newFill.isSpreadBuy = isSpreadBuy;
+        newFill.fillAmount = (int)amount;
+        newFill.orderFillsBegin = m_orderFills.size();
+        for(int role = SPREAD_BOOK; role < NUM_ROLES; role++)
+        {
+            newFill.ticks[role] = ticks[role];
+            books[role]->fillBestLevel(isBuySide[role], (int)amount, m_orderFills);
+            newFill.orderFillsEnd[role] = m_orderFills.size();
+        }
+
+        LOG_DEBUG("NOTE - crossSpread(): Implied match of " << amount << " between " << m_tickers[curSpread.books[SPREAD_BOOK]] << " and its legs");
+        m_fills.push_back(newFill);
+        hasCrossed = true;
+    }
+
+    return hasCrossed;
+}
+
+/**--------------------------------------------------------------------------------------
+ * computeImpliedTop()
+ * 
+ * Recomputes the best prices implied into an order book by each spread it belongs to,
+ * from the cached best prices of the two other books of the spread
+ * 
+ * @param[in] book  Index of the order book
+ * --------------------------------------------------------------------------------------
+*/
+void ImpliedEngine::computeImpliedTop(int book)
+{
+    TopOfBook implied;
+
+    for(int spread : m_linkedSpreads[book])
+    {
+        const Spread& curSpread = m_spreads[spread];
+        const TopOfBook& spreadTop = m_outrightTops[curSpread.books[SPREAD_BOOK]];
+        const TopOfBook& buyLegTop = m_outrightTops[curSpread.books[BUY_LEG]];
+        const TopOfBook& sellLegTop = m_outrightTops[curSpread.books[SELL_LEG]];
+
+        // The spread trades at the price of its buy leg minus that of its sell leg
+        if(curSpread.books[SPREAD_BOOK] == book)
+        {
+            addImpliedPrice(true, (long long)buyLegTop.bidTicks - sellLegTop.askTicks, buyLegTop.bidAmount, sellLegTop.askAmount, implied.bidTicks, implied.bidAmount);
+            addImpliedPrice(false, (long long)buyLegTop.askTicks - sellLegTop.bidTicks, buyLegTop.askAmount, sellLegTop.bidAmount, implied.askTicks, implied.askAmount);
+        }
+        else if(curSpread.books[BUY_LEG] == book)
+        {
+            addImpliedPrice(true, (long long)spreadTop.bidTicks + sellLegTop.bidTicks, spreadTop.bidAmount, sellLegTop.bidAmount, implied.bidTicks, implied.bidAmount);
+            addImpliedPrice(false, (long long)spreadTop.askTicks + sellLegTop.askTicks, spreadTop.askAmount, sellLegTop.askAmount, implied.askTicks, implied.askAmount);
+        }
+        else
+        {
+            addImpliedPrice(true, (long long)buyLegTop.bidTicks - spreadTop.askTicks, buyLegTop.bidAmount, spreadTop.askAmount, implied.bidTicks, implied.bidAmount);
+            addImpliedPrice(false, (long long)buyLegTop.askTicks - spreadTop.bidTicks, buyLegTop.askAmount, spreadTop.bidAmount, implied.askTicks, implied.askAmount);
+        }
+    }
+
+    m_impliedTops[book] = implied;
+}
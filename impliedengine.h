@@ -0,0 +1,308 @@
+/*impliedengine.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the ImpliedEngine class
+ *     Outright and calendar spread order books linked by implied prices, matched across
+ *     books whenever the implied prices cross
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+
+#include "order.h"
+#include "orderbook.h"
+
+/**--------------------------------------------------------------------------------------
+ * TopOfBook struct
+ * 
+ * Best buy and sell prices of an order book and the amounts available at them, an amount
+ * of 0 meaning there is no price on that side
+ * --------------------------------------------------------------------------------------
+*/
+typedef struct TopOfBook
+{
+    int bidTicks = PriceLadder::NO_PRICE;
+    long long bidAmount = 0;
+    int askTicks = PriceLadder::NO_PRICE;
+    long long askAmount = 0;
+} TopOfBook;
+
+/**--------------------------------------------------------------------------------------
+ * ImpliedFill struct
+ * 
+ * Records an implied match: the best price levels of a spread and of both of its legs
+ * filled together by the same amount, each at its own price
+ * --------------------------------------------------------------------------------------
+*/
+typedef struct ImpliedFill
+{
+    int spread;             // Index of the spread in the engine
+    bool isSpreadBuy;       // Whether the spread order bought (and its buy leg sold, its sell leg bought)
+    int fillAmount;
+    int ticks[3];           // Price of the spread, buy leg and sell leg fills
+    size_t orderFillsBegin;     // First of the orders filled in the spread book, among the engine's order fills
+    size_t orderFillsEnd[3];    // End of the orders filled in each book, the next book's begin there
+} ImpliedFill;
+
+/**--------------------------------------------------------------------------------------
+ * ImpliedEngine class
+ * 
+ * Links the order books of outrights with those of calendar spreads between them. Buying
+ * the spread A-B buys A and sells B, at the price of A minus the price of B, so the best
+ * prices of any two of the three books imply a price in the third one. Whenever the best
+ * prices of an order book change, the spreads it belongs to are checked for crossing
+ * implied prices, which are executed atomically across the three books, then the implied
+ * top of book of their other books is recomputed. Implied prices are only ever derived
+ * from the orders resting in the books, never from other implied prices, so the work of
+ * one update is bounded by the spreads linked to the books it touches
+ * --------------------------------------------------------------------------------------
+*/
+class ImpliedEngine
+{
+public:
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Creates an engine without any order book
+     * --------------------------------------------------------------------------------------
+    */
+    ImpliedEngine();
+
+    /**--------------------------------------------------------------------------------------
+     * addOutright()
+     * 
+     * Adds the order book of an outright instrument
+     * 
+     * @param[in] ticker    Ticker symbol of the instrument
+     * @return the index of the new order book, or -1 if the ticker already has one
+     * --------------------------------------------------------------------------------------
+    */
+    int addOutright(const std::string& ticker);
+
+    /**--------------------------------------------------------------------------------------
+     * addSpread()
+     * 
+     * Adds the order book of a calendar spread between two outrights
+     * 
+     * @param[in] ticker    Ticker symbol of the spread
+     * @param[in] buyLeg    Index of the outright bought when buying the spread
+     * @param[in] sellLeg   Index of the outright sold when buying the spread
+     * @return the index of the new order book, or -1 if the ticker already has one or the
+     *         legs are not two different outrights
+     * --------------------------------------------------------------------------------------
+    */
+    int addSpread(const std::string& ticker, int buyLeg, int sellLeg);
+
+    /**--------------------------------------------------------------------------------------
+     * findBook()
+     * 
+     * @param[in] ticker    Ticker symbol of an instrument
+     * @return the index of its order book, or -1 if it has none
+     * --------------------------------------------------------------------------------------
+    */
+    int findBook(const std::string& ticker) const;
+
+    /**--------------------------------------------------------------------------------------
+     * findOrAddBook()
+     * 
+     * Finds the order book of an instrument, adding it if it has none yet. A ticker of the
+     * form A-B is the calendar spread buying A and selling B, whose legs are added as well
+     * 
+     * @param[in] ticker    Ticker symbol of an instrument
+     * @return the index of its order book, or -1 if it could not be added
+     * --------------------------------------------------------------------------------------
+    */
+    int findOrAddBook(const std::string& ticker);
+
+    /**--------------------------------------------------------------------------------------
+     * addOrder()
+     * 
+     * Adds an order to one of the order books and matches it with FIFO against the orders
+     * of that book, then executes any implied match its new best prices allow and updates
+     * the implied prices of the linked books
+     * 
+     * @param[in] book      Index of the order book
+     * @param[in] newOrder  New order to be added
+     * @return true if the order was added
+     * --------------------------------------------------------------------------------------
+    */
+    bool addOrder(int book, const Order& newOrder);
+
+    /**--------------------------------------------------------------------------------------
+     * cancelOrder()
+     * 
+     * Removes a resting order from one of the order books and updates the implied prices of
+     * the linked books
+     * 
+     * @param[in] book      Index of the order book
+     * @param[in] orderID   ID of the order to be cancelled
+     * @return true if the order was removed
+     * --------------------------------------------------------------------------------------
+    */
+    bool cancelOrder(int book, int orderID);
+
+    /**--------------------------------------------------------------------------------------
+     * printFills()
+     * 
+     * Prints every outright fill of each order book, then every implied match since the
+     * last call, oldest first, and discards them
+     * --------------------------------------------------------------------------------------
+    */
+    void printFills();
+
+    /**--------------------------------------------------------------------------------------
+     * printBookContents()
+     * 
+     * Prints the resting orders of every order book, followed by its implied top of book
+     * --------------------------------------------------------------------------------------
+    */
+    void printBookContents() const;
+
+    /**--------------------------------------------------------------------------------------
+     * getBook()
+     * 
+     * @param[in] book  Index of an order book
+     * @return the order book
+     * --------------------------------------------------------------------------------------
+    */
+    const Orderbook& getBook(int book) const
+    {
+        return *m_books[book];
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getNumBooks()
+     * 
+     * @return the number of outright and spread order books
+     * --------------------------------------------------------------------------------------
+    */
+    size_t getNumBooks() const
+    {
+        return m_books.size();
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getImpliedTop()
+     * 
+     * @param[in] book  Index of an order book
+     * @return the best prices implied into the order book by its linked books
+     * --------------------------------------------------------------------------------------
+    */
+    const TopOfBook& getImpliedTop(int book) const
+    {
+        return m_impliedTops[book];
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getFills()
+     * 
+     * @return every implied match since printFills() was last called, oldest first
+     * --------------------------------------------------------------------------------------
+    */
+    const std::vector<ImpliedFill>& getFills() const
+    {
+        return m_fills;
+    }
+
+private:
+    enum BookRole { SPREAD_BOOK = 0, BUY_LEG, SELL_LEG, NUM_ROLES };
+
+    typedef struct Spread
+    {
+        int books[NUM_ROLES];   // Indexes of the spread and leg order books, by role
+    } Spread;
+
+    /**--------------------------------------------------------------------------------------
+     * addBook()
+     * 
+     * @param[in] ticker    Ticker symbol of a new instrument
+     * @return the index of its new order book, or -1 if the ticker already has one
+     * --------------------------------------------------------------------------------------
+    */
+    int addBook(const std::string& ticker);
+
+    /**--------------------------------------------------------------------------------------
+     * onBookUpdate()
+     * 
+     * Handles a change to an order book, and to every book an implied match changes in
+     * turn: executes the implied matches of its spreads and recomputes the implied top of
+     * book of their other books, if its best prices or amounts changed
+     * 
+     * @param[in] book  Index of the order book that changed
+     * --------------------------------------------------------------------------------------
+    */
+    void onBookUpdate(int book);
+
+    /**--------------------------------------------------------------------------------------
+     * readTop()
+     * 
+     * @param[in] book  Index of an order book
+     * @return the current best prices and amounts of its resting limit orders
+     * --------------------------------------------------------------------------------------
+    */
+    TopOfBook readTop(int book) const;
+
+    /**--------------------------------------------------------------------------------------
+     * crossSpread()
+     * 
+     * Executes implied matches between a spread and its legs for as long as their best
+     * prices cross, each match filling the smallest of the three best price levels. A best
+     * price outside of its book's price bands halts that book and ends the matches
+     * 
+     * @param[in] spread    Index of the spread
+     * @return true if anything was executed
+     * --------------------------------------------------------------------------------------
+    */
+    bool crossSpread(int spread);
+
+    /**--------------------------------------------------------------------------------------
+     * computeImpliedTop()
+     * 
+     * Recomputes the best prices implied into an order book by each spread it belongs to,
+     * from the cached best prices of the two other books of the spread
+     * 
+     * @param[in] book  Index of the order book
+     * --------------------------------------------------------------------------------------
+    */
+    void computeImpliedTop(int book);
+
+    std::vector<std::unique_ptr<Orderbook>> m_books;    // Outright and spread order books, by index
+    std::vector<std::string> m_tickers;                 // Ticker symbol of every order book
+    std::vector<int> m_spreadOfBook;                    // Index of the spread of every order book, -1 for outrights
+    std::vector<std::vector<int>> m_linkedSpreads;      // Spreads every order book is the spread or a leg of
+    std::vector<Spread> m_spreads;
+    std::vector<TopOfBook> m_outrightTops;  // Best prices of every order book as of its last update
+    std::vector<TopOfBook> m_impliedTops;   // Best prices implied into every order book
+    std::vector<int> m_pendingBooks;        // Order books whose changes are not handled yet, kept to reuse its memory
+    std::vector<ImpliedFill> m_fills;       // Every implied match since the last printFills(), oldest first
+    std::vector<std::pair<int, int>> m_orderFills;  // ID and amount of every order filled by those matches
+};
@@ -0,0 +1,474 @@
+/*itchreplay.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the ItchReplay class
+ *     Replays a binary Nasdaq TotalView-ITCH 5.0 file into one order book per stock locate
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "itchreplay.h"
+#include "tracer.h"
+
+namespace
+{
+    const size_t NUM_STOCK_LOCATES = 65536;
+    const uint64_t NANOSECONDS_PER_MINUTE = 60000000000ULL;
+    const int ITCH_PRICE_PER_TICK = 100;    // ITCH prices have four decimal places, ticks two
+
+    // Offsets of the fields of each message, counted from its type byte
+    const size_t LOCATE_OFFSET = 1;
+    const size_t TIMESTAMP_OFFSET = 5;
+    const size_t REFERENCE_OFFSET = 11;
+    const size_t ADD_SIDE_OFFSET = 19;
+    const size_t ADD_SHARES_OFFSET = 20;
+    const size_t ADD_STOCK_OFFSET = 24;
+    const size_t ADD_PRICE_OFFSET = 32;
+    const size_t ADD_MPID_OFFSET = 36;
+    const size_t EXECUTED_SHARES_OFFSET = 19;
+    const size_t REPLACE_NEW_REFERENCE_OFFSET = 19;
+    const size_t REPLACE_SHARES_OFFSET = 27;
+    const size_t REPLACE_PRICE_OFFSET = 31;
+
+    const size_t STOCK_LENGTH = 8;
+    const size_t MPID_LENGTH = 4;
+
+    // Shortest valid length of each message type applied to the order books
+    const size_t ADD_LENGTH = 36;
+    const size_t ADD_MPID_LENGTH = 40;
+    const size_t EXECUTED_LENGTH = 31;
+    const size_t EXECUTED_PRICE_LENGTH = 36;
+    const size_t CANCEL_LENGTH = 23;
+    const size_t DELETE_LENGTH = 19;
+    const size_t REPLACE_LENGTH = 35;
+
+    const char* const KIND_NAMES[] = { "Add", "Add with MPID", "Executed", "Executed with price", "Cancel", "Delete", "Replace", "Other" };
+
+    /**--------------------------------------------------------------------------------------
+     * readBigEndian()
+     * 
+     * Reads an unsigned big-endian field of a message
+     * 
+     * @param[in] field     First byte of the field
+     * @param[in] length    Length of the field in bytes, at most 8
+     * @return the value of the field
+     * --------------------------------------------------------------------------------------
+    */
+    inline uint64_t readBigEndian(const unsigned char* field, size_t length)
+    {
+        uint64_t value = 0;
+        for(size_t i = 0; i < length; i++)
+        {
+            value = (value << 8) | field[i];
+        }
+        return value;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * toTime()
+     * 
+     * Converts an ITCH timestamp into a time stored according to military time
+     * 
+     * @param[in] message   First byte of a message
+     * @return the time of the message as hhmm
+     * --------------------------------------------------------------------------------------
+    */
+    inline int toTime(const unsigned char* message)
+    {
+        int minutes = (int)(readBigEndian(message + TIMESTAMP_OFFSET, 6) / NANOSECONDS_PER_MINUTE);
+        return (minutes / 60) * 100 + minutes % 60;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * toPrice()
+     * 
+     * Converts an ITCH price into a price of whole ticks
+     * 
+     * @param[in] field First byte of a 4-byte price field
+     * @return the price, truncated to a whole number of ticks
+     * --------------------------------------------------------------------------------------
+    */
+    inline float toPrice(const unsigned char* field)
+    {
+        return Order::ticksToPrice((int)(readBigEndian(field, 4) / ITCH_PRICE_PER_TICK));
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * toShares()
+     * 
+     * Converts an unsigned 4-byte ITCH share count into an order amount
+     * 
+     * @param[in] field First byte of a 4-byte shares field
+     * @return the number of shares, capped at INT_MAX instead of wrapping around to a
+     *         negative amount
+     * --------------------------------------------------------------------------------------
+    */
+    inline int toShares(const unsigned char* field)
+    {
+        return (int)std::min(readBigEndian(field, 4), (uint64_t)INT_MAX);
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * Constructor
+ * 
+ * Creates a replay without any file or order book
+ * --------------------------------------------------------------------------------------
+*/
+ItchReplay::ItchReplay()
+  : m_books(NUM_STOCK_LOCATES), m_tickers(NUM_STOCK_LOCATES)
+{}
+
+/**--------------------------------------------------------------------------------------
+ * Destructor
+ * 
+ * Unmaps the file if it is still mapped
+ * --------------------------------------------------------------------------------------
+*/
+ItchReplay::~ItchReplay()
+{
+    unmap();
+}
+
+/**--------------------------------------------------------------------------------------
+ * open()
+ * 
+ * Maps an ITCH 5.0 file into memory, read-only
+ * 
+ * @param[in] path  Path of the file
+ * @return true if the file could be mapped
+ * --------------------------------------------------------------------------------------
+*/
+bool ItchReplay::open(const std::string& path)
+{
+    unmap();
+
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        std::cerr << "ERROR - open(): Could not open " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat fileStatus;
+    if(fstat(fd, &fileStatus) != 0)
+    {
+        std::cerr << "ERROR - open(): Could not read the size of " << path << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+
+    m_size = (size_t)fileStatus.st_size;
+    if(m_size > 0)
+    {
+        void* address = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(address == MAP_FAILED)
+        {
+            std::cerr << "ERROR - open(): mmap of " << path << " failed: " << std::strerror(errno) << std::endl;
+            close(fd);
+            m_size = 0;
+            return false;
+        }
+
+        // Messages are decoded front to back, letting the kernel read ahead aggressively
+        madvise(address, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const unsigned char*>(address);
+    }
+
+    close(fd);
+#else
+    std::ifstream itchFile(path, std::ios::binary);
+    if(!itchFile.is_open())
+    {
+        std::cerr << "ERROR - open(): Could not open " << path << std::endl;
+        return false;
+    }
+
+    m_buffer.assign(std::istreambuf_iterator<char>(itchFile), std::istreambuf_iterator<char>());
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+#endif
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * run()
+ * 
+ * Decodes every message of the file and applies it to its order book
+ * 
+ * @return true if the whole file was decoded, false if it ends in the middle of a message
+ * --------------------------------------------------------------------------------------
+*/
+bool ItchReplay::run()
+{
+    TRACE_SCOPE("itch", "run");
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    const unsigned char* cursor = m_data;
+    const unsigned char* const end = m_data + m_size;
+    bool isComplete = true;
+
+    while(cursor < end)
+    {
+        if(end - cursor < 2)
+        {
+            isComplete = false;
+            break;
+        }
+
+        const size_t length = (size_t)readBigEndian(cursor, 2);
+        const unsigned char* message = cursor + 2;
+        if((size_t)(end - message) < length)
+        {
+            isComplete = false;
+            break;
+        }
+        cursor = message + length;
+
+        if(length == 0)
+        {
+            continue;
+        }
+
+        MessageKind kind = OTHER_KIND;
+        size_t minLength = 0;
+        switch(message[0])
+        {
+            case 'A': kind = ADD_KIND; minLength = ADD_LENGTH; break;
+            case 'F': kind = ADD_MPID_KIND; minLength = ADD_MPID_LENGTH; break;
+            case 'E': kind = EXECUTED_KIND; minLength = EXECUTED_LENGTH; break;
+            case 'C': kind = EXECUTED_PRICE_KIND; minLength = EXECUTED_PRICE_LENGTH; break;
+            case 'X': kind = CANCEL_KIND; minLength = CANCEL_LENGTH; break;
+            case 'D': kind = DELETE_KIND; minLength = DELETE_LENGTH; break;
+            case 'U': kind = REPLACE_KIND; minLength = REPLACE_LENGTH; break;
+            default: break;
+        }
+
+        if(length < minLength)  // Too short for its type, skipped like any unknown message
+        {
+            kind = OTHER_KIND;
+        }
+        m_numMessages[kind]++;
+
+        if(kind == ADD_KIND || kind == ADD_MPID_KIND)
+        {
+            addOrder(message, (kind == ADD_MPID_KIND) ? (unsigned int)readBigEndian(message + ADD_MPID_OFFSET, MPID_LENGTH) : 0);
+            continue;
+        }
+
+        if(kind == OTHER_KIND)
+        {
+            continue;
+        }
+
+        Orderbook* book = m_books[readBigEndian(message + LOCATE_OFFSET, 2)].get();
+        int orderID = (int)readBigEndian(message + REFERENCE_OFFSET, 8);
+        bool isApplied = false;
+
+        if(book != nullptr)
+        {
+            switch(kind)
+            {
+                case EXECUTED_KIND:
+                case EXECUTED_PRICE_KIND:
+                case CANCEL_KIND:
+                    isApplied = book->reduceOrder(orderID, toShares(message + EXECUTED_SHARES_OFFSET));
+                    break;
+
+                case DELETE_KIND:
+                    isApplied = book->cancelOrder(orderID);
+                    break;
+
+                default:    // REPLACE_KIND
+                    isApplied = book->replaceOrder(orderID, (long long)readBigEndian(message + REPLACE_NEW_REFERENCE_OFFSET, 8), toPrice(message + REPLACE_PRICE_OFFSET), \
+                                                   toTime(message), toShares(message + REPLACE_SHARES_OFFSET));
+                    break;
+            }
+        }
+
+        if(!isApplied)
+        {
+            m_numUnknownOrders++;
+        }
+    }
+
+    m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if(!isComplete)
+    {
+        std::cerr << "ERROR - run(): The file ends in the middle of a message, " << (end - cursor) << " bytes were not decoded" << std::endl;
+    }
+
+    return isComplete;
+}
+
+/**--------------------------------------------------------------------------------------
+ * addOrder()
+ * 
+ * Applies an A or F message
+ * 
+ * @param[in] message   First byte (the message type) of the message inside the mapping
+ * @param[in] owner     Owner of the order, the MPID of an F message or 0
+ * --------------------------------------------------------------------------------------
+*/
+void ItchReplay::addOrder(const unsigned char* message, unsigned int owner)
+{
+    const size_t stockLocate = (size_t)readBigEndian(message + LOCATE_OFFSET, 2);
+    std::unique_ptr<Orderbook>& book = m_books[stockLocate];
+
+    if(!book)   // First order of this stock, naming its book after the space-padded stock symbol
+    {
+        const char* stock = reinterpret_cast<const char*>(message + ADD_STOCK_OFFSET);
+        size_t stockLength = STOCK_LENGTH;
+        while(stockLength > 0 && stock[stockLength - 1] == ' ')
+        {
+            stockLength--;
+        }
+
+        m_tickers[stockLocate].assign(stock, stockLength);
+        book.reset(new Orderbook(m_tickers[stockLocate]));
+    }
+
+    Order newOrder(m_tickers[stockLocate], (long long)readBigEndian(message + REFERENCE_OFFSET, 8), false, message[ADD_SIDE_OFFSET] == 'B', \
+                   toPrice(message + ADD_PRICE_OFFSET), toTime(message), toShares(message + ADD_SHARES_OFFSET), owner);
+
+    if(!book->acceptsPrice(newOrder.checkIsBuy(), newOrder.getPriceTicks()))
+    {
+        m_numRejected++;
+        return;
+    }
+
+    book->addOrder(newOrder);
+}
+
+/**--------------------------------------------------------------------------------------
+ * printSummary()
+ * 
+ * Prints the number of messages of each type, the replay rate, and the best prices of the
+ * order books holding the most resting orders
+ * 
+ * @param[in] numBooks  Number of order books to be listed
+ * --------------------------------------------------------------------------------------
+*/
+void ItchReplay::printSummary(size_t numBooks) const
+{
+    uint64_t totalMessages = 0;
+    for(uint64_t numMessages : m_numMessages)
+    {
+        totalMessages += numMessages;
+    }
+
+    std::cout << "Replayed " << totalMessages << " ITCH messages (" << m_size << " bytes) in " << std::fixed << std::setprecision(3) << m_seconds << " s";
+    if(m_seconds > 0)
+    {
+        std::cout << ", " << std::setprecision(0) << totalMessages / m_seconds << " messages/s";
+    }
+    std::cout << std::endl;
+
+    for(int kind = 0; kind < NUM_KINDS; kind++)
+    {
+        std::cout << "    " << std::left << std::setw(22) << KIND_NAMES[kind] << std::right << m_numMessages[kind] << std::endl;
+    }
+    std::cout << "    Orders outside their book's price range: " << m_numRejected << ", messages for unknown orders: " << m_numUnknownOrders << std::endl;
+
+    std::vector<size_t> locates;
+    size_t numResting = 0;
+    for(size_t locate = 0; locate < m_books.size(); locate++)
+    {
+        if(m_books[locate])
+        {
+            locates.push_back(locate);
+            numResting += m_books[locate]->getNumRestingOrders();
+        }
+    }
+
+    std::cout << "\n" << locates.size() << " order books, " << numResting << " resting orders" << std::endl;
+
+    // Listing the deepest books first
+    numBooks = std::min(numBooks, locates.size());
+    std::partial_sort(locates.begin(), locates.begin() + numBooks, locates.end(), [this](size_t locate1, size_t locate2)
+    {
+        return m_books[locate1]->getNumRestingOrders() > m_books[locate2]->getNumRestingOrders();
+    });
+
+    if(numBooks > 0)
+    {
+        std::cout << "    Locate   Stock      Resting    Best buy   Best sell" << std::endl;
+    }
+
+    for(size_t i = 0; i < numBooks; i++)
+    {
+        const Orderbook& book = *m_books[locates[i]];
+        int bestBuy = book.getBestBuyTicks();
+        int bestSell = book.getBestSellTicks();
+
+        std::cout << "    " << std::setw(6) << locates[i] << "   " << std::left << std::setw(8) << m_tickers[locates[i]] << std::right << std::setw(10) \
+                  << book.getNumRestingOrders() << std::setprecision(2) << "   " << std::setw(9);
+        if(bestBuy == PriceLadder::NO_PRICE) std::cout << "-"; else std::cout << Order::ticksToPrice(bestBuy);
+        std::cout << "   " << std::setw(9);
+        if(bestSell == PriceLadder::NO_PRICE) std::cout << "-"; else std::cout << Order::ticksToPrice(bestSell);
+        std::cout << std::endl;
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * unmap()
+ * 
+ * Releases the mapping of the file
+ * --------------------------------------------------------------------------------------
+*/
+void ItchReplay::unmap()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    if(m_data != nullptr)
+    {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+#endif
+
+    m_buffer.clear();
+    m_data = nullptr;
+    m_size = 0;
+}
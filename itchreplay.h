@@ -0,0 +1,169 @@
+/*itchreplay.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the ItchReplay class
+ *     Replays a binary Nasdaq TotalView-ITCH 5.0 file into one order book per stock locate
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "orderbook.h"
+
+/**--------------------------------------------------------------------------------------
+ * ItchReplay class
+ * 
+ * Maps an ITCH 5.0 file (every message prefixed by its big-endian 2-byte length, as in the
+ * files published by Nasdaq) into memory and decodes its messages in place, without copying
+ * them out of the mapping. Add (A), Add with MPID (F), Executed (E), Executed with price (C),
+ * Cancel (X), Delete (D) and Replace (U) messages are applied to the order book of their
+ * stock locate, which is created on the first order of that stock. Every other message
+ * type is skipped.
+ * 
+ * Order reference numbers become order IDs through their low 32 bits, prices are truncated
+ * to whole ticks, timestamps become hh:mm times, and the MPID of an F message becomes the
+ * owner of the order. The books only track displayed orders, they are never matched: the
+ * executions of the feed already say which orders traded
+ * --------------------------------------------------------------------------------------
+*/
+class ItchReplay
+{
+public:
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Creates a replay without any file or order book
+     * --------------------------------------------------------------------------------------
+    */
+    ItchReplay();
+
+    /**--------------------------------------------------------------------------------------
+     * Destructor
+     * 
+     * Unmaps the file if it is still mapped
+     * --------------------------------------------------------------------------------------
+    */
+    ~ItchReplay();
+
+    ItchReplay(const ItchReplay&) = delete;
+    ItchReplay& operator=(const ItchReplay&) = delete;
+
+    /**--------------------------------------------------------------------------------------
+     * open()
+     * 
+     * Maps an ITCH 5.0 file into memory, read-only
+     * 
+     * @param[in] path  Path of the file
+     * @return true if the file could be mapped
+     * --------------------------------------------------------------------------------------
+    */
+    bool open(const std::string& path);
+
+    /**--------------------------------------------------------------------------------------
+     * run()
+     * 
+     * Decodes every message of the file and applies it to its order book
+     * 
+     * @return true if the whole file was decoded, false if it ends in the middle of a message
+     * --------------------------------------------------------------------------------------
+    */
+    bool run();
+
+    /**--------------------------------------------------------------------------------------
+     * printSummary()
+     * 
+     * Prints the number of messages of each type, the replay rate, and the best prices of the
+     * order books holding the most resting orders
+     * 
+     * @param[in] numBooks  Number of order books to be listed
+     * --------------------------------------------------------------------------------------
+    */
+    void printSummary(size_t numBooks) const;
+
+    /**--------------------------------------------------------------------------------------
+     * getOrderbook()
+     * 
+     * @param[in] stockLocate   Stock locate code of a stock
+     * @return the order book of the stock, or nullptr if no order was added for it
+     * --------------------------------------------------------------------------------------
+    */
+    const Orderbook* getOrderbook(uint16_t stockLocate) const
+    {
+        return m_books[stockLocate].get();
+    }
+
+private:
+    // Message types applied to the order books, counted separately in the summary
+    enum MessageKind
+    {
+        ADD_KIND = 0,
+        ADD_MPID_KIND,
+        EXECUTED_KIND,
+        EXECUTED_PRICE_KIND,
+        CANCEL_KIND,
+        DELETE_KIND,
+        REPLACE_KIND,
+        OTHER_KIND,
+        NUM_KINDS
+    };
+
+    /**--------------------------------------------------------------------------------------
+     * addOrder()
+     * 
+     * Applies an A or F message
+     * 
+     * @param[in] message   First byte (the message type) of the message inside the mapping
+     * @param[in] owner     Owner of the order, the MPID of an F message or 0
+     * --------------------------------------------------------------------------------------
+    */
+    void addOrder(const unsigned char* message, unsigned int owner);
+
+    /**--------------------------------------------------------------------------------------
+     * unmap()
+     * 
+     * Releases the mapping of the file
+     * --------------------------------------------------------------------------------------
+    */
+    void unmap();
+
+    const unsigned char* m_data = nullptr;  // Start of the mapped file
+    size_t m_size = 0;                      // Size of the mapped file in bytes
+    std::vector<unsigned char> m_buffer;    // Holds the file where it cannot be mapped
+
+    std::vector<std::unique_ptr<Orderbook>> m_books;    // Indexed by stock locate
+    std::vector<std::string> m_tickers;                 // Indexed by stock locate
+
+    uint64_t m_numMessages[NUM_KINDS] = {};
+    uint64_t m_numUnknownOrders = 0;    // Executions, cancels, deletes and replaces of orders not in any book
+    uint64_t m_numRejected = 0;         // Orders whose price did not fit their order book
+    double m_seconds = 0;
+};
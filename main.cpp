@@ -30,67 +30,202 @@
 */
 
 #include <iostream>
-#include <fstream>
+#include <iomanip>
 #include <sstream>
+#include <cmath>
+#include <fstream>
 #include <string>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <chrono>
+#include <csignal>
+#include <thread>
 
 #include "orderbook.h"
+#include "orderreader.h"
+#include "backtestrunner.h"
+#include "algorithmcomparison.h"
+#include "midpointpool.h"
+#include "impliedengine.h"
+#include "combobook.h"
+#include "shmtransport.h"
+#include "marketbyorder.h"
+#include "orderpipeline.h"
+#include "replication.h"
+#include "ordercodec.h"
+#include "itchreplay.h"
+#include "syntheticflow.h"
+#include "allocationcounter.h"
+#include "warmup.h"
+#include "perfcounters.h"
+#include "tracer.h"
 #include "logger.h"
 
 namespace { 
     const int FIFOCHOICE = 1;
     const int PRORATACHOICE = 2;
+    const int MIDPOINTCHOICE = 3;   // Lit FIFO order book with a midpoint dark pool for the market orders
+    const int AUCTIONCHOICE = 4;    // Frequent batch auctions at a uniform price
+
+    const int STEADY_STATE_ORDERS = 100000;     // Length of the synthetic flow used to check the matching hot path
+    const int WARMUP_ORDERS = 100000;           // Length of the synthetic burst run through each algorithm at startup
+    const size_t WARMUP_ORDERS_PER_LEVEL = 64;  // Room prefaulted at every price level at startup
+    const int WARMUP_LEVELS_PER_SIDE = 500;     // Price levels prefaulted above and below the expected best prices at startup
+
+    // Optional arguments, passed after the three necessary ones
+    const char* WARMUP_OPTION = "--warmup";     // Prefault the order book and warm up the matchers before processing orders
+    const char* MLOCK_OPTION = "--mlock";       // Lock all memory of the process into RAM
+    const char* PERF_OPTION = "--perf";         // Report hardware performance counters per stage (parse, add, match, output)
+    const char* TRACE_OPTION = "--trace=";      // Record a timeline of engine activity into the Chrome trace JSON file named after the '='
+    const char* PIPELINE_OPTION = "--pipeline=";    // Match every order as it arrives through the staged pipeline, journaling to the file named after the '='
+    const char* PRIMARY_OPTION = "--primary=";      // Match every order as it arrives, replicating them to a secondary connecting on the port after the '='
+    const char* FEED_OPTION = "--feed=";            // Publish every change to every resting order into the shared-memory segment named after the '='
+    const char* MIN_QUANTITY_OPTION = "--min-quantity=";    // Smallest fill the hidden orders of the midpoint dark pool accept, after the '='
+    const char* BATCH_INTERVAL_OPTION = "--batch-interval=";    // Length of a batch auction after the '=', in minutes of order time (milliseconds with --serve=)
+    const char* PRICE_BANDS_OPTION = "--price-bands=";          // Halt matching outside of the static and dynamic bands after the '=', in percent, optionally followed by the length of the volatility auction
+    const char* const OPTIONS[] = { WARMUP_OPTION, MLOCK_OPTION, PERF_OPTION, TRACE_OPTION, PIPELINE_OPTION, PRIMARY_OPTION, FEED_OPTION, MIN_QUANTITY_OPTION, BATCH_INTERVAL_OPTION, PRICE_BANDS_OPTION };
+
+    // Replaces the three necessary arguments, optionally followed by the number of worker threads
+    const char* BACKTEST_OPTION = "--backtest=";    // Run every job of the manifest CSV file named after the '=' on a pool of threads
+    const char* SERVE_OPTION = "--serve=";          // Replaces the CSV file, accept orders through the shared-memory segment named after the '='
+    const char* PING_OPTION = "--ping=";            // Measure round trips through the shared-memory segment named after the '=', optionally followed by the number of orders
+    const char* WATCH_OPTION = "--watch=";          // Print the market-by-order feed published into the shared-memory segment named after the '='
+    const char* SECONDARY_OPTION = "--secondary=";  // Replicate the order book of the primary at the host:port after the '='
+    const char* ENCODE_OPTION = "--encode=";        // Compress the order file passed after it into the file named after the '='
+    // Optional arguments of --serve=
+    const char* RATE_LIMIT_OPTION = "--rate-limit=";    // Orders per second of each client and each owner after the '=', optionally followed by the burst
+    const char* WATERMARK_OPTION = "--watermark=";      // Reject new orders while more requests than the number after the '=' are queued
+
+    const char* ITCH_OPTION = "--itch=";            // Build the order book of every stock of the ITCH 5.0 file named after the '='
+    const char* IMPLIED_OPTION = "--implied=";      // Match the outrights and calendar spreads of the CSV file named after the '=', with implied prices between them
+    const char* COMBOS_OPTION = "--combos=";        // Match the instruments and all-or-none combo orders of the CSV file named after the '='
+
+    const size_t SERVE_BATCH_SIZE = 256;        // Largest number of requests drained at once from the shared-memory segment
+    const int PING_ORDERS = 100000;             // Default number of orders sent (then cancelled) by --ping
+    const size_t ITCH_BOOKS_LISTED = 10;        // Number of order books listed after an ITCH replay
+    const int DEFAULT_BATCH_INTERVAL = 1;       // Length of a batch auction without --batch-interval=
+    const int DEFAULT_HALT_AUCTION_LENGTH = 5;  // Length of a volatility auction in units of order time, unless given with --price-bands=
+    const unsigned int DEFAULT_RATE_BURST = 100;    // Orders a client or owner may send at once, unless given with --rate-limit=
+
+    volatile std::sig_atomic_t isStopping = 0;  // Set by SIGINT/SIGTERM to stop serving
 }
 
 /**--------------------------------------------------------------------------------------
- * readOrderData()
+ * matchesOption()
  * 
- * Write the completed and solved maze data to a csv file
+ * Checks if an argument is the given option. Options ending in '=' take a value, and match
+ * any argument starting with them
  * 
- * @param[in]       infile          CSV file to be read in, filled with unprocessed orders
- * @param[in,out]   blankOrderbook  Orderbook object that is empty, to be filled with the
- *                                  orders from infile
+ * @param[in] argument  Argument passed to main()
+ * @param[in] option    Option to compare against, e.g. "--warmup" or "--trace="
+ * @return true if the argument is the option
  * --------------------------------------------------------------------------------------
 */
-void readOrderData(std::fstream& infile, Orderbook& blankOrderbook)
+bool matchesOption(const char* argument, const char* option)
 {
-    std::string line;
+    size_t optionLength = std::strlen(option);
 
-    if(infile.is_open())
+    if(optionLength > 0 && option[optionLength - 1] == '=')
     {
-        std::string ticker = "";
-        std::string orderID = "";
-        std::string isMarket = "";
-        std::string isBuy = "";
-        std::string price = "";
-        std::string time = "";
-        std::string amount = "";
+        return std::strncmp(argument, option, optionLength) == 0;
+    }
 
-        // Skipping first line of CSV (contains column headers)
-        std::getline(infile, line);
+    return std::strcmp(argument, option) == 0;
+}
 
-        while(std::getline(infile, line))
+/**--------------------------------------------------------------------------------------
+ * getOptionValue()
+ * 
+ * Finds an optional argument passed to main()
+ * 
+ * @param[in] argc      Number of arguments passed
+ * @param[in] argv      String vector of arguments passed
+ * @param[in] option    Optional argument to look for, e.g. "--warmup" or "--trace="
+ * @return the part of the argument after the option (an empty string for options without a
+ *         value), or nullptr if the option was not passed after the three necessary arguments
+ * --------------------------------------------------------------------------------------
+*/
+const char* getOptionValue(int argc, const char** argv, const char* option)
+{
+    for(int i = 4; i < argc; i++)
+    {
+        if(matchesOption(argv[i], option))
         {
-            std::istringstream curString(line);
+            return argv[i] + std::strlen(option);
+        }
+    }
 
-            std::getline(curString, ticker, ',');
-            std::getline(curString, orderID, ',');
-            std::getline(curString, isMarket, ',');
-            std::getline(curString, isBuy, ',');
-            std::getline(curString, price, ',');
-            std::getline(curString, time, ',');
-            std::getline(curString, amount, ',');
+    return nullptr;
+}
 
-            bool boolIsMarket = (isMarket == "true");
-            bool boolIsBuy = (isBuy == "true");
+/**--------------------------------------------------------------------------------------
+ * hasOption()
+ * 
+ * Checks if an optional argument was passed to main()
+ * 
+ * @param[in] argc      Number of arguments passed
+ * @param[in] argv      String vector of arguments passed
+ * @param[in] option    Optional argument to look for, e.g. "--warmup"
+ * @return true if the option was passed after the three necessary arguments
+ * --------------------------------------------------------------------------------------
+*/
+bool hasOption(int argc, const char** argv, const char* option)
+{
+    return getOptionValue(argc, argv, option) != nullptr;
+}
 
-            blankOrderbook.addOrder(Order(ticker, std::stoll(orderID), boolIsMarket, boolIsBuy, std::stof(price), std::stoi(time), std::stoi(amount)));
-        }
+/**--------------------------------------------------------------------------------------
+ * parseChoices()
+ * 
+ * Splits the choice of matching algorithm passed to main(), e.g. "2", or "1,2" to compare
+ * several algorithms
+ * 
+ * @param[in] argument  Argument passed to main()
+ * @return every choice in the argument, in the order they were given
+ * --------------------------------------------------------------------------------------
+*/
+std::vector<int> parseChoices(const char* argument)
+{
+    std::vector<int> choices;
+    std::istringstream curString(argument);
+    std::string choice = "";
+
+    while(std::getline(curString, choice, ','))
+    {
+        choices.push_back(atoi(choice.c_str()));
     }
-    else
+
+    return choices;
+}
+
+/**--------------------------------------------------------------------------------------
+ * applyPriceBands()
+ * 
+ * Sets the price bands of an order book from the value of --price-bands=, e.g. "5,1" for
+ * a static band of 5% and a dynamic band of 1%, or "5,1,10" to also let the volatility
+ * auction last 10 units of order time
+ * 
+ * @param[in]       value       Value of the option, nullptr if it was not passed
+ * @param[in,out]   orderbook   Order book the bands are set on
+ * --------------------------------------------------------------------------------------
+*/
+void applyPriceBands(const char* value, Orderbook& orderbook)
+{
+    if(value == nullptr)
     {
-        std::cerr << "ERROR: Could not open the given file" << std::endl;
+        return;
     }
+
+    std::istringstream curString(value);
+    std::string staticPercent = "", dynamicPercent = "", auctionLength = "";
+    std::getline(curString, staticPercent, ',');
+    std::getline(curString, dynamicPercent, ',');
+    std::getline(curString, auctionLength, ',');
+
+    orderbook.setPriceBands((int)std::lround(atof(staticPercent.c_str()) * 100), (int)std::lround(atof(dynamicPercent.c_str()) * 100),
+                            auctionLength.empty() ? DEFAULT_HALT_AUCTION_LENGTH : atoi(auctionLength.c_str()));
 }
 
 /**--------------------------------------------------------------------------------------
@@ -107,57 +242,1157 @@ bool printUsage(int argc, const char** argv)
 {
     bool shouldTerminate = false;
 
-    if(argc != 4) // Should be four arguments: 1: name of program, 2: name of input csv file, 3: name of ticker, 4: type of matching algorithm (1: FIFO or 2: PRORATA)
+    if(argc < 4) // Should be at least four arguments: 1: name of program, 2: name of input csv file, 3: name of ticker, 4: type of matching algorithm (1: FIFO or 2: PRORATA)
     {
         std::cerr << "ERROR: Incorrect number of arguments passed to main(), need in following order: #1 Name of CSV File\n" \
                   << "                                                                                #2 Name of ticker\n" \
-                  << "                                                                                #3 Choice of matching algorithm (1 for FIFO, 2 for Pro-Rata)\n" << std::endl;
+                  << "                                                                                #3 Choice of matching algorithm (1 for FIFO, 2 for Pro-Rata, 3 for FIFO with a midpoint dark pool, 4 for batch auctions, or e.g. 1,2 to compare them)\n" \
+                  << "                                                                  followed by any of: " << WARMUP_OPTION << " " << MLOCK_OPTION << " " << PERF_OPTION << " " << TRACE_OPTION << "<file> " << PIPELINE_OPTION << "<journal> " << PRIMARY_OPTION << "<port> " << FEED_OPTION << "<segment> " << MIN_QUANTITY_OPTION << "<amount> " << BATCH_INTERVAL_OPTION << "<interval> " << PRICE_BANDS_OPTION << "<static %>,<dynamic %>[,<auction length>]\n" \
+                  << "       or, to run a backtest: " << BACKTEST_OPTION << "<manifest> [number of worker threads]\n" \
+                  << "       or, to accept orders through shared memory: " << SERVE_OPTION << "<segment> <ticker> <algorithm> [" << FEED_OPTION << "<segment>] [" << BATCH_INTERVAL_OPTION << "<milliseconds>] [" << PRICE_BANDS_OPTION << "<static %>,<dynamic %>[,<auction length>]]\n" \
+                  << "                                                     [" << RATE_LIMIT_OPTION << "<orders/s per client>,<orders/s per owner>[,<burst>]] [" << WATERMARK_OPTION << "<queued requests>]\n" \
+                  << "       or, to measure round trips to such an engine: " << PING_OPTION << "<segment> [number of orders]\n" \
+                  << "       or, to print the feed of an engine started with " << FEED_OPTION << ": " << WATCH_OPTION << "<segment>\n" \
+                  << "       or, to replicate an engine started with " << PRIMARY_OPTION << ": " << SECONDARY_OPTION << "<host>:<port>\n" \
+                  << "       or, to compress an order file: " << ENCODE_OPTION << "<output> <CSV file>\n" \
+                  << "       or, to build the order books of a Nasdaq ITCH 5.0 file: " << ITCH_OPTION << "<ITCH file>\n" \
+                  << "       or, to match outrights and calendar spreads (tickers A-B) with implied prices: " << IMPLIED_OPTION << "<CSV file>\n" \
+                  << "       or, to match instruments and combo orders on them (tickers e.g. A+2*B-C): " << COMBOS_OPTION << "<CSV file>\n" << std::endl;
         shouldTerminate = true;
     }
     else
     {
-        int choice = atoi(argv[3]);
+        std::vector<int> choices = parseChoices(argv[3]);
 
-        if(choice != FIFOCHOICE && choice != PRORATACHOICE)
+        if(choices.empty() || std::any_of(choices.begin(), choices.end(), [](int choice) { return choice < FIFOCHOICE || choice > AUCTIONCHOICE; }))
+        {
+            std::cerr << "ERROR: Invalid choice of algorithm, please pick from the following (FIFO: 1, Pro-Rata: 2, FIFO with a midpoint dark pool: 3, Batch auctions: 4)" << std::endl;
+            shouldTerminate = true;
+        }
+        else if(choices.size() == 1 && AUCTIONCHOICE == choices.front() && (hasOption(argc, argv, PIPELINE_OPTION) || hasOption(argc, argv, PRIMARY_OPTION)))
         {
-            std::cerr << "ERROR: Invalid choice of algorithm, please pick from the following (FIFO: 1, Pro-Rata: 2)" << std::endl;
+            std::cerr << "ERROR: Batch auctions (4) cannot be run with " << PIPELINE_OPTION << " or " << PRIMARY_OPTION << ", which match after every order" << std::endl;
             shouldTerminate = true;
         }
+        else if(std::find(choices.begin(), choices.end(), MIDPOINTCHOICE) != choices.end() && (choices.size() > 1 || hasOption(argc, argv, PIPELINE_OPTION) || hasOption(argc, argv, PRIMARY_OPTION)))
+        {
+            std::cerr << "ERROR: The midpoint dark pool (3) can only be run on its own, without " << PIPELINE_OPTION << " or " << PRIMARY_OPTION << std::endl;
+            shouldTerminate = true;
+        }
+
+        for(int i = 4; i < argc; i++)
+        {
+            if(std::none_of(std::begin(OPTIONS), std::end(OPTIONS), [&](const char* option) { return matchesOption(argv[i], option); }))
+            {
+                std::cerr << "ERROR: Unknown option " << argv[i] << std::endl;
+                shouldTerminate = true;
+            }
+        }
     }
 
     return shouldTerminate;
 }
 
-int main(int argc, const char** argv)
+/**--------------------------------------------------------------------------------------
+ * checkSteadyStateAllocations()
+ * 
+ * Runs a synthetic flow of adds, matches and cancels through an order book twice, clearing
+ * the book in between, and counts the heap allocations made by this thread during the
+ * second run. The first run is the warm-up that grows every container to its steady-state
+ * size, so the second, identical run has to be allocation-free. Only meaningful when built
+ * with -DCOUNT_ALLOCATIONS
+ * 
+ * @param[in] matcher   Order-matching algorithm, e.g. &Orderbook::matchOrdersFIFO
+ * @return true if no allocation happened after the warm-up
+ * --------------------------------------------------------------------------------------
+*/
+bool checkSteadyStateAllocations(void (Orderbook::*matcher)())
 {
-    if(printUsage(argc, argv))
+    Orderbook scratchOrderbook("SYNTH");
+    scratchOrderbook.reserve(STEADY_STATE_ORDERS, STEADY_STATE_ORDERS);
+
+    SyntheticOrderFlow warmupFlow("SYNTH", 2000, 1);
+    warmupFlow.run(scratchOrderbook, matcher, STEADY_STATE_ORDERS);
+    scratchOrderbook.clear();
+    scratchOrderbook.clearOrderHistory();
+
+    SyntheticOrderFlow steadyFlow("SYNTH", 2000, 1);
+    unsigned long long allocationsBefore = AllocationCounter::getThreadAllocations();
+    steadyFlow.run(scratchOrderbook, matcher, STEADY_STATE_ORDERS);
+    unsigned long long numAllocations = AllocationCounter::getThreadAllocations() - allocationsBefore;
+
+    if(numAllocations != 0)
+    {
+        std::cerr << "ERROR - checkSteadyStateAllocations(): " << numAllocations << " heap allocations on the matching thread after warm-up" << std::endl;
+        return false;
+    }
+
+    LOG_DEBUG("checkSteadyStateAllocations(): no heap allocations on the matching thread after warm-up");
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * runBacktest()
+ * 
+ * Runs every job of a backtest manifest and prints their summary
+ * 
+ * @param[in] manifestPath  Path of the manifest CSV file (File, Ticker, Algorithm)
+ * @param[in] numWorkers    Number of worker threads, 0 to use one per hardware thread
+ * @return exit code of the program
+ * --------------------------------------------------------------------------------------
+*/
+int runBacktest(const char* manifestPath, unsigned int numWorkers)
+{
+    BacktestRunner runner(numWorkers);
+
+    if(!runner.readManifest(manifestPath))
     {
         return -1;
     }
 
+    std::cout << "Initiating backtest of " << manifestPath << std::endl;
+    runner.run();
+    runner.printSummary();
+
+    std::cout << "\nProgram finished" <<std::endl;
+
+    return 0;
+}
+
+/**--------------------------------------------------------------------------------------
+ * runSingleAlgorithm()
+ * 
+ * Loads the parsed orders into an order book, matches them with one algorithm and prints
+ * the fills and the remaining contents of the order book
+ * 
+ * @param[in]       argc            Number of arguments passed
+ * @param[in]       argv            String vector of arguments passed
+ * @param[in]       parsedOrders    Every order read from the CSV file
+ * @param[in]       choice          Choice of algorithm (1 for FIFO, 2 for Pro-Rata)
+ * @param[in,out]   perfCounters    Counters measuring each stage, nullptr if not measured
+ * --------------------------------------------------------------------------------------
+*/
+void runSingleAlgorithm(int argc, const char** argv, const std::vector<Order>& parsedOrders, int choice, PerfCounters* perfCounters)
+{
     Orderbook myOrderbook(argv[2]);
+    void (Orderbook::*matcher)() = (FIFOCHOICE == choice) ? &Orderbook::matchOrdersFIFO : &Orderbook::matchOrdersProRata;
+
+    MarketByOrderPublisher feed(argv[2]);
+    const char* feedSegment = getOptionValue(argc, argv, FEED_OPTION);
+    if(feedSegment != nullptr && feed.create(feedSegment))
+    {
+        myOrderbook.setFeed(&feed);
+    }
+
+    if(hasOption(argc, argv, WARMUP_OPTION) && !parsedOrders.empty())
+    {
+        // Touching every pool and the price levels around the median limit price, then warming up the hot path on a throwaway order book.
+        // Market orders are left out, their prices say nothing about where the book will rest
+        std::vector<int> limitTicks;
+        limitTicks.reserve(parsedOrders.size());
+        for(const Order& curOrder : parsedOrders)
+        {
+            if(!curOrder.checkIsMarket())
+            {
+                limitTicks.push_back(curOrder.getPriceTicks());
+            }
+        }
+
+        int expectedTicks = PriceLadder::NO_PRICE;
+        if(!limitTicks.empty())
+        {
+            std::nth_element(limitTicks.begin(), limitTicks.begin() + limitTicks.size() / 2, limitTicks.end());
+            expectedTicks = limitTicks[limitTicks.size() / 2];
+        }
+
+        myOrderbook.reserve(parsedOrders.size(), parsedOrders.size());
+        myOrderbook.prefault(expectedTicks, WARMUP_LEVELS_PER_SIDE, WARMUP_ORDERS_PER_LEVEL);
+
+        Warmup::runSyntheticBurst(WARMUP_ORDERS);
+    }
 
-    std::fstream csvData(argv[1], std::fstream::in);
-    readOrderData(csvData, myOrderbook);
-    csvData.close();
+    // Building the order book in one pass once every order has been parsed
+    if(perfCounters) perfCounters->start();
+    myOrderbook.bulkLoad(parsedOrders);
+    if(perfCounters) perfCounters->stop("add", parsedOrders.size());
 
-    int choice = atoi(argv[3]);
     if(FIFOCHOICE == choice)  // User chose to use FIFO algorithm for order-matching
     {
-        myOrderbook.matchOrdersFIFO();
+        std::cout << "Initiating FIFO order-matching" << std::endl;
     }
     else             // User chose to use Pro-Rata algorithm for order-matching
     {
-        myOrderbook.matchOrdersProRata();
+        std::cout << "Initiating Pro-Rata order-matching" << std::endl;
+    }
+    applyPriceBands(getOptionValue(argc, argv, PRICE_BANDS_OPTION), myOrderbook);
+
+    if(perfCounters) perfCounters->start();
+    (myOrderbook.*matcher)();
+    if(perfCounters) perfCounters->stop("match", parsedOrders.size());
+
+    // No more orders will arrive to end a volatility auction, so it ends right away and matching resumes
+    while(myOrderbook.isHalted())
+    {
+        myOrderbook.printOrderHistory();
+        std::cout << "    VOLATILITY INTERRUPTION:   Fill at " << std::fixed << std::setprecision(2) << Order::ticksToPrice(myOrderbook.getHaltTicks()) \
+                  << " outside of the price bands, switching to an auction" << std::endl;
+
+        myOrderbook.endVolatilityAuction();
+        if(myOrderbook.getLastAuctionVolume() > 0)
+        {
+            std::cout << "    AUCTION CLEARED:   Amount: " << myOrderbook.getLastAuctionVolume() << ",   Price: " << std::fixed << std::setprecision(2) \
+                      << Order::ticksToPrice(myOrderbook.getLastAuctionTicks()) << std::endl;
+        }
+        (myOrderbook.*matcher)();
     }
 
     // Printing all processed orders
+    if(perfCounters) perfCounters->start();
     myOrderbook.printOrderHistory();
 
     std::cout << "\nDisplaying remaining contents of the order book:" << std::endl;
 
     // Printing remaining contents of order book
     myOrderbook.printOrderbookContents();
+    if(perfCounters) perfCounters->stop("output", parsedOrders.size());
+
+    if(feedSegment != nullptr)
+    {
+        std::cout << "\nPublished " << feed.getNumMessages() << " market-by-order messages on " << feedSegment << std::endl;
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * runMidpointPool()
+ * 
+ * Adds the parsed orders one at a time, in the order of the CSV file: market orders go to
+ * a midpoint dark pool as hidden orders, every other order to the lit order book, which is
+ * matched with FIFO after each of them and sets the midpoint of the pool. Prints the lit
+ * fills, the midpoint crosses and what is left in the order book and in the pool
+ * 
+ * @param[in]       argc            Number of arguments passed
+ * @param[in]       argv            String vector of arguments passed
+ * @param[in]       parsedOrders    Every order read from the CSV file
+ * @param[in,out]   perfCounters    Counters measuring each stage, nullptr if not measured
+ * --------------------------------------------------------------------------------------
+*/
+void runMidpointPool(int argc, const char** argv, const std::vector<Order>& parsedOrders, PerfCounters* perfCounters)
+{
+    Orderbook litOrderbook(argv[2]);
+    MidpointPool darkPool(litOrderbook);
+
+    const char* minQuantity = getOptionValue(argc, argv, MIN_QUANTITY_OPTION);
+    const int minAmount = (minQuantity != nullptr) ? atoi(minQuantity) : 1;
+
+    MarketByOrderPublisher feed(argv[2]);
+    const char* feedSegment = getOptionValue(argc, argv, FEED_OPTION);
+    if(feedSegment != nullptr && feed.create(feedSegment))
+    {
+        litOrderbook.setFeed(&feed);
+    }
+
+    std::cout << "Initiating FIFO order-matching with a midpoint dark pool" << std::endl;
+
+    if(perfCounters) perfCounters->start();
+    for(const Order& curOrder : parsedOrders)
+    {
+        if(curOrder.checkIsMarket())
+        {
+            darkPool.addOrder(curOrder, minAmount);
+        }
+        else if(litOrderbook.addOrder(curOrder))
+        {
+            litOrderbook.matchOrdersFIFO();
+            darkPool.onReferenceUpdate();
+        }
+    }
+    if(perfCounters) perfCounters->stop("match", parsedOrders.size());
+
+    if(perfCounters) perfCounters->start();
+    litOrderbook.printOrderHistory();
+
+    std::cout << "\nMidpoint crosses in the dark pool:" << std::endl;
+    darkPool.printFills();
+
+    std::cout << "\nDisplaying remaining contents of the order book:" << std::endl;
+    litOrderbook.printOrderbookContents();
+
+    std::cout << "\nDisplaying remaining contents of the dark pool:" << std::endl;
+    darkPool.printPoolContents();
+    if(perfCounters) perfCounters->stop("output", parsedOrders.size());
+
+    if(feedSegment != nullptr)
+    {
+        std::cout << "\nPublished " << feed.getNumMessages() << " market-by-order messages on " << feedSegment << std::endl;
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * toMinutes()
+ * 
+ * @param[in] time  Time (hr:min) stored as an int according to military time, e.g. 745
+ * @return the number of minutes since midnight, e.g. 465
+ * --------------------------------------------------------------------------------------
+*/
+int toMinutes(int time)
+{
+    return time / 100 * 60 + time % 100;
+}
+
+/**--------------------------------------------------------------------------------------
+ * toMilitaryTime()
+ * 
+ * @param[in] minutes   Number of minutes since midnight, e.g. 465
+ * @return the time (hr:min) as an int according to military time, e.g. 745
+ * --------------------------------------------------------------------------------------
+*/
+int toMilitaryTime(int minutes)
+{
+    return minutes / 60 * 100 + minutes % 60;
+}
+
+/**--------------------------------------------------------------------------------------
+ * runBatchAuctions()
+ * 
+ * Adds the parsed orders one at a time, in the order of the CSV file, without matching
+ * them, and clears the order book in an auction at the end of every interval of order
+ * time in minutes, and once more after the last order. Prints the clearing price and fills of every
+ * auction that executed anything, and the remaining contents of the order book
+ * 
+ * @param[in]       argc            Number of arguments passed
+ * @param[in]       argv            String vector of arguments passed
+ * @param[in]       parsedOrders    Every order read from the CSV file
+ * @param[in,out]   perfCounters    Counters measuring each stage, nullptr if not measured
+ * --------------------------------------------------------------------------------------
+*/
+void runBatchAuctions(int argc, const char** argv, const std::vector<Order>& parsedOrders, PerfCounters* perfCounters)
+{
+    Orderbook myOrderbook(argv[2]);
+    myOrderbook.reserve(parsedOrders.size(), parsedOrders.size());
+
+    const char* intervalValue = getOptionValue(argc, argv, BATCH_INTERVAL_OPTION);
+    const int interval = std::max((intervalValue != nullptr) ? atoi(intervalValue) : DEFAULT_BATCH_INTERVAL, 1);
+
+    MarketByOrderPublisher feed(argv[2]);
+    const char* feedSegment = getOptionValue(argc, argv, FEED_OPTION);
+    if(feedSegment != nullptr && feed.create(feedSegment))
+    {
+        myOrderbook.setFeed(&feed);
+    }
+
+    std::cout << "Initiating batch auctions every " << interval << " minute(s) of order time" << std::endl;
+
+    size_t numAuctions = 0;
+    auto runAuction = [&](int batchStart)
+    {
+        myOrderbook.matchOrdersAuction();
+        numAuctions++;
+
+        if(myOrderbook.getLastAuctionVolume() > 0)
+        {
+            std::cout << "    AUCTION CLEARED:   Batch from time: " << batchStart << ",   Amount: " << myOrderbook.getLastAuctionVolume() \
+                      << ",   Price: " << std::fixed << std::setprecision(2) << Order::ticksToPrice(myOrderbook.getLastAuctionTicks()) << std::endl;
+            myOrderbook.printOrderHistory();
+        }
+    };
+
+    if(perfCounters) perfCounters->start();
+    int curBatch = 0;
+    bool hasOrdersInBatch = false;
+    for(const Order& curOrder : parsedOrders)
+    {
+        // Orders only rest between auctions, the batch they arrived in is cleared once an order of a later batch arrives
+        // The Time column is hhmm, so batches are counted in minutes to line up across the hours
+        int batch = toMinutes(curOrder.getTime()) / interval;
+        if(hasOrdersInBatch && batch != curBatch)
+        {
+            runAuction(toMilitaryTime(curBatch * interval));
+        }
+
+        curBatch = batch;
+        hasOrdersInBatch = myOrderbook.addOrder(curOrder) || hasOrdersInBatch;
+    }
+
+    if(hasOrdersInBatch)
+    {
+        runAuction(toMilitaryTime(curBatch * interval));
+    }
+    if(perfCounters) perfCounters->stop("auctions", parsedOrders.size());
+
+    std::cout << "\nRan " << numAuctions << " auctions" << std::endl;
+    std::cout << "\nDisplaying remaining contents of the order book:" << std::endl;
+    myOrderbook.printOrderbookContents();
+
+    if(feedSegment != nullptr)
+    {
+        std::cout << "\nPublished " << feed.getNumMessages() << " market-by-order messages on " << feedSegment << std::endl;
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * runPipeline()
+ * 
+ * Feeds the parsed orders, in the order of the CSV file, through the staged pipeline that
+ * journals and matches each of them as it arrives, then prints the remaining contents of
+ * the order book
+ * 
+ * @param[in]       argv            String vector of arguments passed
+ * @param[in]       parsedOrders    Every order read from the CSV file
+ * @param[in]       choice          Choice of algorithm (1 for FIFO, 2 for Pro-Rata)
+ * @param[in]       journalPath     File the orders are journaled to
+ * @param[in,out]   perfCounters    Counters measuring each stage, nullptr if not measured
+ * --------------------------------------------------------------------------------------
+*/
+void runPipeline(const char** argv, const std::vector<Order>& parsedOrders, int choice, const char* journalPath, PerfCounters* perfCounters)
+{
+    void (Orderbook::*matcher)() = (FIFOCHOICE == choice) ? &Orderbook::matchOrdersFIFO : &Orderbook::matchOrdersProRata;
+    OrderPipeline pipeline(argv[2], matcher);
+
+    if(FIFOCHOICE == choice)
+    {
+        std::cout << "Initiating pipelined FIFO order-matching" << std::endl;
+    }
+    else
+    {
+        std::cout << "Initiating pipelined Pro-Rata order-matching" << std::endl;
+    }
+
+    // Only the calling thread (the producer) is counted, the stages run on their own threads
+    if(perfCounters) perfCounters->start();
+    pipeline.run(parsedOrders, journalPath);
+    if(perfCounters) perfCounters->stop("pipeline", parsedOrders.size());
+
+    std::cout << "\nDisplaying remaining contents of the order book:" << std::endl;
+    pipeline.getOrderbook().printOrderbookContents();
+}
+
+/**--------------------------------------------------------------------------------------
+ * runPrimary()
+ * 
+ * Waits for a secondary, then adds and matches the parsed orders one at a time, in the
+ * order of the CSV file, replicating each of them before applying it. Prints the fills,
+ * the remaining contents of the order book and the time spent replicating
+ * 
+ * @param[in] argv          String vector of arguments passed
+ * @param[in] parsedOrders  Every order read from the CSV file
+ * @param[in] choice        Choice of algorithm (1 for FIFO, 2 for Pro-Rata)
+ * @param[in] port          TCP port the secondary connects to
+ * --------------------------------------------------------------------------------------
+*/
+void runPrimary(const char** argv, const std::vector<Order>& parsedOrders, int choice, int port)
+{
+    void (Orderbook::*matcher)() = (FIFOCHOICE == choice) ? &Orderbook::matchOrdersFIFO : &Orderbook::matchOrdersProRata;
+    Orderbook myOrderbook(argv[2]);
+    myOrderbook.reserve(parsedOrders.size(), parsedOrders.size());
+
+    ReplicationPrimary primary;
+    if(!primary.start(port, argv[2], choice))
+    {
+        return;
+    }
+
+    std::cout << "Initiating replicated " << ((FIFOCHOICE == choice) ? "FIFO" : "Pro-Rata") << " order-matching" << std::endl;
+
+    uint64_t sequence = 0;
+    std::chrono::steady_clock::duration replicationTime(0);
+    for(const Order& curOrder : parsedOrders)
+    {
+        Replication::ReplicatedEvent event = Replication::makeAddEvent(++sequence, curOrder);
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        primary.append(event);
+        replicationTime += std::chrono::steady_clock::now() - begin;
+
+        Replication::applyEvent(event, argv[2], myOrderbook, matcher);
+    }
+
+    myOrderbook.printOrderHistory();
+
+    std::cout << "\nDisplaying remaining contents of the order book:" << std::endl;
+    myOrderbook.printOrderbookContents();
+
+    if(sequence > 0)
+    {
+        std::cout << "\nReplication cost at the primary: " << std::chrono::duration_cast<std::chrono::nanoseconds>(replicationTime).count() / sequence \
+                  << " ns per event" << std::endl;
+    }
+
+    if(primary.waitForAcknowledgement(sequence))
+    {
+        std::cout << "Secondary applied all " << sequence << " events" << std::endl;
+    }
+    else
+    {
+        std::cerr << "ERROR: The secondary disconnected before applying all " << sequence << " events" << std::endl;
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * runSecondary()
+ * 
+ * Replicates the order book of a primary until the primary goes away, then takes over by
+ * printing the order book it now owns
+ * 
+ * @param[in] primaryAddress    Host and port of the primary, e.g. "localhost:9000"
+ * @return exit code of the program
+ * --------------------------------------------------------------------------------------
+*/
+int runSecondary(const char* primaryAddress)
+{
+    std::string address = primaryAddress;
+    size_t separator = address.rfind(':');
+    if(separator == std::string::npos)
+    {
+        std::cerr << "ERROR: Expected the primary as <host>:<port>, got " << address << std::endl;
+        return -1;
+    }
+
+    ReplicationSecondary secondary;
+    if(!secondary.connectTo(address.substr(0, separator), atoi(address.c_str() + separator + 1)))
+    {
+        return -1;
+    }
+
+    std::cout << "Replicating the " << secondary.getTicker() << " order book of " << address << std::endl;
+
+    Orderbook myOrderbook(secondary.getTicker());
+    uint64_t lastSequence = secondary.applyUntilDisconnected(myOrderbook);
+
+    std::cout << "Primary gone after event " << lastSequence << ", taking over" << std::endl;
+    std::cout << "\nDisplaying remaining contents of the order book:" << std::endl;
+    myOrderbook.printOrderbookContents();
+
+    std::cout << "\nProgram finished" <<std::endl;
+
+    return 0;
+}
+
+/**--------------------------------------------------------------------------------------
+ * runEncode()
+ * 
+ * Compresses an order file and reports the size before and after
+ * 
+ * @param[in] outputPath    Compressed order file to be written
+ * @param[in] inputPath     CSV (or compressed) order file to be read
+ * @return exit code of the program
+ * --------------------------------------------------------------------------------------
+*/
+int runEncode(const char* outputPath, const char* inputPath)
+{
+    std::vector<Order> parsedOrders;
+    if(!OrderReader::readOrderFile(inputPath, parsedOrders))
+    {
+        return -1;
+    }
+
+    CompressedOrderWriter writer;
+    if(!writer.open(outputPath))
+    {
+        return -1;
+    }
+
+    for(const Order& curOrder : parsedOrders)
+    {
+        writer.add(curOrder);
+    }
+
+    if(!writer.close())
+    {
+        std::cerr << "ERROR: Could not write " << outputPath << std::endl;
+        return -1;
+    }
+
+    std::ifstream inputFile(inputPath, std::ios::binary | std::ios::ate);
+    long long inputBytes = (long long)inputFile.tellg();
+
+    std::cout << "Compressed " << parsedOrders.size() << " orders from " << inputBytes << " to " << writer.getNumBytes() << " bytes";
+    if(writer.getNumBytes() > 0)
+    {
+        std::cout << " (" << std::fixed << std::setprecision(1) << (double)inputBytes / writer.getNumBytes() << "x)";
+    }
+    std::cout << std::endl;
+
+    return 0;
+}
+
+/**--------------------------------------------------------------------------------------
+ * runItch()
+ * 
+ * Builds the order book of every stock of an ITCH 5.0 file and reports how fast the
+ * messages were applied
+ * 
+ * @param[in] itchPath  ITCH 5.0 file to be replayed
+ * @return exit code of the program
+ * --------------------------------------------------------------------------------------
+*/
+int runItch(const char* itchPath)
+{
+    ItchReplay replay;
+    if(!replay.open(itchPath))
+    {
+        return -1;
+    }
+
+    bool isComplete = replay.run();
+    replay.printSummary(ITCH_BOOKS_LISTED);
+
+    std::cout << "\nProgram finished" <<std::endl;
+
+    return isComplete ? 0 : -1;
+}
+
+/**--------------------------------------------------------------------------------------
+ * runImplied()
+ * 
+ * Adds the orders of every ticker of a CSV file one at a time, in the order of the file,
+ * to the order book of their ticker, a ticker A-B being the calendar spread buying A and
+ * selling B. Each order is matched with FIFO in its own order book, then against the
+ * prices implied by the linked order books. Prints the fills, the implied matches and the
+ * remaining contents and implied prices of every order book
+ * 
+ * @param[in] csvPath   File containing the orders of the outrights and spreads
+ * @return exit code of the program
+ * --------------------------------------------------------------------------------------
+*/
+int runImplied(const char* csvPath)
+{
+    std::vector<Order> parsedOrders;
+    if(!OrderReader::readOrderFile(csvPath, parsedOrders))
+    {
+        return -1;
+    }
+
+    ImpliedEngine engine;
+
+    std::cout << "Initiating FIFO order-matching with implied prices between outrights and spreads" << std::endl;
+
+    for(const Order& curOrder : parsedOrders)
+    {
+        int book = engine.findOrAddBook(curOrder.getTicker());
+        if(book != -1)
+        {
+            engine.addOrder(book, curOrder);
+        }
+    }
+
+    engine.printFills();
+
+    std::cout << "\nDisplaying remaining contents of the order books:" << std::endl;
+    engine.printBookContents();
+
+    std::cout << "\nProgram finished" <<std::endl;
+
+    return 0;
+}
+
+/**--------------------------------------------------------------------------------------
+ * parseComboLegs()
+ * 
+ * Reads the legs of a combo order from its ticker, a sum of the tickers of its legs, each
+ * optionally preceded by its ratio, e.g. C100+2*C105-P95 buys 1 C100, buys 2 C105 and
+ * sells 1 P95 for every unit of the combo bought
+ * 
+ * @param[in]       ticker  Ticker of the combo order
+ * @param[in,out]   legs    Ticker and ratio of every leg are appended to it
+ * @return true if every leg has a ticker and a positive ratio
+ * --------------------------------------------------------------------------------------
+*/
+bool parseComboLegs(const std::string& ticker, std::vector<std::pair<std::string, int>>& legs)
+{
+    size_t legBegin = 0;
+    while(legBegin < ticker.size())
+    {
+        int sign = 1;
+        if(ticker[legBegin] == '+' || ticker[legBegin] == '-')
+        {
+            sign = (ticker[legBegin] == '-') ? -1 : 1;
+            legBegin++;
+        }
+
+        size_t legEnd = std::min(ticker.find_first_of("+-", legBegin), ticker.size());
+        std::string legTicker = ticker.substr(legBegin, legEnd - legBegin);
+        int ratio = 1;
+
+        size_t separator = legTicker.find('*');
+        if(separator != std::string::npos)
+        {
+            ratio = atoi(legTicker.substr(0, separator).c_str());
+            legTicker = legTicker.substr(separator + 1);
+        }
+
+        if(legTicker.empty() || ratio <= 0)
+        {
+            std::cerr << "ERROR: Combo " << ticker << " has a leg without a ticker or a positive ratio" << std::endl;
+            return false;
+        }
+
+        legs.emplace_back(legTicker, sign * ratio);
+        legBegin = legEnd;
+    }
+
+    return !legs.empty();
+}
+
+/**--------------------------------------------------------------------------------------
+ * runCombos()
+ * 
+ * Adds the orders of every ticker of a CSV file one at a time, in the order of the file.
+ * Orders of a single instrument go to its order book and are matched with FIFO, orders
+ * whose ticker lists several legs (see parseComboLegs()) are combo orders, executed
+ * all-or-none against the order books of their legs. Prints the fills of every order
+ * book, the executed combos and what is left resting
+ * 
+ * @param[in] csvPath   File containing the orders of the instruments and combos
+ * @return exit code of the program
+ * --------------------------------------------------------------------------------------
+*/
+int runCombos(const char* csvPath)
+{
+    std::vector<Order> parsedOrders;
+    if(!OrderReader::readOrderFile(csvPath, parsedOrders))
+    {
+        return -1;
+    }
+
+    // Combo legs keep pointers to the order books, which therefore never move
+    std::vector<std::unique_ptr<Orderbook>> books;
+    auto findOrAddBook = [&books](const std::string& ticker)
+    {
+        auto found = std::find_if(books.begin(), books.end(), [&ticker](const std::unique_ptr<Orderbook>& book) { return book->getTicker() == ticker; });
+        if(found != books.end())
+        {
+            return found->get();
+        }
+        books.emplace_back(new Orderbook(ticker));
+        return books.back().get();
+    };
+
+    ComboBook combos;
+    std::vector<std::pair<std::string, int>> legTickers;
+    std::vector<ComboLeg> legs;
+
+    std::cout << "Initiating FIFO order-matching with all-or-none combo orders" << std::endl;
+
+    for(const Order& curOrder : parsedOrders)
+    {
+        const std::string& ticker = curOrder.getTicker();
+
+        if(ticker.find_first_of("+-*") == std::string::npos)
+        {
+            Orderbook* book = findOrAddBook(ticker);
+            if(book->addOrder(curOrder))
+            {
+                book->matchOrdersFIFO();
+                combos.onLegUpdate(*book);
+            }
+            continue;
+        }
+
+        legTickers.clear();
+        legs.clear();
+        if(parseComboLegs(ticker, legTickers))
+        {
+            for(const std::pair<std::string, int>& curLeg : legTickers)
+            {
+                legs.emplace_back(findOrAddBook(curLeg.first), curLeg.second);
+            }
+            combos.addOrder(curOrder, legs);
+        }
+    }
+
+    for(const std::unique_ptr<Orderbook>& book : books)
+    {
+        if(!book->getOrderHistory().empty())
+        {
+            std::cout << "    " << book->getTicker() << ":" << std::endl;
+            book->printOrderHistory();
+        }
+    }
+    combos.printFills();
+
+    std::cout << "\nDisplaying remaining contents of the order books:" << std::endl;
+    for(const std::unique_ptr<Orderbook>& book : books)
+    {
+        std::cout << "\n" << book->getTicker() << ":" << std::endl;
+        book->printOrderbookContents();
+    }
+
+    std::cout << "\nDisplaying resting combo orders:" << std::endl;
+    combos.printBookContents();
+
+    std::cout << "\nProgram finished" <<std::endl;
+
+    return 0;
+}
+
+/**--------------------------------------------------------------------------------------
+ * stopServing()
+ * 
+ * Signal handler asking runServer() to stop
+ * 
+ * @param[in] signalNumber  Signal received
+ * --------------------------------------------------------------------------------------
+*/
+extern "C" void stopServing(int signalNumber)
+{
+    (void)signalNumber;
+    isStopping = 1;
+}
+
+/**--------------------------------------------------------------------------------------
+ * runServer()
+ * 
+ * Creates a shared-memory order-entry segment and submits the orders of its clients to an
+ * order book, matching after every order, or in an auction at the end of every interval
+ * with batch auctions, until interrupted
+ * 
+ * @param[in] segmentName       Name of the segment, e.g. "/orders" for /dev/shm/orders
+ * @param[in] ticker            Ticker of the order book
+ * @param[in] choice            Choice of algorithm (1 for FIFO, 2 for Pro-Rata, 4 for batch
+ *                              auctions)
+ * @param[in] feedSegment       Name of the segment to publish the market-by-order feed into,
+ *                              nullptr for no feed
+ * @param[in] auctionInterval   Milliseconds between two batch auctions
+ * @param[in] priceBands        Value of --price-bands=, nullptr for no price bands
+ * @param[in] rateLimits        Value of --rate-limit=, nullptr for no rate limits
+ * @param[in] watermark         Value of --watermark=, nullptr for no watermark
+ * @return exit code of the program
+ * --------------------------------------------------------------------------------------
+*/
+int runServer(const char* segmentName, const char* ticker, int choice, const char* feedSegment, int auctionInterval, const char* priceBands,
+              const char* rateLimits, const char* watermark)
+{
+    // Batch auctions only accept orders while draining, the book is matched on the clock instead
+    void (Orderbook::*matcher)() = (FIFOCHOICE == choice) ? &Orderbook::matchOrdersFIFO : &Orderbook::matchOrdersProRata;
+    if(AUCTIONCHOICE == choice)
+    {
+        matcher = nullptr;
+    }
+
+    Orderbook myOrderbook(ticker);
+    ShmOrderEntryServer server(ticker);
+    MarketByOrderPublisher feed(ticker);
+    applyPriceBands(priceBands, myOrderbook);
+
+    if(rateLimits != nullptr)
+    {
+        std::istringstream curString(rateLimits);
+        std::string sessionRate = "", accountRate = "", burst = "";
+        std::getline(curString, sessionRate, ',');
+        std::getline(curString, accountRate, ',');
+        std::getline(curString, burst, ',');
+        server.setRateLimits((unsigned int)atoi(sessionRate.c_str()), (unsigned int)atoi(accountRate.c_str()),
+                             burst.empty() ? DEFAULT_RATE_BURST : (unsigned int)atoi(burst.c_str()));
+    }
+    if(watermark != nullptr)
+    {
+        server.setQueueWatermark((size_t)std::max(atoi(watermark), 0));
+    }
+
+    if(!server.create(segmentName))
+    {
+        return -1;
+    }
+
+    if(feedSegment != nullptr)
+    {
+        if(!feed.create(feedSegment))
+        {
+            return -1;
+        }
+        myOrderbook.setFeed(&feed);
+    }
+
+    std::signal(SIGINT, stopServing);
+    std::signal(SIGTERM, stopServing);
+
+    std::cout << "Accepting orders on shared-memory segment " << segmentName << std::endl;
+
+    const std::chrono::milliseconds interval(auctionInterval);
+    std::chrono::steady_clock::time_point nextAuction = std::chrono::steady_clock::now() + interval;
+    size_t numAuctions = 0;
+
+    // Polling without ever sleeping, the engine owns its core while serving
+    while(!isStopping)
+    {
+        server.drain(myOrderbook, matcher, SERVE_BATCH_SIZE);
+
+        if(AUCTIONCHOICE == choice && std::chrono::steady_clock::now() >= nextAuction)
+        {
+            myOrderbook.matchOrdersAuction();
+            myOrderbook.clearOrderHistory();
+            numAuctions++;
+            nextAuction += interval;
+        }
+    }
+
+    std::cout << "\nHandled " << server.getNumRequests() << " requests, dropped " << server.getNumDroppedResponses() << " responses, cancelled " \
+              << server.getNumCancelledOnDetach() << " orders of detached clients" << std::endl;
+    if(rateLimits != nullptr || watermark != nullptr)
+    {
+        std::cout << "Rejected " << server.getNumThrottled() << " orders over the rate limits and " << server.getNumShed() << " orders above the queue watermark" << std::endl;
+    }
+    if(AUCTIONCHOICE == choice)
+    {
+        std::cout << "Ran " << numAuctions << " batch auctions" << std::endl;
+    }
+    if(priceBands != nullptr)
+    {
+        std::cout << "Halted " << myOrderbook.getNumHalts() << " times by the price bands" << std::endl;
+    }
+    if(feedSegment != nullptr)
+    {
+        std::cout << "Published " << feed.getNumMessages() << " market-by-order messages on " << feedSegment << std::endl;
+    }
+    std::cout << "\nDisplaying remaining contents of the order book:" << std::endl;
+    myOrderbook.printOrderbookContents();
+
+    std::cout << "\nProgram finished" <<std::endl;
+
+    return 0;
+}
+
+/**--------------------------------------------------------------------------------------
+ * runPing()
+ * 
+ * Measures round trips through the shared-memory segment of a running engine: adds
+ * non-crossing orders one at a time, cancelling each right after it is accepted, and waits
+ * for every response before sending the next request
+ * 
+ * @param[in] segmentName   Name the engine created the segment with
+ * @param[in] numOrders     Number of orders to be added and cancelled
+ * @return exit code of the program
+ * --------------------------------------------------------------------------------------
+*/
+int runPing(const char* segmentName, int numOrders)
+{
+    ShmOrderEntryClient client;
+
+    if(!client.attach(segmentName))
+    {
+        return -1;
+    }
+
+    std::vector<long long> roundTrips;
+    roundTrips.reserve(2 * (size_t)numOrders);
+
+    ShmTransport::OrderRequest request = {};
+    ShmTransport::OrderResponse response;
+    int numRejected = 0;
+
+    for(int i = 0; i < 2 * numOrders; i++)
+    {
+        request.clientSequence = i;
+        request.orderID = i / 2 + 1;
+        request.type = (i % 2 == 0) ? ShmTransport::ADD_ORDER : ShmTransport::CANCEL_ORDER;
+        request.isBuy = true;
+        request.priceTicks = 1;
+        request.amount = 1;
+
+        std::chrono::steady_clock::time_point sent = std::chrono::steady_clock::now();
+        while(!client.submit(request)) {}
+        while(!client.poll(response) || response.clientSequence != request.clientSequence) {}
+        roundTrips.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sent).count());
+        numRejected += (response.status == ShmTransport::REJECTED) ? 1 : 0;
+    }
+
+    std::sort(roundTrips.begin(), roundTrips.end());
+    std::cout << roundTrips.size() << " round trips through " << segmentName << " (ns): median " << roundTrips[roundTrips.size() / 2] \
+              << ", 99th percentile " << roundTrips[roundTrips.size() * 99 / 100] << ", max " << roundTrips.back() << std::endl;
+    if(numRejected > 0)
+    {
+        std::cout << numRejected << " orders rejected by the engine, e.g. by its rate limits" << std::endl;
+    }
+
+    return 0;
+}
+
+/**--------------------------------------------------------------------------------------
+ * runWatch()
+ * 
+ * Prints every message of the market-by-order feed of a running engine until interrupted
+ * 
+ * @param[in] segmentName   Name the engine created the feed segment with
+ * @return exit code of the program
+ * --------------------------------------------------------------------------------------
+*/
+int runWatch(const char* segmentName)
+{
+    const char* const TYPE_NAMES[] = { "ADD", "MODIFY", "DELETE", "EXECUTE" };
+
+    MarketByOrderSubscriber subscriber;
+    if(!subscriber.attach(segmentName))
+    {
+        return -1;
+    }
+
+    std::signal(SIGINT, stopServing);
+    std::signal(SIGTERM, stopServing);
+
+    std::cout << "Watching the " << subscriber.getTicker() << " market-by-order feed on " << segmentName << std::endl;
+
+    MarketByOrder::FeedMessage message;
+    while(!isStopping)
+    {
+        if(!subscriber.poll(message))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::cout << "    " << message.sequence << "   " << std::left << std::setw(7) << TYPE_NAMES[message.type] << std::right << "#" << message.orderID \
+                  << (message.isBuy ? "   BUY    " : "   SELL   ") << std::fixed << std::setprecision(2) << Order::ticksToPrice(message.priceTicks) \
+                  << "   Amount: " << message.amount << "   Remaining: " << message.remainingAmount << std::endl;
+    }
+
+    std::cout << "\nLost " << subscriber.getNumLost() << " messages the engine overwrote before they were read" << std::endl;
+
+    return 0;
+}
+
+int main(int argc, const char** argv)
+{
+    if(argc >= 2 && matchesOption(argv[1], BACKTEST_OPTION))
+    {
+        unsigned int numWorkers = (argc >= 3) ? (unsigned int)atoi(argv[2]) : 0;
+        return runBacktest(argv[1] + std::strlen(BACKTEST_OPTION), numWorkers);
+    }
+
+    if(argc >= 4 && matchesOption(argv[1], SERVE_OPTION))
+    {
+        int choice = atoi(argv[3]);
+        if(choice != FIFOCHOICE && choice != PRORATACHOICE && choice != AUCTIONCHOICE)
+        {
+            std::cerr << "ERROR: Invalid choice of algorithm, please pick from the following (FIFO: 1, Pro-Rata: 2, Batch auctions: 4)" << std::endl;
+            return -1;
+        }
+
+        const char* intervalValue = getOptionValue(argc, argv, BATCH_INTERVAL_OPTION);
+        const int auctionInterval = std::max((intervalValue != nullptr) ? atoi(intervalValue) : DEFAULT_BATCH_INTERVAL, 1);
+        return runServer(argv[1] + std::strlen(SERVE_OPTION), argv[2], choice, getOptionValue(argc, argv, FEED_OPTION), auctionInterval,
+                         getOptionValue(argc, argv, PRICE_BANDS_OPTION),
+                         getOptionValue(argc, argv, RATE_LIMIT_OPTION), getOptionValue(argc, argv, WATERMARK_OPTION));
+    }
+
+    if(argc >= 3 && matchesOption(argv[1], ENCODE_OPTION))
+    {
+        return runEncode(argv[1] + std::strlen(ENCODE_OPTION), argv[2]);
+    }
+
+    if(argc >= 2 && matchesOption(argv[1], ITCH_OPTION))
+    {
+        return runItch(argv[1] + std::strlen(ITCH_OPTION));
+    }
+
+    if(argc >= 2 && matchesOption(argv[1], IMPLIED_OPTION))
+    {
+        return runImplied(argv[1] + std::strlen(IMPLIED_OPTION));
+    }
+
+    if(argc >= 2 && matchesOption(argv[1], COMBOS_OPTION))
+    {
+        return runCombos(argv[1] + std::strlen(COMBOS_OPTION));
+    }
+
+    if(argc >= 2 && matchesOption(argv[1], SECONDARY_OPTION))
+    {
+        return runSecondary(argv[1] + std::strlen(SECONDARY_OPTION));
+    }
+
+    if(argc >= 2 && matchesOption(argv[1], WATCH_OPTION))
+    {
+        return runWatch(argv[1] + std::strlen(WATCH_OPTION));
+    }
+
+    if(argc >= 2 && matchesOption(argv[1], PING_OPTION))
+    {
+        int numOrders = (argc >= 3) ? atoi(argv[2]) : PING_ORDERS;
+        return runPing(argv[1] + std::strlen(PING_OPTION), std::max(numOrders, 1));
+    }
+
+    if(printUsage(argc, argv))
+    {
+        return -1;
+    }
+
+    std::vector<int> choices = parseChoices(argv[3]);
+    int choice = choices.front();
+    void (Orderbook::*matcher)() = (PRORATACHOICE == choice) ? &Orderbook::matchOrdersProRata : &Orderbook::matchOrdersFIFO;
+    if(AUCTIONCHOICE == choice)
+    {
+        matcher = &Orderbook::matchOrdersAuction;
+    }
+
+    if(hasOption(argc, argv, MLOCK_OPTION) && !Warmup::lockMemory())
+    {
+        return -1;
+    }
+
+    // Built with the counting allocator, refusing to run if the matching hot path allocates in its steady state
+    if(AllocationCounter::isEnabled() && !checkSteadyStateAllocations(matcher))
+    {
+        return -1;
+    }
+
+    // Only opening the counters if asked to, each stage below is measured if perfCounters is set
+    std::unique_ptr<PerfCounters> perfCounters;
+    if(hasOption(argc, argv, PERF_OPTION))
+    {
+        perfCounters.reset(new PerfCounters());
+    }
+
+    const char* tracePath = getOptionValue(argc, argv, TRACE_OPTION);
+    if(tracePath != nullptr)
+    {
+        Tracer::enable();
+    }
+
+    std::vector<Order> parsedOrders;
+
+    if(perfCounters) perfCounters->start();
+    OrderReader::readOrderFile(argv[1], parsedOrders);
+    if(perfCounters) perfCounters->stop("parse", parsedOrders.size());
+
+    if(choices.size() > 1)  // User chose to compare several algorithms on the same orders
+    {
+        if(perfCounters) perfCounters->start();
+        AlgorithmComparison comparison(argv[2], parsedOrders);
+        comparison.run(choices);
+        if(perfCounters) perfCounters->stop("compare", parsedOrders.size());
+
+        comparison.printReport();
+    }
+    else if(MIDPOINTCHOICE == choice)  // User chose to cross the market orders in a midpoint dark pool
+    {
+        runMidpointPool(argc, argv, parsedOrders, perfCounters.get());
+    }
+    else if(AUCTIONCHOICE == choice)  // User chose to clear the orders in batch auctions
+    {
+        runBatchAuctions(argc, argv, parsedOrders, perfCounters.get());
+    }
+    else if(hasOption(argc, argv, PRIMARY_OPTION))  // User chose to replicate every order to a secondary
+    {
+        runPrimary(argv, parsedOrders, choice, atoi(getOptionValue(argc, argv, PRIMARY_OPTION)));
+    }
+    else if(hasOption(argc, argv, PIPELINE_OPTION))  // User chose to match every order as it arrives
+    {
+        runPipeline(argv, parsedOrders, choice, getOptionValue(argc, argv, PIPELINE_OPTION), perfCounters.get());
+    }
+    else
+    {
+        runSingleAlgorithm(argc, argv, parsedOrders, choice, perfCounters.get());
+    }
+
+    if(perfCounters)
+    {
+        std::cout << "\nHardware performance counters per stage:" << std::endl;
+        perfCounters->printReport();
+    }
+
+    if(tracePath != nullptr && !Tracer::writeChromeTrace(tracePath))
+    {
+        std::cerr << "ERROR: Could not write the trace to " << tracePath << std::endl;
+    }
 
     std::cout << "\nProgram finished" <<std::endl;
 
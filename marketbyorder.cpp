@@ -0,0 +1,357 @@
+/*marketbyorder.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the MarketByOrderPublisher and MarketByOrderSubscriber classes
+ *     Order-by-order (level 3) market data feed of an order book, published into a ring in a
+ *     POSIX shared-memory segment (/dev/shm) for consumers on the same host
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <cstring>
+#include <cerrno>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "marketbyorder.h"
+
+namespace MarketByOrder
+{
+    const uint64_t SEGMENT_MAGIC = 0x4f4d454d424f4645ULL;  // "OMEMBOFE"
+    const size_t CACHE_LINE_SIZE = 64;
+    const size_t TICKER_LENGTH = 16;
+    const size_t WORDS_PER_MESSAGE = sizeof(FeedMessage) / sizeof(uint64_t);
+
+    // A slot holding the message of a sequence has version 2 * sequence, and 2 * sequence - 1 while it
+    // is being written. The message is copied word by word, so that a torn read is caught by the version
+    typedef struct alignas(CACHE_LINE_SIZE) FeedSlot
+    {
+        std::atomic<uint64_t> version;
+        std::atomic<uint64_t> words[WORDS_PER_MESSAGE];
+    } FeedSlot;
+
+    typedef struct FeedSegment
+    {
+        uint64_t magic;
+        char ticker[TICKER_LENGTH];
+        std::atomic<uint32_t> isReady;
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> lastSequence;   // Sequence of the last message published
+        FeedSlot slots[FEED_RING_SIZE];
+    } FeedSegment;
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+                  "Atomics shared between processes have to be lock-free");
+    static_assert((FEED_RING_SIZE & (FEED_RING_SIZE - 1)) == 0, "The ring size has to be a power of 2");
+}
+
+using namespace MarketByOrder;
+
+namespace {
+    /**--------------------------------------------------------------------------------------
+     * mapFeedSegment()
+     * 
+     * Opens and maps a shared-memory segment the size of a FeedSegment
+     * 
+     * @param[in] segmentName   Name of the segment
+     * @param[in] isCreating    True to create (or replace) the segment, false to open an
+     *                          existing one
+     * @return the mapped segment, or nullptr on error
+     * --------------------------------------------------------------------------------------
+    */
+    FeedSegment* mapFeedSegment(const std::string& segmentName, bool isCreating)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        if(isCreating)
+        {
+            shm_unlink(segmentName.c_str());
+        }
+
+        int fd = shm_open(segmentName.c_str(), isCreating ? (O_CREAT | O_EXCL | O_RDWR) : O_RDWR, 0600);
+        if(fd < 0)
+        {
+            std::cerr << "ERROR - mapFeedSegment(): shm_open of " << segmentName << " failed: " << std::strerror(errno) << std::endl;
+            return nullptr;
+        }
+
+        if(isCreating && ftruncate(fd, sizeof(FeedSegment)) != 0)
+        {
+            std::cerr << "ERROR - mapFeedSegment(): ftruncate of " << segmentName << " failed: " << std::strerror(errno) << std::endl;
+            close(fd);
+            return nullptr;
+        }
+
+        void* address = mmap(nullptr, sizeof(FeedSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if(address == MAP_FAILED)
+        {
+            std::cerr << "ERROR - mapFeedSegment(): mmap of " << segmentName << " failed: " << std::strerror(errno) << std::endl;
+            return nullptr;
+        }
+
+        return static_cast<FeedSegment*>(address);
+#else
+        (void)isCreating;
+        std::cerr << "ERROR - mapFeedSegment(): shared memory " << segmentName << " is not supported on this platform" << std::endl;
+        return nullptr;
+#endif
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * unmapFeedSegment()
+     * 
+     * Unmaps a segment mapped by mapFeedSegment()
+     * 
+     * @param[in] segment   Mapped segment
+     * --------------------------------------------------------------------------------------
+    */
+    void unmapFeedSegment(FeedSegment* segment)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        munmap(segment, sizeof(FeedSegment));
+#else
+        (void)segment;
+#endif
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * oldestSequence()
+     * 
+     * @param[in] lastSequence  Sequence of the last message published
+     * @return the sequence of the oldest message still in the ring
+     * --------------------------------------------------------------------------------------
+    */
+    uint64_t oldestSequence(uint64_t lastSequence)
+    {
+        return (lastSequence >= FEED_RING_SIZE) ? lastSequence - FEED_RING_SIZE + 1 : 1;
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * Constructor
+ * 
+ * Creates a publisher without any segment
+ * 
+ * @param[in] ticker    Ticker of the order book the feed is published for
+ * --------------------------------------------------------------------------------------
+*/
+MarketByOrderPublisher::MarketByOrderPublisher(std::string ticker)
+    : m_ticker(ticker)
+{}
+
+/**--------------------------------------------------------------------------------------
+ * Destructor
+ * 
+ * Unmaps and removes the segment
+ * --------------------------------------------------------------------------------------
+*/
+MarketByOrderPublisher::~MarketByOrderPublisher()
+{
+    if(m_segment != nullptr)
+    {
+        unmapFeedSegment(m_segment);
+#if defined(__unix__) || defined(__APPLE__)
+        shm_unlink(m_segmentName.c_str());
+#endif
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * create()
+ * 
+ * Creates the shared-memory segment consumers attach to, replacing any left over segment
+ * of the same name
+ * 
+ * @param[in] segmentName   Name of the segment, e.g. "/feed" for /dev/shm/feed
+ * @return true if the segment was created, false on error or on platforms without
+ *         POSIX shared memory
+ * --------------------------------------------------------------------------------------
+*/
+bool MarketByOrderPublisher::create(const std::string& segmentName)
+{
+    m_segment = mapFeedSegment(segmentName, true);
+    if(m_segment == nullptr)
+    {
+        return false;
+    }
+    m_segmentName = segmentName;
+
+    // The new mapping is zero-filled, constructing the atomics in place before any consumer can see them
+    new (m_segment) FeedSegment();
+    m_segment->magic = SEGMENT_MAGIC;
+    std::strncpy(m_segment->ticker, m_ticker.c_str(), TICKER_LENGTH - 1);
+    m_segment->isReady.store(1, std::memory_order_release);
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * publish()
+ * 
+ * Writes the next message of the feed
+ * 
+ * @param[in] type              Kind of change to the order
+ * @param[in] orderID           ID of the order
+ * @param[in] isBuy             Side of the order
+ * @param[in] priceTicks        Price level of the order
+ * @param[in] amount            Amount added, taken away, removed or filled
+ * @param[in] remainingAmount   Amount of the order left resting afterwards
+ * @param[in] time              Time of the order
+ * --------------------------------------------------------------------------------------
+*/
+void MarketByOrderPublisher::publish(MessageType type, int orderID, bool isBuy, int priceTicks, int amount, int remainingAmount, int time)
+{
+    if(m_segment == nullptr)
+    {
+        return;
+    }
+
+    FeedMessage message = {};
+    message.sequence = ++m_sequence;
+    message.orderID = orderID;
+    message.priceTicks = priceTicks;
+    message.amount = amount;
+    message.remainingAmount = remainingAmount;
+    message.time = time;
+    message.type = type;
+    message.isBuy = isBuy;
+
+    uint64_t words[WORDS_PER_MESSAGE];
+    std::memcpy(words, &message, sizeof(message));
+
+    FeedSlot& slot = m_segment->slots[(m_sequence - 1) & (FEED_RING_SIZE - 1)];
+    slot.version.store(2 * m_sequence - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for(size_t i = 0; i < WORDS_PER_MESSAGE; i++)
+    {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    slot.version.store(2 * m_sequence, std::memory_order_release);
+    m_segment->lastSequence.store(m_sequence, std::memory_order_release);
+}
+
+/**--------------------------------------------------------------------------------------
+ * Destructor
+ * 
+ * Unmaps the segment
+ * --------------------------------------------------------------------------------------
+*/
+MarketByOrderSubscriber::~MarketByOrderSubscriber()
+{
+    if(m_segment != nullptr)
+    {
+        unmapFeedSegment(m_segment);
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * attach()
+ * 
+ * Maps the segment of a running engine, starting at the oldest message still in its ring
+ * 
+ * @param[in] segmentName   Name the engine created the segment with, e.g. "/feed"
+ * @return true if attached, false if the segment does not exist
+ * --------------------------------------------------------------------------------------
+*/
+bool MarketByOrderSubscriber::attach(const std::string& segmentName)
+{
+    FeedSegment* segment = mapFeedSegment(segmentName, false);
+    if(segment == nullptr)
+    {
+        return false;
+    }
+
+    if(segment->isReady.load(std::memory_order_acquire) != 1 || segment->magic != SEGMENT_MAGIC)
+    {
+        std::cerr << "ERROR - attach(): " << segmentName << " is not a market-by-order feed segment" << std::endl;
+        unmapFeedSegment(segment);
+        return false;
+    }
+
+    m_segment = segment;
+    m_ticker.assign(segment->ticker, strnlen(segment->ticker, TICKER_LENGTH));
+    m_nextSequence = oldestSequence(segment->lastSequence.load(std::memory_order_acquire));
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * poll()
+ * 
+ * Takes the next message of the feed, if any. If the engine overwrote messages this
+ * subscriber had not read yet, they are skipped and counted by getNumLost()
+ * 
+ * @param[out] message  Message received
+ * @return true if a message was received
+ * --------------------------------------------------------------------------------------
+*/
+bool MarketByOrderSubscriber::poll(FeedMessage& message)
+{
+    while(true)
+    {
+        const FeedSlot& slot = m_segment->slots[(m_nextSequence - 1) & (FEED_RING_SIZE - 1)];
+        const uint64_t expectedVersion = 2 * m_nextSequence;
+
+        uint64_t versionBefore = slot.version.load(std::memory_order_acquire);
+        if(versionBefore < expectedVersion)
+        {
+            return false;   // Not published yet, or still being written
+        }
+
+        if(versionBefore == expectedVersion)
+        {
+            uint64_t words[WORDS_PER_MESSAGE];
+            for(size_t i = 0; i < WORDS_PER_MESSAGE; i++)
+            {
+                words[i] = slot.words[i].load(std::memory_order_relaxed);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(slot.version.load(std::memory_order_relaxed) == versionBefore)
+            {
+                std::memcpy(&message, words, sizeof(message));
+                m_nextSequence++;
+                return true;
+            }
+        }
+
+        // The message was overwritten a full ring later, skipping to the oldest message still in the ring
+        uint64_t oldest = std::max(oldestSequence(m_segment->lastSequence.load(std::memory_order_acquire)), m_nextSequence + 1);
+        m_numLost += oldest - m_nextSequence;
+        m_nextSequence = oldest;
+    }
+}
@@ -0,0 +1,231 @@
+/*marketbyorder.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the MarketByOrderPublisher and MarketByOrderSubscriber classes
+ *     Order-by-order (level 3) market data feed of an order book, published into a ring in a
+ *     POSIX shared-memory segment (/dev/shm) for consumers on the same host
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace MarketByOrder
+{
+    const uint32_t FEED_RING_SIZE = 65536;  // Messages kept in the ring before the oldest is overwritten (power of 2)
+
+    enum MessageType : uint8_t
+    {
+        ORDER_ADDED,        // amount and remainingAmount are the amount of the new order
+        ORDER_MODIFIED,     // amount was taken away without a trade (negative if the order grew), the order now rests at priceTicks
+                            // with remainingAmount, and kept its time priority only if neither its price changed nor it grew
+        ORDER_DELETED,      // amount was resting when the order was removed, remainingAmount is 0
+        ORDER_EXECUTED      // amount was filled by a trade, the order is gone once remainingAmount is 0
+    };
+
+    /**--------------------------------------------------------------------------------------
+     * FeedMessage struct
+     * 
+     * One change to one resting order, copied as is through shared memory
+     * --------------------------------------------------------------------------------------
+    */
+    typedef struct FeedMessage
+    {
+        uint64_t sequence;          // 1 for the first message of the feed, without gaps
+        int32_t orderID;
+        int32_t priceTicks;
+        int32_t amount;
+        int32_t remainingAmount;
+        int32_t time;               // Time of the order itself, which sets its time priority
+        MessageType type;
+        bool isBuy;
+    } FeedMessage;
+
+    static_assert(sizeof(FeedMessage) == 32, "Feed messages have a fixed size of 32 bytes");
+
+    struct FeedSegment;
+}
+
+/**--------------------------------------------------------------------------------------
+ * MarketByOrderPublisher class
+ * 
+ * Engine side of the feed. Creates the shared-memory segment and writes every message into
+ * the next slot of its ring without ever waiting for consumers: a consumer that falls more
+ * than FEED_RING_SIZE messages behind loses the overwritten ones and is told so. Every slot
+ * carries a version that is odd while the slot is being written, so that consumers can
+ * copy messages without locks
+ * --------------------------------------------------------------------------------------
+*/
+class MarketByOrderPublisher
+{
+public:
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Creates a publisher without any segment
+     * 
+     * @param[in] ticker    Ticker of the order book the feed is published for
+     * --------------------------------------------------------------------------------------
+    */
+    MarketByOrderPublisher(std::string ticker);
+
+    /**--------------------------------------------------------------------------------------
+     * Destructor
+     * 
+     * Unmaps and removes the segment
+     * --------------------------------------------------------------------------------------
+    */
+    ~MarketByOrderPublisher();
+
+    MarketByOrderPublisher(const MarketByOrderPublisher&) = delete;
+    MarketByOrderPublisher& operator=(const MarketByOrderPublisher&) = delete;
+
+    /**--------------------------------------------------------------------------------------
+     * create()
+     * 
+     * Creates the shared-memory segment consumers attach to, replacing any left over segment
+     * of the same name
+     * 
+     * @param[in] segmentName   Name of the segment, e.g. "/feed" for /dev/shm/feed
+     * @return true if the segment was created, false on error or on platforms without
+     *         POSIX shared memory
+     * --------------------------------------------------------------------------------------
+    */
+    bool create(const std::string& segmentName);
+
+    /**--------------------------------------------------------------------------------------
+     * publish()
+     * 
+     * Writes the next message of the feed
+     * 
+     * @param[in] type              Kind of change to the order
+     * @param[in] orderID           ID of the order
+     * @param[in] isBuy             Side of the order
+     * @param[in] priceTicks        Price level of the order
+     * @param[in] amount            Amount added, taken away, removed or filled
+     * @param[in] remainingAmount   Amount of the order left resting afterwards
+     * @param[in] time              Time of the order
+     * --------------------------------------------------------------------------------------
+    */
+    void publish(MarketByOrder::MessageType type, int orderID, bool isBuy, int priceTicks, int amount, int remainingAmount, int time);
+
+    /**--------------------------------------------------------------------------------------
+     * getNumMessages()
+     * 
+     * @return the number of messages published since the segment was created
+     * --------------------------------------------------------------------------------------
+    */
+    uint64_t getNumMessages() const
+    {
+        return m_sequence;
+    }
+
+private:
+    std::string m_ticker;
+    std::string m_segmentName;
+    MarketByOrder::FeedSegment* m_segment = nullptr;
+    uint64_t m_sequence = 0;    // Sequence of the last message published
+};
+
+/**--------------------------------------------------------------------------------------
+ * MarketByOrderSubscriber class
+ * 
+ * Consumer side of the feed. Attaches to the segment of a running engine and reads its
+ * messages in sequence without blocking. Any number of subscribers can read the same feed,
+ * none of them can slow down the engine
+ * --------------------------------------------------------------------------------------
+*/
+class MarketByOrderSubscriber
+{
+public:
+    MarketByOrderSubscriber() = default;
+
+    /**--------------------------------------------------------------------------------------
+     * Destructor
+     * 
+     * Unmaps the segment
+     * --------------------------------------------------------------------------------------
+    */
+    ~MarketByOrderSubscriber();
+
+    MarketByOrderSubscriber(const MarketByOrderSubscriber&) = delete;
+    MarketByOrderSubscriber& operator=(const MarketByOrderSubscriber&) = delete;
+
+    /**--------------------------------------------------------------------------------------
+     * attach()
+     * 
+     * Maps the segment of a running engine, starting at the oldest message still in its ring
+     * 
+     * @param[in] segmentName   Name the engine created the segment with, e.g. "/feed"
+     * @return true if attached, false if the segment does not exist
+     * --------------------------------------------------------------------------------------
+    */
+    bool attach(const std::string& segmentName);
+
+    /**--------------------------------------------------------------------------------------
+     * poll()
+     * 
+     * Takes the next message of the feed, if any. If the engine overwrote messages this
+     * subscriber had not read yet, they are skipped and counted by getNumLost()
+     * 
+     * @param[out] message  Message received
+     * @return true if a message was received
+     * --------------------------------------------------------------------------------------
+    */
+    bool poll(MarketByOrder::FeedMessage& message);
+
+    /**--------------------------------------------------------------------------------------
+     * getTicker()
+     * 
+     * @return the ticker of the order book the feed is published for
+     * --------------------------------------------------------------------------------------
+    */
+    const std::string& getTicker() const
+    {
+        return m_ticker;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getNumLost()
+     * 
+     * @return the number of messages overwritten before this subscriber could read them
+     * --------------------------------------------------------------------------------------
+    */
+    uint64_t getNumLost() const
+    {
+        return m_numLost;
+    }
+
+private:
+    MarketByOrder::FeedSegment* m_segment = nullptr;
+    std::string m_ticker;
+    uint64_t m_nextSequence = 1;
+    uint64_t m_numLost = 0;
+};
@@ -0,0 +1,311 @@
+/*midpointpool.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the MidpointPool class
+ *     Non-displayed orders crossed at the midpoint of the best buy and sell prices of a lit
+ *     order book
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <climits>
+
+#include "midpointpool.h"
+#include "logger.h"
+
+/**--------------------------------------------------------------------------------------
+ * Constructor
+ * 
+ * Creates an empty dark pool
+ * 
+ * @param[in] reference Lit order book whose best prices set the midpoint, it must
+ *                      outlive the pool
+ * --------------------------------------------------------------------------------------
+*/
+MidpointPool::MidpointPool(const Orderbook& reference)
+  : m_reference(reference)
+{
+    onReferenceUpdate();
+}
+
+/**--------------------------------------------------------------------------------------
+ * addOrder()
+ * 
+ * Crosses a new hidden order with the opposite side of the pool at the current midpoint,
+ * then queues what is left of it
+ * 
+ * @param[in] newOrder  Hidden order, a market order accepts any midpoint and a limit order
+ *                      only a midpoint at or better than its price
+ * @param[in] minAmount Smallest amount the order accepts in one fill
+ * @return true if the order was added, false if its amount is not positive or an order
+ *         with the same ID is queued
+ * --------------------------------------------------------------------------------------
+*/
+bool MidpointPool::addOrder(const Order& newOrder, int minAmount)
+{
+    const int orderID = newOrder.getID();
+    auto hasID = [orderID](const HiddenOrder& order) { return order.orderID == orderID; };
+
+    if(newOrder.getAmount() <= 0)
+    {
+        std::cerr << "ERROR - addOrder(): amount of hidden order " << orderID << " is not positive" << std::endl;
+        return false;
+    }
+
+    if(std::any_of(m_buyOrders.begin(), m_buyOrders.end(), hasID) || std::any_of(m_sellOrders.begin(), m_sellOrders.end(), hasID))
+    {
+        std::cerr << "ERROR - addOrder(): a hidden order with ID " << orderID << " is already in the pool" << std::endl;
+        return false;
+    }
+
+    const bool isBuy = newOrder.checkIsBuy();
+    HiddenOrder order;
+    order.orderID = orderID;
+    order.time = newOrder.getTime();
+    order.amount = newOrder.getAmount();
+    order.minAmount = std::max(minAmount, 1);
+
+    if(newOrder.checkIsMarket())
+    {
+        order.limitHalfTicks = isBuy ? INT_MAX : INT_MIN;
+    }
+    else
+    {
+        order.limitHalfTicks = 2 * newOrder.getPriceTicks();
+    }
+
+    // Every pair already queued was checked at the current midpoint, so only the new order can cross
+    size_t numFillsBefore = m_fills.size();
+    if(m_midpointHalfTicks != PriceLadder::NO_PRICE && accepts(order, isBuy))
+    {
+        crossOrder(order, isBuy);
+    }
+
+    if(order.amount > 0)
+    {
+        (isBuy ? m_buyOrders : m_sellOrders).push_back(order);
+    }
+
+    // Orders it partially filled may now have a remainder below their minimum amount, which other orders can take
+    if(m_fills.size() != numFillsBefore)
+    {
+        crossAll();
+    }
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * cancelOrder()
+ * 
+ * Removes a queued hidden order
+ * 
+ * @param[in] orderID   ID of the order to be cancelled
+ * @return true if the order was removed, false if no order with that ID is queued
+ * --------------------------------------------------------------------------------------
+*/
+bool MidpointPool::cancelOrder(int orderID)
+{
+    std::vector<HiddenOrder>* sides[] = { &m_buyOrders, &m_sellOrders };
+
+    for(std::vector<HiddenOrder>* side : sides)
+    {
+        auto found = std::find_if(side->begin(), side->end(), [orderID](const HiddenOrder& order) { return order.orderID == orderID; });
+        if(found != side->end())
+        {
+            side->erase(found);
+            return true;
+        }
+    }
+
+    LOG_DEBUG("NOTE - cancelOrder(): No hidden order with ID " << orderID);
+    return false;
+}
+
+/**--------------------------------------------------------------------------------------
+ * onReferenceUpdate()
+ * 
+ * Rereads the best prices of the lit order book, and crosses the whole pool if their
+ * midpoint moved. Called after every change to the lit order book
+ * 
+ * @return true if the midpoint moved
+ * --------------------------------------------------------------------------------------
+*/
+bool MidpointPool::onReferenceUpdate()
+{
+    const int bestBuyTicks = m_reference.getBestBuyTicks();
+    const int bestSellTicks = m_reference.getBestSellTicks();
+
+    // Without both sides, or with a locked or crossed lit book, there is no midpoint to trade at
+    int midpointHalfTicks = PriceLadder::NO_PRICE;
+    if(bestBuyTicks != PriceLadder::NO_PRICE && bestSellTicks != PriceLadder::NO_PRICE && bestBuyTicks < bestSellTicks)
+    {
+        midpointHalfTicks = bestBuyTicks + bestSellTicks;
+    }
+
+    if(midpointHalfTicks == m_midpointHalfTicks)
+    {
+        return false;
+    }
+
+    m_midpointHalfTicks = midpointHalfTicks;
+    if(m_midpointHalfTicks == PriceLadder::NO_PRICE)
+    {
+        return true;
+    }
+
+    crossAll();
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * crossAll()
+ * 
+ * Crosses the whole pool at the current midpoint: the buys in time priority each take the
+ * sells they can cross with in time priority. The pass is repeated while it fills anything,
+ * as a partial fill can bring an order's remainder below its minimum amount and let it
+ * cross with an order that skipped it before
+ * --------------------------------------------------------------------------------------
+*/
+void MidpointPool::crossAll()
+{
+    size_t numFillsBefore = 0;
+
+    do
+    {
+        numFillsBefore = m_fills.size();
+
+        for(HiddenOrder& curBuy : m_buyOrders)
+        {
+            if(curBuy.amount > 0 && accepts(curBuy, true))
+            {
+                crossOrder(curBuy, true);
+            }
+        }
+    } while(m_fills.size() != numFillsBefore);
+
+    removeFilled(m_buyOrders);
+    removeFilled(m_sellOrders);
+}
+
+/**--------------------------------------------------------------------------------------
+ * crossOrder()
+ * 
+ * Fills one hidden order against the opposite side in time priority, as far as the
+ * minimum amounts of both allow, at the current midpoint
+ * 
+ * @param[in,out]   order   Hidden order, its amount is reduced by every fill
+ * @param[in]       isBuy   Side of the order
+ * --------------------------------------------------------------------------------------
+*/
+void MidpointPool::crossOrder(HiddenOrder& order, bool isBuy)
+{
+    for(HiddenOrder& curOther : (isBuy ? m_sellOrders : m_buyOrders))
+    {
+        if(order.amount == 0)
+        {
+            break;
+        }
+
+        if(curOther.amount == 0 || !accepts(curOther, !isBuy))
+        {
+            continue;
+        }
+
+        // A fill has to reach the minimum amount of both orders, or take everything left of one whose remainder is smaller
+        int amountFilled = std::min(order.amount, curOther.amount);
+        if(amountFilled < std::min(order.minAmount, order.amount) || amountFilled < std::min(curOther.minAmount, curOther.amount))
+        {
+            continue;
+        }
+
+        order.amount -= amountFilled;
+        curOther.amount -= amountFilled;
+
+        if(isBuy)
+        {
+            m_fills.emplace_back(order.orderID, curOther.orderID, amountFilled, m_midpointHalfTicks);
+        }
+        else
+        {
+            m_fills.emplace_back(curOther.orderID, order.orderID, amountFilled, m_midpointHalfTicks);
+        }
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * removeFilled()
+ * 
+ * Drops every filled order from a side, keeping the others in time priority
+ * 
+ * @param[in,out] orders    Hidden orders of one side
+ * --------------------------------------------------------------------------------------
+*/
+void MidpointPool::removeFilled(std::vector<HiddenOrder>& orders)
+{
+    orders.erase(std::remove_if(orders.begin(), orders.end(), [](const HiddenOrder& order) { return order.amount == 0; }), orders.end());
+}
+
+/**--------------------------------------------------------------------------------------
+ * printFills()
+ * 
+ * Prints every cross since the last call, oldest first, and discards them
+ * --------------------------------------------------------------------------------------
+*/
+void MidpointPool::printFills()
+{
+    for(const MidpointFill& curFill : m_fills)
+    {
+        std::cout << "    MIDPOINT CROSS:    Buyer ID: " << curFill.buyID << ",   Amount filled: " << curFill.fillAmount \
+                  << ",   Seller ID: " << curFill.sellID << ",   Price: " << std::fixed << std::setprecision(3) << curFill.midpointHalfTicks / (2.0 * Order::TICKS_PER_UNIT) << std::endl;
+    }
+
+    m_fills.clear();
+}
+
+/**--------------------------------------------------------------------------------------
+ * printPoolContents()
+ * 
+ * Prints the queued hidden orders, sells then buys, each side in time priority
+ * --------------------------------------------------------------------------------------
+*/
+void MidpointPool::printPoolContents() const
+{
+    std::cout << "    Id   Side    Time   Qty   Min qty" << std::endl;
+
+    for(int isBuy = 0; isBuy < 2; isBuy++)
+    {
+        for(const HiddenOrder& curOrder : (isBuy ? m_buyOrders : m_sellOrders))
+        {
+            std::cout << "    #" << curOrder.orderID << (isBuy ? "   BUY    " : "   SELL   ") << Order::formatTime(curOrder.time) << "   " << curOrder.amount \
+                      << "   " << curOrder.minAmount << std::endl;
+        }
+    }
+}
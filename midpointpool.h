@@ -0,0 +1,223 @@
+/*midpointpool.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the MidpointPool class
+ *     Non-displayed orders crossed at the midpoint of the best buy and sell prices of a lit
+ *     order book
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "order.h"
+#include "orderbook.h"
+
+/**--------------------------------------------------------------------------------------
+ * MidpointFill struct
+ * 
+ * Records a cross between a hidden buy and a hidden sell order
+ * --------------------------------------------------------------------------------------
+*/
+typedef struct MidpointFill
+{
+    int buyID;
+    int sellID;
+    int fillAmount;
+    int midpointHalfTicks;  // Price of the cross in half ticks, the midpoint may fall between two ticks
+
+    MidpointFill(int buyNum, int sellNum, int fillAmt, int midpoint)
+        : buyID(buyNum), sellID(sellNum), fillAmount(fillAmt), midpointHalfTicks(midpoint)
+    {}
+} MidpointFill;
+
+
+
+/**--------------------------------------------------------------------------------------
+ * MidpointPool class
+ * 
+ * Dark pool of hidden orders, which never rest in the lit order book and only ever trade
+ * with each other at the midpoint of the lit order book's best buy and sell prices. Each
+ * side is a FIFO queue, and an order only trades in fills of at least its minimum amount
+ * (or all of its remaining amount, if that is smaller). A crossing pass runs when an order
+ * arrives, for that order only unless it fills something, and when the midpoint moves, for
+ * the whole pool
+ * --------------------------------------------------------------------------------------
+*/
+class MidpointPool
+{
+public:
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Creates an empty dark pool
+     * 
+     * @param[in] reference Lit order book whose best prices set the midpoint, it must
+     *                      outlive the pool
+     * --------------------------------------------------------------------------------------
+    */
+    MidpointPool(const Orderbook& reference);
+
+    /**--------------------------------------------------------------------------------------
+     * addOrder()
+     * 
+     * Crosses a new hidden order with the opposite side of the pool at the current midpoint,
+     * then queues what is left of it
+     * 
+     * @param[in] newOrder  Hidden order, a market order accepts any midpoint and a limit order
+     *                      only a midpoint at or better than its price
+     * @param[in] minAmount Smallest amount the order accepts in one fill
+     * @return true if the order was added, false if its amount is not positive or an order
+     *         with the same ID is queued
+     * --------------------------------------------------------------------------------------
+    */
+    bool addOrder(const Order& newOrder, int minAmount);
+
+    /**--------------------------------------------------------------------------------------
+     * cancelOrder()
+     * 
+     * Removes a queued hidden order
+     * 
+     * @param[in] orderID   ID of the order to be cancelled
+     * @return true if the order was removed, false if no order with that ID is queued
+     * --------------------------------------------------------------------------------------
+    */
+    bool cancelOrder(int orderID);
+
+    /**--------------------------------------------------------------------------------------
+     * onReferenceUpdate()
+     * 
+     * Rereads the best prices of the lit order book, and crosses the whole pool if their
+     * midpoint moved. Called after every change to the lit order book
+     * 
+     * @return true if the midpoint moved
+     * --------------------------------------------------------------------------------------
+    */
+    bool onReferenceUpdate();
+
+    /**--------------------------------------------------------------------------------------
+     * printFills()
+     * 
+     * Prints every cross since the last call, oldest first, and discards them
+     * --------------------------------------------------------------------------------------
+    */
+    void printFills();
+
+    /**--------------------------------------------------------------------------------------
+     * printPoolContents()
+     * 
+     * Prints the queued hidden orders, sells then buys, each side in time priority
+     * --------------------------------------------------------------------------------------
+    */
+    void printPoolContents() const;
+
+    /**--------------------------------------------------------------------------------------
+     * getFills()
+     * 
+     * @return every cross since printFills() was last called, oldest first
+     * --------------------------------------------------------------------------------------
+    */
+    const std::vector<MidpointFill>& getFills() const
+    {
+        return m_fills;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getNumRestingOrders()
+     * 
+     * @return the number of hidden buy and sell orders currently queued
+     * --------------------------------------------------------------------------------------
+    */
+    size_t getNumRestingOrders() const
+    {
+        return m_buyOrders.size() + m_sellOrders.size();
+    }
+
+private:
+    typedef struct HiddenOrder
+    {
+        int orderID;
+        int limitHalfTicks;     // Worst midpoint the order accepts, in half ticks
+        int time;
+        int amount;             // Remaining amount, 0 once filled
+        int minAmount;
+    } HiddenOrder;
+
+    /**--------------------------------------------------------------------------------------
+     * accepts()
+     * 
+     * @param[in] order Hidden order
+     * @param[in] isBuy Side of the order
+     * @return true if the order accepts to trade at the current midpoint
+     * --------------------------------------------------------------------------------------
+    */
+    bool accepts(const HiddenOrder& order, bool isBuy) const
+    {
+        return isBuy ? order.limitHalfTicks >= m_midpointHalfTicks : order.limitHalfTicks <= m_midpointHalfTicks;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * crossAll()
+     * 
+     * Crosses the whole pool at the current midpoint: the buys in time priority each take the
+     * sells they can cross with in time priority. The pass is repeated while it fills anything,
+     * as a partial fill can bring an order's remainder below its minimum amount and let it
+     * cross with an order that skipped it before
+     * --------------------------------------------------------------------------------------
+    */
+    void crossAll();
+
+    /**--------------------------------------------------------------------------------------
+     * crossOrder()
+     * 
+     * Fills one hidden order against the opposite side in time priority, as far as the
+     * minimum amounts of both allow, at the current midpoint
+     * 
+     * @param[in,out]   order   Hidden order, its amount is reduced by every fill
+     * @param[in]       isBuy   Side of the order
+     * --------------------------------------------------------------------------------------
+    */
+    void crossOrder(HiddenOrder& order, bool isBuy);
+
+    /**--------------------------------------------------------------------------------------
+     * removeFilled()
+     * 
+     * Drops every filled order from a side, keeping the others in time priority
+     * 
+     * @param[in,out] orders    Hidden orders of one side
+     * --------------------------------------------------------------------------------------
+    */
+    static void removeFilled(std::vector<HiddenOrder>& orders);
+
+    const Orderbook& m_reference;
+    std::vector<HiddenOrder> m_buyOrders;       // Hidden buy orders in time priority
+    std::vector<HiddenOrder> m_sellOrders;      // Hidden sell orders in time priority
+    int m_midpointHalfTicks = PriceLadder::NO_PRICE;    // Sum of the best lit buy and sell prices, NO_PRICE without a two-sided lit book
+    std::vector<MidpointFill> m_fills;          // Every cross since the last printFills(), oldest first
+};
@@ -30,6 +30,8 @@
  * SOFTWARE.
 */
 
+#include <utility>
+
 #include "order.h"
 
 /**--------------------------------------------------------------------------------------
@@ -46,8 +48,25 @@
  *                            i.e. 12 AM would be 0, 7:45 AM would be 745, and 10:20 PM
  *                            would be 2220
  * @param[in] amount    Amount the order intended to be filled
+ * @param[in] owner     ID of the account/participant that placed the order
+ * @param[in] session   ID of the order-entry session the order came through, 0 if it did
+ *                      not come through one
+ * --------------------------------------------------------------------------------------
+*/
+Order::Order(std::string ticker, long long orderID, bool isMarket, bool isBuy, float price, int time, int amount, unsigned int owner, unsigned int session)
+  : m_ticker(std::move(ticker)), m_orderID(orderID), m_isMarket(isMarket), m_isBuy(isBuy), m_price(price), m_time(time), m_amount(amount), m_owner(owner), m_session(session)
+{}
+
+/**--------------------------------------------------------------------------------------
+ * formatTime()
+ * 
+ * Formats a time stored according to military time as hh:mm
+ * 
+ * @param[in] intTime   Time (hr:min) stored as an int according to military time
+ * @return a string representing the time as hh:mm
  * --------------------------------------------------------------------------------------
 */
-Order::Order(std::string ticker, long long orderID, bool isMarket, bool isBuy, float price, int time, int amount)
-  : m_ticker(ticker), m_orderID(orderID), m_isMarket(isMarket), m_isBuy(isBuy), m_price(price), m_time(time), m_amount(amount)
-{}
\ No newline at end of file
+std::string Order::formatTime(int intTime)
+{
+    return std::to_string((intTime / 1000) % 10) + std::to_string((intTime / 100) % 10) + ":" + std::to_string((intTime / 10) % 10) + std::to_string(intTime % 10);
+}
\ No newline at end of file
@@ -33,10 +33,14 @@
 #pragma once
 
 #include <string>
+#include <cmath>
 
 class Order
 {
 public:
+    static const int TICKS_PER_UNIT = 100;  // Prices have a maximum of two decimal places
+
+
     /**--------------------------------------------------------------------------------------
      * Constructor
      * 
@@ -51,9 +55,38 @@ public:
      *                            i.e. 12 AM would be 0, 7:45 AM would be 745, and 10:20 PM
      *                            would be 2220
      * @param[in] amount    Amount the order intended to be filled
+     * @param[in] owner     ID of the account/participant that placed the order
+     * @param[in] session   ID of the order-entry session the order came through, 0 if it did
+     *                      not come through one
+     * --------------------------------------------------------------------------------------
+    */
+    Order(std::string ticker, long long orderID, bool isMarket, bool isBuy, float price, int time, int amount, unsigned int owner = 0, unsigned int session = 0);
+
+    /**--------------------------------------------------------------------------------------
+     * getTicker()
+     * 
+     * Returns the ticker of the financial instrument the order is for
+     * 
+     * @return a string representing the ticker of the order
+     * --------------------------------------------------------------------------------------
+    */
+    const std::string& getTicker() const
+    {
+        return m_ticker;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * checkIsMarket()
+     * 
+     * Checks if the order is a market order or limit order
+     * 
+     * @return true if the order is a market order, false if it is a limit order
      * --------------------------------------------------------------------------------------
     */
-    Order(std::string ticker, long long orderID, bool isMarket, bool isBuy, float price, int time, int amount);
+    bool checkIsMarket() const
+    {
+        return m_isMarket;
+    }
 
     /**--------------------------------------------------------------------------------------
      * checkIsBuy()
@@ -94,6 +127,44 @@ public:
         return m_price;
     }
 
+    /**--------------------------------------------------------------------------------------
+     * getPriceTicks()
+     * 
+     * Returns the price at which the order is intended to be filled as a whole number of ticks
+     * 
+     * @return an int representing the price in ticks, i.e. 20.35 would be 2035
+     * --------------------------------------------------------------------------------------
+    */
+    int getPriceTicks() const
+    {
+        return (int)std::lround(m_price * TICKS_PER_UNIT);
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * ticksToPrice()
+     * 
+     * Converts a whole number of ticks back into a price
+     * 
+     * @param[in] ticks An int representing a price in ticks
+     * @return a float representing the same price
+     * --------------------------------------------------------------------------------------
+    */
+    static float ticksToPrice(int ticks)
+    {
+        return (float)ticks / TICKS_PER_UNIT;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * formatTime()
+     * 
+     * Formats a time stored according to military time as hh:mm
+     * 
+     * @param[in] intTime   Time (hr:min) stored as an int according to military time
+     * @return a string representing the time as hh:mm
+     * --------------------------------------------------------------------------------------
+    */
+    static std::string formatTime(int intTime);
+
     /**--------------------------------------------------------------------------------------
      * getTime()
      * 
@@ -120,6 +191,32 @@ public:
         return m_amount;
     }
 
+    /**--------------------------------------------------------------------------------------
+     * getOwner()
+     * 
+     * Returns the ID of the account/participant that placed the order
+     * 
+     * @return an unsigned int representing the owner of the order
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned int getOwner() const
+    {
+        return m_owner;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getSession()
+     * 
+     * Returns the ID of the order-entry session the order came through
+     * 
+     * @return an unsigned int representing the session of the order, 0 if there is none
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned int getSession() const
+    {
+        return m_session;
+    }
+
     /**--------------------------------------------------------------------------------------
      * setAmount()
      * 
@@ -141,4 +238,6 @@ private:
     float m_price;
     int m_time; // int formatted along military time (0 -> 2359)
     int m_amount;
+    unsigned int m_owner;
+    unsigned int m_session;
 };
\ No newline at end of file
@@ -34,13 +34,19 @@
 #include <iostream>
 #include <iomanip>
 #include <vector>
-#include <stack>
 #include <algorithm>
 #include <cmath>
+#include <climits>
+#include <cstdlib>
 
 #include "orderbook.h"
+#include "tracer.h"
 #include "logger.h"
 
+namespace {
+    const size_t MAX_PREFAULT_BYTES = 64 << 20;     // Most memory prefault() spends on the price levels of both sides together
+}
+
 /**--------------------------------------------------------------------------------------
  * Constructor
  * 
@@ -51,28 +57,271 @@
  * --------------------------------------------------------------------------------------
 */
 Orderbook::Orderbook(std::string ticker)
-  : m_ticker(ticker)
+  : m_ticker(ticker), m_buyOrders(true, &m_orderStore), m_sellOrders(false, &m_orderStore), m_peggedOrders(&m_orderStore)
+{
+    // Reserving space for order history beforehand, thereby saving time on resizing it while matching
+    m_orderHistory.reserve(2048);
+}
+
+/**--------------------------------------------------------------------------------------
+ * setPriceBands()
+ * 
+ * Limits the prices continuous matching may trade at: a static band around the
+ * reference price and a dynamic band around the last trade. A fill that would print
+ * outside of either band is not executed, instead matching halts and the book collects
+ * orders for a short volatility auction, which reopens it. A fill prints at the price
+ * of whichever of its two orders arrived first
+ * 
+ * @param[in] staticBasisPoints     Half width of the static band in 1/100 of a percent of
+ *                                  the reference price, 0 for no static band
+ * @param[in] dynamicBasisPoints    Half width of the dynamic band in 1/100 of a percent of
+ *                                  the last trade, 0 for no dynamic band
+ * @param[in] auctionLength         Time a volatility auction lasts, in the units of order
+ *                                  time, it ends once an order at least this much later
+ *                                  than the halt has been added
+ * --------------------------------------------------------------------------------------
+*/
+void Orderbook::setPriceBands(int staticBasisPoints, int dynamicBasisPoints, int auctionLength)
+{
+    m_staticBandBasisPoints = std::max(staticBasisPoints, 0);
+    m_dynamicBandBasisPoints = std::max(dynamicBasisPoints, 0);
+    m_haltAuctionLength = std::max(auctionLength, 0);
+    updatePriceBands();
+}
+
+/**--------------------------------------------------------------------------------------
+ * setReferencePrice()
+ * 
+ * Sets the price the static band is centered on. Without one, the first trade is used
+ * 
+ * @param[in] priceTicks    Reference price in ticks
+ * --------------------------------------------------------------------------------------
+*/
+void Orderbook::setReferencePrice(int priceTicks)
+{
+    m_referenceTicks = priceTicks;
+    updatePriceBands();
+}
+
+/**--------------------------------------------------------------------------------------
+ * updatePriceBands()
+ * 
+ * Recomputes the lowest price and the width of the intersection of both bands, after the
+ * reference price or the last trade changed
+ * --------------------------------------------------------------------------------------
+*/
+void Orderbook::updatePriceBands()
+{
+    if(m_referenceTicks == PriceLadder::NO_PRICE)
+    {
+        m_referenceTicks = m_lastTradeTicks;
+    }
+
+    computePriceBands(m_referenceTicks, m_lastTradeTicks, m_bandLowTicks, m_bandWidthTicks);
+}
+
+/**--------------------------------------------------------------------------------------
+ * computePriceBands()
+ * 
+ * Computes the lowest price and the width of the intersection of both bands around the
+ * given reference price and last trade
+ * 
+ * @param[in]   referenceTicks  Center of the static band, or PriceLadder::NO_PRICE
+ * @param[in]   lastTradeTicks  Center of the dynamic band, or PriceLadder::NO_PRICE
+ * @param[out]  lowTicks        Lowest price inside both bands
+ * @param[out]  widthTicks      Number of prices above lowTicks inside both bands
+ * --------------------------------------------------------------------------------------
+*/
+void Orderbook::computePriceBands(int referenceTicks, int lastTradeTicks, int& lowTicks, unsigned int& widthTicks) const
 {
-    // Reserving extra space for the underlying containers of the priority_queuess beforehand, thereby saving time on resizing the vectors
-    std::vector<Order> buyContainer;
-    buyContainer.reserve(2048);
-    m_buyOrders = new std::priority_queue<Order, std::vector<Order>, prioritizeMax> (prioritizeMax(), std::move(buyContainer));
+    long long bandLowTicks = (long long)PriceLadder::NO_PRICE + 1;
+    long long bandHighTicks = INT_MAX;
+
+    if(m_staticBandBasisPoints > 0 && referenceTicks != PriceLadder::NO_PRICE)
+    {
+        long long halfWidth = std::llabs(referenceTicks) * m_staticBandBasisPoints / 10000;
+        bandLowTicks = std::max(bandLowTicks, referenceTicks - halfWidth);
+        bandHighTicks = std::min(bandHighTicks, referenceTicks + halfWidth);
+    }
 
-    std::vector<Order> sellContainer;
-    sellContainer.reserve(2048);
-    m_sellOrders = new std::priority_queue<Order, std::vector<Order>, prioritizeMin> (prioritizeMin(), std::move(sellContainer));
+    if(m_dynamicBandBasisPoints > 0 && lastTradeTicks != PriceLadder::NO_PRICE)
+    {
+        long long halfWidth = std::llabs(lastTradeTicks) * m_dynamicBandBasisPoints / 10000;
+        bandLowTicks = std::max(bandLowTicks, lastTradeTicks - halfWidth);
+        bandHighTicks = std::min(bandHighTicks, lastTradeTicks + halfWidth);
+    }
+
+    // Bands that do not overlap allow no price at all (but INT_MAX, which no order reaches)
+    if(bandHighTicks < bandLowTicks)
+    {
+        bandLowTicks = INT_MAX;
+        bandHighTicks = INT_MAX;
+    }
+
+    lowTicks = (int)bandLowTicks;
+    widthTicks = (unsigned int)(bandHighTicks - bandLowTicks);
 }
 
 /**--------------------------------------------------------------------------------------
- * Destructor
+ * haltMatching()
  * 
- * Destroys m_buyOrders and m_sellOrders
+ * Halts continuous matching instead of executing a fill outside of the price bands
+ * 
+ * @param[in] tradeTick Price the fill would have printed at
  * --------------------------------------------------------------------------------------
 */
-Orderbook::~Orderbook()
+void Orderbook::haltMatching(int tradeTick)
 {
-    delete m_buyOrders;
-    delete m_sellOrders;
+    LOG_DEBUG("NOTE - haltMatching(): A fill at " << Order::ticksToPrice(tradeTick) << " would print outside of the price bands, halting for a volatility auction");
+
+    m_isHalted = true;
+    m_haltTicks = tradeTick;
+    m_haltEndTime = m_latestTime + m_haltAuctionLength;
+    m_numHalts++;
+}
+
+/**--------------------------------------------------------------------------------------
+ * canMatch()
+ * 
+ * Ends the volatility auction of a halted book once it has lasted long enough
+ * 
+ * @return true if continuous matching may go on
+ * --------------------------------------------------------------------------------------
+*/
+bool Orderbook::canMatch()
+{
+    if(!m_isHalted)
+    {
+        return true;
+    }
+
+    if(m_latestTime < m_haltEndTime)
+    {
+        return false;
+    }
+
+    endVolatilityAuction();
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * endVolatilityAuction()
+ * 
+ * Ends a halt right away, e.g. when no more orders will arrive: clears the book in an
+ * auction, re-centers both bands on its price and resumes continuous matching
+ * --------------------------------------------------------------------------------------
+*/
+void Orderbook::endVolatilityAuction()
+{
+    m_isHalted = false;
+    matchOrdersAuction();
+
+    if(m_lastAuctionTicks != PriceLadder::NO_PRICE)
+    {
+        m_referenceTicks = m_lastAuctionTicks;
+        m_lastTradeTicks = m_lastAuctionTicks;
+        updatePriceBands();
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * reserve()
+ * 
+ * Preallocates room for resting orders and order history, so that adding, matching and
+ * cancelling orders within these limits does not allocate any memory
+ * 
+ * @param[in] maxRestingOrders  Largest number of orders expected to rest at the same time
+ * @param[in] maxHistory        Largest number of fills expected between two calls to
+ *                              printOrderHistory()/clearOrderHistory()
+ * --------------------------------------------------------------------------------------
+*/
+void Orderbook::reserve(size_t maxRestingOrders, size_t maxHistory)
+{
+    m_orderStore.reserve(maxRestingOrders);
+    m_orderHistory.reserve(maxHistory);
+}
+
+/**--------------------------------------------------------------------------------------
+ * prefault()
+ * 
+ * Touches all memory reserved for resting orders and order history, and allocates and
+ * touches the price levels around the expected best prices on both sides, so that the
+ * first orders after startup do not pay for page faults. Fewer levels are prefaulted if
+ * they would take more than MAX_PREFAULT_BYTES
+ * 
+ * @param[in] centerTicks       Price in ticks the best prices are expected around, or
+ *                              PriceLadder::NO_PRICE to prefault no price level
+ * @param[in] levelsPerSide     Number of price levels prefaulted above and below it
+ * @param[in] ordersPerLevel    Number of orders to make room for at each price level
+ * --------------------------------------------------------------------------------------
+*/
+void Orderbook::prefault(int centerTicks, int levelsPerSide, size_t ordersPerLevel)
+{
+    // Both ladders prefault 2 * levelsPerSide + 1 levels each, -1 if not even one fits
+    const size_t bytesPerLevel = sizeof(PriceLevel) + ordersPerLevel * PriceLevel::BYTES_PER_ORDER;
+    const size_t maxLevels = MAX_PREFAULT_BYTES / (2 * bytesPerLevel);
+    const long long maxLevelsPerSide = (maxLevels == 0) ? -1 : (long long)(maxLevels - 1) / 2;
+    if(levelsPerSide > maxLevelsPerSide)
+    {
+        LOG_DEBUG("NOTE - prefault(): Only prefaulting " << maxLevelsPerSide << " price levels either side instead of " << levelsPerSide);
+        levelsPerSide = (int)maxLevelsPerSide;
+    }
+
+    if(centerTicks != PriceLadder::NO_PRICE && levelsPerSide >= 0)
+    {
+        m_buyOrders.prefault(centerTicks, levelsPerSide, ordersPerLevel);
+        m_sellOrders.prefault(centerTicks, levelsPerSide, ordersPerLevel);
+    }
+    m_orderStore.prefault();
+
+    const size_t numHistory = m_orderHistory.size();
+    m_orderHistory.resize(m_orderHistory.capacity(), ProcessedOrder(0, 0, 0));
+    m_orderHistory.resize(numHistory, ProcessedOrder(0, 0, 0));
+}
+
+/**--------------------------------------------------------------------------------------
+ * clear()
+ * 
+ * Removes every resting order from the order book, keeping all memory allocated for them
+ * --------------------------------------------------------------------------------------
+*/
+void Orderbook::clear()
+{
+    PriceLadder* sides[] = { &m_buyOrders, &m_sellOrders };
+
+    for(PriceLadder* side : sides)
+    {
+        int tick = side->bestTick();
+        while(tick != PriceLadder::NO_PRICE)
+        {
+            PriceLevel& curLevel = side->getLevel(tick);
+            while(!curLevel.empty())
+            {
+                publish(MarketByOrder::ORDER_DELETED, curLevel.getID(0), side == &m_buyOrders, tick, curLevel.getAmount(0), 0, curLevel.getTime(0));
+                m_orderStore.release(curLevel.getSlot(0));
+                curLevel.popFront();
+            }
+
+            int nextTick = side->nextTick(tick);
+            side->refreshLevel(tick);
+            tick = nextTick;
+        }
+    }
+
+    for(int isBuy = 0; isBuy < 2; isBuy++)
+    {
+        for(const std::unique_ptr<PegBook::PegGroup>& curGroup : m_peggedOrders.getGroups(isBuy))
+        {
+            PriceLevel& curLevel = curGroup->orders;
+            while(!curLevel.empty())
+            {
+                publish(MarketByOrder::ORDER_DELETED, curLevel.getID(0), isBuy, curGroup->effectiveTick, curLevel.getAmount(0), 0, curLevel.getTime(0));
+                m_orderStore.release(curLevel.getSlot(0));
+                curLevel.popFront();
+            }
+        }
+    }
+    m_peggedOrders.clear();
 }
 
 /**--------------------------------------------------------------------------------------
@@ -81,74 +330,559 @@ Orderbook::~Orderbook()
  * Adds a new order to the order book, either on the buy or sell side
  * 
  * @param[in] newOrder  new order to be added
+ * @return true if the order was added, false if its price is NO_PRICE or an order with
+ *         the same ID is resting
+ * --------------------------------------------------------------------------------------
+*/
+bool Orderbook::addOrder(const Order& newOrder)
+{
+    PriceLadder& side = newOrder.checkIsBuy() ? m_buyOrders : m_sellOrders;
+
+    if(!side.accepts(newOrder.getPriceTicks()))
+    {
+        std::cerr << "ERROR - addOrder(): price " << newOrder.getPrice() << " of order " << newOrder.getID() \
+                  << " is not a valid price" << std::endl;
+        return false;
+    }
+
+    unsigned int slot = m_orderStore.allocate(newOrder);
+    if(slot == OrderStore::NO_SLOT)
+    {
+        std::cerr << "ERROR - addOrder(): an order with ID " << newOrder.getID() << " is already in the order book" << std::endl;
+        return false;
+    }
+
+    side.addOrder(newOrder, slot);
+    m_latestTime = std::max(m_latestTime, newOrder.getTime());
+    publish(MarketByOrder::ORDER_ADDED, newOrder.getID(), newOrder.checkIsBuy(), newOrder.getPriceTicks(), newOrder.getAmount(), newOrder.getAmount(), newOrder.getTime());
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * addPeggedOrder()
+ * 
+ * Adds a new order whose price follows the best buy price, the best sell price or their
+ * midpoint, plus an offset. It rests in a group with the other orders of its side pegged
+ * the same way and matches at the group's current price, which is only recomputed when
+ * the best limit prices have moved and the group is needed again
+ * 
+ * @param[in] newOrder      new order to be added, its price is ignored
+ * @param[in] reference     Price the order follows
+ * @param[in] offsetTicks   Ticks added to the reference price, e.g. -1 to buy one tick
+ *                          below the best buy price
+ * @return true if the order was added, false if the reference is NOT_PEGGED or an order
+ *         with the same ID is resting
+ * --------------------------------------------------------------------------------------
+*/
+bool Orderbook::addPeggedOrder(const Order& newOrder, PegReference reference, int offsetTicks)
+{
+    if(reference == NOT_PEGGED)
+    {
+        std::cerr << "ERROR - addPeggedOrder(): order " << newOrder.getID() << " is not pegged to any price" << std::endl;
+        return false;
+    }
+
+    unsigned int slot = m_orderStore.allocate(newOrder);
+    if(slot == OrderStore::NO_SLOT)
+    {
+        std::cerr << "ERROR - addPeggedOrder(): an order with ID " << newOrder.getID() << " is already in the order book" << std::endl;
+        return false;
+    }
+
+    m_orderStore.peg(slot, reference, offsetTicks);
+    m_peggedOrders.addOrder(newOrder, reference, offsetTicks, slot);
+    m_latestTime = std::max(m_latestTime, newOrder.getTime());
+
+    // Published at the price the order would match at now, later repricing of its group is not published
+    PegBook::PegGroup* group = m_peggedOrders.findGroup(newOrder.checkIsBuy(), reference, offsetTicks);
+    int tick = PegBook::getEffectiveTick(newOrder.checkIsBuy(), *group, m_buyOrders.bestTick(), m_sellOrders.bestTick());
+    publish(MarketByOrder::ORDER_ADDED, newOrder.getID(), newOrder.checkIsBuy(), tick, newOrder.getAmount(), newOrder.getAmount(), newOrder.getTime());
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * cancelOrder()
+ * 
+ * Removes a resting order from the order book
+ * 
+ * @param[in] orderID   ID of the order to be cancelled
+ * @return true if the order was removed, false if no order with that ID is resting
+ * --------------------------------------------------------------------------------------
+*/
+bool Orderbook::cancelOrder(int orderID)
+{
+    unsigned int slot = m_orderStore.findSlot(orderID);
+    if(slot == OrderStore::NO_SLOT)
+    {
+        LOG_DEBUG("NOTE - cancelOrder(): No resting order with ID " << orderID);
+        return false;
+    }
+
+    removeOrder(slot);
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * cancelOrdersOfOwner()
+ * 
+ * Removes every resting order of one owner, e.g. to mass cancel an account. Only the
+ * owner's own orders are visited
+ * 
+ * @param[in] owner ID of the account/participant whose orders are cancelled
+ * @return the number of orders removed
  * --------------------------------------------------------------------------------------
 */
-void Orderbook::addOrder(Order newOrder)
+size_t Orderbook::cancelOrdersOfOwner(unsigned int owner)
 {
-    if(newOrder.checkIsBuy())
+    size_t numCancelled = 0;
+
+    unsigned int slot = m_orderStore.firstSlotOfOwner(owner);
+    while(slot != OrderStore::NO_SLOT)
     {
-        (*m_buyOrders).push(newOrder);
+        unsigned int nextSlot = m_orderStore.nextSlotOfOwner(slot);
+        removeOrder(slot);
+        numCancelled++;
+        slot = nextSlot;
+    }
+
+    return numCancelled;
+}
+
+/**--------------------------------------------------------------------------------------
+ * cancelOrdersOfSession()
+ * 
+ * Removes every resting order that came through one order-entry session, e.g. when the
+ * session disconnects. Orders its owners entered through other sessions stay, and only the
+ * session's own orders are visited
+ * 
+ * @param[in] session   ID of the session whose orders are cancelled, not 0
+ * @return the number of orders removed
+ * --------------------------------------------------------------------------------------
+*/
+size_t Orderbook::cancelOrdersOfSession(unsigned int session)
+{
+    size_t numCancelled = 0;
+
+    unsigned int slot = m_orderStore.firstSlotOfSession(session);
+    while(slot != OrderStore::NO_SLOT)
+    {
+        unsigned int nextSlot = m_orderStore.nextSlotOfSession(slot);
+        removeOrder(slot);
+        numCancelled++;
+        slot = nextSlot;
+    }
+
+    return numCancelled;
+}
+
+/**--------------------------------------------------------------------------------------
+ * removeOrder()
+ * 
+ * Removes a resting order from its price level and frees its slot
+ * 
+ * @param[in] slot  Slot of the order
+ * --------------------------------------------------------------------------------------
+*/
+void Orderbook::removeOrder(unsigned int slot)
+{
+    const HotOrder& hot = m_orderStore.getHot(slot);
+    int tick = 0;
+    PriceLevel& level = getRestingLevel(hot, tick);
+    size_t index = level.find(slot);
+
+    publish(MarketByOrder::ORDER_DELETED, level.getID(index), hot.isBuy, tick, level.getAmount(index), 0, level.getTime(index));
+    level.erase(index);
+    refreshRestingLevel(hot);
+    m_orderStore.release(slot);
+}
+
+/**--------------------------------------------------------------------------------------
+ * findBestLevel()
+ * 
+ * Finds the best price level of one side among its limit orders and its active groups of
+ * pegged orders, repricing the groups first if the best limit prices moved. A limit
+ * price level comes before a group of pegged orders at the same price
+ * 
+ * @param[in] isBuy     Side of the book
+ * @param[out] tick     Price of the level
+ * @param[out] level    Orders at that price
+ * @param[out] group    Group of pegged orders the level belongs to, or nullptr if it is a
+ *                      level of limit orders
+ * @return true if the side has a level, false if it has no order with a price
+ * --------------------------------------------------------------------------------------
+*/
+bool Orderbook::findBestLevel(bool isBuy, int& tick, PriceLevel*& level, PegBook::PegGroup*& group)
+{
+    PriceLadder& side = isBuy ? m_buyOrders : m_sellOrders;
+    tick = side.bestTick();
+    group = nullptr;
+
+    if(!m_peggedOrders.empty())
+    {
+        m_peggedOrders.reprice(m_buyOrders.bestTick(), m_sellOrders.bestTick());
+
+        const std::vector<PegBook::PegGroup*>& activeGroups = m_peggedOrders.getActiveGroups(isBuy);
+        if(!activeGroups.empty() && (tick == PriceLadder::NO_PRICE || (isBuy ? activeGroups[0]->effectiveTick > tick : activeGroups[0]->effectiveTick < tick)))
+        {
+            group = activeGroups[0];
+            tick = group->effectiveTick;
+            level = &group->orders;
+            return true;
+        }
+    }
+
+    if(tick == PriceLadder::NO_PRICE)
+    {
+        return false;
+    }
+
+    level = &side.getLevel(tick);
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * getRestingLevel()
+ * 
+ * @param[in] hot   Hot record of a resting order
+ * @param[out] tick Price the order currently rests at
+ * @return the price level or group of pegged orders holding the order
+ * --------------------------------------------------------------------------------------
+*/
+PriceLevel& Orderbook::getRestingLevel(const HotOrder& hot, int& tick)
+{
+    if(hot.pegReference == NOT_PEGGED)
+    {
+        tick = hot.priceTicks;
+        return (hot.isBuy ? m_buyOrders : m_sellOrders).getLevel(hot.priceTicks);
+    }
+
+    PegBook::PegGroup* group = m_peggedOrders.findGroup(hot.isBuy, hot.pegReference, hot.priceTicks);
+    tick = PegBook::getEffectiveTick(hot.isBuy, *group, m_buyOrders.bestTick(), m_sellOrders.bestTick());
+    return group->orders;
+}
+
+/**--------------------------------------------------------------------------------------
+ * refreshRestingLevel()
+ * 
+ * Notes that orders were removed from the price level or group of pegged orders holding
+ * an order, after removing them
+ * 
+ * @param[in] hot   Hot record of the order
+ * --------------------------------------------------------------------------------------
+*/
+void Orderbook::refreshRestingLevel(const HotOrder& hot)
+{
+    if(hot.pegReference == NOT_PEGGED)
+    {
+        (hot.isBuy ? m_buyOrders : m_sellOrders).refreshLevel(hot.priceTicks);
     }
     else
     {
-        (*m_sellOrders).push(newOrder);
+        m_peggedOrders.markStale();
     }
 }
 
 /**--------------------------------------------------------------------------------------
- * matchOrdersFIFO()
+ * reduceOrder()
  * 
- * Matches a buy and sell order at the top of their respective piles if the buy price is
- * greater than or equal to the sell price
+ * Takes part of the amount of a resting order away without changing its time priority,
+ * e.g. when it is executed or partially cancelled on another venue, removing the order
+ * once nothing is left of it
+ * 
+ * @param[in] orderID   ID of the order to be reduced
+ * @param[in] amount    Amount taken away, capped at the order's remaining amount
+ * @return true if the order was reduced, false if the amount is not positive or no order
+ *         with that ID is resting
  * --------------------------------------------------------------------------------------
 */
-void Orderbook::matchOrdersFIFO()
+bool Orderbook::reduceOrder(int orderID, int amount)
+{
+    if(amount <= 0)
+    {
+        std::cerr << "ERROR - reduceOrder(): cannot reduce order " << orderID << " by " << amount << ", the amount has to be positive" << std::endl;
+        return false;
+    }
+
+    unsigned int slot = m_orderStore.findSlot(orderID);
+    if(slot == OrderStore::NO_SLOT)
+    {
+        LOG_DEBUG("NOTE - reduceOrder(): No resting order with ID " << orderID);
+        return false;
+    }
+
+    const HotOrder& hot = m_orderStore.getHot(slot);
+    int tick = 0;
+    PriceLevel& level = getRestingLevel(hot, tick);
+    size_t index = level.find(slot);
+    int reducedAmount = std::min(amount, level.getAmount(index));
+    int remainingAmount = level.fill(index, reducedAmount);
+
+    publish((remainingAmount == 0) ? MarketByOrder::ORDER_DELETED : MarketByOrder::ORDER_MODIFIED, orderID, hot.isBuy, tick, reducedAmount, remainingAmount, level.getTime(index));
+
+    if(remainingAmount == 0)
+    {
+        level.erase(index);
+        refreshRestingLevel(hot);
+        m_orderStore.release(slot);
+    }
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * replaceOrder()
+ * 
+ * Removes a resting order and adds a new order on the same side for the same owner and
+ * session, which loses the time priority of the original
+ * 
+ * @param[in] orderID       ID of the order to be replaced
+ * @param[in] newOrderID    ID of the new order
+ * @param[in] newPrice      Price of the new order
+ * @param[in] newTime       Time of the new order
+ * @param[in] newAmount     Amount of the new order
+ * @return true if the new order was added, false if no order with that ID is resting or
+ *         the new price is NO_PRICE (the original order is removed either way)
+ * --------------------------------------------------------------------------------------
+*/
+bool Orderbook::replaceOrder(int orderID, long long newOrderID, float newPrice, int newTime, int newAmount)
 {
-    std::cout << "Initiating FIFO order-matching" << std::endl;
+    unsigned int slot = m_orderStore.findSlot(orderID);
+    if(slot == OrderStore::NO_SLOT)
+    {
+        LOG_DEBUG("NOTE - replaceOrder(): No resting order with ID " << orderID);
+        return false;
+    }
 
-    while(!(*m_buyOrders).empty() && !(*m_sellOrders).empty())
+    // Built before the original is cancelled, as the new order may be given the same slot
+    const ColdOrder& cold = m_orderStore.getCold(slot);
+    Order newOrder(cold.ticker, newOrderID, false, m_orderStore.getHot(slot).isBuy, newPrice, newTime, newAmount, cold.owner, cold.session);
+
+    cancelOrder(orderID);
+
+    if(!acceptsPrice(newOrder.checkIsBuy(), newOrder.getPriceTicks()))
     {
-        Order bestBuy = (*m_buyOrders).top();
-        Order bestSell = (*m_sellOrders).top();
+        LOG_DEBUG("NOTE - replaceOrder(): price " << newPrice << " of order " << newOrder.getID() << " is not a valid price");
+        return false;
+    }
+
+    return addOrder(newOrder);
+}
 
-        (*m_buyOrders).pop();
-        (*m_sellOrders).pop();
+/**--------------------------------------------------------------------------------------
+ * applyQuote()
+ * 
+ * Replaces every level of a market maker's quote in one call. The order of each entry is
+ * added if it is not resting yet, removed if its amount is 0, and otherwise updated in
+ * place in the slot it already holds: a smaller amount at the same price keeps its time
+ * priority, a larger amount or a new price moves it to the back of its new level. Every
+ * entry is checked before any is applied, and every price but NO_PRICE can be held by the
+ * ladders whatever the removals do to them, so the quote is applied either completely or
+ * not at all
+ * 
+ * @param[in] owner     ID of the market maker, every resting order of the quote must be
+ *                      its own
+ * @param[in] entries   Levels of the quote, each with its own order ID
+ * @param[in] time      Time of the quote, given to orders that are added or moved
+ * @return true if the quote was applied, false if an entry has a negative amount, the
+ *         price NO_PRICE, the ID of another entry, or the ID of another owner's order, of an
+ *         order on the other side or of a pegged order
+ * --------------------------------------------------------------------------------------
+*/
+bool Orderbook::applyQuote(unsigned int owner, const std::vector<QuoteEntry>& entries, int time)
+{
+    for(size_t entryIndex = 0; entryIndex < entries.size(); entryIndex++)
+    {
+        const QuoteEntry& curEntry = entries[entryIndex];
 
-        if(bestBuy.getPrice() >= bestSell.getPrice())   // Buy and sell price levels are compatible
+        unsigned int slot = m_orderStore.findSlot(curEntry.orderID);
+        if(slot != OrderStore::NO_SLOT && (m_orderStore.getCold(slot).owner != owner || m_orderStore.getHot(slot).isBuy != curEntry.isBuy || m_orderStore.getHot(slot).pegReference != NOT_PEGGED))
         {
-            int buyAmount = bestBuy.getAmount();
-            int sellAmount = bestSell.getAmount();
-            int amountFilled = 0;
+            std::cerr << "ERROR - applyQuote(): order " << curEntry.orderID << " of the quote of owner " << owner << " is resting for another owner or side, or is pegged" << std::endl;
+            return false;
+        }
 
-            if(buyAmount > sellAmount)      // Sell order should be completely filled
-            {
-                bestBuy.setAmount(buyAmount - sellAmount);
+        // The order is rebuilt from its price, which has to come back as the same tick
+        if(curEntry.amount < 0 || (curEntry.amount > 0 && (!acceptsPrice(curEntry.isBuy, curEntry.priceTicks) || \
+           std::lround(Order::ticksToPrice(curEntry.priceTicks) * Order::TICKS_PER_UNIT) != curEntry.priceTicks)))
+        {
+            std::cerr << "ERROR - applyQuote(): order " << curEntry.orderID << " of the quote of owner " << owner << " has an invalid amount or price" << std::endl;
+            return false;
+        }
 
-                amountFilled = sellAmount;
-                (*m_buyOrders).push(bestBuy); // Re-adding partially filled buy order to maxheap of buy orders
-            }
-            else if(buyAmount < sellAmount) // Buy order should be completely filled
+        // Quotes only hold a handful of levels, so comparing with every earlier entry is cheaper than any set
+        for(size_t earlierIndex = 0; earlierIndex < entryIndex; earlierIndex++)
+        {
+            if(entries[earlierIndex].orderID == curEntry.orderID)
             {
-                bestSell.setAmount(sellAmount - buyAmount);
+                std::cerr << "ERROR - applyQuote(): order " << curEntry.orderID << " appears more than once in the quote of owner " << owner << std::endl;
+                return false;
+            }
+        }
+    }
+
+    for(const QuoteEntry& curEntry : entries)
+    {
+        unsigned int slot = m_orderStore.findSlot(curEntry.orderID);
 
-                amountFilled = buyAmount;
-                (*m_sellOrders).push(bestSell); // Re-adding partially filled sell order to minheap of sell orders
+        if(slot == OrderStore::NO_SLOT)
+        {
+            if(curEntry.amount > 0)
+            {
+                addOrder(Order(m_ticker, curEntry.orderID, false, curEntry.isBuy, Order::ticksToPrice(curEntry.priceTicks), time, curEntry.amount, owner));
             }
-            else                            // Both orders should be completely filled
+            continue;
+        }
+
+        if(curEntry.amount == 0)
+        {
+            removeOrder(slot);
+            continue;
+        }
+
+        const int oldTicks = m_orderStore.getHot(slot).priceTicks;
+        PriceLadder& side = curEntry.isBuy ? m_buyOrders : m_sellOrders;
+        PriceLevel& level = side.getLevel(oldTicks);
+        size_t index = level.find(slot);
+        const int oldAmount = level.getAmount(index);
+
+        if(curEntry.priceTicks == oldTicks && curEntry.amount <= oldAmount)
+        {
+            // Only shrinking at the same price, keeping the place in the queue
+            if(curEntry.amount < oldAmount)
             {
-                amountFilled = buyAmount;
+                level.fill(index, oldAmount - curEntry.amount);
+                publish(MarketByOrder::ORDER_MODIFIED, curEntry.orderID, curEntry.isBuy, oldTicks, oldAmount - curEntry.amount, curEntry.amount, level.getTime(index));
             }
+            continue;
+        }
+
+        // Moving the order to the back of its new level, reusing its slot
+        level.erase(index);
+        side.refreshLevel(oldTicks);
+        m_orderStore.reprice(slot, curEntry.priceTicks, time);
+        side.addOrder(Order(m_ticker, curEntry.orderID, false, curEntry.isBuy, Order::ticksToPrice(curEntry.priceTicks), time, curEntry.amount, owner), slot);
+        publish(MarketByOrder::ORDER_MODIFIED, curEntry.orderID, curEntry.isBuy, curEntry.priceTicks, oldAmount - curEntry.amount, curEntry.amount, time);
+    }
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * bulkLoad()
+ * 
+ * Adds a whole batch of orders to the order book at once, in O(n). Orders are partitioned
+ * by side and each side is counting-sorted by price into its levels, so that every price
+ * level is filled by appending instead of inserting orders one by one at random levels
+ * 
+ * @param[in] orders    orders to be added, e.g. every row of an opening order file
+ * --------------------------------------------------------------------------------------
+*/
+void Orderbook::bulkLoad(const std::vector<Order>& orders)
+{
+    TRACE_SCOPE("add", "bulkLoad");
+
+    m_orderStore.reserve(m_orderStore.size() + orders.size());
 
-            m_orderHistory.emplace(bestBuy.getID(), bestSell.getID(), amountFilled); // Updating order book history
+    std::vector<unsigned int> slots(orders.size(), (unsigned int)OrderStore::NO_SLOT);
+    std::vector<unsigned int> sideIndices[2];
+
+    for(size_t i = 0; i < orders.size(); i++)
+    {
+        const Order& curOrder = orders[i];
+        if(!acceptsPrice(curOrder.checkIsBuy(), curOrder.getPriceTicks()))
+        {
+            std::cerr << "ERROR - bulkLoad(): price " << curOrder.getPrice() << " of order " << curOrder.getID() << " is not a valid price" << std::endl;
+            continue;
         }
-        else
+
+        slots[i] = m_orderStore.allocate(curOrder);
+        if(slots[i] == OrderStore::NO_SLOT)
         {
-            (*m_buyOrders).push(bestBuy);
-            (*m_sellOrders).push(bestSell);
+            std::cerr << "ERROR - bulkLoad(): an order with ID " << curOrder.getID() << " is already in the order book" << std::endl;
+            continue;
+        }
+
+        sideIndices[curOrder.checkIsBuy()].push_back((unsigned int)i);
+    }
+
+    m_buyOrders.bulkAdd(orders, sideIndices[true], slots);
+    m_sellOrders.bulkAdd(orders, sideIndices[false], slots);
 
+    for(size_t i = 0; i < orders.size(); i++)
+    {
+        if(slots[i] != OrderStore::NO_SLOT)
+        {
+            const Order& curOrder = orders[i];
+            m_latestTime = std::max(m_latestTime, curOrder.getTime());
+            publish(MarketByOrder::ORDER_ADDED, curOrder.getID(), curOrder.checkIsBuy(), curOrder.getPriceTicks(), curOrder.getAmount(), curOrder.getAmount(), curOrder.getTime());
+        }
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * matchOrdersFIFO()
+ * 
+ * Matches a buy and sell order at the top of their respective piles if the buy price is
+ * greater than or equal to the sell price
+ * --------------------------------------------------------------------------------------
+*/
+void Orderbook::matchOrdersFIFO()
+{
+    TRACE_SCOPE("match", "matchOrdersFIFO");
+
+    if(!canMatch())
+    {
+        return;
+    }
+
+    int buyTick = 0, sellTick = 0;
+    PriceLevel* buyLevelPtr = nullptr;
+    PriceLevel* sellLevelPtr = nullptr;
+    PegBook::PegGroup* buyGroup = nullptr;
+    PegBook::PegGroup* sellGroup = nullptr;
+
+    while(findBestLevel(true, buyTick, buyLevelPtr, buyGroup) && findBestLevel(false, sellTick, sellLevelPtr, sellGroup))
+    {
+        if(buyTick < sellTick)  // Buy and sell price levels are incompatible
+        {
             LOG_DEBUG("NOTE - matchOrdersFIFO(): Best buy price does not fulfill best sell price, waiting for new orders");
             break;
         }
+
+        PriceLevel& buyLevel = *buyLevelPtr;
+        PriceLevel& sellLevel = *sellLevelPtr;
+
+        // The fill prints at the price of the order that was resting first, and halts matching instead if that is outside of the price bands
+        const int tradeTick = (buyLevel.getTime(0) < sellLevel.getTime(0)) ? buyTick : sellTick;
+        if(isOutsideBands(tradeTick))
+        {
+            haltMatching(tradeTick);
+            break;
+        }
+
+        // Whichever order is smaller is completely filled, or both are if they are equal
+        int amountFilled = std::min(buyLevel.getAmount(0), sellLevel.getAmount(0));
+        m_orderHistory.emplace_back(buyLevel.getID(0), sellLevel.getID(0), amountFilled); // Updating order book history
+        publish(MarketByOrder::ORDER_EXECUTED, buyLevel.getID(0), true, buyTick, amountFilled, buyLevel.getAmount(0) - amountFilled, buyLevel.getTime(0));
+        publish(MarketByOrder::ORDER_EXECUTED, sellLevel.getID(0), false, sellTick, amountFilled, sellLevel.getAmount(0) - amountFilled, sellLevel.getTime(0));
+        recordTrade(tradeTick);
+
+        if(buyLevel.fill(0, amountFilled) == 0)
+        {
+            m_orderStore.release(buyLevel.getSlot(0));
+            buyLevel.popFront();
+            refreshLevel(true, buyTick, buyGroup);
+        }
+
+        if(sellLevel.fill(0, amountFilled) == 0)
+        {
+            m_orderStore.release(sellLevel.getSlot(0));
+            sellLevel.popFront();
+            refreshLevel(false, sellTick, sellGroup);
+        }
     }
 }
 
@@ -162,121 +896,403 @@ void Orderbook::matchOrdersFIFO()
 */
 void Orderbook::matchOrdersProRata()
 {
-    std::cout << "Initiating Pro-Rata order-matching" << std::endl;
+    TRACE_SCOPE("match", "matchOrdersProRata");
 
-    while(!(*m_buyOrders).empty() && !(*m_sellOrders).empty())
+    if(!canMatch())
     {
-        if((*m_buyOrders).top().getPrice() < (*m_sellOrders).top().getPrice())
+        return;
+    }
+
+    int buyTick = 0, bestSellTick = 0;
+    PriceLevel* buyLevelPtr = nullptr;
+    PriceLevel* bestSellLevel = nullptr;
+    PegBook::PegGroup* buyGroup = nullptr;
+    PegBook::PegGroup* bestSellGroup = nullptr;
+
+    while(!m_isHalted && findBestLevel(true, buyTick, buyLevelPtr, buyGroup) && findBestLevel(false, bestSellTick, bestSellLevel, bestSellGroup))
+    {
+        if(buyTick < bestSellTick)
         {
             LOG_DEBUG("NOTE - matchOrdersProRata(): Best buy price does not fulfill best sell price, waiting for new orders");
             break;
         }
 
-        Order bestBuy = (*m_buyOrders).top();
-        int buyAmount = bestBuy.getAmount();
-        (*m_buyOrders).pop();
-
-        std::vector<Order> matchingOrders;
+        PriceLevel& buyLevel = *buyLevelPtr;
+        const int bestBuyID = buyLevel.getID(0);
+        const int bestBuyTime = buyLevel.getTime(0);
+        const int buyAmountBeforeMatching = buyLevel.getAmount(0);
+        int buyAmount = buyAmountBeforeMatching;
 
-        // Finding all sell orders at a matching price level with the best buy order
-        while(bestBuy.getPrice() >= (*m_sellOrders).top().getPrice())
+        // Partially filling all sell orders at each successive matching price level, until either the buy order is filled or no more sell orders match.
+        // Limit price levels and active groups of pegged sell orders, priced as of the start of the sweep, are walked together by price
+        const std::vector<PegBook::PegGroup*>& sellGroups = m_peggedOrders.getActiveGroups(false);
+        size_t sellGroupIndex = 0;
+        int ladderSellTick = m_sellOrders.bestTick();
+        while(buyAmount > 0)
         {
-            // NOTE: This is creating two copies of the same Order object (push_back() creates a copy of the object it is, passed, which it then adds to the vector)
-            //       See if this can be improved
-            Order bestSell = (*m_sellOrders).top();
-            matchingOrders.push_back(bestSell);
-            (*m_sellOrders).pop();
+            TRACE_SCOPE("match", "level sweep");
 
-            if((*m_sellOrders).empty())
+            const bool hasSellGroup = !m_peggedOrders.empty() && sellGroupIndex < sellGroups.size();
+            const bool isLadderLevel = ladderSellTick != PriceLadder::NO_PRICE && (!hasSellGroup || ladderSellTick <= sellGroups[sellGroupIndex]->effectiveTick);
+            if(!isLadderLevel && !hasSellGroup)
             {
-                LOG_DEBUG("NOTE - matchOrdersProRata(): All remaining sell orders in the orderbook are being filled");
                 break;
             }
-        }
-        
-        // Partially filling all sell orders at each successive price level, until there are either no more buy orders remaining or no more sell orders to fill
-        int curIndex = 0;
-        int indexNextPriceLevel = 0;
-        const int numMatchingSells = matchingOrders.size();
-        bool buyOrdersStillRemaining = true;
-        while(curIndex < numMatchingSells && buyOrdersStillRemaining)
-        {
-            // Finding the index of the earliest sell order at the next price level
-            for(int i = curIndex; i < numMatchingSells; i++)
-            {
-                indexNextPriceLevel++;
-
-                if(matchingOrders[indexNextPriceLevel].getPrice() > matchingOrders[curIndex].getPrice())
-                {
-                    break;
-                }
-            }
 
-            // Finding the total amount of sell orders at the current price level
-            int curTotalSellAmount = 0;
-            for(int i = curIndex; i < indexNextPriceLevel; i++)
+            const int sellTick = isLadderLevel ? ladderSellTick : sellGroups[sellGroupIndex]->effectiveTick;
+            if(sellTick > buyTick)
             {
-                curTotalSellAmount += matchingOrders[i].getAmount();
+                break;
             }
 
-            LOG_DEBUG("matchingOrdersProRata: Current price level of sell orders: " << matchingOrders[curIndex].getPrice() \
+            PriceLevel& sellLevel = isLadderLevel ? m_sellOrders.getLevel(sellTick) : sellGroups[sellGroupIndex]->orders;
+            const long long curTotalSellAmount = sellLevel.getTotalAmount();
+            const size_t numSellsAtLevel = sellLevel.size();
+            const int* sellAmounts = sellLevel.amounts();
+
+            LOG_DEBUG("matchingOrdersProRata: Current price level of sell orders: " << Order::ticksToPrice(sellTick) \
                       << ", Total number of sell orders at current price level: " << curTotalSellAmount);
 
             int buyAmountBeforeFillingCurPriceLevel = buyAmount;
             // Partially filling each sell order at the current price level according to the proportion they make up of the current price level
-            for(int i = curIndex; i < indexNextPriceLevel; i++)
-            {    
-                if(i >= numMatchingSells)
+            for(size_t i = 0; i < numSellsAtLevel; i++)
+            {
+                // The fill prints at the price of the order that was resting first, and halts matching instead if that is outside of the price bands
+                const int tradeTick = (bestBuyTime < sellLevel.getTime(i)) ? buyTick : sellTick;
+                if(isOutsideBands(tradeTick))
                 {
-                    std::cerr << "ERROR - matchOrdersProRata: index" << i << "out of bounds (total matching sell orders: " << numMatchingSells \
-                              << ") while filling sell orders" << std::endl;
-                    buyOrdersStillRemaining = false; // Doing this to exit the current while loop
+                    haltMatching(tradeTick);
                     break;
                 }
-                
-                int sellAmount = matchingOrders[i].getAmount();
+
+                int sellAmount = sellAmounts[i];
                 float proportion = (float)sellAmount / (float)curTotalSellAmount;
                 int amountFilled = std::min(std::min(buyAmount, sellAmount), (int)std::ceil(buyAmountBeforeFillingCurPriceLevel * proportion));
 
                 buyAmount -= amountFilled;
-                sellAmount -= amountFilled;
-                matchingOrders[i].setAmount(sellAmount);
+                sellAmount = sellLevel.fill(i, amountFilled);
 
                 LOG_DEBUG("    matchingOrdersProRata - processed order:    Amount filled: " << amountFilled \
                           << "\n                                                Proportion of total sell orders at current price level: " << proportion \
-                          << "\n                                                Seller: ID: " << matchingOrders[i].getID() << ", Amount remaining: " << sellAmount \
-                          << "\n                                                Buyer: ID: " << bestBuy.getID() << ", Amount remaining: " << buyAmount)
-                m_orderHistory.emplace(ProcessedOrder(bestBuy.getID(), matchingOrders[i].getID(), amountFilled)); // Updating order book history
+                          << "\n                                                Seller: ID: " << sellLevel.getID(i) << ", Amount remaining: " << sellAmount \
+                          << "\n                                                Buyer: ID: " << bestBuyID << ", Amount remaining: " << buyAmount)
+                m_orderHistory.emplace_back(bestBuyID, sellLevel.getID(i), amountFilled); // Updating order book history
+                publish(MarketByOrder::ORDER_EXECUTED, bestBuyID, true, buyTick, amountFilled, buyAmount, bestBuyTime);
+                publish(MarketByOrder::ORDER_EXECUTED, sellLevel.getID(i), false, sellTick, amountFilled, sellAmount, sellLevel.getTime(i));
+                recordTrade(tradeTick);
+
+                if(sellAmount == 0)
+                {
+                    m_orderStore.release(sellLevel.getSlot(i));
+                }
 
                 if(buyAmount == 0)
                 {
-                    buyOrdersStillRemaining = false;
                     break;
                 }
             }
 
-            // Move on to the next price level
-            curIndex = indexNextPriceLevel;
+            // Removing completely filled sell orders and moving on to the next price level
+            sellLevel.removeFilled();
+            if(isLadderLevel)
+            {
+                ladderSellTick = m_sellOrders.nextTick(sellTick);
+                m_sellOrders.refreshLevel(sellTick);
+            }
+            else
+            {
+                m_peggedOrders.markStale();
+                sellGroupIndex++;
+            }
+
+            if(m_isHalted)
+            {
+                break;
+            }
+        }
+
+        // Removing the best buy order from the order book if it is completely filled
+        if(buyLevel.fill(0, buyAmountBeforeMatching - buyAmount) == 0)
+        {
+            m_orderStore.release(buyLevel.getSlot(0));
+            buyLevel.popFront();
+            refreshLevel(true, buyTick, buyGroup);
+        }
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * matchOrdersAuction()
+ * 
+ * Clears every crossing buy and sell order at one uniform price, as a call auction at
+ * the end of a batch of orders. The price is the one executing the largest amount,
+ * found by one pass over the crossing price levels in ascending order while summing
+ * supply (sells at or below the price) and demand (buys at or above it). Ties go to the
+ * smallest imbalance between them, then to the higher price if demand exceeds supply,
+ * and to the middle of the tied prices if neither does. Orders are filled in price,
+ * then time priority. Pegged orders take no part in the auction
+ * --------------------------------------------------------------------------------------
+*/
+void Orderbook::matchOrdersAuction()
+{
+    TRACE_SCOPE("match", "matchOrdersAuction");
+
+    m_lastAuctionTicks = PriceLadder::NO_PRICE;
+    m_lastAuctionVolume = 0;
+
+    const int bestBuyTick = m_buyOrders.bestTick();
+    const int bestSellTick = m_sellOrders.bestTick();
+    if(bestBuyTick == PriceLadder::NO_PRICE || bestSellTick == PriceLadder::NO_PRICE || bestBuyTick < bestSellTick)
+    {
+        LOG_DEBUG("NOTE - matchOrdersAuction(): Best buy price does not fulfill best sell price, nothing to clear");
+        return;
+    }
+
+    // Only levels between the best sell and best buy prices can trade, buys are collected from the highest price down, sells from the lowest up
+    m_auctionBuyLevels.clear();
+    m_auctionSellLevels.clear();
+    long long demand = 0;
+
+    for(int tick = bestBuyTick; tick != PriceLadder::NO_PRICE && tick >= bestSellTick; tick = m_buyOrders.nextTick(tick))
+    {
+        m_auctionBuyLevels.emplace_back(tick, m_buyOrders.getLevel(tick).getTotalAmount());
+        demand += m_auctionBuyLevels.back().second;
+    }
+
+    for(int tick = bestSellTick; tick != PriceLadder::NO_PRICE && tick <= bestBuyTick; tick = m_sellOrders.nextTick(tick))
+    {
+        m_auctionSellLevels.emplace_back(tick, m_sellOrders.getLevel(tick).getTotalAmount());
+    }
+
+    // Sweeping every price with a crossing level upwards: demand loses the buys below the price, supply gains the sells at it
+    long long supply = 0;
+    long long bestVolume = 0;
+    long long bestImbalance = 0;
+    int lowTick = PriceLadder::NO_PRICE;
+    int highTick = PriceLadder::NO_PRICE;
+    size_t buyIndex = m_auctionBuyLevels.size();
+    size_t sellIndex = 0;
+
+    while(buyIndex > 0 || sellIndex < m_auctionSellLevels.size())
+    {
+        int tick = INT_MAX;
+        if(buyIndex > 0)
+        {
+            tick = m_auctionBuyLevels[buyIndex - 1].first;
+        }
+        if(sellIndex < m_auctionSellLevels.size())
+        {
+            tick = std::min(tick, m_auctionSellLevels[sellIndex].first);
         }
-        
-        // Re-adding any partially filled sell orders to the minheap of sell orders
-        for(Order& matchingSell : matchingOrders)
+
+        while(sellIndex < m_auctionSellLevels.size() && m_auctionSellLevels[sellIndex].first == tick)
         {
-            if(matchingSell.getAmount() > 0)
+            supply += m_auctionSellLevels[sellIndex++].second;
+        }
+
+        const long long volume = std::min(demand, supply);
+        const long long imbalance = demand - supply;
+
+        if(volume > bestVolume || (volume == bestVolume && volume > 0 && std::llabs(imbalance) < std::llabs(bestImbalance)))
+        {
+            bestVolume = volume;
+            bestImbalance = imbalance;
+            lowTick = tick;
+            highTick = tick;
+        }
+        else if(volume == bestVolume && volume > 0 && std::llabs(imbalance) == std::llabs(bestImbalance))
+        {
+            // Excess demand pushes the price up, and a balanced range is split in the middle
+            if(imbalance > 0)
             {
-                (*m_sellOrders).push(matchingSell);
+                bestImbalance = imbalance;
+                lowTick = tick;
+                highTick = tick;
             }
+            else if(imbalance == 0 && bestImbalance == 0)
+            {
+                highTick = tick;
+            }
+        }
+
+        while(buyIndex > 0 && m_auctionBuyLevels[buyIndex - 1].first == tick)
+        {
+            demand -= m_auctionBuyLevels[--buyIndex].second;
+        }
+    }
+
+    if(bestVolume == 0)
+    {
+        return;
+    }
+
+    const int clearingTick = lowTick + (highTick - lowTick) / 2;
+    m_lastAuctionTicks = clearingTick;
+    m_lastAuctionVolume = bestVolume;
+    recordTrade(clearingTick);
+
+    // Every buy at or above the clearing price and every sell at or below it come first in priority, so filling from the top of both sides executes exactly the volume
+    long long remainingVolume = bestVolume;
+    while(remainingVolume > 0)
+    {
+        const int buyTick = m_buyOrders.bestTick();
+        const int sellTick = m_sellOrders.bestTick();
+        PriceLevel& buyLevel = m_buyOrders.getLevel(buyTick);
+        PriceLevel& sellLevel = m_sellOrders.getLevel(sellTick);
+
+        int amountFilled = (int)std::min<long long>(std::min(buyLevel.getAmount(0), sellLevel.getAmount(0)), remainingVolume);
+        remainingVolume -= amountFilled;
+        m_orderHistory.emplace_back(buyLevel.getID(0), sellLevel.getID(0), amountFilled);
+        publish(MarketByOrder::ORDER_EXECUTED, buyLevel.getID(0), true, clearingTick, amountFilled, buyLevel.getAmount(0) - amountFilled, buyLevel.getTime(0));
+        publish(MarketByOrder::ORDER_EXECUTED, sellLevel.getID(0), false, clearingTick, amountFilled, sellLevel.getAmount(0) - amountFilled, sellLevel.getTime(0));
+
+        if(buyLevel.fill(0, amountFilled) == 0)
+        {
+            m_orderStore.release(buyLevel.getSlot(0));
+            buyLevel.popFront();
+            m_buyOrders.refreshLevel(buyTick);
         }
 
-        // Re-adding the best buy order to the minheap of buy orders if it is not completely filled
-        if(buyAmount > 0)
+        if(sellLevel.fill(0, amountFilled) == 0)
         {
-            bestBuy.setAmount(buyAmount);
-            (*m_buyOrders).push(bestBuy);
+            m_orderStore.release(sellLevel.getSlot(0));
+            sellLevel.popFront();
+            m_sellOrders.refreshLevel(sellTick);
         }
     }
 }
 
+/**--------------------------------------------------------------------------------------
+ * canTradeAt()
+ * 
+ * Checks whether a fill may print at a price before anything is filled, e.g. for every
+ * book of an implied match so that none is filled unless all are. A price outside of the
+ * price bands halts matching, as a fill there would from the matching loop
+ * 
+ * @param[in] tradeTick Price the fill would print at
+ * @return true if the order book is not halted and the price is inside the price bands
+ * --------------------------------------------------------------------------------------
+*/
+bool Orderbook::canTradeAt(int tradeTick)
+{
+    if(m_isHalted)
+    {
+        LOG_DEBUG("NOTE - canTradeAt(): " << m_ticker << " is halted for a volatility auction");
+        return false;
+    }
+
+    if(isOutsideBands(tradeTick))
+    {
+        haltMatching(tradeTick);
+        return false;
+    }
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * fillBestLevel()
+ * 
+ * Fills an amount from the best price level of one side in time priority, without a
+ * counterparty in this order book, e.g. for one leg of an implied match whose other legs
+ * trade in other order books. Nothing is filled unless the level holds the whole amount
+ * and matching may trade at its price: a level outside of the price bands halts matching
+ * instead, as a fill there would from the matching loop
+ * 
+ * @param[in]       isBuy   Side whose best (limit) price level is filled
+ * @param[in]       amount  Amount to be filled
+ * @param[in,out]   fills   ID and amount filled of every order filled are appended to it
+ * @return true if the amount was filled, false if the best price level holds less, the
+ *         order book is halted or the level is outside of the price bands
+ * --------------------------------------------------------------------------------------
+*/
+bool Orderbook::fillBestLevel(bool isBuy, int amount, std::vector<std::pair<int, int>>& fills)
+{
+    PriceLadder& side = isBuy ? m_buyOrders : m_sellOrders;
+    const int tick = side.bestTick();
+
+    if(amount <= 0 || tick == PriceLadder::NO_PRICE || side.getLevel(tick).getTotalAmount() < amount)
+    {
+        std::cerr << "ERROR - fillBestLevel(): the best " << (isBuy ? "buy" : "sell") << " price level of " << m_ticker << " cannot fill " << amount << std::endl;
+        return false;
+    }
+
+    if(!canTradeAt(tick))
+    {
+        return false;
+    }
+
+    PriceLevel& level = side.getLevel(tick);
+    recordTrade(tick);
+
+    while(amount > 0)
+    {
+        int amountFilled = std::min(level.getAmount(0), amount);
+        amount -= amountFilled;
+        fills.emplace_back(level.getID(0), amountFilled);
+        publish(MarketByOrder::ORDER_EXECUTED, level.getID(0), isBuy, tick, amountFilled, level.getAmount(0) - amountFilled, level.getTime(0));
+
+        if(level.fill(0, amountFilled) == 0)
+        {
+            m_orderStore.release(level.getSlot(0));
+            level.popFront();
+        }
+    }
+
+    side.refreshLevel(tick);
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * getFillCost()
+ * 
+ * Prices an amount as if it were filled from one side, from the best price level down,
+ * reading only the total amount of each price level and filling nothing. Every level is
+ * checked against the price bands as they would be after filling the levels before it
+ * 
+ * @param[in]   isBuy       Side whose (limit) price levels would be filled
+ * @param[in]   amount      Amount that would be filled
+ * @param[out]  costTicks   Sum of the price in ticks of every unit that would be filled
+ * @return true if the side holds the whole amount inside of the price bands
+ * --------------------------------------------------------------------------------------
+*/
+bool Orderbook::getFillCost(bool isBuy, long long amount, long long& costTicks) const
+{
+    const PriceLadder& side = isBuy ? m_buyOrders : m_sellOrders;
+    costTicks = 0;
+
+    // Each fill moves the dynamic band onto its price, and the first one sets the reference price if there is none yet
+    int referenceTicks = m_referenceTicks;
+    int lastTradeTicks = m_lastTradeTicks;
+    int bandLowTicks = m_bandLowTicks;
+    unsigned int bandWidthTicks = m_bandWidthTicks;
+
+    for(int tick = side.bestTick(); tick != PriceLadder::NO_PRICE && amount > 0; tick = side.nextTick(tick))
+    {
+        if((unsigned int)tick - (unsigned int)bandLowTicks > bandWidthTicks)
+        {
+            return false;
+        }
+
+        long long amountFilled = std::min(amount, side.getLevel(tick).getTotalAmount());
+        costTicks += amountFilled * tick;
+        amount -= amountFilled;
+
+        if(tick != lastTradeTicks)
+        {
+            lastTradeTicks = tick;
+            if(referenceTicks == PriceLadder::NO_PRICE)
+            {
+                referenceTicks = tick;
+            }
+            computePriceBands(referenceTicks, lastTradeTicks, bandLowTicks, bandWidthTicks);
+        }
+    }
+
+    return amount <= 0;
+}
+
 /**--------------------------------------------------------------------------------------
  * printOrderHistory()
  * 
@@ -285,14 +1301,15 @@ void Orderbook::matchOrdersProRata()
 */
 void Orderbook::printOrderHistory()
 {
-    while(!m_orderHistory.empty())
+    TRACE_SCOPE("output", "printOrderHistory");
+
+    for(const ProcessedOrder& curProcessed : m_orderHistory)
     {
-        ProcessedOrder& curProcessed = m_orderHistory.front();
         std::cout << "    ORDER PROCESSED:   Buyer ID: " << curProcessed.buyID << ",   Amount filled: " << curProcessed.fillAmount \
                   << ",   Seller ID: " << curProcessed.sellID << std::endl;
-
-        m_orderHistory.pop();
     }
+
+    m_orderHistory.clear();
 }
 
 /**--------------------------------------------------------------------------------------
@@ -303,46 +1320,64 @@ void Orderbook::printOrderHistory()
  *     Buy orders are arranged in ascending order, based on price, then time.
  * --------------------------------------------------------------------------------------
 */
-void Orderbook::printOrderbookContents()
+void Orderbook::printOrderbookContents() const
 {
-    std::stack<Order> sellOrdersAscending;
+    TRACE_SCOPE("output", "printOrderbookContents");
 
     std::cout << "    Id   Side    Time   Qty   Price   Qty    Time   Side\n    ---+------+-------+-----+-------+-----+-------+------" << std::endl;
 
-    // Arranging sell orders into descending order, based on price, then time
-    while(!(*m_sellOrders).empty())
+    // Printing sell orders remaining in the order book, walking from the worst (highest) price level to the best
+    for(int tick = m_sellOrders.worstTick(); tick != PriceLadder::NO_PRICE; tick = m_sellOrders.prevTick(tick))
     {
-        sellOrdersAscending.push((*m_sellOrders).top());
-        (*m_sellOrders).pop();
+        const PriceLevel& curLevel = m_sellOrders.getLevel(tick);
+
+        for(size_t i = curLevel.size(); i > 0; i--)
+        {
+            std::cout << "    #" << curLevel.getID(i - 1) << "                        " << std::fixed << std::setprecision(2) << Order::ticksToPrice(tick) << "   " \
+                      << curLevel.getAmount(i - 1) << "   " << Order::formatTime(curLevel.getTime(i - 1)) << "   SELL" << std::endl;
+        }
     }
 
-    // Printing sell orders remaining in the order book
-    while(!sellOrdersAscending.empty())
+    // Printing buy orders remaining in the order book, walking from the best (highest) price level to the worst
+    for(int tick = m_buyOrders.bestTick(); tick != PriceLadder::NO_PRICE; tick = m_buyOrders.nextTick(tick))
     {
-        const Order& curSell = sellOrdersAscending.top();
-        int intTime = curSell.getTime();
-        std::string stringTime = "";
+        const PriceLevel& curLevel = m_buyOrders.getLevel(tick);
 
-        stringTime = std::to_string((intTime / 1000) % 10) + std::to_string((intTime / 100) % 10) + ":" + std::to_string((intTime / 10) % 10) + std::to_string(intTime % 10);
-
-        std::cout << "    #" << curSell.getID() << "                        " << std::fixed << std::setprecision(2) << curSell.getPrice() << "   " \
-                  << curSell.getAmount() << "   " << stringTime << "   SELL" << std::endl;
-
-        sellOrdersAscending.pop();
+        for(size_t i = 0; i < curLevel.size(); i++)
+        {
+            std::cout << "    #" << curLevel.getID(i) << "   BUY    " << Order::formatTime(curLevel.getTime(i)) << "   " << curLevel.getAmount(i) << "   " << std::fixed << std::setprecision(2) \
+                      << Order::ticksToPrice(tick) << std::endl;
+        }
     }
-
-    // Printing buy orders remaining in the order book
-    while(!(*m_buyOrders).empty())
+    if(m_peggedOrders.empty())
     {
-        const Order& curBuy = (*m_buyOrders).top();
-        int intTime = curBuy.getTime();
-        std::string stringTime = "";
+        return;
+    }
 
-        stringTime = std::to_string((intTime / 1000) % 10) + std::to_string((intTime / 100) % 10) + ":" + std::to_string((intTime / 10) % 10) + std::to_string(intTime % 10);
+    // Printing pegged orders, group by group, at the price they would match at now
+    static const char* REFERENCE_NAMES[] = { "", "PRIMARY", "MARKET", "MIDPOINT" };
 
-        std::cout << "    #" << curBuy.getID() << "   BUY    " << stringTime << "   " << curBuy.getAmount() << "   " << std::fixed << std::setprecision(2) \
-                  << curBuy.getPrice() << std::endl;
+    std::cout << "    Pegged orders:" << std::endl;
+    for(int isBuy = 1; isBuy >= 0; isBuy--)
+    {
+        for(const std::unique_ptr<PegBook::PegGroup>& curGroup : m_peggedOrders.getGroups(isBuy))
+        {
+            int tick = PegBook::getEffectiveTick(isBuy, *curGroup, m_buyOrders.bestTick(), m_sellOrders.bestTick());
+            const PriceLevel& curLevel = curGroup->orders;
 
-        (*m_buyOrders).pop();
+            for(size_t i = 0; i < curLevel.size(); i++)
+            {
+                std::cout << "    #" << curLevel.getID(i) << (isBuy ? "   BUY    " : "   SELL   ") << Order::formatTime(curLevel.getTime(i)) << "   " << curLevel.getAmount(i) << "   ";
+                if(tick == PriceLadder::NO_PRICE)
+                {
+                    std::cout << "-";
+                }
+                else
+                {
+                    std::cout << std::fixed << std::setprecision(2) << Order::ticksToPrice(tick);
+                }
+                std::cout << "   " << REFERENCE_NAMES[curGroup->reference] << " " << std::showpos << curGroup->offsetTicks << std::noshowpos << std::endl;
+            }
+        }
     }
 }
\ No newline at end of file
@@ -34,9 +34,15 @@
 #pragma once
 
 #include <string>
-#include <queue>
+#include <vector>
+#include <utility>
+#include <climits>
 
 #include "order.h"
+#include "priceladder.h"
+#include "orderstore.h"
+#include "pegbook.h"
+#include "marketbyorder.h"
 
 /**--------------------------------------------------------------------------------------
  * ProcessedOrder struct
@@ -55,6 +61,20 @@ typedef struct ProcessedOrder
     {} 
 } ProcessedOrder;
 
+/**--------------------------------------------------------------------------------------
+ * QuoteEntry struct
+ * 
+ * One level of one side of a market maker's quote
+ * --------------------------------------------------------------------------------------
+*/
+typedef struct QuoteEntry
+{
+    int orderID;        // ID of the quote order at this level, kept from one quote to the next
+    bool isBuy;
+    int priceTicks;
+    int amount;         // 0 to pull the level
+} QuoteEntry;
+
 
 
 /**--------------------------------------------------------------------------------------
@@ -77,13 +97,89 @@ public:
     */
     Orderbook(std::string ticker);
 
+    Orderbook(const Orderbook&) = delete;
+    Orderbook& operator=(const Orderbook&) = delete;
+
     /**--------------------------------------------------------------------------------------
-     * Destructor
+     * setFeed()
+     * 
+     * Publishes every change to every resting order from now on: adds, cancels, reductions,
+     * replacements and the executions of both sides of every fill
+     * 
+     * @param[in] feed  Market-by-order feed to publish to, or nullptr to stop publishing
+     * --------------------------------------------------------------------------------------
+    */
+    void setFeed(MarketByOrderPublisher* feed)
+    {
+        m_feed = feed;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * setPriceBands()
+     * 
+     * Limits the prices continuous matching may trade at: a static band around the
+     * reference price and a dynamic band around the last trade. A fill that would print
+     * outside of either band is not executed, instead matching halts and the book collects
+     * orders for a short volatility auction, which reopens it. A fill prints at the price
+     * of whichever of its two orders arrived first
+     * 
+     * @param[in] staticBasisPoints     Half width of the static band in 1/100 of a percent of
+     *                                  the reference price, 0 for no static band
+     * @param[in] dynamicBasisPoints    Half width of the dynamic band in 1/100 of a percent of
+     *                                  the last trade, 0 for no dynamic band
+     * @param[in] auctionLength         Time a volatility auction lasts, in the units of order
+     *                                  time, it ends once an order at least this much later
+     *                                  than the halt has been added
+     * --------------------------------------------------------------------------------------
+    */
+    void setPriceBands(int staticBasisPoints, int dynamicBasisPoints, int auctionLength);
+
+    /**--------------------------------------------------------------------------------------
+     * setReferencePrice()
+     * 
+     * Sets the price the static band is centered on. Without one, the first trade is used
+     * 
+     * @param[in] priceTicks    Reference price in ticks
+     * --------------------------------------------------------------------------------------
+    */
+    void setReferencePrice(int priceTicks);
+
+    /**--------------------------------------------------------------------------------------
+     * reserve()
+     * 
+     * Preallocates room for resting orders and order history, so that adding, matching and
+     * cancelling orders within these limits does not allocate any memory
+     * 
+     * @param[in] maxRestingOrders  Largest number of orders expected to rest at the same time
+     * @param[in] maxHistory        Largest number of fills expected between two calls to
+     *                              printOrderHistory()/clearOrderHistory()
+     * --------------------------------------------------------------------------------------
+    */
+    void reserve(size_t maxRestingOrders, size_t maxHistory);
+
+    /**--------------------------------------------------------------------------------------
+     * prefault()
+     * 
+     * Touches all memory reserved for resting orders and order history, and allocates and
+     * touches the price levels around the expected best prices on both sides, so that the
+     * first orders after startup do not pay for page faults. Fewer levels are prefaulted if
+     * they would take more than MAX_PREFAULT_BYTES
      * 
-     * Destroys m_buyOrders and m_sellOrders
+     * @param[in] centerTicks       Price in ticks the best prices are expected around, or
+     *                              PriceLadder::NO_PRICE to prefault no price level
+     * @param[in] levelsPerSide     Number of price levels prefaulted above and below it
+     * @param[in] ordersPerLevel    Number of orders to make room for at each price level
      * --------------------------------------------------------------------------------------
     */
-    ~Orderbook();
+    void prefault(int centerTicks, int levelsPerSide, size_t ordersPerLevel);
+
+    /**--------------------------------------------------------------------------------------
+     * clear()
+     * 
+     * Removes every resting order from the order book, keeping all memory allocated for them
+     * --------------------------------------------------------------------------------------
+    */
+    void clear();
 
     /**--------------------------------------------------------------------------------------
      * addOrder()
@@ -91,9 +187,131 @@ public:
      * Adds a new order to the order book, either on the buy or sell side
      * 
      * @param[in] newOrder  new order to be added
+     * @return true if the order was added, false if its price is NO_PRICE or an order with
+     *         the same ID is resting
+     * --------------------------------------------------------------------------------------
+    */
+    bool addOrder(const Order& newOrder);
+
+    /**--------------------------------------------------------------------------------------
+     * addPeggedOrder()
+     * 
+     * Adds a new order whose price follows the best buy price, the best sell price or their
+     * midpoint, plus an offset. It rests in a group with the other orders of its side pegged
+     * the same way and matches at the group's current price, which is only recomputed when
+     * the best limit prices have moved and the group is needed again
+     * 
+     * @param[in] newOrder      new order to be added, its price is ignored
+     * @param[in] reference     Price the order follows
+     * @param[in] offsetTicks   Ticks added to the reference price, e.g. -1 to buy one tick
+     *                          below the best buy price
+     * @return true if the order was added, false if the reference is NOT_PEGGED or an order
+     *         with the same ID is resting
+     * --------------------------------------------------------------------------------------
+    */
+    bool addPeggedOrder(const Order& newOrder, PegReference reference, int offsetTicks);
+
+    /**--------------------------------------------------------------------------------------
+     * cancelOrder()
+     * 
+     * Removes a resting order from the order book
+     * 
+     * @param[in] orderID   ID of the order to be cancelled
+     * @return true if the order was removed, false if no order with that ID is resting
+     * --------------------------------------------------------------------------------------
+    */
+    bool cancelOrder(int orderID);
+
+    /**--------------------------------------------------------------------------------------
+     * cancelOrdersOfOwner()
+     * 
+     * Removes every resting order of one owner, e.g. to mass cancel an account. Only the
+     * owner's own orders are visited
+     * 
+     * @param[in] owner ID of the account/participant whose orders are cancelled
+     * @return the number of orders removed
+     * --------------------------------------------------------------------------------------
+    */
+    size_t cancelOrdersOfOwner(unsigned int owner);
+
+    /**--------------------------------------------------------------------------------------
+     * cancelOrdersOfSession()
+     * 
+     * Removes every resting order that came through one order-entry session, e.g. when the
+     * session disconnects. Orders its owners entered through other sessions stay, and only the
+     * session's own orders are visited
+     * 
+     * @param[in] session   ID of the session whose orders are cancelled, not 0
+     * @return the number of orders removed
+     * --------------------------------------------------------------------------------------
+    */
+    size_t cancelOrdersOfSession(unsigned int session);
+
+    /**--------------------------------------------------------------------------------------
+     * reduceOrder()
+     * 
+     * Takes part of the amount of a resting order away without changing its time priority,
+     * e.g. when it is executed or partially cancelled on another venue, removing the order
+     * once nothing is left of it
+     * 
+     * @param[in] orderID   ID of the order to be reduced
+     * @param[in] amount    Amount taken away, capped at the order's remaining amount
+     * @return true if the order was reduced, false if the amount is not positive or no order
+     *         with that ID is resting
+     * --------------------------------------------------------------------------------------
+    */
+    bool reduceOrder(int orderID, int amount);
+
+    /**--------------------------------------------------------------------------------------
+     * replaceOrder()
+     * 
+     * Removes a resting order and adds a new order on the same side for the same owner and
+     * session, which loses the time priority of the original
+     * 
+     * @param[in] orderID       ID of the order to be replaced
+     * @param[in] newOrderID    ID of the new order
+     * @param[in] newPrice      Price of the new order
+     * @param[in] newTime       Time of the new order
+     * @param[in] newAmount     Amount of the new order
+     * @return true if the new order was added, false if no order with that ID is resting or
+     *         the new price is NO_PRICE (the original order is removed either way)
      * --------------------------------------------------------------------------------------
     */
-    void addOrder(Order newOrder);
+    bool replaceOrder(int orderID, long long newOrderID, float newPrice, int newTime, int newAmount);
+
+    /**--------------------------------------------------------------------------------------
+     * applyQuote()
+     * 
+     * Replaces every level of a market maker's quote in one call. The order of each entry is
+     * added if it is not resting yet, removed if its amount is 0, and otherwise updated in
+     * place in the slot it already holds: a smaller amount at the same price keeps its time
+     * priority, a larger amount or a new price moves it to the back of its new level. Every
+     * entry is checked before any is applied, and every price but NO_PRICE can be held by the
+     * ladders whatever the removals do to them, so the quote is applied either completely or
+     * not at all
+     * 
+     * @param[in] owner     ID of the market maker, every resting order of the quote must be
+     *                      its own
+     * @param[in] entries   Levels of the quote, each with its own order ID
+     * @param[in] time      Time of the quote, given to orders that are added or moved
+     * @return true if the quote was applied, false if an entry has a negative amount, the
+     *         price NO_PRICE, the ID of another entry, or the ID of another owner's order, of an
+     *         order on the other side or of a pegged order
+     * --------------------------------------------------------------------------------------
+    */
+    bool applyQuote(unsigned int owner, const std::vector<QuoteEntry>& entries, int time);
+
+    /**--------------------------------------------------------------------------------------
+     * bulkLoad()
+     * 
+     * Adds a whole batch of orders to the order book at once, in O(n). Orders are partitioned
+     * by side and each side is counting-sorted by price into its levels, so that every price
+     * level is filled by appending instead of inserting orders one by one at random levels
+     * 
+     * @param[in] orders    orders to be added, e.g. every row of an opening order file
+     * --------------------------------------------------------------------------------------
+    */
+    void bulkLoad(const std::vector<Order>& orders);
 
     /**--------------------------------------------------------------------------------------
      * matchOrdersFIFO()
@@ -114,6 +332,133 @@ public:
     */
     void matchOrdersProRata();
 
+    /**--------------------------------------------------------------------------------------
+     * matchOrdersAuction()
+     * 
+     * Clears every crossing buy and sell order at one uniform price, as a call auction at
+     * the end of a batch of orders. The price is the one executing the largest amount,
+     * found by one pass over the crossing price levels in ascending order while summing
+     * supply (sells at or below the price) and demand (buys at or above it). Ties go to the
+     * smallest imbalance between them, then to the higher price if demand exceeds supply,
+     * and to the middle of the tied prices if neither does. Orders are filled in price,
+     * then time priority. Pegged orders take no part in the auction
+     * --------------------------------------------------------------------------------------
+    */
+    void matchOrdersAuction();
+
+    /**--------------------------------------------------------------------------------------
+     * fillBestLevel()
+     * 
+     * Fills an amount from the best price level of one side in time priority, without a
+     * counterparty in this order book, e.g. for one leg of an implied match whose other legs
+     * trade in other order books. Nothing is filled unless the level holds the whole amount
+     * and matching may trade at its price: a level outside of the price bands halts matching
+     * instead, as a fill there would from the matching loop
+     * 
+     * @param[in]       isBuy   Side whose best (limit) price level is filled
+     * @param[in]       amount  Amount to be filled
+     * @param[in,out]   fills   ID and amount filled of every order filled are appended to it
+     * @return true if the amount was filled, false if the best price level holds less, the
+     *         order book is halted or the level is outside of the price bands
+     * --------------------------------------------------------------------------------------
+    */
+    bool fillBestLevel(bool isBuy, int amount, std::vector<std::pair<int, int>>& fills);
+
+    /**--------------------------------------------------------------------------------------
+     * canTradeAt()
+     * 
+     * Checks whether a fill may print at a price before anything is filled, e.g. for every
+     * book of an implied match so that none is filled unless all are. A price outside of the
+     * price bands halts matching, as a fill there would from the matching loop
+     * 
+     * @param[in] tradeTick Price the fill would print at
+     * @return true if the order book is not halted and the price is inside the price bands
+     * --------------------------------------------------------------------------------------
+    */
+    bool canTradeAt(int tradeTick);
+
+    /**--------------------------------------------------------------------------------------
+     * getFillCost()
+     * 
+     * Prices an amount as if it were filled from one side, from the best price level down,
+     * reading only the total amount of each price level and filling nothing. Every level is
+     * checked against the price bands as they would be after filling the levels before it
+     * 
+     * @param[in]   isBuy       Side whose (limit) price levels would be filled
+     * @param[in]   amount      Amount that would be filled
+     * @param[out]  costTicks   Sum of the price in ticks of every unit that would be filled
+     * @return true if the side holds the whole amount inside of the price bands
+     * --------------------------------------------------------------------------------------
+    */
+    bool getFillCost(bool isBuy, long long amount, long long& costTicks) const;
+
+    /**--------------------------------------------------------------------------------------
+     * getLastAuctionTicks()
+     * 
+     * @return the clearing price in ticks of the last matchOrdersAuction(), or
+     *         PriceLadder::NO_PRICE if no order crossed in it
+     * --------------------------------------------------------------------------------------
+    */
+    int getLastAuctionTicks() const
+    {
+        return m_lastAuctionTicks;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getLastAuctionVolume()
+     * 
+     * @return the amount executed by the last matchOrdersAuction()
+     * --------------------------------------------------------------------------------------
+    */
+    long long getLastAuctionVolume() const
+    {
+        return m_lastAuctionVolume;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * endVolatilityAuction()
+     * 
+     * Ends a halt right away, e.g. when no more orders will arrive: clears the book in an
+     * auction, re-centers both bands on its price and resumes continuous matching
+     * --------------------------------------------------------------------------------------
+    */
+    void endVolatilityAuction();
+
+    /**--------------------------------------------------------------------------------------
+     * isHalted()
+     * 
+     * @return true if a fill outside of the price bands halted continuous matching, and the
+     *         volatility auction that follows has not ended yet
+     * --------------------------------------------------------------------------------------
+    */
+    bool isHalted() const
+    {
+        return m_isHalted;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getHaltTicks()
+     * 
+     * @return the price in ticks of the fill that caused the last halt, or
+     *         PriceLadder::NO_PRICE if matching never halted
+     * --------------------------------------------------------------------------------------
+    */
+    int getHaltTicks() const
+    {
+        return m_haltTicks;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getNumHalts()
+     * 
+     * @return the number of times the price bands halted continuous matching
+     * --------------------------------------------------------------------------------------
+    */
+    size_t getNumHalts() const
+    {
+        return m_numHalts;
+    }
+
     /**--------------------------------------------------------------------------------------
      * printOrderHistory()
      * 
@@ -122,76 +467,303 @@ public:
     */
     void printOrderHistory();
 
+    /**--------------------------------------------------------------------------------------
+     * clearOrderHistory()
+     * 
+     * Discards the order history without printing it
+     * --------------------------------------------------------------------------------------
+    */
+    void clearOrderHistory()
+    {
+        m_orderHistory.clear();
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getOrderHistory()
+     * 
+     * @return every fill processed since the order history was last printed or cleared,
+     *         oldest first
+     * --------------------------------------------------------------------------------------
+    */
+    const std::vector<ProcessedOrder>& getOrderHistory() const
+    {
+        return m_orderHistory;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getTicker()
+     * 
+     * @return the ticker symbol of the order book's instrument
+     * --------------------------------------------------------------------------------------
+    */
+    const std::string& getTicker() const
+    {
+        return m_ticker;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getNumRestingOrders()
+     * 
+     * @return the number of buy and sell orders currently resting in the order book
+     * --------------------------------------------------------------------------------------
+    */
+    size_t getNumRestingOrders() const
+    {
+        return m_orderStore.size();
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * acceptsPrice()
+     * 
+     * @param[in] isBuy         Side of an order
+     * @param[in] priceTicks    Price of the order in ticks
+     * @return true if addOrder() would find room for an order at this price on that side
+     * --------------------------------------------------------------------------------------
+    */
+    bool acceptsPrice(bool isBuy, int priceTicks) const
+    {
+        return (isBuy ? m_buyOrders : m_sellOrders).accepts(priceTicks);
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getBestBuyTicks()
+     * 
+     * @return the price in ticks of the best (highest) buy limit order, or PriceLadder::NO_PRICE
+     *         if there is none
+     * --------------------------------------------------------------------------------------
+    */
+    int getBestBuyTicks() const
+    {
+        return m_buyOrders.bestTick();
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getBestSellTicks()
+     * 
+     * @return the price in ticks of the best (lowest) sell limit order, or PriceLadder::NO_PRICE
+     *         if there is none
+     * --------------------------------------------------------------------------------------
+    */
+    int getBestSellTicks() const
+    {
+        return m_sellOrders.bestTick();
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getBestAmount()
+     * 
+     * @param[in] isBuy Side of the order book
+     * @return the total amount of the best limit price level of that side, 0 if there is none
+     * --------------------------------------------------------------------------------------
+    */
+    long long getBestAmount(bool isBuy) const
+    {
+        const PriceLadder& side = isBuy ? m_buyOrders : m_sellOrders;
+        int tick = side.bestTick();
+        return (tick == PriceLadder::NO_PRICE) ? 0 : side.getLevel(tick).getTotalAmount();
+    }
+
     /**--------------------------------------------------------------------------------------
      * printOrderbookContents()
      * 
      * Prints the current buy and sell orders inside the order book. 
      *     Sell orders are arranged in descending order, based on price, then time. 
      *     Buy orders are arranged in ascending order, based on price, then time.
+     *     Pegged orders, if any, follow by side and group, at their current price.
      * --------------------------------------------------------------------------------------
     */
-    void printOrderbookContents();
+    void printOrderbookContents() const;
 
 private:
     /**--------------------------------------------------------------------------------------
-     * prioritizeMax
+     * removeOrder()
+     * 
+     * Removes a resting order from its price level and frees its slot
      * 
-     * Functor used to sort sell orders in the Maxheap according to price(greatest on top), 
-     * then time(least on top)
+     * @param[in] slot  Slot of the order
      * --------------------------------------------------------------------------------------
     */
-    class prioritizeMax
+    void removeOrder(unsigned int slot);
+
+    /**--------------------------------------------------------------------------------------
+     * isOutsideBands()
+     * 
+     * @param[in] tradeTick Price a fill would print at
+     * @return true if the price is outside of the price bands, checked with a single
+     *         unsigned compare: a price below the low end wraps around to a huge distance
+     * --------------------------------------------------------------------------------------
+    */
+    bool isOutsideBands(int tradeTick) const
+    {
+        return (unsigned int)tradeTick - (unsigned int)m_bandLowTicks > m_bandWidthTicks;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * recordTrade()
+     * 
+     * Moves the dynamic band with the price of the last fill
+     * 
+     * @param[in] tradeTick Price the fill printed at
+     * --------------------------------------------------------------------------------------
+    */
+    void recordTrade(int tradeTick)
+    {
+        if(tradeTick != m_lastTradeTicks)
+        {
+            m_lastTradeTicks = tradeTick;
+            updatePriceBands();
+        }
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * updatePriceBands()
+     * 
+     * Recomputes the lowest price and the width of the intersection of both bands, after the
+     * reference price or the last trade changed
+     * --------------------------------------------------------------------------------------
+    */
+    void updatePriceBands();
+
+    /**--------------------------------------------------------------------------------------
+     * computePriceBands()
+     * 
+     * Computes the lowest price and the width of the intersection of both bands around the
+     * given reference price and last trade
+     * 
+     * @param[in]   referenceTicks  Center of the static band, or PriceLadder::NO_PRICE
+     * @param[in]   lastTradeTicks  Center of the dynamic band, or PriceLadder::NO_PRICE
+     * @param[out]  lowTicks        Lowest price inside both bands
+     * @param[out]  widthTicks      Number of prices above lowTicks inside both bands
+     * --------------------------------------------------------------------------------------
+    */
+    void computePriceBands(int referenceTicks, int lastTradeTicks, int& lowTicks, unsigned int& widthTicks) const;
+
+    /**--------------------------------------------------------------------------------------
+     * haltMatching()
+     * 
+     * Halts continuous matching instead of executing a fill outside of the price bands
+     * 
+     * @param[in] tradeTick Price the fill would have printed at
+     * --------------------------------------------------------------------------------------
+    */
+    void haltMatching(int tradeTick);
+
+    /**--------------------------------------------------------------------------------------
+     * canMatch()
+     * 
+     * Ends the volatility auction of a halted book once it has lasted long enough
+     * 
+     * @return true if continuous matching may go on
+     * --------------------------------------------------------------------------------------
+    */
+    bool canMatch();
+
+    /**--------------------------------------------------------------------------------------
+     * findBestLevel()
+     * 
+     * Finds the best price level of one side among its limit orders and its active groups of
+     * pegged orders, repricing the groups first if the best limit prices moved. A limit
+     * price level comes before a group of pegged orders at the same price
+     * 
+     * @param[in] isBuy     Side of the book
+     * @param[out] tick     Price of the level
+     * @param[out] level    Orders at that price
+     * @param[out] group    Group of pegged orders the level belongs to, or nullptr if it is a
+     *                      level of limit orders
+     * @return true if the side has a level, false if it has no order with a price
+     * --------------------------------------------------------------------------------------
+    */
+    bool findBestLevel(bool isBuy, int& tick, PriceLevel*& level, PegBook::PegGroup*& group);
+
+    /**--------------------------------------------------------------------------------------
+     * refreshLevel()
+     * 
+     * Notes that orders were removed from a level found by findBestLevel()
+     * 
+     * @param[in] isBuy Side of the book
+     * @param[in] tick  Price of the level
+     * @param[in] group Group of pegged orders the level belongs to, or nullptr
+     * --------------------------------------------------------------------------------------
+    */
+    void refreshLevel(bool isBuy, int tick, PegBook::PegGroup* group)
     {
-    public:
-        bool operator()(const Order& order1, const Order& order2) const
+        if(group != nullptr)
         {
-            if(order1.getPrice() < order2.getPrice())
-            {
-                return true;
-            }
-            else if(order1.getPrice() > order2.getPrice())
-            {
-                return false;
-            }
-            else
-            {
-                return order1.getTime() > order2.getTime();
-            }
+            m_peggedOrders.markStale();
         }
-    };
+        else
+        {
+            (isBuy ? m_buyOrders : m_sellOrders).refreshLevel(tick);
+        }
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getRestingLevel()
+     * 
+     * @param[in] hot   Hot record of a resting order
+     * @param[out] tick Price the order currently rests at
+     * @return the price level or group of pegged orders holding the order
+     * --------------------------------------------------------------------------------------
+    */
+    PriceLevel& getRestingLevel(const HotOrder& hot, int& tick);
+
+    /**--------------------------------------------------------------------------------------
+     * refreshRestingLevel()
+     * 
+     * Notes that orders were removed from the price level or group of pegged orders holding
+     * an order, after removing them
+     * 
+     * @param[in] hot   Hot record of the order
+     * --------------------------------------------------------------------------------------
+    */
+    void refreshRestingLevel(const HotOrder& hot);
 
     /**--------------------------------------------------------------------------------------
-     * prioritizeMin
+     * publish()
+     * 
+     * Sends a change to a resting order to the market-by-order feed, if there is one
      * 
-     * Functor used to sort sell orders in the minheap according to price (least on top), 
-     * then time(least on top)
+     * @param[in] type              Kind of change to the order
+     * @param[in] orderID           ID of the order
+     * @param[in] isBuy             Side of the order
+     * @param[in] priceTicks        Price level of the order
+     * @param[in] amount            Amount added, taken away, removed or filled
+     * @param[in] remainingAmount   Amount of the order left resting afterwards
+     * @param[in] time              Time of the order
      * --------------------------------------------------------------------------------------
     */
-    class prioritizeMin
+    void publish(MarketByOrder::MessageType type, int orderID, bool isBuy, int priceTicks, int amount, int remainingAmount, int time)
     {
-    public:
-        bool operator()(const Order& order1, const Order& order2) const
+        if(m_feed != nullptr)
         {
-            if(order1.getPrice() > order2.getPrice())
-            {
-                return true;
-            }
-            else if(order1.getPrice() < order2.getPrice())
-            {
-                return false;
-            }
-            else
-            {
-                return order1.getTime() > order2.getTime();
-            }
+            m_feed->publish(type, orderID, isBuy, priceTicks, amount, remainingAmount, time);
         }
-    };
+    }
 
     std::string m_ticker = "";
 
-    // NOTE: Memory pointed to by m_buyOrders and m_sellOrders is released in the destructor
-    //       This can also be replaced by smart pointers
-    std::priority_queue<Order, std::vector<Order>, prioritizeMax>* m_buyOrders;    // Maxheap (binheap) for buy orders
-    std::priority_queue<Order, std::vector<Order>, prioritizeMin>* m_sellOrders;   // Minheap (binheap) for sell orders
-    std::queue<ProcessedOrder> m_orderHistory;  // Contains history of all filled buy and sell orders
+    PriceLadder m_buyOrders;    // Price levels of buy orders, best (highest) price found through its occupancy bitmap
+    PriceLadder m_sellOrders;   // Price levels of sell orders, best (lowest) price found through its occupancy bitmap
+    PegBook m_peggedOrders;     // Pegged orders of both sides, grouped by the price they follow
+    OrderStore m_orderStore;    // Hot and cold records of every resting order, indexed by the slots held in the price levels
+    std::vector<ProcessedOrder> m_orderHistory; // Contains history of all filled buy and sell orders, oldest first
+    MarketByOrderPublisher* m_feed = nullptr;   // Feed every change to a resting order is published to, if any
+
+    std::vector<std::pair<int, long long>> m_auctionBuyLevels;  // Crossing buy price levels and their amounts, kept between auctions to reuse their memory
+    std::vector<std::pair<int, long long>> m_auctionSellLevels; // Crossing sell price levels and their amounts
+    int m_lastAuctionTicks = PriceLadder::NO_PRICE;             // Clearing price of the last auction
+    long long m_lastAuctionVolume = 0;                          // Amount executed by the last auction
+
+    int m_staticBandBasisPoints = 0;                // Half width of the static band, 0 for none
+    int m_dynamicBandBasisPoints = 0;               // Half width of the dynamic band, 0 for none
+    int m_haltAuctionLength = 0;                    // Time a volatility auction lasts, in units of order time
+    int m_referenceTicks = PriceLadder::NO_PRICE;   // Center of the static band
+    int m_lastTradeTicks = PriceLadder::NO_PRICE;   // Center of the dynamic band
+    int m_bandLowTicks = 0;                         // Lowest price both bands allow
+    unsigned int m_bandWidthTicks = UINT_MAX;       // Highest price both bands allow, minus the lowest
+    bool m_isHalted = false;                        // Whether continuous matching is halted for a volatility auction
+    int m_haltEndTime = 0;                          // Order time at which the volatility auction ends
+    int m_latestTime = 0;                           // Latest time of any order added
+    int m_haltTicks = PriceLadder::NO_PRICE;        // Price of the fill that caused the last halt
+    size_t m_numHalts = 0;                          // Number of halts so far
 };
\ No newline at end of file
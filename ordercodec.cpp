@@ -0,0 +1,570 @@
+/*ordercodec.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the CompressedOrderWriter and CompressedOrderReader classes
+ *     Compact binary format for order files and journals: blocks of orders stored as
+ *     zigzag varint deltas, with an index of the blocks for random access
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+#include "ordercodec.h"
+#include "logger.h"
+
+namespace {
+    const char MAGIC[4] = { 'O', 'M', 'E', 'C' };
+    const uint32_t FORMAT_VERSION = 1;
+    const size_t HEADER_SIZE = 8;
+    const size_t TRAILER_SIZE = 16;
+    const size_t INDEX_ENTRY_SIZE = 12;
+    const size_t MIN_ORDER_SIZE = 6;    // Every order is six varints of at least one byte each
+
+    /**--------------------------------------------------------------------------------------
+     * putVarint()
+     * 
+     * Appends an unsigned integer as a LEB128 varint, 7 bits per byte, lowest bits first
+     * 
+     * @param[in,out]   bytes   Buffer the varint is appended to
+     * @param[in]       value   Value to be encoded
+     * --------------------------------------------------------------------------------------
+    */
+    void putVarint(std::vector<uint8_t>& bytes, uint64_t value)
+    {
+        while(value >= 0x80)
+        {
+            bytes.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back((uint8_t)value);
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * zigzag()
+     * 
+     * Maps signed integers to unsigned ones so that small negative deltas stay small:
+     * 0, -1, 1, -2, 2... become 0, 1, 2, 3, 4...
+     * 
+     * @param[in] value Signed value
+     * @return the zigzag encoding of value
+     * --------------------------------------------------------------------------------------
+    */
+    uint64_t zigzag(int64_t value)
+    {
+        return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * unzigzag()
+     * 
+     * @param[in] value Zigzag encoded value
+     * @return the signed value
+     * --------------------------------------------------------------------------------------
+    */
+    int64_t unzigzag(uint64_t value)
+    {
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getVarint()
+     * 
+     * Decodes a LEB128 varint
+     * 
+     * @param[in,out]   position    Next byte to be read, moved past the varint
+     * @param[in]       end         End of the bytes that may be read
+     * @param[out]      value       Decoded value
+     * @return false if the varint runs past end or is too long
+     * --------------------------------------------------------------------------------------
+    */
+    inline bool getVarint(const uint8_t*& position, const uint8_t* end, uint64_t& value)
+    {
+        // Single bytes first, most deltas fit in 7 bits
+        if(position < end && *position < 0x80)
+        {
+            value = *position++;
+            return true;
+        }
+
+        value = 0;
+        for(int shift = 0; shift < 64 && position < end; shift += 7)
+        {
+            uint8_t curByte = *position++;
+            value |= (uint64_t)(curByte & 0x7f) << shift;
+
+            if(curByte < 0x80)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * putFixed()
+     * 
+     * Appends an unsigned integer as size little-endian bytes
+     * 
+     * @param[in,out]   bytes   Buffer the integer is appended to
+     * @param[in]       value   Value to be encoded
+     * @param[in]       size    Number of bytes
+     * --------------------------------------------------------------------------------------
+    */
+    void putFixed(std::vector<uint8_t>& bytes, uint64_t value, size_t size)
+    {
+        for(size_t i = 0; i < size; i++)
+        {
+            bytes.push_back((uint8_t)(value >> (8 * i)));
+        }
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getFixed()
+     * 
+     * @param[in] bytes Little-endian bytes
+     * @param[in] size  Number of bytes
+     * @return the unsigned integer encoded in bytes
+     * --------------------------------------------------------------------------------------
+    */
+    uint64_t getFixed(const uint8_t* bytes, size_t size)
+    {
+        uint64_t value = 0;
+        for(size_t i = 0; i < size; i++)
+        {
+            value |= (uint64_t)bytes[i] << (8 * i);
+        }
+        return value;
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * Destructor
+ * 
+ * Closes the file if it is still open
+ * --------------------------------------------------------------------------------------
+*/
+CompressedOrderWriter::~CompressedOrderWriter()
+{
+    if(m_file != nullptr)
+    {
+        close();
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * open()
+ * 
+ * Creates a compressed order file, replacing it if it exists
+ * 
+ * @param[in] path  Path of the file
+ * @return true if the file could be created
+ * --------------------------------------------------------------------------------------
+*/
+bool CompressedOrderWriter::open(const std::string& path)
+{
+    m_file = std::fopen(path.c_str(), "wb");
+    if(m_file == nullptr)
+    {
+        std::cerr << "ERROR - open(): could not create " << path << std::endl;
+        return false;
+    }
+
+    m_isFailed = false;
+    m_numBytes = 0;
+    m_index.clear();
+    m_tickers.clear();
+    m_lastTicker = 0;
+    m_block.clear();
+    m_block.reserve(BLOCK_SIZE * 8);
+    m_blockOrders = 0;
+
+    std::vector<uint8_t> header(MAGIC, MAGIC + sizeof(MAGIC));
+    putFixed(header, FORMAT_VERSION, 4);
+    write(header.data(), header.size());
+
+    return !m_isFailed;
+}
+
+/**--------------------------------------------------------------------------------------
+ * add()
+ * 
+ * Encodes an order into the current block
+ * 
+ * @param[in] newOrder  Order to be written
+ * --------------------------------------------------------------------------------------
+*/
+void CompressedOrderWriter::add(const Order& newOrder)
+{
+    add(newOrder.getTicker(), newOrder.getID(), newOrder.checkIsMarket(), newOrder.checkIsBuy(), newOrder.getPriceTicks(),
+        newOrder.getTime(), newOrder.getAmount(), newOrder.getOwner());
+}
+
+/**--------------------------------------------------------------------------------------
+ * add()
+ * 
+ * Encodes the fields of an order into the current block
+ * 
+ * @param[in] ticker        Ticker of the order
+ * @param[in] orderID       ID of the order
+ * @param[in] isMarket      True for a market order
+ * @param[in] isBuy         True for a buy order
+ * @param[in] priceTicks    Price of the order in ticks
+ * @param[in] time          Time of the order
+ * @param[in] amount        Amount of the order
+ * @param[in] owner         Account that placed the order
+ * --------------------------------------------------------------------------------------
+*/
+void CompressedOrderWriter::add(const std::string& ticker, long long orderID, bool isMarket, bool isBuy, int priceTicks, int time, int amount, unsigned int owner)
+{
+    // Files rarely hold more than a handful of tickers, and consecutive orders mostly share theirs
+    if(m_lastTicker >= m_tickers.size() || m_tickers[m_lastTicker] != ticker)
+    {
+        m_lastTicker = std::find(m_tickers.begin(), m_tickers.end(), ticker) - m_tickers.begin();
+        if(m_lastTicker == m_tickers.size())
+        {
+            m_tickers.push_back(ticker.substr(0, 255));
+        }
+    }
+
+    putVarint(m_block, ((uint64_t)m_lastTicker << 2) | ((uint64_t)isBuy << 1) | (uint64_t)isMarket);
+    putVarint(m_block, zigzag(orderID - m_previousID));
+    putVarint(m_block, zigzag((int64_t)priceTicks - m_previousPriceTicks));
+    putVarint(m_block, zigzag((int64_t)time - m_previousTime));
+    putVarint(m_block, zigzag(amount));
+    putVarint(m_block, owner);
+
+    m_previousID = orderID;
+    m_previousPriceTicks = priceTicks;
+    m_previousTime = time;
+
+    if(++m_blockOrders == BLOCK_SIZE)
+    {
+        flushBlock();
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * flushBlock()
+ * 
+ * Ends the current block and hands it to the OS, if it holds any order
+ * 
+ * @return false if the block could not be written
+ * --------------------------------------------------------------------------------------
+*/
+bool CompressedOrderWriter::flushBlock()
+{
+    if(m_blockOrders > 0)
+    {
+        m_index.push_back({m_numBytes, m_blockOrders});
+        write(m_block.data(), m_block.size());
+
+        if(m_file != nullptr && std::fflush(m_file) != 0)
+        {
+            m_isFailed = true;
+        }
+
+        m_block.clear();
+        m_blockOrders = 0;
+        m_previousID = 0;
+        m_previousPriceTicks = 0;
+        m_previousTime = 0;
+    }
+
+    return !m_isFailed;
+}
+
+/**--------------------------------------------------------------------------------------
+ * close()
+ * 
+ * Writes the last block, the index, the tickers and the trailer, and closes the file
+ * 
+ * @return false if anything could not be written
+ * --------------------------------------------------------------------------------------
+*/
+bool CompressedOrderWriter::close()
+{
+    if(m_file == nullptr)
+    {
+        return false;
+    }
+
+    flushBlock();
+
+    uint64_t indexOffset = m_numBytes;
+    std::vector<uint8_t> footer;
+
+    for(const BlockEntry& curEntry : m_index)
+    {
+        putFixed(footer, curEntry.offset, 8);
+        putFixed(footer, curEntry.numOrders, 4);
+    }
+
+    putFixed(footer, m_tickers.size(), 4);
+    for(const std::string& curTicker : m_tickers)
+    {
+        footer.push_back((uint8_t)curTicker.size());
+        footer.insert(footer.end(), curTicker.begin(), curTicker.end());
+    }
+
+    putFixed(footer, indexOffset, 8);
+    putFixed(footer, m_index.size(), 4);
+    footer.insert(footer.end(), MAGIC, MAGIC + sizeof(MAGIC));
+    write(footer.data(), footer.size());
+
+    if(std::fclose(m_file) != 0)
+    {
+        m_isFailed = true;
+    }
+    m_file = nullptr;
+
+    return !m_isFailed;
+}
+
+/**--------------------------------------------------------------------------------------
+ * write()
+ * 
+ * Writes bytes at the end of the file, remembering any failure until close()
+ * 
+ * @param[in] bytes     Bytes to be written
+ * @param[in] size      Number of bytes
+ * --------------------------------------------------------------------------------------
+*/
+void CompressedOrderWriter::write(const void* bytes, size_t size)
+{
+    if(m_file == nullptr || std::fwrite(bytes, 1, size, m_file) != size)
+    {
+        m_isFailed = true;
+        return;
+    }
+
+    m_numBytes += size;
+}
+
+/**--------------------------------------------------------------------------------------
+ * isCompressed()
+ * 
+ * Checks whether a file starts like a compressed order file
+ * 
+ * @param[in] path  Path of the file
+ * @return true if the file is a compressed order file, false otherwise (e.g. a CSV file)
+ * --------------------------------------------------------------------------------------
+*/
+bool CompressedOrderReader::isCompressed(const std::string& path)
+{
+    std::ifstream infile(path, std::ios::binary);
+    char magic[sizeof(MAGIC)] = {};
+
+    return infile.read(magic, sizeof(magic)) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+/**--------------------------------------------------------------------------------------
+ * open()
+ * 
+ * Reads a compressed order file along with its index and tickers
+ * 
+ * @param[in] path  Path of the file
+ * @return true if the file could be read and is well-formed
+ * --------------------------------------------------------------------------------------
+*/
+bool CompressedOrderReader::open(const std::string& path)
+{
+    std::ifstream infile(path, std::ios::binary | std::ios::ate);
+    if(!infile.is_open())
+    {
+        std::cerr << "ERROR: Could not open the given file" << std::endl;
+        return false;
+    }
+
+    m_data.resize((size_t)infile.tellg());
+    infile.seekg(0);
+    if(!infile.read(reinterpret_cast<char*>(m_data.data()), m_data.size()))
+    {
+        std::cerr << "ERROR - open(): could not read " << path << std::endl;
+        return false;
+    }
+
+    const size_t size = m_data.size();
+    if(size < HEADER_SIZE + TRAILER_SIZE || std::memcmp(m_data.data(), MAGIC, sizeof(MAGIC)) != 0 ||
+       getFixed(m_data.data() + 4, 4) != FORMAT_VERSION || std::memcmp(m_data.data() + size - sizeof(MAGIC), MAGIC, sizeof(MAGIC)) != 0)
+    {
+        std::cerr << "ERROR - open(): " << path << " is not a compressed order file, or is truncated" << std::endl;
+        return false;
+    }
+
+    const uint8_t* trailer = m_data.data() + size - TRAILER_SIZE;
+    uint64_t indexOffset = getFixed(trailer, 8);
+    uint64_t numBlocks = getFixed(trailer + 8, 4);
+
+    // Checked one bound at a time, so that a corrupt offset or count cannot overflow the sums below
+    if(indexOffset < HEADER_SIZE || indexOffset > size - TRAILER_SIZE || numBlocks > (size - TRAILER_SIZE - indexOffset) / INDEX_ENTRY_SIZE)
+    {
+        std::cerr << "ERROR - open(): the index of " << path << " is corrupt" << std::endl;
+        return false;
+    }
+
+    size_t tickersOffset = indexOffset + numBlocks * INDEX_ENTRY_SIZE;
+    if(tickersOffset + 4 > size - TRAILER_SIZE)
+    {
+        std::cerr << "ERROR - open(): the index of " << path << " is corrupt" << std::endl;
+        return false;
+    }
+
+    m_index.clear();
+    m_numOrders = 0;
+    for(uint64_t i = 0; i < numBlocks; i++)
+    {
+        const uint8_t* entry = m_data.data() + indexOffset + i * INDEX_ENTRY_SIZE;
+        size_t begin = getFixed(entry, 8);
+        size_t end = (i + 1 < numBlocks) ? getFixed(entry + INDEX_ENTRY_SIZE, 8) : indexOffset;
+
+        uint32_t numOrders = (uint32_t)getFixed(entry + 8, 4);
+
+        if(begin < HEADER_SIZE || begin > end || end > indexOffset || numOrders > (end - begin) / MIN_ORDER_SIZE)
+        {
+            std::cerr << "ERROR - open(): the index of " << path << " is corrupt" << std::endl;
+            return false;
+        }
+
+        m_index.push_back({begin, end, m_numOrders, numOrders});
+        m_numOrders += m_index.back().numOrders;
+    }
+
+    m_tickers.clear();
+    const uint8_t* position = m_data.data() + tickersOffset;
+    const uint8_t* tickersEnd = trailer;
+    uint64_t numTickers = getFixed(position, 4);
+    position += 4;
+    for(uint64_t i = 0; i < numTickers; i++)
+    {
+        if(position >= tickersEnd || position + 1 + *position > tickersEnd)
+        {
+            std::cerr << "ERROR - open(): the tickers of " << path << " are corrupt" << std::endl;
+            return false;
+        }
+
+        m_tickers.emplace_back(reinterpret_cast<const char*>(position + 1), *position);
+        position += 1 + *position;
+    }
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * findBlock()
+ * 
+ * @param[in] orderIndex    Position of an order in the file, starting at 0
+ * @return the block holding the order, or getNumBlocks() if there is no such order
+ * --------------------------------------------------------------------------------------
+*/
+size_t CompressedOrderReader::findBlock(size_t orderIndex) const
+{
+    auto block = std::upper_bound(m_index.begin(), m_index.end(), orderIndex,
+                                  [](size_t index, const BlockEntry& entry) { return index < entry.firstOrder; });
+
+    if(block == m_index.begin() || orderIndex >= m_numOrders)
+    {
+        return m_index.size();
+    }
+
+    return (block - m_index.begin()) - 1;
+}
+
+/**--------------------------------------------------------------------------------------
+ * readBlock()
+ * 
+ * Decodes every order of a block
+ * 
+ * @param[in]       block           Index of the block
+ * @param[in,out]   parsedOrders    Vector the orders of the block are appended to
+ * @return false if the block is malformed
+ * --------------------------------------------------------------------------------------
+*/
+bool CompressedOrderReader::readBlock(size_t block, std::vector<Order>& parsedOrders) const
+{
+    const BlockEntry& entry = m_index[block];
+    const uint8_t* position = m_data.data() + entry.begin;
+    const uint8_t* end = m_data.data() + entry.end;
+
+    int64_t orderID = 0;
+    int64_t priceTicks = 0;
+    int64_t time = 0;
+    uint64_t flags = 0;
+    uint64_t deltaID = 0;
+    uint64_t deltaPrice = 0;
+    uint64_t deltaTime = 0;
+    uint64_t amount = 0;
+    uint64_t owner = 0;
+
+    for(uint32_t i = 0; i < entry.numOrders; i++)
+    {
+        if(!getVarint(position, end, flags) || !getVarint(position, end, deltaID) || !getVarint(position, end, deltaPrice) ||
+           !getVarint(position, end, deltaTime) || !getVarint(position, end, amount) || !getVarint(position, end, owner) ||
+           (flags >> 2) >= m_tickers.size())
+        {
+            std::cerr << "ERROR - readBlock(): block " << block << " is corrupt" << std::endl;
+            return false;
+        }
+
+        orderID += unzigzag(deltaID);
+        priceTicks += unzigzag(deltaPrice);
+        time += unzigzag(deltaTime);
+
+        parsedOrders.emplace_back(m_tickers[flags >> 2], orderID, (flags & 1) != 0, (flags & 2) != 0, Order::ticksToPrice((int)priceTicks),
+                                  (int)time, (int)unzigzag(amount), (unsigned int)owner);
+    }
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * readAll()
+ * 
+ * Decodes every order of the file
+ * 
+ * @param[in,out] parsedOrders  Vector the orders of the file are appended to
+ * @return false if a block is malformed
+ * --------------------------------------------------------------------------------------
+*/
+bool CompressedOrderReader::readAll(std::vector<Order>& parsedOrders) const
+{
+    // Never trusting the counts of the index for more orders than the file has room for
+    parsedOrders.reserve(parsedOrders.size() + std::min(m_numOrders, m_data.size() / MIN_ORDER_SIZE));
+
+    for(size_t i = 0; i < m_index.size(); i++)
+    {
+        if(!readBlock(i, parsedOrders))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,286 @@
+/*ordercodec.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the CompressedOrderWriter and CompressedOrderReader classes
+ *     Compact binary format for order files and journals: blocks of orders stored as
+ *     zigzag varint deltas, with an index of the blocks for random access
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+#include "order.h"
+
+/**--------------------------------------------------------------------------------------
+ * Compressed order file format (all fixed-size fields little-endian)
+ * 
+ *     Header:  "OMEC", uint32 version
+ *     Blocks:  orders, each block decodable on its own. Per order, as LEB128 varints:
+ *                  (ticker index << 2) | (isBuy << 1) | isMarket
+ *                  zigzag(ID - previous ID)
+ *                  zigzag(price ticks - previous price ticks)
+ *                  zigzag(time - previous time)
+ *                  zigzag(amount)
+ *                  owner
+ *              where the previous values are 0 for the first order of a block
+ *     Index:   per block, uint64 offset in the file and uint32 number of orders
+ *     Tickers: uint32 number of tickers, then per ticker a uint8 length and its characters
+ *     Trailer: uint64 offset of the index, uint32 number of blocks, "OMEC"
+ * --------------------------------------------------------------------------------------
+*/
+
+/**--------------------------------------------------------------------------------------
+ * CompressedOrderWriter class
+ * 
+ * Writes orders into a compressed order file, one block at a time. Blocks are written when
+ * full or when flushBlock() is called, so that a journal can end a block at every batch
+ * --------------------------------------------------------------------------------------
+*/
+class CompressedOrderWriter
+{
+public:
+    static const size_t BLOCK_SIZE = 4096;  // Orders per block unless flushed earlier
+
+    CompressedOrderWriter() = default;
+
+    /**--------------------------------------------------------------------------------------
+     * Destructor
+     * 
+     * Closes the file if it is still open
+     * --------------------------------------------------------------------------------------
+    */
+    ~CompressedOrderWriter();
+
+    CompressedOrderWriter(const CompressedOrderWriter&) = delete;
+    CompressedOrderWriter& operator=(const CompressedOrderWriter&) = delete;
+
+    /**--------------------------------------------------------------------------------------
+     * open()
+     * 
+     * Creates a compressed order file, replacing it if it exists
+     * 
+     * @param[in] path  Path of the file
+     * @return true if the file could be created
+     * --------------------------------------------------------------------------------------
+    */
+    bool open(const std::string& path);
+
+    /**--------------------------------------------------------------------------------------
+     * add()
+     * 
+     * Encodes an order into the current block
+     * 
+     * @param[in] newOrder  Order to be written
+     * --------------------------------------------------------------------------------------
+    */
+    void add(const Order& newOrder);
+
+    /**--------------------------------------------------------------------------------------
+     * add()
+     * 
+     * Encodes the fields of an order into the current block
+     * 
+     * @param[in] ticker        Ticker of the order
+     * @param[in] orderID       ID of the order
+     * @param[in] isMarket      True for a market order
+     * @param[in] isBuy         True for a buy order
+     * @param[in] priceTicks    Price of the order in ticks
+     * @param[in] time          Time of the order
+     * @param[in] amount        Amount of the order
+     * @param[in] owner         Account that placed the order
+     * --------------------------------------------------------------------------------------
+    */
+    void add(const std::string& ticker, long long orderID, bool isMarket, bool isBuy, int priceTicks, int time, int amount, unsigned int owner);
+
+    /**--------------------------------------------------------------------------------------
+     * flushBlock()
+     * 
+     * Ends the current block and hands it to the OS, if it holds any order
+     * 
+     * @return false if the block could not be written
+     * --------------------------------------------------------------------------------------
+    */
+    bool flushBlock();
+
+    /**--------------------------------------------------------------------------------------
+     * close()
+     * 
+     * Writes the last block, the index, the tickers and the trailer, and closes the file
+     * 
+     * @return false if anything could not be written
+     * --------------------------------------------------------------------------------------
+    */
+    bool close();
+
+    /**--------------------------------------------------------------------------------------
+     * getNumBytes()
+     * 
+     * @return the number of bytes written to the file so far
+     * --------------------------------------------------------------------------------------
+    */
+    uint64_t getNumBytes() const
+    {
+        return m_numBytes;
+    }
+
+private:
+    typedef struct BlockEntry
+    {
+        uint64_t offset;
+        uint32_t numOrders;
+    } BlockEntry;
+
+    /**--------------------------------------------------------------------------------------
+     * write()
+     * 
+     * Writes bytes at the end of the file, remembering any failure until close()
+     * 
+     * @param[in] bytes     Bytes to be written
+     * @param[in] size      Number of bytes
+     * --------------------------------------------------------------------------------------
+    */
+    void write(const void* bytes, size_t size);
+
+    std::FILE* m_file = nullptr;
+    bool m_isFailed = false;
+    uint64_t m_numBytes = 0;
+
+    std::vector<uint8_t> m_block;   // Encoded orders of the current block
+    uint32_t m_blockOrders = 0;
+    long long m_previousID = 0;
+    int m_previousPriceTicks = 0;
+    int m_previousTime = 0;
+
+    std::vector<BlockEntry> m_index;
+    std::vector<std::string> m_tickers;
+    size_t m_lastTicker = 0;        // Index of the ticker of the previous order, checked first
+};
+
+/**--------------------------------------------------------------------------------------
+ * CompressedOrderReader class
+ * 
+ * Reads a compressed order file into memory and decodes all of it, or any single block
+ * --------------------------------------------------------------------------------------
+*/
+class CompressedOrderReader
+{
+public:
+    /**--------------------------------------------------------------------------------------
+     * isCompressed()
+     * 
+     * Checks whether a file starts like a compressed order file
+     * 
+     * @param[in] path  Path of the file
+     * @return true if the file is a compressed order file, false otherwise (e.g. a CSV file)
+     * --------------------------------------------------------------------------------------
+    */
+    static bool isCompressed(const std::string& path);
+
+    /**--------------------------------------------------------------------------------------
+     * open()
+     * 
+     * Reads a compressed order file along with its index and tickers
+     * 
+     * @param[in] path  Path of the file
+     * @return true if the file could be read and is well-formed
+     * --------------------------------------------------------------------------------------
+    */
+    bool open(const std::string& path);
+
+    /**--------------------------------------------------------------------------------------
+     * getNumBlocks()
+     * 
+     * @return the number of blocks in the file
+     * --------------------------------------------------------------------------------------
+    */
+    size_t getNumBlocks() const
+    {
+        return m_index.size();
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getNumOrders()
+     * 
+     * @return the number of orders in the file
+     * --------------------------------------------------------------------------------------
+    */
+    size_t getNumOrders() const
+    {
+        return m_numOrders;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * findBlock()
+     * 
+     * @param[in] orderIndex    Position of an order in the file, starting at 0
+     * @return the block holding the order, or getNumBlocks() if there is no such order
+     * --------------------------------------------------------------------------------------
+    */
+    size_t findBlock(size_t orderIndex) const;
+
+    /**--------------------------------------------------------------------------------------
+     * readBlock()
+     * 
+     * Decodes every order of a block
+     * 
+     * @param[in]       block           Index of the block
+     * @param[in,out]   parsedOrders    Vector the orders of the block are appended to
+     * @return false if the block is malformed
+     * --------------------------------------------------------------------------------------
+    */
+    bool readBlock(size_t block, std::vector<Order>& parsedOrders) const;
+
+    /**--------------------------------------------------------------------------------------
+     * readAll()
+     * 
+     * Decodes every order of the file
+     * 
+     * @param[in,out] parsedOrders  Vector the orders of the file are appended to
+     * @return false if a block is malformed
+     * --------------------------------------------------------------------------------------
+    */
+    bool readAll(std::vector<Order>& parsedOrders) const;
+
+private:
+    typedef struct BlockEntry
+    {
+        size_t begin;           // Offset of the block in m_data
+        size_t end;             // Offset after the block
+        size_t firstOrder;      // Position in the file of the first order of the block
+        uint32_t numOrders;
+    } BlockEntry;
+
+    std::vector<uint8_t> m_data;
+    std::vector<BlockEntry> m_index;
+    std::vector<std::string> m_tickers;
+    size_t m_numOrders = 0;
+};
@@ -0,0 +1,218 @@
+/*orderindex.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the OrderIndex class
+ *     Open-addressing hash table from order ID to order slot that never allocates once reserved
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "orderindex.h"
+
+namespace {
+    const size_t INITIAL_CAPACITY = 4096;
+}
+
+/**--------------------------------------------------------------------------------------
+ * Constructor
+ * 
+ * Creates an empty index with room for a small number of orders
+ * --------------------------------------------------------------------------------------
+*/
+OrderIndex::OrderIndex()
+{
+    rehash(INITIAL_CAPACITY);
+}
+
+/**--------------------------------------------------------------------------------------
+ * reserve()
+ * 
+ * Sizes the table so that numOrders orders can be indexed without growing it
+ * 
+ * @param[in] numOrders Largest number of orders expected to rest at the same time
+ * --------------------------------------------------------------------------------------
+*/
+void OrderIndex::reserve(size_t numOrders)
+{
+    // Keeping the load factor at or below 1/2 so that probe sequences stay short
+    size_t capacity = m_entries.size();
+    while(capacity < numOrders * 2)
+    {
+        capacity *= 2;
+    }
+
+    if(capacity != m_entries.size())
+    {
+        rehash(capacity);
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * insert()
+ * 
+ * @param[in] orderID   ID of the order
+ * @param[in] slot      Slot of the order
+ * @return true if the order was indexed, false if the ID is already indexed
+ * --------------------------------------------------------------------------------------
+*/
+bool OrderIndex::insert(int orderID, unsigned int slot)
+{
+    if((m_size + 1) * 2 > m_entries.size())
+    {
+        rehash(m_entries.size() * 2);
+    }
+
+    for(size_t i = home(orderID); ; i = (i + 1) & m_mask)
+    {
+        Entry& curEntry = m_entries[i];
+
+        if(curEntry.slot == NO_SLOT)
+        {
+            curEntry.orderID = orderID;
+            curEntry.slot = slot;
+            m_size++;
+            return true;
+        }
+        if(curEntry.orderID == orderID)
+        {
+            return false;
+        }
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * find()
+ * 
+ * @param[in] orderID   ID of the order
+ * @return the slot of the order, or NO_SLOT if the ID is not indexed
+ * --------------------------------------------------------------------------------------
+*/
+unsigned int OrderIndex::find(int orderID) const
+{
+    for(size_t i = home(orderID); ; i = (i + 1) & m_mask)
+    {
+        const Entry& curEntry = m_entries[i];
+
+        if(curEntry.slot == NO_SLOT || curEntry.orderID == orderID)
+        {
+            return curEntry.slot;
+        }
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * assign()
+ * 
+ * Indexes an ID, or points it at another slot if it is already indexed
+ * 
+ * @param[in] orderID   ID of the order
+ * @param[in] slot      Slot of the order
+ * --------------------------------------------------------------------------------------
+*/
+void OrderIndex::assign(int orderID, unsigned int slot)
+{
+    for(size_t i = home(orderID); ; i = (i + 1) & m_mask)
+    {
+        Entry& curEntry = m_entries[i];
+
+        if(curEntry.slot == NO_SLOT)
+        {
+            insert(orderID, slot);
+            return;
+        }
+        if(curEntry.orderID == orderID)
+        {
+            curEntry.slot = slot;
+            return;
+        }
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * erase()
+ * 
+ * @param[in] orderID   ID of the order to be removed from the index
+ * --------------------------------------------------------------------------------------
+*/
+void OrderIndex::erase(int orderID)
+{
+    size_t hole = home(orderID);
+    while(m_entries[hole].slot != NO_SLOT && m_entries[hole].orderID != orderID)
+    {
+        hole = (hole + 1) & m_mask;
+    }
+
+    if(m_entries[hole].slot == NO_SLOT)
+    {
+        return;
+    }
+
+    // Shifting later entries of the same probe run back into the hole, so that no tombstones are needed
+    for(size_t i = (hole + 1) & m_mask; m_entries[i].slot != NO_SLOT; i = (i + 1) & m_mask)
+    {
+        size_t curHome = home(m_entries[i].orderID);
+
+        // The entry can move into the hole only if the hole lies on its probe path, i.e. between its home and i (cyclically)
+        if(((i - curHome) & m_mask) >= ((i - hole) & m_mask))
+        {
+            m_entries[hole] = m_entries[i];
+            hole = i;
+        }
+    }
+
+    m_entries[hole].slot = NO_SLOT;
+    m_size--;
+}
+
+/**--------------------------------------------------------------------------------------
+ * rehash()
+ * 
+ * Moves every entry into a new table of the given capacity
+ * 
+ * @param[in] capacity  Number of entries of the new table, a power of two
+ * --------------------------------------------------------------------------------------
+*/
+void OrderIndex::rehash(size_t capacity)
+{
+    std::vector<Entry> oldEntries(capacity, Entry{0, NO_SLOT});
+    oldEntries.swap(m_entries);
+
+    m_mask = capacity - 1;
+    m_shift = 64;
+    for(size_t bits = capacity; bits > 1; bits >>= 1)
+    {
+        m_shift--;
+    }
+    m_size = 0;
+
+    for(const Entry& curEntry : oldEntries)
+    {
+        if(curEntry.slot != NO_SLOT)
+        {
+            insert(curEntry.orderID, curEntry.slot);
+        }
+    }
+}
@@ -0,0 +1,243 @@
+/*orderindex.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the OrderIndex class
+ *     Open-addressing hash table from order ID to order slot that never allocates once reserved
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**--------------------------------------------------------------------------------------
+ * OrderIndex class
+ * 
+ * Maps the ID of every resting order to its slot using linear probing in a single
+ * power-of-two array. Unlike std::unordered_map, inserting and erasing never allocate
+ * nodes, so once reserve() has sized the table for the largest expected book, adding
+ * and cancelling orders do not touch the heap at all
+ * --------------------------------------------------------------------------------------
+*/
+class OrderIndex
+{
+public:
+    static const unsigned int NO_SLOT = ~0u;
+
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Creates an empty index with room for a small number of orders
+     * --------------------------------------------------------------------------------------
+    */
+    OrderIndex();
+
+    /**--------------------------------------------------------------------------------------
+     * reserve()
+     * 
+     * Sizes the table so that numOrders orders can be indexed without growing it
+     * 
+     * @param[in] numOrders Largest number of orders expected to rest at the same time
+     * --------------------------------------------------------------------------------------
+    */
+    void reserve(size_t numOrders);
+
+    /**--------------------------------------------------------------------------------------
+     * insert()
+     * 
+     * @param[in] orderID   ID of the order
+     * @param[in] slot      Slot of the order
+     * @return true if the order was indexed, false if the ID is already indexed
+     * --------------------------------------------------------------------------------------
+    */
+    bool insert(int orderID, unsigned int slot);
+
+    /**--------------------------------------------------------------------------------------
+     * find()
+     * 
+     * @param[in] orderID   ID of the order
+     * @return the slot of the order, or NO_SLOT if the ID is not indexed
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned int find(int orderID) const;
+
+    /**--------------------------------------------------------------------------------------
+     * assign()
+     * 
+     * Indexes an ID, or points it at another slot if it is already indexed
+     * 
+     * @param[in] orderID   ID of the order
+     * @param[in] slot      Slot of the order
+     * --------------------------------------------------------------------------------------
+    */
+    void assign(int orderID, unsigned int slot);
+
+    /**--------------------------------------------------------------------------------------
+     * erase()
+     * 
+     * @param[in] orderID   ID of the order to be removed from the index
+     * --------------------------------------------------------------------------------------
+    */
+    void erase(int orderID);
+
+    /**--------------------------------------------------------------------------------------
+     * size()
+     * 
+     * @return the number of orders indexed
+     * --------------------------------------------------------------------------------------
+    */
+    size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    typedef struct Entry
+    {
+        int orderID;
+        unsigned int slot;  // NO_SLOT if the entry is empty
+    } Entry;
+
+    size_t home(int orderID) const
+    {
+        // Fibonacci hashing, spreads consecutive IDs across the whole table
+        return (size_t)(((unsigned long long)(unsigned int)orderID * 11400714819323198485ULL) >> m_shift);
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * rehash()
+     * 
+     * Moves every entry into a new table of the given capacity
+     * 
+     * @param[in] capacity  Number of entries of the new table, a power of two
+     * --------------------------------------------------------------------------------------
+    */
+    void rehash(size_t capacity);
+
+    std::vector<Entry> m_entries;
+    size_t m_mask = 0;      // Capacity - 1
+    int m_shift = 0;        // 64 - log2(capacity)
+    size_t m_size = 0;
+};
+
+/**--------------------------------------------------------------------------------------
+ * OwnerIndex class
+ * 
+ * Maps the ID of every owner (account/participant) with resting orders, or of any other
+ * group of orders keyed by an unsigned ID such as an order-entry session, to a slot. Keys
+ * are kept apart from order IDs, the table underneath is the same as OrderIndex's
+ * --------------------------------------------------------------------------------------
+*/
+class OwnerIndex
+{
+public:
+    static const unsigned int NO_SLOT = OrderIndex::NO_SLOT;
+
+    /**--------------------------------------------------------------------------------------
+     * reserve()
+     * 
+     * Sizes the table so that numOwners owners can be indexed without growing it
+     * 
+     * @param[in] numOwners Largest number of owners expected at the same time
+     * --------------------------------------------------------------------------------------
+    */
+    void reserve(size_t numOwners)
+    {
+        m_index.reserve(numOwners);
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * insert()
+     * 
+     * @param[in] owner ID of the owner
+     * @param[in] slot  Slot of the owner
+     * @return true if the owner was indexed, false if the owner is already indexed
+     * --------------------------------------------------------------------------------------
+    */
+    bool insert(unsigned int owner, unsigned int slot)
+    {
+        return m_index.insert(toKey(owner), slot);
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * find()
+     * 
+     * @param[in] owner ID of the owner
+     * @return the slot of the owner, or NO_SLOT if the owner is not indexed
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned int find(unsigned int owner) const
+    {
+        return m_index.find(toKey(owner));
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * assign()
+     * 
+     * Indexes an owner, or points it at another slot if it is already indexed
+     * 
+     * @param[in] owner ID of the owner
+     * @param[in] slot  Slot of the owner
+     * --------------------------------------------------------------------------------------
+    */
+    void assign(unsigned int owner, unsigned int slot)
+    {
+        m_index.assign(toKey(owner), slot);
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * erase()
+     * 
+     * @param[in] owner ID of the owner to be removed from the index
+     * --------------------------------------------------------------------------------------
+    */
+    void erase(unsigned int owner)
+    {
+        m_index.erase(toKey(owner));
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * size()
+     * 
+     * @return the number of owners indexed
+     * --------------------------------------------------------------------------------------
+    */
+    size_t size() const
+    {
+        return m_index.size();
+    }
+
+private:
+    static int toKey(unsigned int owner)
+    {
+        // Two's complement round trip, every owner keeps a key of its own and hashes as itself
+        return (int)owner;
+    }
+
+    OrderIndex m_index;
+};
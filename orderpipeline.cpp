@@ -0,0 +1,367 @@
+/*orderpipeline.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the OrderPipeline class
+ *     Processes orders in stages running on their own threads (sequence, journal, match,
+ *     publish), handing them over through preallocated rings guarded by sequence barriers
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+
+#include "orderpipeline.h"
+#include "tracer.h"
+#include "logger.h"
+
+namespace {
+    const int SPINS_BEFORE_YIELD = 256;     // Polls of a cursor before giving up the core to other threads
+
+    /**--------------------------------------------------------------------------------------
+     * printPrice()
+     * 
+     * Prints a price in ticks as a price, or "-" for PriceLadder::NO_PRICE
+     * 
+     * @param[in] priceTicks    Price in ticks
+     * --------------------------------------------------------------------------------------
+    */
+    void printPrice(int priceTicks)
+    {
+        if(priceTicks == PriceLadder::NO_PRICE)
+        {
+            std::cout << "-";
+        }
+        else
+        {
+            std::cout << std::fixed << std::setprecision(2) << Order::ticksToPrice(priceTicks);
+        }
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * Constructor
+ * 
+ * Creates a pipeline feeding a new order book
+ * 
+ * @param[in] ticker    Ticker of the order book
+ * @param[in] matcher   Order-matching algorithm, e.g. &Orderbook::matchOrdersFIFO
+ * --------------------------------------------------------------------------------------
+*/
+OrderPipeline::OrderPipeline(std::string ticker, void (Orderbook::*matcher)())
+    : m_ticker(ticker), m_matcher(matcher), m_orderbook(ticker),
+      m_events(EVENT_RING_SIZE), m_fills(FILL_RING_SIZE, ProcessedOrder(0, 0, 0))
+{}
+
+/**--------------------------------------------------------------------------------------
+ * run()
+ * 
+ * Starts every stage on its own thread, feeds the orders through the pipeline from the
+ * calling thread, and returns once the publish stage has handled the last of them
+ * 
+ * @param[in] orders        Orders in arrival order
+ * @param[in] journalPath   File the journal stage writes to, replaced if it exists
+ * @return true if every order went through, false if the journal could not be written
+ * --------------------------------------------------------------------------------------
+*/
+bool OrderPipeline::run(const std::vector<Order>& orders, const std::string& journalPath)
+{
+    if(!m_journal.open(journalPath))
+    {
+        std::cerr << "ERROR - run(): could not open the journal " << journalPath << std::endl;
+        return false;
+    }
+
+    const int64_t numEvents = (int64_t)orders.size();
+
+    std::thread sequenceStage(&OrderPipeline::runSequenceStage, this, numEvents);
+    std::thread journalStage(&OrderPipeline::runJournalStage, this, numEvents);
+    std::thread matchStage(&OrderPipeline::runMatchStage, this, numEvents);
+    std::thread publishStage(&OrderPipeline::runPublishStage, this, numEvents);
+
+    int64_t publishedPosition = -1;
+    for(int64_t position = 0; position < numEvents; position++)
+    {
+        // Waiting for the publish stage to be done with the event a full ring ago
+        if(position - EVENT_RING_SIZE > publishedPosition)
+        {
+            publishedPosition = waitFor(m_publishCursor, position - EVENT_RING_SIZE);
+        }
+
+        const Order& curOrder = orders[position];
+        OrderEvent& curEvent = m_events[position & (EVENT_RING_SIZE - 1)];
+        curEvent.orderID = curOrder.getID();
+        curEvent.priceTicks = curOrder.getPriceTicks();
+        curEvent.time = curOrder.getTime();
+        curEvent.amount = curOrder.getAmount();
+        curEvent.owner = curOrder.getOwner();
+        curEvent.isBuy = curOrder.checkIsBuy();
+        curEvent.isMarket = curOrder.checkIsMarket();
+
+        m_producerCursor.position.store(position, std::memory_order_release);
+    }
+
+    sequenceStage.join();
+    journalStage.join();
+    matchStage.join();
+    publishStage.join();
+
+    if(!m_journal.close())
+    {
+        m_isJournalFailed = true;
+    }
+
+    if(m_isJournalFailed)
+    {
+        std::cerr << "ERROR - run(): could not write the journal " << journalPath << std::endl;
+    }
+
+    return !m_isJournalFailed;
+}
+
+/**--------------------------------------------------------------------------------------
+ * waitFor()
+ * 
+ * Sequence barrier: waits until a cursor reaches a position
+ * 
+ * @param[in] cursor    Cursor of the stage being followed
+ * @param[in] position  Position needed
+ * @return the position of the cursor, at least the one needed, so that everything up to
+ *         it is handled as one batch
+ * --------------------------------------------------------------------------------------
+*/
+int64_t OrderPipeline::waitFor(const Cursor& cursor, int64_t position)
+{
+    int numSpins = 0;
+    int64_t available = cursor.position.load(std::memory_order_acquire);
+
+    while(available < position)
+    {
+        if(++numSpins == SPINS_BEFORE_YIELD)
+        {
+            std::this_thread::yield();
+            numSpins = 0;
+        }
+
+        available = cursor.position.load(std::memory_order_acquire);
+    }
+
+    return available;
+}
+
+/**--------------------------------------------------------------------------------------
+ * runSequenceStage()
+ * 
+ * Stamps the engine's sequence number on every event put on the ring by the producer
+ * 
+ * @param[in] numEvents Number of events going through the pipeline
+ * --------------------------------------------------------------------------------------
+*/
+void OrderPipeline::runSequenceStage(int64_t numEvents)
+{
+    int64_t next = 0;
+
+    while(next < numEvents)
+    {
+        int64_t available = waitFor(m_producerCursor, next);
+
+        for(; next <= available; next++)
+        {
+            m_events[next & (EVENT_RING_SIZE - 1)].engineSequence = next + 1;
+        }
+
+        m_sequenceCursor.position.store(available, std::memory_order_release);
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * runJournalStage()
+ * 
+ * Appends every sequenced event to the journal, one block per batch
+ * 
+ * @param[in] numEvents Number of events going through the pipeline
+ * --------------------------------------------------------------------------------------
+*/
+void OrderPipeline::runJournalStage(int64_t numEvents)
+{
+    int64_t next = 0;
+
+    while(next < numEvents)
+    {
+        int64_t available = waitFor(m_sequenceCursor, next);
+
+        TRACE_SCOPE("pipeline", "journal batch");
+
+        for(; next <= available; next++)
+        {
+            const OrderEvent& curEvent = m_events[next & (EVENT_RING_SIZE - 1)];
+            m_journal.add(m_ticker, curEvent.orderID, curEvent.isMarket, curEvent.isBuy, curEvent.priceTicks, curEvent.time,
+                          curEvent.amount, curEvent.owner);
+        }
+
+        // Handing the batch to the OS before the orders can reach the order book (not synced to disk)
+        if(!m_journal.flushBlock())
+        {
+            m_isJournalFailed = true;
+        }
+
+        m_journalCursor.position.store(available, std::memory_order_release);
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * runMatchStage()
+ * 
+ * Adds every journaled order to the order book and matches it, putting its fills on the
+ * fill ring and the best prices after it on its event
+ * 
+ * @param[in] numEvents Number of events going through the pipeline
+ * --------------------------------------------------------------------------------------
+*/
+void OrderPipeline::runMatchStage(int64_t numEvents)
+{
+    int64_t next = 0;
+    int64_t nextFill = 0;
+    int64_t publishedFill = -1;
+
+    while(next < numEvents)
+    {
+        int64_t available = waitFor(m_journalCursor, next);
+
+        TRACE_SCOPE("pipeline", "match batch");
+
+        for(; next <= available; next++)
+        {
+            OrderEvent& curEvent = m_events[next & (EVENT_RING_SIZE - 1)];
+
+            Order newOrder(m_ticker, curEvent.orderID, curEvent.isMarket, curEvent.isBuy, Order::ticksToPrice(curEvent.priceTicks),
+                           curEvent.time, curEvent.amount, curEvent.owner);
+
+            if(m_orderbook.addOrder(newOrder))
+            {
+                (m_orderbook.*m_matcher)();
+            }
+
+            for(const ProcessedOrder& curFill : m_orderbook.getOrderHistory())
+            {
+                // Publishing the fills so far and waiting for the publish stage to make room
+                if(nextFill - FILL_RING_SIZE > publishedFill)
+                {
+                    m_fillCursor.position.store(nextFill - 1, std::memory_order_release);
+                    publishedFill = waitFor(m_publishedFillCursor, nextFill - FILL_RING_SIZE);
+                }
+
+                m_fills[nextFill & (FILL_RING_SIZE - 1)] = curFill;
+                nextFill++;
+            }
+            m_orderbook.clearOrderHistory();
+
+            curEvent.fillEnd = nextFill;
+            curEvent.bestBuyTicks = m_orderbook.getBestBuyTicks();
+            curEvent.bestSellTicks = m_orderbook.getBestSellTicks();
+        }
+
+        // Fills first, so that the fills of every matched event are visible along with it
+        m_fillCursor.position.store(nextFill - 1, std::memory_order_release);
+        m_matchCursor.position.store(available, std::memory_order_release);
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * runPublishStage()
+ * 
+ * Prints the fills of every matched event followed by the best prices if they changed,
+ * flushing the output once per batch
+ * 
+ * @param[in] numEvents Number of events going through the pipeline
+ * --------------------------------------------------------------------------------------
+*/
+void OrderPipeline::runPublishStage(int64_t numEvents)
+{
+    int64_t next = 0;
+    int64_t nextFill = 0;
+    int bestBuyTicks = PriceLadder::NO_PRICE;
+    int bestSellTicks = PriceLadder::NO_PRICE;
+
+    while(next < numEvents)
+    {
+        // Waiting for either ring, the fills of a single order may not fit on the fill ring at once
+        int numSpins = 0;
+        int64_t availableEvents = m_matchCursor.position.load(std::memory_order_acquire);
+        int64_t availableFills = m_fillCursor.position.load(std::memory_order_acquire);
+        while(availableEvents < next && availableFills < nextFill)
+        {
+            if(++numSpins == SPINS_BEFORE_YIELD)
+            {
+                std::this_thread::yield();
+                numSpins = 0;
+            }
+
+            availableEvents = m_matchCursor.position.load(std::memory_order_acquire);
+            availableFills = m_fillCursor.position.load(std::memory_order_acquire);
+        }
+
+        TRACE_SCOPE("pipeline", "publish batch");
+
+        for(; next <= availableEvents; next++)
+        {
+            const OrderEvent& curEvent = m_events[next & (EVENT_RING_SIZE - 1)];
+
+            for(; nextFill < curEvent.fillEnd; nextFill++)
+            {
+                const ProcessedOrder& curFill = m_fills[nextFill & (FILL_RING_SIZE - 1)];
+                std::cout << "    ORDER PROCESSED:   Buyer ID: " << curFill.buyID << ",   Amount filled: " << curFill.fillAmount \
+                          << ",   Seller ID: " << curFill.sellID << "\n";
+            }
+
+            if(curEvent.bestBuyTicks != bestBuyTicks || curEvent.bestSellTicks != bestSellTicks)
+            {
+                bestBuyTicks = curEvent.bestBuyTicks;
+                bestSellTicks = curEvent.bestSellTicks;
+
+                std::cout << "    BEST PRICES:       Buy: ";
+                printPrice(bestBuyTicks);
+                std::cout << ",   Sell: ";
+                printPrice(bestSellTicks);
+                std::cout << "\n";
+            }
+        }
+
+        // Fills of an order still being matched
+        for(; nextFill <= availableFills; nextFill++)
+        {
+            const ProcessedOrder& curFill = m_fills[nextFill & (FILL_RING_SIZE - 1)];
+            std::cout << "    ORDER PROCESSED:   Buyer ID: " << curFill.buyID << ",   Amount filled: " << curFill.fillAmount \
+                      << ",   Seller ID: " << curFill.sellID << "\n";
+        }
+
+        std::cout.flush();
+
+        m_publishedFillCursor.position.store(nextFill - 1, std::memory_order_release);
+        m_publishCursor.position.store(next - 1, std::memory_order_release);
+    }
+}
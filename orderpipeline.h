@@ -0,0 +1,201 @@
+/*orderpipeline.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the OrderPipeline class
+ *     Processes orders in stages running on their own threads (sequence, journal, match,
+ *     publish), handing them over through preallocated rings guarded by sequence barriers
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+#include "order.h"
+#include "orderbook.h"
+#include "ordercodec.h"
+
+/**--------------------------------------------------------------------------------------
+ * OrderPipeline class
+ * 
+ * Disruptor-style pipeline of an order book. Orders are written into a preallocated ring of
+ * events, each stage then follows the cursor of the stage before it (its sequence barrier),
+ * handles every event that is available in one batch and moves its own cursor past them:
+ *     Sequence:    stamps each event with the engine's sequence number
+ *     Journal:     appends each event to a journal before it can reach the order book, as a
+ *                  compressed order file (one block per batch) that can be replayed
+ *     Match:       adds each order to the order book and matches it right away, putting the
+ *                  fills on a second ring and the resulting best prices on the event
+ *     Publish:     prints the fills (executions) and every change of the best prices
+ *                  (market data)
+ * The producer only reuses an event once the publish stage is past it, and the match stage
+ * only reuses a fill once it is published, so nothing is allocated per order
+ * --------------------------------------------------------------------------------------
+*/
+class OrderPipeline
+{
+public:
+    static const int64_t EVENT_RING_SIZE = 4096;    // Orders in flight between the producer and the publish stage (power of 2)
+    static const int64_t FILL_RING_SIZE = 16384;    // Fills in flight between the match and publish stages (power of 2)
+
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Creates a pipeline feeding a new order book
+     * 
+     * @param[in] ticker    Ticker of the order book
+     * @param[in] matcher   Order-matching algorithm, e.g. &Orderbook::matchOrdersFIFO
+     * --------------------------------------------------------------------------------------
+    */
+    OrderPipeline(std::string ticker, void (Orderbook::*matcher)());
+
+    /**--------------------------------------------------------------------------------------
+     * run()
+     * 
+     * Starts every stage on its own thread, feeds the orders through the pipeline from the
+     * calling thread, and returns once the publish stage has handled the last of them
+     * 
+     * @param[in] orders        Orders in arrival order
+     * @param[in] journalPath   File the journal stage writes to, replaced if it exists
+     * @return true if every order went through, false if the journal could not be written
+     * --------------------------------------------------------------------------------------
+    */
+    bool run(const std::vector<Order>& orders, const std::string& journalPath);
+
+    /**--------------------------------------------------------------------------------------
+     * getOrderbook()
+     * 
+     * @return the order book fed by the match stage, only to be used while not running
+     * --------------------------------------------------------------------------------------
+    */
+    const Orderbook& getOrderbook() const
+    {
+        return m_orderbook;
+    }
+
+private:
+    typedef struct OrderEvent
+    {
+        // Written by the producer
+        int64_t orderID;
+        int32_t priceTicks;
+        int32_t time;
+        int32_t amount;
+        uint32_t owner;
+        bool isBuy;
+        bool isMarket;
+
+        // Written by the sequence stage
+        int64_t engineSequence;
+
+        // Written by the match stage
+        int64_t fillEnd;            // Position in the fill ring after the last fill of the order
+        int32_t bestBuyTicks;
+        int32_t bestSellTicks;
+    } OrderEvent;
+
+    // Cursor of a stage, the position of the last event it is done with, alone on its cache line
+    typedef struct alignas(64) Cursor
+    {
+        std::atomic<int64_t> position{-1};
+    } Cursor;
+
+    /**--------------------------------------------------------------------------------------
+     * waitFor()
+     * 
+     * Sequence barrier: waits until a cursor reaches a position
+     * 
+     * @param[in] cursor    Cursor of the stage being followed
+     * @param[in] position  Position needed
+     * @return the position of the cursor, at least the one needed, so that everything up to
+     *         it is handled as one batch
+     * --------------------------------------------------------------------------------------
+    */
+    static int64_t waitFor(const Cursor& cursor, int64_t position);
+
+    /**--------------------------------------------------------------------------------------
+     * runSequenceStage()
+     * 
+     * Stamps the engine's sequence number on every event put on the ring by the producer
+     * 
+     * @param[in] numEvents Number of events going through the pipeline
+     * --------------------------------------------------------------------------------------
+    */
+    void runSequenceStage(int64_t numEvents);
+
+    /**--------------------------------------------------------------------------------------
+     * runJournalStage()
+     * 
+     * Appends every sequenced event to the journal, one block per batch
+     * 
+     * @param[in] numEvents Number of events going through the pipeline
+     * --------------------------------------------------------------------------------------
+    */
+    void runJournalStage(int64_t numEvents);
+
+    /**--------------------------------------------------------------------------------------
+     * runMatchStage()
+     * 
+     * Adds every journaled order to the order book and matches it, putting its fills on the
+     * fill ring and the best prices after it on its event
+     * 
+     * @param[in] numEvents Number of events going through the pipeline
+     * --------------------------------------------------------------------------------------
+    */
+    void runMatchStage(int64_t numEvents);
+
+    /**--------------------------------------------------------------------------------------
+     * runPublishStage()
+     * 
+     * Prints the fills of every matched event followed by the best prices if they changed,
+     * flushing the output once per batch
+     * 
+     * @param[in] numEvents Number of events going through the pipeline
+     * --------------------------------------------------------------------------------------
+    */
+    void runPublishStage(int64_t numEvents);
+
+    std::string m_ticker;
+    void (Orderbook::*m_matcher)();
+    Orderbook m_orderbook;
+    CompressedOrderWriter m_journal;
+    bool m_isJournalFailed = false;
+
+    std::vector<OrderEvent> m_events;           // Ring of EVENT_RING_SIZE events, indexed by position modulo its size
+    std::vector<ProcessedOrder> m_fills;        // Ring of FILL_RING_SIZE fills
+
+    Cursor m_producerCursor;
+    Cursor m_sequenceCursor;
+    Cursor m_journalCursor;
+    Cursor m_matchCursor;
+    Cursor m_publishCursor;
+    Cursor m_fillCursor;            // Last fill put on the fill ring by the match stage
+    Cursor m_publishedFillCursor;   // Last fill printed by the publish stage
+};
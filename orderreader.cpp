@@ -0,0 +1,144 @@
+/*orderreader.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the OrderReader namespace
+ *     Parses the CSV files of orders read by the engine
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "orderreader.h"
+#include "ordercodec.h"
+#include "tracer.h"
+
+namespace {
+    const int PARSE_BATCH_SIZE = 4096;          // Number of CSV rows recorded as one parse event when tracing
+}
+
+/**--------------------------------------------------------------------------------------
+ * readOrderData()
+ * 
+ * Reads every order in a CSV file
+ * 
+ * @param[in]       infile          CSV file to be read in, filled with unprocessed orders
+ * @param[in,out]   parsedOrders    Vector the orders from infile are appended to
+ * @return true if the file could be read
+ * --------------------------------------------------------------------------------------
+*/
+bool OrderReader::readOrderData(std::fstream& infile, std::vector<Order>& parsedOrders)
+{
+    std::string line;
+
+    if(infile.is_open())
+    {
+        std::string ticker = "";
+        std::string orderID = "";
+        std::string isMarket = "";
+        std::string isBuy = "";
+        std::string price = "";
+        std::string time = "";
+        std::string amount = "";
+        std::string owner = "";
+
+        // Skipping first line of CSV (contains column headers)
+        std::getline(infile, line);
+
+        unsigned long long batchBegin = Tracer::isEnabled() ? Tracer::nowNanoseconds() : 0;
+        int rowsInBatch = 0;
+
+        while(std::getline(infile, line))
+        {
+            std::istringstream curString(line);
+
+            std::getline(curString, ticker, ',');
+            std::getline(curString, orderID, ',');
+            std::getline(curString, isMarket, ',');
+            std::getline(curString, isBuy, ',');
+            std::getline(curString, price, ',');
+            std::getline(curString, time, ',');
+            std::getline(curString, amount, ',');
+
+            // Owner column is optional, orders without one belong to owner 0
+            owner.clear();
+            std::getline(curString, owner, ',');
+            unsigned int intOwner = owner.empty() ? 0 : std::stoul(owner);
+
+            bool boolIsMarket = (isMarket == "true");
+            bool boolIsBuy = (isBuy == "true");
+
+            parsedOrders.emplace_back(ticker, std::stoll(orderID), boolIsMarket, boolIsBuy, std::stof(price), std::stoi(time), std::stoi(amount), intOwner);
+
+            if(batchBegin != 0 && ++rowsInBatch == PARSE_BATCH_SIZE)
+            {
+                unsigned long long batchEnd = Tracer::nowNanoseconds();
+                Tracer::record("parse", "parse batch", batchBegin, batchEnd);
+                batchBegin = batchEnd;
+                rowsInBatch = 0;
+            }
+        }
+
+        if(batchBegin != 0 && rowsInBatch > 0)
+        {
+            Tracer::record("parse", "parse batch", batchBegin, Tracer::nowNanoseconds());
+        }
+
+        return true;
+    }
+    else
+    {
+        std::cerr << "ERROR: Could not open the given file" << std::endl;
+        return false;
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * readOrderFile()
+ * 
+ * Reads every order in a file, either a CSV file or a compressed order file (see
+ * ordercodec.h), told apart by the first bytes of the file
+ * 
+ * @param[in]       path            Path of the file
+ * @param[in,out]   parsedOrders    Vector the orders of the file are appended to
+ * @return true if the file could be read
+ * --------------------------------------------------------------------------------------
+*/
+bool OrderReader::readOrderFile(const std::string& path, std::vector<Order>& parsedOrders)
+{
+    if(CompressedOrderReader::isCompressed(path))
+    {
+        TRACE_SCOPE("parse", "decode");
+
+        CompressedOrderReader reader;
+        return reader.open(path) && reader.readAll(parsedOrders);
+    }
+
+    std::fstream csvData(path, std::fstream::in);
+    return readOrderData(csvData, parsedOrders);
+}
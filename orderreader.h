@@ -0,0 +1,67 @@
+/*orderreader.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the OrderReader namespace
+ *     Parses the CSV files of orders read by the engine
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "order.h"
+
+namespace OrderReader
+{
+    /**--------------------------------------------------------------------------------------
+     * readOrderData()
+     * 
+     * Reads every order in a CSV file
+     * 
+     * @param[in]       infile          CSV file to be read in, filled with unprocessed orders
+     * @param[in,out]   parsedOrders    Vector the orders from infile are appended to
+     * @return true if the file could be read
+     * --------------------------------------------------------------------------------------
+    */
+    bool readOrderData(std::fstream& infile, std::vector<Order>& parsedOrders);
+
+    /**--------------------------------------------------------------------------------------
+     * readOrderFile()
+     * 
+     * Reads every order in a file, either a CSV file or a compressed order file (see
+     * ordercodec.h), told apart by the first bytes of the file
+     * 
+     * @param[in]       path            Path of the file
+     * @param[in,out]   parsedOrders    Vector the orders of the file are appended to
+     * @return true if the file could be read
+     * --------------------------------------------------------------------------------------
+    */
+    bool readOrderFile(const std::string& path, std::vector<Order>& parsedOrders);
+}
@@ -0,0 +1,246 @@
+/*orderstore.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the OrderStore class
+ *     Slot-indexed storage for every order resting in an order book, split into a compact hot
+ *     record used while matching and a cold record for fields that are rarely read
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "orderstore.h"
+
+/**--------------------------------------------------------------------------------------
+ * reserve()
+ * 
+ * Preallocates slots so that numOrders orders can rest at the same time without any
+ * further allocation
+ * 
+ * @param[in] numOrders Largest number of orders expected to rest at the same time
+ * --------------------------------------------------------------------------------------
+*/
+void OrderStore::reserve(size_t numOrders)
+{
+    m_hot.reserve(numOrders);
+    m_cold.reserve(numOrders);
+    m_ownerLinks.reserve(numOrders);
+    m_sessionLinks.reserve(numOrders);
+    m_freeSlots.reserve(numOrders);
+    m_slotByID.reserve(numOrders);
+
+    // At worst every resting order has an owner of its own
+    m_firstSlotByOwner.reserve(numOrders);
+}
+
+/**--------------------------------------------------------------------------------------
+ * prefault()
+ * 
+ * Writes to every reserved slot once, so that the memory behind them is already mapped
+ * when the first orders arrive
+ * --------------------------------------------------------------------------------------
+*/
+void OrderStore::prefault()
+{
+    const size_t numSlots = m_hot.size();
+    const size_t numFree = m_freeSlots.size();
+
+    // Growing every array to its capacity and shrinking it back keeps the capacity and leaves every page touched
+    m_hot.resize(m_hot.capacity());
+    m_cold.resize(m_cold.capacity());
+    m_ownerLinks.resize(m_ownerLinks.capacity());
+    m_sessionLinks.resize(m_sessionLinks.capacity());
+    m_freeSlots.resize(m_freeSlots.capacity());
+
+    m_hot.resize(numSlots);
+    m_cold.resize(numSlots);
+    m_ownerLinks.resize(numSlots);
+    m_sessionLinks.resize(numSlots);
+    m_freeSlots.resize(numFree);
+}
+
+/**--------------------------------------------------------------------------------------
+ * allocate()
+ * 
+ * Gives a new order a slot and records its hot and cold fields
+ * 
+ * @param[in] newOrder  Order being added to the order book
+ * @return the slot of the order, or NO_SLOT if an order with the same ID is already resting
+ * --------------------------------------------------------------------------------------
+*/
+unsigned int OrderStore::allocate(const Order& newOrder)
+{
+    if(m_slotByID.find(newOrder.getID()) != NO_SLOT)
+    {
+        return NO_SLOT;
+    }
+
+    unsigned int slot = 0;
+    if(!m_freeSlots.empty())
+    {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        slot = m_hot.size();
+        m_hot.emplace_back();
+        m_cold.emplace_back();
+        m_ownerLinks.emplace_back();
+        m_sessionLinks.emplace_back();
+
+        // Keeping room for every slot on the free list, so that release() never allocates
+        m_freeSlots.reserve(m_hot.capacity());
+    }
+
+    m_slotByID.insert(newOrder.getID(), slot);
+
+    m_hot[slot].priceTicks = newOrder.getPriceTicks();
+    m_hot[slot].isBuy = newOrder.checkIsBuy();
+    m_hot[slot].pegReference = NOT_PEGGED;
+
+    ColdOrder& cold = m_cold[slot];
+    cold.ticker = newOrder.getTicker();
+    cold.orderID = newOrder.getID();
+    cold.isMarket = newOrder.checkIsMarket();
+    cold.price = newOrder.getPrice();
+    cold.time = newOrder.getTime();
+    cold.owner = newOrder.getOwner();
+    cold.session = newOrder.getSession();
+
+    link(m_ownerLinks, m_firstSlotByOwner, cold.owner, slot);
+    if(cold.session != 0)
+    {
+        link(m_sessionLinks, m_firstSlotBySession, cold.session, slot);
+    }
+
+    return slot;
+}
+
+/**--------------------------------------------------------------------------------------
+ * release()
+ * 
+ * Frees the slot of an order that left the order book
+ * 
+ * @param[in] slot  Slot of the order
+ * --------------------------------------------------------------------------------------
+*/
+void OrderStore::release(unsigned int slot)
+{
+    m_slotByID.erase((int)m_cold[slot].orderID);
+    m_freeSlots.push_back(slot);
+
+    unlink(m_ownerLinks, m_firstSlotByOwner, m_cold[slot].owner, slot);
+    if(m_cold[slot].session != 0)
+    {
+        unlink(m_sessionLinks, m_firstSlotBySession, m_cold[slot].session, slot);
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * reprice()
+ * 
+ * Records the new price and time of a resting order that was moved to another price
+ * level, or to the back of its own, without giving up its slot
+ * 
+ * @param[in] slot          Slot of the order
+ * @param[in] priceTicks    New price of the order in ticks
+ * @param[in] time          New time of the order
+ * --------------------------------------------------------------------------------------
+*/
+void OrderStore::reprice(unsigned int slot, int priceTicks, int time)
+{
+    m_hot[slot].priceTicks = priceTicks;
+    m_cold[slot].price = Order::ticksToPrice(priceTicks);
+    m_cold[slot].time = time;
+}
+
+/**--------------------------------------------------------------------------------------
+ * findSlot()
+ * 
+ * @param[in] orderID   ID of a resting order
+ * @return the slot of the order, or NO_SLOT if no order with that ID is resting
+ * --------------------------------------------------------------------------------------
+*/
+unsigned int OrderStore::findSlot(int orderID) const
+{
+    return m_slotByID.find(orderID);
+}
+
+/**--------------------------------------------------------------------------------------
+ * link()
+ * 
+ * Puts a slot at the front of the list of its owner or session
+ * 
+ * @param[in,out]   links       Links of every slot for the kind of list
+ * @param[in,out]   firstSlots  First slot of every list of that kind, by key
+ * @param[in]       key         Owner or session of the slot
+ * @param[in]       slot        Slot of a new resting order
+ * --------------------------------------------------------------------------------------
+*/
+void OrderStore::link(std::vector<SlotLink>& links, OwnerIndex& firstSlots, unsigned int key, unsigned int slot)
+{
+    unsigned int firstSlot = firstSlots.find(key);
+    links[slot].prevSlot = NO_SLOT;
+    links[slot].nextSlot = firstSlot;
+    if(firstSlot != NO_SLOT)
+    {
+        links[firstSlot].prevSlot = slot;
+    }
+    firstSlots.assign(key, slot);
+}
+
+/**--------------------------------------------------------------------------------------
+ * unlink()
+ * 
+ * Takes a slot out of the list of its owner or session
+ * 
+ * @param[in,out]   links       Links of every slot for the kind of list
+ * @param[in,out]   firstSlots  First slot of every list of that kind, by key
+ * @param[in]       key         Owner or session of the slot
+ * @param[in]       slot        Slot of an order leaving the book
+ * --------------------------------------------------------------------------------------
+*/
+void OrderStore::unlink(std::vector<SlotLink>& links, OwnerIndex& firstSlots, unsigned int key, unsigned int slot)
+{
+    const SlotLink curLink = links[slot];
+    if(curLink.nextSlot != NO_SLOT)
+    {
+        links[curLink.nextSlot].prevSlot = curLink.prevSlot;
+    }
+
+    if(curLink.prevSlot != NO_SLOT)
+    {
+        links[curLink.prevSlot].nextSlot = curLink.nextSlot;
+    }
+    else if(curLink.nextSlot != NO_SLOT)
+    {
+        firstSlots.assign(key, curLink.nextSlot);
+    }
+    else
+    {
+        firstSlots.erase(key);
+    }
+}
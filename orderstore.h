@@ -0,0 +1,325 @@
+/*orderstore.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the OrderStore class
+ *     Slot-indexed storage for every order resting in an order book, split into a compact hot
+ *     record used while matching and a cold record for fields that are rarely read
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "order.h"
+#include "orderindex.h"
+#include "pegbook.h"
+
+/**--------------------------------------------------------------------------------------
+ * HotOrder struct
+ * 
+ * Fields of a resting order needed to find it inside the order book. The amount, ID, time
+ * priority and owner used while matching live in the parallel arrays of its PriceLevel
+ * --------------------------------------------------------------------------------------
+*/
+typedef struct HotOrder
+{
+    int priceTicks;             // Price level the order rests at, or its offset if the order is pegged
+    bool isBuy;                 // Side of the book the order rests on
+    PegReference pegReference;  // Price the order is pegged to, NOT_PEGGED for limit orders
+    unsigned int levelIndex;    // Position of the order in the arrays of its PriceLevel, kept up to date by the level
+} HotOrder;
+
+/**--------------------------------------------------------------------------------------
+ * ColdOrder struct
+ * 
+ * Fields of a resting order that are never touched while matching
+ * --------------------------------------------------------------------------------------
+*/
+typedef struct ColdOrder
+{
+    std::string ticker;
+    unsigned long long orderID;
+    bool isMarket;
+    float price;
+    int time;
+    unsigned int owner;
+    unsigned int session;   // Order-entry session the order came through, 0 if none
+} ColdOrder;
+
+
+
+/**--------------------------------------------------------------------------------------
+ * SlotLink struct
+ * 
+ * Links a resting order to the previous and next resting orders of the same owner, or of
+ * the same order-entry session
+ * --------------------------------------------------------------------------------------
+*/
+typedef struct SlotLink
+{
+    unsigned int prevSlot;  // NO_SLOT for the first order of the list
+    unsigned int nextSlot;  // NO_SLOT for the last order of the list
+} SlotLink;
+
+
+
+/**--------------------------------------------------------------------------------------
+ * OrderStore class
+ * 
+ * Gives every resting order a slot, which indexes its hot and cold records in two parallel
+ * arrays. Slots of orders that leave the book are reused by later orders. The slots of each
+ * owner, and of each order-entry session, are also chained into doubly linked lists, so
+ * that every order of one owner or session can be found without looking at the orders of
+ * anyone else
+ * --------------------------------------------------------------------------------------
+*/
+class OrderStore
+{
+public:
+    static const unsigned int NO_SLOT = OrderIndex::NO_SLOT;
+
+    /**--------------------------------------------------------------------------------------
+     * reserve()
+     * 
+     * Preallocates slots so that numOrders orders can rest at the same time without any
+     * further allocation
+     * 
+     * @param[in] numOrders Largest number of orders expected to rest at the same time
+     * --------------------------------------------------------------------------------------
+    */
+    void reserve(size_t numOrders);
+
+    /**--------------------------------------------------------------------------------------
+     * prefault()
+     * 
+     * Writes to every reserved slot once, so that the memory behind them is already mapped
+     * when the first orders arrive
+     * --------------------------------------------------------------------------------------
+    */
+    void prefault();
+
+    /**--------------------------------------------------------------------------------------
+     * allocate()
+     * 
+     * Gives a new order a slot and records its hot and cold fields
+     * 
+     * @param[in] newOrder  Order being added to the order book
+     * @return the slot of the order, or NO_SLOT if an order with the same ID is already resting
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned int allocate(const Order& newOrder);
+
+    /**--------------------------------------------------------------------------------------
+     * release()
+     * 
+     * Frees the slot of an order that left the order book
+     * 
+     * @param[in] slot  Slot of the order
+     * --------------------------------------------------------------------------------------
+    */
+    void release(unsigned int slot);
+
+    /**--------------------------------------------------------------------------------------
+     * reprice()
+     * 
+     * Records the new price and time of a resting order that was moved to another price
+     * level, or to the back of its own, without giving up its slot
+     * 
+     * @param[in] slot          Slot of the order
+     * @param[in] priceTicks    New price of the order in ticks
+     * @param[in] time          New time of the order
+     * --------------------------------------------------------------------------------------
+    */
+    void reprice(unsigned int slot, int priceTicks, int time);
+
+    /**--------------------------------------------------------------------------------------
+     * peg()
+     * 
+     * Records that a newly allocated order rests in a group of pegged orders instead of at
+     * its own price
+     * 
+     * @param[in] slot          Slot of the order
+     * @param[in] reference     Price the order follows
+     * @param[in] offsetTicks   Ticks added to the reference price
+     * --------------------------------------------------------------------------------------
+    */
+    void peg(unsigned int slot, PegReference reference, int offsetTicks)
+    {
+        m_hot[slot].priceTicks = offsetTicks;
+        m_hot[slot].pegReference = reference;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * findSlot()
+     * 
+     * @param[in] orderID   ID of a resting order
+     * @return the slot of the order, or NO_SLOT if no order with that ID is resting
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned int findSlot(int orderID) const;
+
+    /**--------------------------------------------------------------------------------------
+     * firstSlotOfOwner()
+     * 
+     * @param[in] owner ID of an account/participant
+     * @return the slot of the most recently added resting order of the owner, or NO_SLOT if
+     *         the owner has no resting order
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned int firstSlotOfOwner(unsigned int owner) const
+    {
+        return m_firstSlotByOwner.find(owner);
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * nextSlotOfOwner()
+     * 
+     * @param[in] slot  Slot of a resting order
+     * @return the slot of the next older resting order of the same owner, or NO_SLOT
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned int nextSlotOfOwner(unsigned int slot) const
+    {
+        return m_ownerLinks[slot].nextSlot;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * firstSlotOfSession()
+     * 
+     * @param[in] session   ID of an order-entry session, not 0
+     * @return the slot of the most recently added resting order of the session, or NO_SLOT
+     *         if the session has no resting order
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned int firstSlotOfSession(unsigned int session) const
+    {
+        return m_firstSlotBySession.find(session);
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * nextSlotOfSession()
+     * 
+     * @param[in] slot  Slot of a resting order that came through a session
+     * @return the slot of the next older resting order of the same session, or NO_SLOT
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned int nextSlotOfSession(unsigned int slot) const
+    {
+        return m_sessionLinks[slot].nextSlot;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getHot() / getCold()
+     * 
+     * @param[in] slot  Slot of a resting order
+     * @return the hot or cold record of the order
+     * --------------------------------------------------------------------------------------
+    */
+    const HotOrder& getHot(unsigned int slot) const
+    {
+        return m_hot[slot];
+    }
+
+    const ColdOrder& getCold(unsigned int slot) const
+    {
+        return m_cold[slot];
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * setLevelIndex()
+     * 
+     * Records where a resting order sits in the arrays of its PriceLevel
+     * 
+     * @param[in] slot          Slot of a resting order
+     * @param[in] levelIndex    Position of the order in the arrays of its price level
+     * --------------------------------------------------------------------------------------
+    */
+    void setLevelIndex(unsigned int slot, unsigned int levelIndex)
+    {
+        m_hot[slot].levelIndex = levelIndex;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * size()
+     * 
+     * @return the number of orders currently holding a slot
+     * --------------------------------------------------------------------------------------
+    */
+    size_t size() const
+    {
+        return m_slotByID.size();
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * capacity()
+     * 
+     * @return the number of orders that can hold a slot before the store has to grow
+     * --------------------------------------------------------------------------------------
+    */
+    size_t capacity() const
+    {
+        return m_hot.capacity();
+    }
+
+private:
+    /**--------------------------------------------------------------------------------------
+     * link()
+     * 
+     * Puts a slot at the front of the list of its owner or session
+     * 
+     * @param[in,out]   links       Links of every slot for the kind of list
+     * @param[in,out]   firstSlots  First slot of every list of that kind, by key
+     * @param[in]       key         Owner or session of the slot
+     * @param[in]       slot        Slot of a new resting order
+     * --------------------------------------------------------------------------------------
+    */
+    static void link(std::vector<SlotLink>& links, OwnerIndex& firstSlots, unsigned int key, unsigned int slot);
+
+    /**--------------------------------------------------------------------------------------
+     * unlink()
+     * 
+     * Takes a slot out of the list of its owner or session
+     * 
+     * @param[in,out]   links       Links of every slot for the kind of list
+     * @param[in,out]   firstSlots  First slot of every list of that kind, by key
+     * @param[in]       key         Owner or session of the slot
+     * @param[in]       slot        Slot of an order leaving the book
+     * --------------------------------------------------------------------------------------
+    */
+    static void unlink(std::vector<SlotLink>& links, OwnerIndex& firstSlots, unsigned int key, unsigned int slot);
+
+    std::vector<HotOrder> m_hot;                            // Indexed by slot
+    std::vector<ColdOrder> m_cold;                          // Indexed by slot
+    std::vector<SlotLink> m_ownerLinks;                     // Indexed by slot
+    std::vector<SlotLink> m_sessionLinks;                   // Indexed by slot, only meaningful for orders with a session
+    std::vector<unsigned int> m_freeSlots;                  // Slots released by orders that left the book
+    OrderIndex m_slotByID;                                  // Slot of every resting order, by order ID
+    OwnerIndex m_firstSlotByOwner;                          // First slot of the list of every owner with resting orders, by owner
+    OwnerIndex m_firstSlotBySession;                        // First slot of the list of every session with resting orders, by session
+};
@@ -0,0 +1,257 @@
+/*pegbook.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the PegBook class
+ *     Holds the pegged orders of an order book, grouped by the price they are pegged to, and
+ *     reprices the groups lazily when the best prices of the book move
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <utility>
+#include <climits>
+
+#include "pegbook.h"
+
+/**--------------------------------------------------------------------------------------
+ * addOrder()
+ * 
+ * Adds a pegged order to the back of its group, creating the group if needed
+ * 
+ * @param[in] newOrder      Order to be added, its price is ignored
+ * @param[in] reference     Price the order follows
+ * @param[in] offsetTicks   Ticks added to the reference price
+ * @param[in] slot          Slot of the order in the order book's OrderStore
+ * --------------------------------------------------------------------------------------
+*/
+void PegBook::addOrder(const Order& newOrder, PegReference reference, int offsetTicks, unsigned int slot)
+{
+    PegGroup* group = findGroup(newOrder.checkIsBuy(), reference, offsetTicks);
+
+    if(group == nullptr)
+    {
+        // Reusing a group dropped earlier keeps the memory of its level, like the levels of the ladders,
+        // preferably the one of the same peg so that it comes back with the room it grew to
+        std::vector<std::unique_ptr<PegGroup>>& spareGroups = m_spareGroups[newOrder.checkIsBuy()];
+        if(spareGroups.empty())
+        {
+            m_groups[newOrder.checkIsBuy()].emplace_back(new PegGroup());
+            m_groups[newOrder.checkIsBuy()].back()->orders = PriceLevel(m_orderStore);
+        }
+        else
+        {
+            size_t spareIndex = spareGroups.size() - 1;
+            for(size_t i = 0; i < spareGroups.size(); i++)
+            {
+                if(spareGroups[i]->reference == reference && spareGroups[i]->offsetTicks == offsetTicks)
+                {
+                    spareIndex = i;
+                    break;
+                }
+            }
+
+            m_groups[newOrder.checkIsBuy()].push_back(std::move(spareGroups[spareIndex]));
+            spareGroups[spareIndex] = std::move(spareGroups.back());
+            spareGroups.pop_back();
+        }
+
+        group = m_groups[newOrder.checkIsBuy()].back().get();
+        group->reference = reference;
+        group->offsetTicks = offsetTicks;
+        group->effectiveTick = PriceLadder::NO_PRICE;
+    }
+
+    unsigned long long sequence = ((unsigned long long)(unsigned int)newOrder.getTime() << 32) | m_arrivals++;
+    group->orders.insert(newOrder, sequence, slot);
+    m_isStale = true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * findGroup()
+ * 
+ * @param[in] isBuy         Side of the group
+ * @param[in] reference     Price the orders of the group follow
+ * @param[in] offsetTicks   Offset of the orders of the group
+ * @return the group, or nullptr if it does not exist
+ * --------------------------------------------------------------------------------------
+*/
+PegBook::PegGroup* PegBook::findGroup(bool isBuy, PegReference reference, int offsetTicks)
+{
+    // Few distinct pegs exist at any time, scanning them is cheaper than hashing
+    for(const std::unique_ptr<PegGroup>& group : m_groups[isBuy])
+    {
+        if(group->reference == reference && group->offsetTicks == offsetTicks)
+        {
+            return group.get();
+        }
+    }
+
+    return nullptr;
+}
+
+/**--------------------------------------------------------------------------------------
+ * reprice()
+ * 
+ * Recomputes the price of every group and sorts the active groups, but only if the
+ * reference prices moved or a group changed since the last call
+ * 
+ * @param[in] bestBuyTick   Best buy price of the limit orders, or PriceLadder::NO_PRICE
+ * @param[in] bestSellTick  Best sell price of the limit orders, or PriceLadder::NO_PRICE
+ * --------------------------------------------------------------------------------------
+*/
+void PegBook::reprice(int bestBuyTick, int bestSellTick)
+{
+    if(!m_isStale && bestBuyTick == m_pricedBuyTick && bestSellTick == m_pricedSellTick)
+    {
+        return;
+    }
+
+    for(int isBuy = 0; isBuy < 2; isBuy++)
+    {
+        // Setting the empty groups aside for reuse, keeping the others in the order they were created
+        std::vector<std::unique_ptr<PegGroup>>& groups = m_groups[isBuy];
+        size_t numKept = 0;
+        for(size_t i = 0; i < groups.size(); i++)
+        {
+            if(groups[i]->orders.empty())
+            {
+                m_spareGroups[isBuy].push_back(std::move(groups[i]));
+            }
+            else if(i != numKept)
+            {
+                groups[numKept++] = std::move(groups[i]);
+            }
+            else
+            {
+                numKept++;
+            }
+        }
+        groups.resize(numKept);
+
+        std::vector<PegGroup*>& activeGroups = m_activeGroups[isBuy];
+        activeGroups.clear();
+
+        for(const std::unique_ptr<PegGroup>& group : groups)
+        {
+            group->effectiveTick = getEffectiveTick(isBuy, *group, bestBuyTick, bestSellTick);
+            if(group->effectiveTick != PriceLadder::NO_PRICE)
+            {
+                activeGroups.push_back(group.get());
+            }
+        }
+
+        // Insertion sort, stable and without the buffer std::stable_sort allocates, for the few groups there are
+        for(size_t i = 1; i < activeGroups.size(); i++)
+        {
+            PegGroup* curGroup = activeGroups[i];
+            size_t j = i;
+            while(j > 0 && (isBuy ? curGroup->effectiveTick > activeGroups[j - 1]->effectiveTick : curGroup->effectiveTick < activeGroups[j - 1]->effectiveTick))
+            {
+                activeGroups[j] = activeGroups[j - 1];
+                j--;
+            }
+            activeGroups[j] = curGroup;
+        }
+    }
+
+    m_pricedBuyTick = bestBuyTick;
+    m_pricedSellTick = bestSellTick;
+    m_isStale = false;
+}
+
+/**--------------------------------------------------------------------------------------
+ * getEffectiveTick()
+ * 
+ * @param[in] isBuy         Side of the group
+ * @param[in] group         Group of pegged orders
+ * @param[in] bestBuyTick   Best buy price of the limit orders, or PriceLadder::NO_PRICE
+ * @param[in] bestSellTick  Best sell price of the limit orders, or PriceLadder::NO_PRICE
+ * @return the price of the group, or PriceLadder::NO_PRICE if its reference price does
+ *         not exist or the price does not fit in an int
+ * --------------------------------------------------------------------------------------
+*/
+int PegBook::getEffectiveTick(bool isBuy, const PegGroup& group, int bestBuyTick, int bestSellTick)
+{
+    int referenceTick = PriceLadder::NO_PRICE;
+
+    switch(group.reference)
+    {
+        case PEG_PRIMARY:
+            referenceTick = isBuy ? bestBuyTick : bestSellTick;
+            break;
+
+        case PEG_MARKET:
+            referenceTick = isBuy ? bestSellTick : bestBuyTick;
+            break;
+
+        case PEG_MIDPOINT:
+            if(bestBuyTick != PriceLadder::NO_PRICE && bestSellTick != PriceLadder::NO_PRICE)
+            {
+                // Rounding down for buys and up for sells, also for negative prices
+                long long sum = (long long)bestBuyTick + bestSellTick + (isBuy ? 0 : 1);
+                referenceTick = (int)((sum >= 0) ? sum / 2 : -((1 - sum) / 2));
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    if(referenceTick == PriceLadder::NO_PRICE)
+    {
+        return PriceLadder::NO_PRICE;
+    }
+
+    long long effectiveTick = (long long)referenceTick + group.offsetTicks;
+    if(effectiveTick <= INT_MIN || effectiveTick > INT_MAX)
+    {
+        return PriceLadder::NO_PRICE;
+    }
+
+    return (int)effectiveTick;
+}
+
+/**--------------------------------------------------------------------------------------
+ * clear()
+ * 
+ * Drops every group, keeping their memory for later groups. The orders have to be removed
+ * and their slots released by the caller
+ * --------------------------------------------------------------------------------------
+*/
+void PegBook::clear()
+{
+    for(int isBuy = 0; isBuy < 2; isBuy++)
+    {
+        for(std::unique_ptr<PegGroup>& group : m_groups[isBuy])
+        {
+            m_spareGroups[isBuy].push_back(std::move(group));
+        }
+        m_groups[isBuy].clear();
+        m_activeGroups[isBuy].clear();
+    }
+
+    m_isStale = true;
+}
@@ -0,0 +1,208 @@
+/*pegbook.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the PegBook class
+ *     Holds the pegged orders of an order book, grouped by the price they are pegged to, and
+ *     reprices the groups lazily when the best prices of the book move
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "order.h"
+#include "priceladder.h"
+
+/**--------------------------------------------------------------------------------------
+ * PegReference enum
+ * 
+ * Price a pegged order follows, before adding its offset
+ * --------------------------------------------------------------------------------------
+*/
+enum PegReference : unsigned char
+{
+    NOT_PEGGED = 0,
+    PEG_PRIMARY,    // Best price of the order's own side
+    PEG_MARKET,     // Best price of the opposite side
+    PEG_MIDPOINT    // Midpoint of the best buy and sell prices, rounded down for buys and up for sells
+};
+
+
+
+/**--------------------------------------------------------------------------------------
+ * PegBook class
+ * 
+ * Pegged orders sharing a side, reference and offset always share their price, so they are
+ * kept together in one group, a PriceLevel in time priority, instead of in the price
+ * ladders. When the reference prices move, only the price of every group is recomputed, and
+ * only once the groups are next needed, instead of moving every pegged order to a new
+ * price level. Reference prices are the best prices of the limit orders in the ladders, so
+ * pegged orders never peg to each other
+ * --------------------------------------------------------------------------------------
+*/
+class PegBook
+{
+public:
+    typedef struct PegGroup
+    {
+        PegReference reference;
+        int offsetTicks;
+        int effectiveTick;  // Price the orders currently rest at, as of the last reprice()
+        PriceLevel orders;
+    } PegGroup;
+
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Creates a book without any pegged orders
+     * 
+     * @param[in] orderStore    Order store holding the slots of the pegged orders
+     * --------------------------------------------------------------------------------------
+    */
+    explicit PegBook(OrderStore* orderStore)
+      : m_orderStore(orderStore)
+    {}
+
+    /**--------------------------------------------------------------------------------------
+     * empty()
+     * 
+     * @return true if no group of pegged orders exists
+     * --------------------------------------------------------------------------------------
+    */
+    bool empty() const
+    {
+        return m_groups[0].empty() && m_groups[1].empty();
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * addOrder()
+     * 
+     * Adds a pegged order to the back of its group, creating the group if needed
+     * 
+     * @param[in] newOrder      Order to be added, its price is ignored
+     * @param[in] reference     Price the order follows
+     * @param[in] offsetTicks   Ticks added to the reference price
+     * @param[in] slot          Slot of the order in the order book's OrderStore
+     * --------------------------------------------------------------------------------------
+    */
+    void addOrder(const Order& newOrder, PegReference reference, int offsetTicks, unsigned int slot);
+
+    /**--------------------------------------------------------------------------------------
+     * findGroup()
+     * 
+     * @param[in] isBuy         Side of the group
+     * @param[in] reference     Price the orders of the group follow
+     * @param[in] offsetTicks   Offset of the orders of the group
+     * @return the group, or nullptr if it does not exist
+     * --------------------------------------------------------------------------------------
+    */
+    PegGroup* findGroup(bool isBuy, PegReference reference, int offsetTicks);
+
+    /**--------------------------------------------------------------------------------------
+     * markStale()
+     * 
+     * Notes that orders were removed from a group, so that the next reprice() drops the
+     * groups left empty
+     * --------------------------------------------------------------------------------------
+    */
+    void markStale()
+    {
+        m_isStale = true;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * reprice()
+     * 
+     * Recomputes the price of every group and sorts the active groups, but only if the
+     * reference prices moved or a group changed since the last call
+     * 
+     * @param[in] bestBuyTick   Best buy price of the limit orders, or PriceLadder::NO_PRICE
+     * @param[in] bestSellTick  Best sell price of the limit orders, or PriceLadder::NO_PRICE
+     * --------------------------------------------------------------------------------------
+    */
+    void reprice(int bestBuyTick, int bestSellTick);
+
+    /**--------------------------------------------------------------------------------------
+     * getActiveGroups()
+     * 
+     * @param[in] isBuy Side of the groups
+     * @return every group of the side whose reference price exists, best price first and
+     *         groups with the same price in the order they were created, as of the last
+     *         reprice()
+     * --------------------------------------------------------------------------------------
+    */
+    const std::vector<PegGroup*>& getActiveGroups(bool isBuy) const
+    {
+        return m_activeGroups[isBuy];
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getGroups()
+     * 
+     * @param[in] isBuy Side of the groups
+     * @return every group of the side, in the order they were created
+     * --------------------------------------------------------------------------------------
+    */
+    const std::vector<std::unique_ptr<PegGroup>>& getGroups(bool isBuy) const
+    {
+        return m_groups[isBuy];
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getEffectiveTick()
+     * 
+     * @param[in] isBuy         Side of the group
+     * @param[in] group         Group of pegged orders
+     * @param[in] bestBuyTick   Best buy price of the limit orders, or PriceLadder::NO_PRICE
+     * @param[in] bestSellTick  Best sell price of the limit orders, or PriceLadder::NO_PRICE
+     * @return the price of the group, or PriceLadder::NO_PRICE if its reference price does
+     *         not exist or the price does not fit in an int
+     * --------------------------------------------------------------------------------------
+    */
+    static int getEffectiveTick(bool isBuy, const PegGroup& group, int bestBuyTick, int bestSellTick);
+
+    /**--------------------------------------------------------------------------------------
+     * clear()
+     * 
+     * Drops every group, keeping their memory for later groups. The orders have to be removed
+     * and their slots released by the caller
+     * --------------------------------------------------------------------------------------
+    */
+    void clear();
+
+private:
+    OrderStore* m_orderStore;                               // Store holding the slots of the pegged orders
+    std::vector<std::unique_ptr<PegGroup>> m_groups[2];     // Indexed by isBuy
+    std::vector<PegGroup*> m_activeGroups[2];               // Indexed by isBuy, best price first
+    std::vector<std::unique_ptr<PegGroup>> m_spareGroups[2];    // Indexed by isBuy, emptied groups kept with their memory for new pegs
+    int m_pricedBuyTick = PriceLadder::NO_PRICE;            // Reference prices of the last reprice()
+    int m_pricedSellTick = PriceLadder::NO_PRICE;
+    bool m_isStale = false;                                 // Whether a group changed since the last reprice()
+    unsigned int m_arrivals = 0;                            // Number of orders added so far, breaks ties between orders with the same time
+};
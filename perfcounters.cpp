@@ -0,0 +1,248 @@
+/*perfcounters.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the PerfCounters class
+ *     Hardware performance counters (perf_event_open) sampled around each stage of the engine
+ *     and reported per stage and per million orders
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "perfcounters.h"
+
+namespace {
+    const char* EVENT_NAMES[PerfCounters::NUM_EVENTS] = { "task-clock(ns)", "cycles", "instructions", "L1d-misses", "LLC-misses", "branch-misses" };
+
+#ifdef __linux__
+    /**--------------------------------------------------------------------------------------
+     * openCounter()
+     * 
+     * Opens a disabled counter of user-space events for the calling thread
+     * 
+     * @param[in] type      perf_event type, e.g. PERF_TYPE_HARDWARE
+     * @param[in] config    perf_event config, e.g. PERF_COUNT_HW_CPU_CYCLES
+     * @return the file descriptor of the counter, or -1 if it is not available
+     * --------------------------------------------------------------------------------------
+    */
+    int openCounter(unsigned int type, unsigned long long config)
+    {
+        struct perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.type = type;
+        attributes.config = config;
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+
+        return (int)syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+    }
+#endif
+}
+
+/**--------------------------------------------------------------------------------------
+ * Constructor
+ * 
+ * Opens every counter for the calling thread, disabled until start() is called
+ * --------------------------------------------------------------------------------------
+*/
+PerfCounters::PerfCounters()
+{
+    for(int& fd : m_fds)
+    {
+        fd = -1;
+    }
+
+#ifdef __linux__
+    m_fds[TASK_CLOCK] = openCounter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK);
+    m_fds[CYCLES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    m_fds[INSTRUCTIONS] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    m_fds[L1D_MISSES] = openCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    m_fds[LLC_MISSES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    m_fds[BRANCH_MISSES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+}
+
+/**--------------------------------------------------------------------------------------
+ * Destructor
+ * 
+ * Closes every counter
+ * --------------------------------------------------------------------------------------
+*/
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+    for(int fd : m_fds)
+    {
+        if(fd != -1)
+        {
+            close(fd);
+        }
+    }
+#endif
+}
+
+/**--------------------------------------------------------------------------------------
+ * start()
+ * 
+ * Resets and enables every counter, marking the beginning of a stage
+ * --------------------------------------------------------------------------------------
+*/
+void PerfCounters::start()
+{
+#ifdef __linux__
+    for(int fd : m_fds)
+    {
+        if(fd != -1)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+
+    m_startNanoseconds = nowNanoseconds();
+}
+
+/**--------------------------------------------------------------------------------------
+ * stop()
+ * 
+ * Disables every counter and adds their values to the totals of a stage
+ * 
+ * @param[in] stage     Name of the stage that ran since start()
+ * @param[in] numOrders Number of orders processed by the stage, used to report the
+ *                      counters per million orders
+ * --------------------------------------------------------------------------------------
+*/
+void PerfCounters::stop(const std::string& stage, long long numOrders)
+{
+    double elapsedNanoseconds = nowNanoseconds() - m_startNanoseconds;
+    unsigned long long counts[NUM_EVENTS] = {};
+    bool isCounted[NUM_EVENTS] = {};
+
+#ifdef __linux__
+    for(int i = 0; i < NUM_EVENTS; i++)
+    {
+        if(m_fds[i] != -1)
+        {
+            ioctl(m_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            isCounted[i] = (read(m_fds[i], &counts[i], sizeof(counts[i])) == (ssize_t)sizeof(counts[i]));
+        }
+    }
+#endif
+
+    StageTotals* totals = nullptr;
+    for(StageTotals& curStage : m_stages)
+    {
+        if(curStage.name == stage)
+        {
+            totals = &curStage;
+        }
+    }
+
+    if(totals == nullptr)
+    {
+        m_stages.push_back(StageTotals{stage, 0, {}, {}, 0});
+        totals = &m_stages.back();
+        std::copy(std::begin(isCounted), std::end(isCounted), std::begin(totals->isCounted));
+    }
+
+    totals->numOrders += numOrders;
+    totals->wallNanoseconds += elapsedNanoseconds;
+    for(int i = 0; i < NUM_EVENTS; i++)
+    {
+        totals->counts[i] += counts[i];
+        totals->isCounted[i] = totals->isCounted[i] && isCounted[i];
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * printReport()
+ * 
+ * Prints the totals of every stage, in the order the stages first ran, along with their
+ * values per million orders
+ * --------------------------------------------------------------------------------------
+*/
+void PerfCounters::printReport() const
+{
+    std::cout << "    Stage      Orders      Counter           Total        Per 1M orders\n    ---------+-----------+----------------+---------------+---------------" << std::endl;
+
+    for(const StageTotals& curStage : m_stages)
+    {
+        double perMillion = (curStage.numOrders > 0) ? 1000000.0 / curStage.numOrders : 0.0;
+
+        std::cout << "    " << std::left << std::setw(9) << curStage.name << "  " << std::setw(10) << curStage.numOrders << "  " \
+                  << std::setw(15) << "wall(ns)" << "  " << std::setw(14) << std::fixed << std::setprecision(0) << curStage.wallNanoseconds << "  " \
+                  << curStage.wallNanoseconds * perMillion << std::endl;
+
+        for(int i = 0; i < NUM_EVENTS; i++)
+        {
+            std::cout << "    " << std::setw(9) << "" << "  " << std::setw(10) << "" << "  " << std::setw(15) << EVENT_NAMES[i] << "  ";
+            if(curStage.isCounted[i])
+            {
+                std::cout << std::setw(14) << curStage.counts[i] << "  " << curStage.counts[i] * perMillion << std::endl;
+            }
+            else
+            {
+                std::cout << std::setw(14) << "n/a" << "  n/a" << std::endl;
+            }
+        }
+
+        // Instructions per cycle tells whether a stage is stalled (on cache misses) or busy
+        if(curStage.isCounted[CYCLES] && curStage.isCounted[INSTRUCTIONS] && curStage.counts[CYCLES] != 0)
+        {
+            std::cout << "    " << std::setw(9) << "" << "  " << std::setw(10) << "" << "  " << std::setw(15) << "IPC" << "  " \
+                      << std::setprecision(2) << (double)curStage.counts[INSTRUCTIONS] / curStage.counts[CYCLES] << std::endl;
+        }
+    }
+
+    std::cout << std::right;
+}
+
+/**--------------------------------------------------------------------------------------
+ * nowNanoseconds()
+ * 
+ * @return the current time of a monotonic clock, in nanoseconds
+ * --------------------------------------------------------------------------------------
+*/
+double PerfCounters::nowNanoseconds()
+{
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,132 @@
+/*perfcounters.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the PerfCounters class
+ *     Hardware performance counters (perf_event_open) sampled around each stage of the engine
+ *     and reported per stage and per million orders
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**--------------------------------------------------------------------------------------
+ * PerfCounters class
+ * 
+ * Counts cycles, instructions, L1 data cache misses, last level cache misses and branch
+ * misses of the calling thread between start() and stop(), and accumulates them under the
+ * name of the stage being measured (e.g. parse, add, match, output). Counters the kernel or
+ * CPU does not provide (e.g. inside most virtual machines) are reported as n/a. On platforms
+ * without perf_event_open only the wall time of each stage is reported
+ * --------------------------------------------------------------------------------------
+*/
+class PerfCounters
+{
+public:
+    enum Event
+    {
+        TASK_CLOCK,     // Nanoseconds the thread was running, always available on Linux
+        CYCLES,
+        INSTRUCTIONS,
+        L1D_MISSES,
+        LLC_MISSES,
+        BRANCH_MISSES,
+        NUM_EVENTS
+    };
+
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Opens every counter for the calling thread, disabled until start() is called
+     * --------------------------------------------------------------------------------------
+    */
+    PerfCounters();
+
+    /**--------------------------------------------------------------------------------------
+     * Destructor
+     * 
+     * Closes every counter
+     * --------------------------------------------------------------------------------------
+    */
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /**--------------------------------------------------------------------------------------
+     * start()
+     * 
+     * Resets and enables every counter, marking the beginning of a stage
+     * --------------------------------------------------------------------------------------
+    */
+    void start();
+
+    /**--------------------------------------------------------------------------------------
+     * stop()
+     * 
+     * Disables every counter and adds their values to the totals of a stage
+     * 
+     * @param[in] stage     Name of the stage that ran since start()
+     * @param[in] numOrders Number of orders processed by the stage, used to report the
+     *                      counters per million orders
+     * --------------------------------------------------------------------------------------
+    */
+    void stop(const std::string& stage, long long numOrders);
+
+    /**--------------------------------------------------------------------------------------
+     * printReport()
+     * 
+     * Prints the totals of every stage, in the order the stages first ran, along with their
+     * values per million orders
+     * --------------------------------------------------------------------------------------
+    */
+    void printReport() const;
+
+private:
+    typedef struct StageTotals
+    {
+        std::string name;
+        long long numOrders;
+        unsigned long long counts[NUM_EVENTS];
+        bool isCounted[NUM_EVENTS];     // False if the counter could not be read
+        double wallNanoseconds;
+    } StageTotals;
+
+    /**--------------------------------------------------------------------------------------
+     * nowNanoseconds()
+     * 
+     * @return the current time of a monotonic clock, in nanoseconds
+     * --------------------------------------------------------------------------------------
+    */
+    static double nowNanoseconds();
+
+    int m_fds[NUM_EVENTS];              // -1 for counters that could not be opened
+    double m_startNanoseconds = 0;
+    std::vector<StageTotals> m_stages;
+};
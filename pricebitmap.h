@@ -0,0 +1,274 @@
+/*pricebitmap.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the PriceBitmap class
+ *     Three-level occupancy bitmap over a window of price ticks, used to find the best and next
+ *     occupied price level of one side of an order book in a handful of instructions
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/**--------------------------------------------------------------------------------------
+ * PriceBitmap class
+ * 
+ * Tracks which of CAPACITY price ticks currently hold resting orders. Every bit of a word in
+ * a higher level summarizes whether the corresponding word of the level below is non-zero,
+ * so finding the next occupied tick in either direction costs at most one bit scan
+ * (tzcnt/lzcnt) per level, no matter how sparse the ladder is.
+ * --------------------------------------------------------------------------------------
+*/
+class PriceBitmap
+{
+public:
+    static const int WORD_BITS = 64;
+    static const int CAPACITY = WORD_BITS * WORD_BITS * WORD_BITS;  // 262144 ticks
+    static const int NONE = -1;
+
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Creates a bitmap with every tick unoccupied
+     * --------------------------------------------------------------------------------------
+    */
+    PriceBitmap()
+    {
+        std::memset(m_leaves, 0, sizeof(m_leaves));
+        std::memset(m_summaries, 0, sizeof(m_summaries));
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * empty()
+     * 
+     * @return true if no tick is occupied
+     * --------------------------------------------------------------------------------------
+    */
+    bool empty() const
+    {
+        return m_root == 0;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * test()
+     * 
+     * @param[in] index Tick index, in the range [0, CAPACITY)
+     * @return true if the tick is occupied
+     * --------------------------------------------------------------------------------------
+    */
+    bool test(int index) const
+    {
+        return (m_leaves[index >> 6] >> (index & 63)) & 1;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * set()
+     * 
+     * Marks a tick as occupied
+     * 
+     * @param[in] index Tick index, in the range [0, CAPACITY)
+     * --------------------------------------------------------------------------------------
+    */
+    void set(int index)
+    {
+        int leaf = index >> 6;
+        int summary = leaf >> 6;
+
+        m_leaves[leaf] |= bit(index & 63);
+        m_summaries[summary] |= bit(leaf & 63);
+        m_root |= bit(summary);
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * clear()
+     * 
+     * Marks a tick as unoccupied, clearing the summary bits above it that become empty
+     * 
+     * @param[in] index Tick index, in the range [0, CAPACITY)
+     * --------------------------------------------------------------------------------------
+    */
+    void clear(int index)
+    {
+        int leaf = index >> 6;
+        int summary = leaf >> 6;
+
+        m_leaves[leaf] &= ~bit(index & 63);
+        if(m_leaves[leaf] == 0)
+        {
+            m_summaries[summary] &= ~bit(leaf & 63);
+            if(m_summaries[summary] == 0)
+            {
+                m_root &= ~bit(summary);
+            }
+        }
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * findFirst()
+     * 
+     * @return the lowest occupied tick, or NONE if the bitmap is empty
+     * --------------------------------------------------------------------------------------
+    */
+    int findFirst() const
+    {
+        return findNext(0);
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * findLast()
+     * 
+     * @return the highest occupied tick, or NONE if the bitmap is empty
+     * --------------------------------------------------------------------------------------
+    */
+    int findLast() const
+    {
+        return findPrev(CAPACITY - 1);
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * findNext()
+     * 
+     * Finds the lowest occupied tick greater than or equal to index
+     * 
+     * @param[in] index Tick index to start searching from
+     * @return the occupied tick, or NONE if there is none at or above index
+     * --------------------------------------------------------------------------------------
+    */
+    int findNext(int index) const
+    {
+        if(index < 0)
+        {
+            index = 0;
+        }
+        if(index >= CAPACITY)
+        {
+            return NONE;
+        }
+
+        int leaf = index >> 6;
+        uint64_t word = m_leaves[leaf] & (~0ULL << (index & 63));
+        if(word != 0)
+        {
+            return (leaf << 6) | lowestBit(word);
+        }
+
+        int summary = leaf >> 6;
+        word = m_summaries[summary] & bitsAbove(leaf & 63);
+        if(word == 0)
+        {
+            word = m_root & bitsAbove(summary);
+            if(word == 0)
+            {
+                return NONE;
+            }
+            summary = lowestBit(word);
+            word = m_summaries[summary];
+        }
+
+        leaf = (summary << 6) | lowestBit(word);
+        return (leaf << 6) | lowestBit(m_leaves[leaf]);
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * findPrev()
+     * 
+     * Finds the highest occupied tick less than or equal to index
+     * 
+     * @param[in] index Tick index to start searching from
+     * @return the occupied tick, or NONE if there is none at or below index
+     * --------------------------------------------------------------------------------------
+    */
+    int findPrev(int index) const
+    {
+        if(index >= CAPACITY)
+        {
+            index = CAPACITY - 1;
+        }
+        if(index < 0)
+        {
+            return NONE;
+        }
+
+        int leaf = index >> 6;
+        uint64_t word = m_leaves[leaf] & bitsUpTo(index & 63);
+        if(word != 0)
+        {
+            return (leaf << 6) | highestBit(word);
+        }
+
+        int summary = leaf >> 6;
+        word = m_summaries[summary] & (bit(leaf & 63) - 1);
+        if(word == 0)
+        {
+            word = m_root & (bit(summary) - 1);
+            if(word == 0)
+            {
+                return NONE;
+            }
+            summary = highestBit(word);
+            word = m_summaries[summary];
+        }
+
+        leaf = (summary << 6) | highestBit(word);
+        return (leaf << 6) | highestBit(m_leaves[leaf]);
+    }
+
+private:
+    static uint64_t bit(int position)
+    {
+        return 1ULL << position;
+    }
+
+    // Bits strictly above position, i.e. position + 1 to 63
+    static uint64_t bitsAbove(int position)
+    {
+        return (position == 63) ? 0 : (~0ULL << (position + 1));
+    }
+
+    // Bits from 0 up to and including position
+    static uint64_t bitsUpTo(int position)
+    {
+        return (position == 63) ? ~0ULL : (bit(position + 1) - 1);
+    }
+
+    // NOTE: word must be non-zero for both of these (tzcnt/lzcnt on x86 with BMI enabled)
+    static int lowestBit(uint64_t word)
+    {
+        return __builtin_ctzll(word);
+    }
+
+    static int highestBit(uint64_t word)
+    {
+        return 63 - __builtin_clzll(word);
+    }
+
+    uint64_t m_root = 0;                                // Bit i set if m_summaries[i] is non-zero
+    uint64_t m_summaries[WORD_BITS];                    // Bit j of word i set if m_leaves[i * 64 + j] is non-zero
+    uint64_t m_leaves[WORD_BITS * WORD_BITS];           // One bit per tick
+};
@@ -0,0 +1,693 @@
+/*priceladder.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the PriceLevel and PriceLadder classes
+ *     A price level holds every resting order at one price, in time priority
+ *     A price ladder holds every price level of one side of an order book, indexed by price tick
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <algorithm>
+#include <iterator>
+
+#include "priceladder.h"
+#include "orderstore.h"
+
+/**--------------------------------------------------------------------------------------
+ * insert()
+ * 
+ * Adds an order behind every order at this price level with an earlier time priority
+ * 
+ * @param[in] newOrder  Order to be added
+ * @param[in] sequence  Time priority of the order: its time in the upper 32 bits, and the
+ *                      order in which it arrived in the lower 32 bits
+ * @param[in] slot      Slot of the order in the order book's OrderStore
+ * --------------------------------------------------------------------------------------
+*/
+void PriceLevel::insert(const Order& newOrder, unsigned long long sequence, unsigned int slot)
+{
+    m_totalAmount += newOrder.getAmount();
+
+    // Orders nearly always arrive in time order, so appending is the common case
+    if(empty() || m_sequences.back() <= sequence)
+    {
+        m_amounts.push_back(newOrder.getAmount());
+        m_ids.push_back(newOrder.getID());
+        m_sequences.push_back(sequence);
+        m_owners.push_back(newOrder.getOwner());
+        m_slots.push_back(slot);
+        recordPositions(m_slots.size() - 1);
+        return;
+    }
+
+    size_t position = std::upper_bound(m_sequences.begin() + m_head, m_sequences.end(), sequence) - m_sequences.begin();
+    m_amounts.insert(m_amounts.begin() + position, newOrder.getAmount());
+    m_ids.insert(m_ids.begin() + position, newOrder.getID());
+    m_sequences.insert(m_sequences.begin() + position, sequence);
+    m_owners.insert(m_owners.begin() + position, newOrder.getOwner());
+    m_slots.insert(m_slots.begin() + position, slot);
+    recordPositions(position);
+}
+
+/**--------------------------------------------------------------------------------------
+ * popFront()
+ * 
+ * Removes the earliest order at this price level
+ * --------------------------------------------------------------------------------------
+*/
+void PriceLevel::popFront()
+{
+    m_totalAmount -= m_amounts[m_head];
+    m_head++;
+
+    compact();
+}
+
+/**--------------------------------------------------------------------------------------
+ * erase()
+ * 
+ * Removes the order at the given position, keeping the remaining orders in time priority
+ * 
+ * @param[in] index Position of the order in time priority, 0 being the earliest
+ * --------------------------------------------------------------------------------------
+*/
+void PriceLevel::erase(size_t index)
+{
+    if(index == 0)
+    {
+        popFront();
+        return;
+    }
+
+    size_t position = m_head + index;
+    m_totalAmount -= m_amounts[position];
+
+    m_amounts.erase(m_amounts.begin() + position);
+    m_ids.erase(m_ids.begin() + position);
+    m_sequences.erase(m_sequences.begin() + position);
+    m_owners.erase(m_owners.begin() + position);
+    m_slots.erase(m_slots.begin() + position);
+    recordPositions(position);
+}
+
+/**--------------------------------------------------------------------------------------
+ * removeFilled()
+ * 
+ * Removes every completely filled order, keeping the remaining orders in time priority
+ * --------------------------------------------------------------------------------------
+*/
+void PriceLevel::removeFilled()
+{
+    const size_t numOrders = m_amounts.size();
+
+    // Skipping over the orders that stay where they are, only the amounts need to be read for this
+    size_t writeIndex = m_head;
+    while(writeIndex < numOrders && m_amounts[writeIndex] != 0)
+    {
+        writeIndex++;
+    }
+
+    for(size_t readIndex = writeIndex; readIndex < numOrders; readIndex++)
+    {
+        if(m_amounts[readIndex] != 0)
+        {
+            m_amounts[writeIndex] = m_amounts[readIndex];
+            m_ids[writeIndex] = m_ids[readIndex];
+            m_sequences[writeIndex] = m_sequences[readIndex];
+            m_owners[writeIndex] = m_owners[readIndex];
+            m_slots[writeIndex] = m_slots[readIndex];
+            if(m_orderStore != nullptr)
+            {
+                m_orderStore->setLevelIndex(m_slots[writeIndex], (unsigned int)writeIndex);
+            }
+            writeIndex++;
+        }
+    }
+
+    m_amounts.resize(writeIndex);
+    m_ids.resize(writeIndex);
+    m_sequences.resize(writeIndex);
+    m_owners.resize(writeIndex);
+    m_slots.resize(writeIndex);
+
+    compact();
+}
+
+/**--------------------------------------------------------------------------------------
+ * prefault()
+ * 
+ * Reserves room for numOrders orders and writes to all of it once, so that the memory is
+ * already mapped when the first orders arrive
+ * 
+ * @param[in] numOrders Number of orders to make room for
+ * --------------------------------------------------------------------------------------
+*/
+void PriceLevel::prefault(size_t numOrders)
+{
+    const size_t numResting = m_amounts.size();
+    const size_t newSize = std::max(numResting, numOrders);
+
+    // Growing every array with zeroes and shrinking it back keeps the capacity and leaves every page touched
+    m_amounts.resize(newSize);
+    m_ids.resize(newSize);
+    m_sequences.resize(newSize);
+    m_owners.resize(newSize);
+    m_slots.resize(newSize);
+
+    m_amounts.resize(numResting);
+    m_ids.resize(numResting);
+    m_sequences.resize(numResting);
+    m_owners.resize(numResting);
+    m_slots.resize(numResting);
+}
+
+/**--------------------------------------------------------------------------------------
+ * compact()
+ * 
+ * Releases the slots in front of m_head once they make up most of the level
+ * --------------------------------------------------------------------------------------
+*/
+void PriceLevel::compact()
+{
+    if(m_head == m_amounts.size())
+    {
+        m_amounts.clear();
+        m_ids.clear();
+        m_sequences.clear();
+        m_owners.clear();
+        m_slots.clear();
+        m_head = 0;
+    }
+    else if(m_head >= 64 && m_head * 2 >= m_amounts.size())
+    {
+        m_amounts.erase(m_amounts.begin(), m_amounts.begin() + m_head);
+        m_ids.erase(m_ids.begin(), m_ids.begin() + m_head);
+        m_sequences.erase(m_sequences.begin(), m_sequences.begin() + m_head);
+        m_owners.erase(m_owners.begin(), m_owners.begin() + m_head);
+        m_slots.erase(m_slots.begin(), m_slots.begin() + m_head);
+        m_head = 0;
+        recordPositions(0);
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * find()
+ * 
+ * Finds the position of an order from the position this level keeps in its hot record
+ * 
+ * @param[in] slot  Slot of an order resting at this level in the order book's OrderStore
+ * @return the position of the order in time priority
+ * --------------------------------------------------------------------------------------
+*/
+size_t PriceLevel::find(unsigned int slot) const
+{
+    return m_orderStore->getHot(slot).levelIndex - m_head;
+}
+
+/**--------------------------------------------------------------------------------------
+ * recordPositions()
+ * 
+ * Writes the position of every order from the given one onwards into its hot record,
+ * after these orders moved inside the arrays
+ * 
+ * @param[in] position  Position in the arrays, counted from their start rather than m_head
+ * --------------------------------------------------------------------------------------
+*/
+void PriceLevel::recordPositions(size_t position)
+{
+    if(m_orderStore == nullptr)
+    {
+        return;
+    }
+
+    for(; position < m_slots.size(); position++)
+    {
+        m_orderStore->setLevelIndex(m_slots[position], (unsigned int)position);
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * Constructor
+ * 
+ * Creates an empty price ladder
+ * 
+ * @param[in] isBid         True if the ladder holds buy orders (best price is the highest),
+ *                          false if it holds sell orders (best price is the lowest)
+ * @param[in] orderStore    Order store holding the slots of the orders of this ladder
+ * --------------------------------------------------------------------------------------
+*/
+PriceLadder::PriceLadder(bool isBid, OrderStore* orderStore)
+  : m_isBid(isBid), m_orderStore(orderStore), m_pages(PriceBitmap::CAPACITY / PriceBitmap::WORD_BITS)
+{}
+
+/**--------------------------------------------------------------------------------------
+ * addOrder()
+ * 
+ * Adds an order to the price level matching its price. An order outside the ladder's
+ * window of ticks re-bases the window around every occupied level and its price if they
+ * fit in it, and is otherwise kept in the overflow map
+ * 
+ * @param[in] newOrder  Order to be added
+ * @param[in] slot      Slot of the order in the order book's OrderStore
+ * @return true if the order was added, false if its price is NO_PRICE
+ * --------------------------------------------------------------------------------------
+*/
+bool PriceLadder::addOrder(const Order& newOrder, unsigned int slot)
+{
+    int tick = newOrder.getPriceTicks();
+
+    if(!accepts(tick))
+    {
+        return false;
+    }
+
+    if(!m_isAnchored)
+    {
+        anchor(tick);
+    }
+    else if(!inWindow(tick))
+    {
+        rebase(tick);
+    }
+
+    unsigned long long sequence = nextSequence(newOrder);
+
+    if(!inWindow(tick))
+    {
+        getOverflowLevel(tick).insert(newOrder, sequence, slot);
+        return true;
+    }
+
+    int index = tick - m_baseTick;
+    getPage(index)[index & 63].insert(newOrder, sequence, slot);
+    m_occupied.set(index);
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * accepts()
+ * 
+ * @param[in] tick  Price of an order in ticks
+ * @return true if an order at this price can be added to the ladder, i.e. it is not NO_PRICE
+ * --------------------------------------------------------------------------------------
+*/
+bool PriceLadder::accepts(int tick) const
+{
+    return tick != NO_PRICE;
+}
+
+/**--------------------------------------------------------------------------------------
+ * prefault()
+ * 
+ * Allocates the pages of the price levels up to numLevels ticks either side of centerTick,
+ * and reserves and touches room for ordersPerLevel orders in each of them, so that the
+ * first orders at these prices do not pay for page faults or allocations. An empty ladder
+ * centers its window on centerTick first, and levels outside of the window are skipped
+ * 
+ * @param[in] centerTick    Price in ticks the best prices are expected around
+ * @param[in] numLevels     Number of price levels prefaulted on either side of centerTick
+ * @param[in] ordersPerLevel Number of orders to make room for at each price level
+ * --------------------------------------------------------------------------------------
+*/
+void PriceLadder::prefault(int centerTick, int numLevels, size_t ordersPerLevel)
+{
+    if(!m_isAnchored || (m_occupied.empty() && !inWindow(centerTick)))
+    {
+        anchor(centerTick);
+    }
+
+    long long lowIndex = std::max((long long)centerTick - numLevels - m_baseTick, 0LL);
+    long long highIndex = std::min((long long)centerTick + numLevels - m_baseTick, (long long)PriceBitmap::CAPACITY - 1);
+
+    for(long long index = lowIndex; index <= highIndex; index++)
+    {
+        getPage((int)index)[index & 63].prefault(ordersPerLevel);
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * bulkAdd()
+ * 
+ * Adds a batch of orders of this side in O(n). An empty ladder first centers its window on
+ * the median price of the batch. The orders inside the window are then counting-sorted by
+ * price, keeping the order of the batch for equal prices, and appended level by level,
+ * while the orders outside of it go straight to the overflow map
+ * 
+ * @param[in] orders    Orders of the batch, of both sides
+ * @param[in] indices   Positions in orders of the orders of this side
+ * @param[in] slots     Slot in the order book's OrderStore of every order of the batch
+ * --------------------------------------------------------------------------------------
+*/
+void PriceLadder::bulkAdd(const std::vector<Order>& orders, const std::vector<unsigned int>& indices, const std::vector<unsigned int>& slots)
+{
+    const size_t numOrders = indices.size();
+    if(numOrders == 0)
+    {
+        return;
+    }
+
+    std::vector<int> ticks(numOrders);
+    for(size_t i = 0; i < numOrders; i++)
+    {
+        ticks[i] = orders[indices[i]].getPriceTicks();
+    }
+
+    // The median rather than the best price, so that a few outliers do not push the bulk of the batch out of the window
+    if(empty())
+    {
+        std::vector<int> medianTicks(ticks);
+        std::nth_element(medianTicks.begin(), medianTicks.begin() + numOrders / 2, medianTicks.end());
+        anchor(medianTicks[numOrders / 2]);
+    }
+
+    int lowIndex = PriceBitmap::CAPACITY;
+    int highIndex = -1;
+    for(size_t i = 0; i < numOrders; i++)
+    {
+        if(inWindow(ticks[i]))
+        {
+            lowIndex = std::min(lowIndex, ticks[i] - m_baseTick);
+            highIndex = std::max(highIndex, ticks[i] - m_baseTick);
+        }
+        else
+        {
+            const Order& curOrder = orders[indices[i]];
+            getOverflowLevel(ticks[i]).insert(curOrder, nextSequence(curOrder), slots[indices[i]]);
+        }
+    }
+
+    if(highIndex < lowIndex)
+    {
+        return;
+    }
+
+    // Counting sort by tick: first where each tick's orders start, then every order in its place
+    std::vector<unsigned int> starts(highIndex - lowIndex + 2, 0);
+    for(size_t i = 0; i < numOrders; i++)
+    {
+        if(inWindow(ticks[i]))
+        {
+            starts[ticks[i] - m_baseTick - lowIndex + 1]++;
+        }
+    }
+    for(size_t bucket = 1; bucket < starts.size(); bucket++)
+    {
+        starts[bucket] += starts[bucket - 1];
+    }
+
+    std::vector<unsigned int> sortedOrders(starts.back());
+    for(size_t i = 0; i < numOrders; i++)
+    {
+        if(inWindow(ticks[i]))
+        {
+            sortedOrders[starts[ticks[i] - m_baseTick - lowIndex]++] = (unsigned int)i;
+        }
+    }
+
+    for(unsigned int i : sortedOrders)
+    {
+        const Order& curOrder = orders[indices[i]];
+        int index = ticks[i] - m_baseTick;
+        getPage(index)[index & 63].insert(curOrder, nextSequence(curOrder), slots[indices[i]]);
+        m_occupied.set(index);
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * rebase()
+ * 
+ * Moves the window of ticks so that it holds tick, if every price level occupied inside
+ * the window fits in it as well. Levels of the overflow map that end up inside the moved
+ * window are moved into it
+ * 
+ * @param[in] tick  Price in ticks of an order outside the window
+ * --------------------------------------------------------------------------------------
+*/
+void PriceLadder::rebase(int tick)
+{
+    if(m_occupied.empty())
+    {
+        anchor(tick);
+        return;
+    }
+
+    long long lowTick = std::min((long long)tick, (long long)m_occupied.findFirst() + m_baseTick);
+    long long highTick = std::max((long long)tick, (long long)m_occupied.findLast() + m_baseTick);
+    if(highTick - lowTick >= PriceBitmap::CAPACITY)
+    {
+        return;
+    }
+
+    // Taking every level out of the window before placing them again, the old and new windows may overlap
+    std::vector<std::pair<int, PriceLevel>> levels;
+    for(int index = m_occupied.findFirst(); index != PriceBitmap::NONE; index = m_occupied.findNext(index + 1))
+    {
+        PriceLevel& curLevel = (*m_pages[index >> 6])[index & 63];
+        levels.emplace_back(index + m_baseTick, std::move(curLevel));
+        curLevel = PriceLevel(m_orderStore);
+        m_occupied.clear(index);
+    }
+
+    anchor((int)(lowTick + (highTick - lowTick) / 2));
+
+    for(std::pair<int, PriceLevel>& curLevel : levels)
+    {
+        int index = curLevel.first - m_baseTick;
+        getPage(index)[index & 63] = std::move(curLevel.second);
+        m_occupied.set(index);
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * anchor()
+ * 
+ * Centers the window of ticks the ladder can hold around the given price. The window
+ * must not hold any occupied price level
+ * 
+ * @param[in] tick  Price in ticks at the center of the window
+ * --------------------------------------------------------------------------------------
+*/
+void PriceLadder::anchor(int tick)
+{
+    // Keeping every tick of the window a valid int other than NO_PRICE
+    long long baseTick = (long long)tick - PriceBitmap::CAPACITY / 2;
+    baseTick = std::max(baseTick, (long long)INT_MIN + 1);
+    baseTick = std::min(baseTick, (long long)INT_MAX - PriceBitmap::CAPACITY + 1);
+
+    m_baseTick = (int)baseTick;
+    m_isAnchored = true;
+
+    // Moving the levels of the overflow map the window now covers into it
+    std::map<int, PriceLevel>::iterator curLevel = m_overflow.lower_bound(m_baseTick);
+    while(curLevel != m_overflow.end() && inWindow(curLevel->first))
+    {
+        int index = curLevel->first - m_baseTick;
+        getPage(index)[index & 63] = std::move(curLevel->second);
+        m_occupied.set(index);
+        curLevel = m_overflow.erase(curLevel);
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * refreshOverflowLevel()
+ * 
+ * Removes the price level at tick from the overflow map if its last order was removed
+ * 
+ * @param[in] tick  Tick of a price level outside the window
+ * --------------------------------------------------------------------------------------
+*/
+void PriceLadder::refreshOverflowLevel(int tick)
+{
+    std::map<int, PriceLevel>::iterator curLevel = m_overflow.find(tick);
+    if(curLevel != m_overflow.end() && curLevel->second.empty())
+    {
+        m_overflow.erase(curLevel);
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * getPage()
+ * 
+ * @param[in] index Index of a tick inside the window
+ * @return the page of price levels holding that tick, allocated if this is its first use
+ * --------------------------------------------------------------------------------------
+*/
+PriceLadder::LevelPage& PriceLadder::getPage(int index)
+{
+    std::unique_ptr<LevelPage>& page = m_pages[index >> 6];
+    if(!page)
+    {
+        page.reset(new LevelPage());
+        for(PriceLevel& curLevel : *page)
+        {
+            curLevel = PriceLevel(m_orderStore);
+        }
+    }
+
+    return *page;
+}
+
+/**--------------------------------------------------------------------------------------
+ * bestTick()
+ * 
+ * @return the tick of the best occupied price level, or NO_PRICE if the ladder is empty
+ * --------------------------------------------------------------------------------------
+*/
+int PriceLadder::bestTick() const
+{
+    return m_isBid ? highestTick() : lowestTick();
+}
+
+/**--------------------------------------------------------------------------------------
+ * nextTick()
+ * 
+ * @param[in] tick  Tick of a price level on this side
+ * @return the tick of the next occupied price level worse than tick, or NO_PRICE
+ * --------------------------------------------------------------------------------------
+*/
+int PriceLadder::nextTick(int tick) const
+{
+    return m_isBid ? tickBelow(tick) : tickAbove(tick);
+}
+
+/**--------------------------------------------------------------------------------------
+ * worstTick()
+ * 
+ * @return the tick of the worst occupied price level, or NO_PRICE if the ladder is empty
+ * --------------------------------------------------------------------------------------
+*/
+int PriceLadder::worstTick() const
+{
+    return m_isBid ? lowestTick() : highestTick();
+}
+
+/**--------------------------------------------------------------------------------------
+ * prevTick()
+ * 
+ * @param[in] tick  Tick of a price level on this side
+ * @return the tick of the next occupied price level better than tick, or NO_PRICE
+ * --------------------------------------------------------------------------------------
+*/
+int PriceLadder::prevTick(int tick) const
+{
+    return m_isBid ? tickAbove(tick) : tickBelow(tick);
+}
+
+/**--------------------------------------------------------------------------------------
+ * lowestTick()
+ * 
+ * @return the tick of the lowest occupied price level, or NO_PRICE if the ladder is empty
+ * --------------------------------------------------------------------------------------
+*/
+int PriceLadder::lowestTick() const
+{
+    int tick = toTick(m_occupied.findFirst());
+
+    if(!m_overflow.empty() && (tick == NO_PRICE || m_overflow.begin()->first < tick))
+    {
+        tick = m_overflow.begin()->first;
+    }
+
+    return tick;
+}
+
+/**--------------------------------------------------------------------------------------
+ * highestTick()
+ * 
+ * @return the tick of the highest occupied price level, or NO_PRICE if the ladder is empty
+ * --------------------------------------------------------------------------------------
+*/
+int PriceLadder::highestTick() const
+{
+    int tick = toTick(m_occupied.findLast());
+
+    if(!m_overflow.empty() && (tick == NO_PRICE || m_overflow.rbegin()->first > tick))
+    {
+        tick = m_overflow.rbegin()->first;
+    }
+
+    return tick;
+}
+
+/**--------------------------------------------------------------------------------------
+ * tickAbove()
+ * 
+ * @param[in] tick  Price in ticks
+ * @return the tick of the lowest occupied price level above tick, or NO_PRICE
+ * --------------------------------------------------------------------------------------
+*/
+int PriceLadder::tickAbove(int tick) const
+{
+    int result = NO_PRICE;
+
+    long long index = (long long)tick - m_baseTick + 1;
+    if(index < PriceBitmap::CAPACITY)
+    {
+        result = toTick(m_occupied.findNext((int)std::max(index, 0LL)));
+    }
+
+    if(!m_overflow.empty())
+    {
+        std::map<int, PriceLevel>::const_iterator curLevel = m_overflow.upper_bound(tick);
+        if(curLevel != m_overflow.end() && (result == NO_PRICE || curLevel->first < result))
+        {
+            result = curLevel->first;
+        }
+    }
+
+    return result;
+}
+
+/**--------------------------------------------------------------------------------------
+ * tickBelow()
+ * 
+ * @param[in] tick  Price in ticks
+ * @return the tick of the highest occupied price level below tick, or NO_PRICE
+ * --------------------------------------------------------------------------------------
+*/
+int PriceLadder::tickBelow(int tick) const
+{
+    int result = NO_PRICE;
+
+    long long index = (long long)tick - m_baseTick - 1;
+    if(index >= 0)
+    {
+        result = toTick(m_occupied.findPrev((int)std::min(index, (long long)PriceBitmap::CAPACITY - 1)));
+    }
+
+    if(!m_overflow.empty())
+    {
+        std::map<int, PriceLevel>::const_iterator curLevel = m_overflow.lower_bound(tick);
+        if(curLevel != m_overflow.begin() && (result == NO_PRICE || std::prev(curLevel)->first > result))
+        {
+            result = std::prev(curLevel)->first;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,551 @@
+/*priceladder.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the PriceLevel and PriceLadder classes
+ *     A price level holds every resting order at one price, in time priority
+ *     A price ladder holds every price level of one side of an order book, indexed by price tick
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <array>
+#include <map>
+#include <memory>
+#include <climits>
+
+#include "order.h"
+#include "pricebitmap.h"
+
+class OrderStore;
+
+/**--------------------------------------------------------------------------------------
+ * PriceLevel class
+ * 
+ * Contains all resting orders at a single price, earliest time first. Orders are stored as
+ * parallel arrays (structure of arrays) rather than as Order objects, so that summing,
+ * allocating and compacting the amounts of a level only streams through dense arrays of
+ * integers instead of dragging every field of every order through the cache
+ * --------------------------------------------------------------------------------------
+*/
+class PriceLevel
+{
+public:
+    static const size_t BYTES_PER_ORDER = 2 * sizeof(int) + sizeof(unsigned long long) + 2 * sizeof(unsigned int);  // One element of every parallel array
+
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Creates an empty price level
+     * 
+     * @param[in] orderStore    Order store whose hot records are kept up to date with the
+     *                          position of every order at this level
+     * --------------------------------------------------------------------------------------
+    */
+    explicit PriceLevel(OrderStore* orderStore = nullptr)
+      : m_orderStore(orderStore)
+    {}
+
+    /**--------------------------------------------------------------------------------------
+     * empty()
+     * 
+     * @return true if there are no orders resting at this price level
+     * --------------------------------------------------------------------------------------
+    */
+    bool empty() const
+    {
+        return m_head == m_amounts.size();
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * size()
+     * 
+     * @return the number of orders resting at this price level
+     * --------------------------------------------------------------------------------------
+    */
+    size_t size() const
+    {
+        return m_amounts.size() - m_head;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getTotalAmount()
+     * 
+     * @return the total amount waiting to be filled across all orders at this price level
+     * --------------------------------------------------------------------------------------
+    */
+    long long getTotalAmount() const
+    {
+        return m_totalAmount;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * Per-order accessors
+     * 
+     * @param[in] index Position of the order in time priority, 0 being the earliest
+     * @return the amount waiting to be filled, ID, time, time priority sequence or owner of
+     *         the order at the given position
+     * --------------------------------------------------------------------------------------
+    */
+    int getAmount(size_t index) const
+    {
+        return m_amounts[m_head + index];
+    }
+
+    int getID(size_t index) const
+    {
+        return m_ids[m_head + index];
+    }
+
+    int getTime(size_t index) const
+    {
+        return (int)(m_sequences[m_head + index] >> 32);
+    }
+
+    unsigned long long getSequence(size_t index) const
+    {
+        return m_sequences[m_head + index];
+    }
+
+    unsigned int getOwner(size_t index) const
+    {
+        return m_owners[m_head + index];
+    }
+
+    unsigned int getSlot(size_t index) const
+    {
+        return m_slots[m_head + index];
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * find()
+     * 
+     * Finds the position of an order from the position this level keeps in its hot record
+     * 
+     * @param[in] slot  Slot of an order resting at this level in the order book's OrderStore
+     * @return the position of the order in time priority
+     * --------------------------------------------------------------------------------------
+    */
+    size_t find(unsigned int slot) const;
+
+    /**--------------------------------------------------------------------------------------
+     * amounts()
+     * 
+     * @return the amounts waiting to be filled of every order at this price level, as one
+     *         contiguous array of size() elements in time priority
+     * --------------------------------------------------------------------------------------
+    */
+    const int* amounts() const
+    {
+        return m_amounts.data() + m_head;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * fill()
+     * 
+     * Fills part of the order at the given position
+     * 
+     * @param[in] index     Position of the order in time priority, 0 being the earliest
+     * @param[in] amount    Amount being filled, no greater than the order's remaining amount
+     * @return the amount of the order still waiting to be filled
+     * --------------------------------------------------------------------------------------
+    */
+    int fill(size_t index, int amount)
+    {
+        m_totalAmount -= amount;
+        return m_amounts[m_head + index] -= amount;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * insert()
+     * 
+     * Adds an order behind every order at this price level with an earlier time priority
+     * 
+     * @param[in] newOrder  Order to be added
+     * @param[in] sequence  Time priority of the order: its time in the upper 32 bits, and the
+     *                      order in which it arrived in the lower 32 bits
+     * @param[in] slot      Slot of the order in the order book's OrderStore
+     * --------------------------------------------------------------------------------------
+    */
+    void insert(const Order& newOrder, unsigned long long sequence, unsigned int slot);
+
+    /**--------------------------------------------------------------------------------------
+     * popFront()
+     * 
+     * Removes the earliest order at this price level
+     * --------------------------------------------------------------------------------------
+    */
+    void popFront();
+
+    /**--------------------------------------------------------------------------------------
+     * erase()
+     * 
+     * Removes the order at the given position, keeping the remaining orders in time priority
+     * 
+     * @param[in] index Position of the order in time priority, 0 being the earliest
+     * --------------------------------------------------------------------------------------
+    */
+    void erase(size_t index);
+
+    /**--------------------------------------------------------------------------------------
+     * removeFilled()
+     * 
+     * Removes every completely filled order, keeping the remaining orders in time priority
+     * --------------------------------------------------------------------------------------
+    */
+    void removeFilled();
+
+    /**--------------------------------------------------------------------------------------
+     * prefault()
+     * 
+     * Reserves room for numOrders orders and writes to all of it once, so that the memory is
+     * already mapped when the first orders arrive
+     * 
+     * @param[in] numOrders Number of orders to make room for
+     * --------------------------------------------------------------------------------------
+    */
+    void prefault(size_t numOrders);
+
+private:
+    /**--------------------------------------------------------------------------------------
+     * compact()
+     * 
+     * Releases the slots in front of m_head once they make up most of the level
+     * --------------------------------------------------------------------------------------
+    */
+    void compact();
+
+    /**--------------------------------------------------------------------------------------
+     * recordPositions()
+     * 
+     * Writes the position of every order from the given one onwards into its hot record,
+     * after these orders moved inside the arrays
+     * 
+     * @param[in] position  Position in the arrays, counted from their start rather than m_head
+     * --------------------------------------------------------------------------------------
+    */
+    void recordPositions(size_t position);
+
+    // Parallel arrays in time priority, only the elements from m_head onwards are still resting
+    std::vector<int> m_amounts;
+    std::vector<int> m_ids;
+    std::vector<unsigned long long> m_sequences;
+    std::vector<unsigned int> m_owners;
+    std::vector<unsigned int> m_slots;
+    size_t m_head = 0;
+    long long m_totalAmount = 0;
+    OrderStore* m_orderStore;   // Store of the hot records holding each order's position in the arrays, or nullptr
+};
+
+
+
+/**--------------------------------------------------------------------------------------
+ * PriceLadder class
+ * 
+ * Contains all price levels of one side of an order book. Levels are indexed directly by
+ * their price tick relative to a base tick, inside a window of PriceBitmap::CAPACITY ticks,
+ * and are only allocated in pages of 64 once a tick inside that page is used. The occupancy
+ * bitmap finds the best and the next occupied level without scanning empty ticks. The window
+ * is placed by the first order (or prefault()) and is re-based when an order arrives outside
+ * of it, as long as every occupied level still fits. Levels that do not fit are kept in an
+ * ordered overflow map, so any price other than NO_PRICE, including negative ones, is held.
+ * --------------------------------------------------------------------------------------
+*/
+class PriceLadder
+{
+public:
+    static const int NO_PRICE = INT_MIN;     // Not a valid price, ladders refuse orders at it
+
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Creates an empty price ladder
+     * 
+     * @param[in] isBid         True if the ladder holds buy orders (best price is the highest),
+     *                          false if it holds sell orders (best price is the lowest)
+     * @param[in] orderStore    Order store holding the slots of the orders of this ladder
+     * --------------------------------------------------------------------------------------
+    */
+    PriceLadder(bool isBid, OrderStore* orderStore);
+
+    /**--------------------------------------------------------------------------------------
+     * empty()
+     * 
+     * @return true if there are no orders resting on this side
+     * --------------------------------------------------------------------------------------
+    */
+    bool empty() const
+    {
+        return m_occupied.empty() && m_overflow.empty();
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * addOrder()
+     * 
+     * Adds an order to the price level matching its price. An order outside the ladder's
+     * window of ticks re-bases the window around every occupied level and its price if they
+     * fit in it, and is otherwise kept in the overflow map
+     * 
+     * @param[in] newOrder  Order to be added
+     * @param[in] slot      Slot of the order in the order book's OrderStore
+     * @return true if the order was added, false if its price is NO_PRICE
+     * --------------------------------------------------------------------------------------
+    */
+    bool addOrder(const Order& newOrder, unsigned int slot);
+
+    /**--------------------------------------------------------------------------------------
+     * accepts()
+     * 
+     * @param[in] tick  Price of an order in ticks
+     * @return true if an order at this price can be added to the ladder, i.e. it is not NO_PRICE
+     * --------------------------------------------------------------------------------------
+    */
+    bool accepts(int tick) const;
+
+    /**--------------------------------------------------------------------------------------
+     * prefault()
+     * 
+     * Allocates the pages of the price levels up to numLevels ticks either side of centerTick,
+     * and reserves and touches room for ordersPerLevel orders in each of them, so that the
+     * first orders at these prices do not pay for page faults or allocations. An empty ladder
+     * centers its window on centerTick first, and levels outside of the window are skipped
+     * 
+     * @param[in] centerTick    Price in ticks the best prices are expected around
+     * @param[in] numLevels     Number of price levels prefaulted on either side of centerTick
+     * @param[in] ordersPerLevel Number of orders to make room for at each price level
+     * --------------------------------------------------------------------------------------
+    */
+    void prefault(int centerTick, int numLevels, size_t ordersPerLevel);
+
+    /**--------------------------------------------------------------------------------------
+     * bulkAdd()
+     * 
+     * Adds a batch of orders of this side in O(n). An empty ladder first centers its window on
+     * the median price of the batch. The orders inside the window are then counting-sorted by
+     * price, keeping the order of the batch for equal prices, and appended level by level,
+     * while the orders outside of it go straight to the overflow map
+     * 
+     * @param[in] orders    Orders of the batch, of both sides
+     * @param[in] indices   Positions in orders of the orders of this side
+     * @param[in] slots     Slot in the order book's OrderStore of every order of the batch
+     * --------------------------------------------------------------------------------------
+    */
+    void bulkAdd(const std::vector<Order>& orders, const std::vector<unsigned int>& indices, const std::vector<unsigned int>& slots);
+
+    /**--------------------------------------------------------------------------------------
+     * bestTick()
+     * 
+     * @return the tick of the best occupied price level, or NO_PRICE if the ladder is empty
+     * --------------------------------------------------------------------------------------
+    */
+    int bestTick() const;
+
+    /**--------------------------------------------------------------------------------------
+     * nextTick()
+     * 
+     * @param[in] tick  Tick of a price level on this side
+     * @return the tick of the next occupied price level worse than tick, or NO_PRICE
+     * --------------------------------------------------------------------------------------
+    */
+    int nextTick(int tick) const;
+
+    /**--------------------------------------------------------------------------------------
+     * worstTick()
+     * 
+     * @return the tick of the worst occupied price level, or NO_PRICE if the ladder is empty
+     * --------------------------------------------------------------------------------------
+    */
+    int worstTick() const;
+
+    /**--------------------------------------------------------------------------------------
+     * prevTick()
+     * 
+     * @param[in] tick  Tick of a price level on this side
+     * @return the tick of the next occupied price level better than tick, or NO_PRICE
+     * --------------------------------------------------------------------------------------
+    */
+    int prevTick(int tick) const;
+
+    /**--------------------------------------------------------------------------------------
+     * getLevel()
+     * 
+     * @param[in] tick  Tick of an occupied price level, as returned by bestTick()/nextTick()
+     * @return the price level at tick
+     * --------------------------------------------------------------------------------------
+    */
+    PriceLevel& getLevel(int tick)
+    {
+        if(!inWindow(tick))
+        {
+            return m_overflow.find(tick)->second;
+        }
+
+        int index = tick - m_baseTick;
+        return (*m_pages[index >> 6])[index & 63];
+    }
+
+    const PriceLevel& getLevel(int tick) const
+    {
+        if(!inWindow(tick))
+        {
+            return m_overflow.find(tick)->second;
+        }
+
+        int index = tick - m_baseTick;
+        return (*m_pages[index >> 6])[index & 63];
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * refreshLevel()
+     * 
+     * Marks the price level at tick as unoccupied if its last order was removed
+     * 
+     * @param[in] tick  Tick of a price level on this side
+     * --------------------------------------------------------------------------------------
+    */
+    void refreshLevel(int tick)
+    {
+        if(!inWindow(tick))
+        {
+            refreshOverflowLevel(tick);
+        }
+        else if(getLevel(tick).empty())
+        {
+            m_occupied.clear(tick - m_baseTick);
+        }
+    }
+
+private:
+    typedef std::array<PriceLevel, PriceBitmap::WORD_BITS> LevelPage;
+
+    int toTick(int index) const
+    {
+        return (index == PriceBitmap::NONE) ? NO_PRICE : index + m_baseTick;
+    }
+
+    unsigned long long nextSequence(const Order& newOrder)
+    {
+        return ((unsigned long long)(unsigned int)newOrder.getTime() << 32) | m_arrivals++;
+    }
+
+    PriceLevel& getOverflowLevel(int tick)
+    {
+        return m_overflow.try_emplace(tick, m_orderStore).first->second;
+    }
+
+    bool inWindow(int tick) const
+    {
+        long long index = (long long)tick - m_baseTick;
+        return index >= 0 && index < PriceBitmap::CAPACITY;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * lowestTick()
+     * 
+     * @return the tick of the lowest occupied price level, or NO_PRICE if the ladder is empty
+     * --------------------------------------------------------------------------------------
+    */
+    int lowestTick() const;
+
+    /**--------------------------------------------------------------------------------------
+     * highestTick()
+     * 
+     * @return the tick of the highest occupied price level, or NO_PRICE if the ladder is empty
+     * --------------------------------------------------------------------------------------
+    */
+    int highestTick() const;
+
+    /**--------------------------------------------------------------------------------------
+     * tickAbove()
+     * 
+     * @param[in] tick  Price in ticks
+     * @return the tick of the lowest occupied price level above tick, or NO_PRICE
+     * --------------------------------------------------------------------------------------
+    */
+    int tickAbove(int tick) const;
+
+    /**--------------------------------------------------------------------------------------
+     * tickBelow()
+     * 
+     * @param[in] tick  Price in ticks
+     * @return the tick of the highest occupied price level below tick, or NO_PRICE
+     * --------------------------------------------------------------------------------------
+    */
+    int tickBelow(int tick) const;
+
+    /**--------------------------------------------------------------------------------------
+     * rebase()
+     * 
+     * Moves the window of ticks so that it holds tick, if every price level occupied inside
+     * the window fits in it as well. Levels of the overflow map that end up inside the moved
+     * window are moved into it
+     * 
+     * @param[in] tick  Price in ticks of an order outside the window
+     * --------------------------------------------------------------------------------------
+    */
+    void rebase(int tick);
+
+    /**--------------------------------------------------------------------------------------
+     * anchor()
+     * 
+     * Centers the window of ticks the ladder can hold around the given price. The window
+     * must not hold any occupied price level
+     * 
+     * @param[in] tick  Price in ticks at the center of the window
+     * --------------------------------------------------------------------------------------
+    */
+    void anchor(int tick);
+
+    /**--------------------------------------------------------------------------------------
+     * refreshOverflowLevel()
+     * 
+     * Removes the price level at tick from the overflow map if its last order was removed
+     * 
+     * @param[in] tick  Tick of a price level outside the window
+     * --------------------------------------------------------------------------------------
+    */
+    void refreshOverflowLevel(int tick);
+
+    /**--------------------------------------------------------------------------------------
+     * getPage()
+     * 
+     * @param[in] index Index of a tick inside the window
+     * @return the page of price levels holding that tick, allocated if this is its first use
+     * --------------------------------------------------------------------------------------
+    */
+    LevelPage& getPage(int index);
+
+    bool m_isBid;
+    OrderStore* m_orderStore;                           // Store holding the slots of the orders of this ladder
+    bool m_isAnchored = false;                          // Whether the window has been placed by an order or prefault()
+    int m_baseTick = 0;                                 // Tick represented by index 0 of the window
+    unsigned int m_arrivals = 0;                        // Number of orders added so far, breaks ties between orders with the same time
+    PriceBitmap m_occupied;                             // Occupancy of every tick in the window
+    std::vector<std::unique_ptr<LevelPage>> m_pages;    // One page of levels per leaf word of m_occupied, allocated on first use
+    std::map<int, PriceLevel> m_overflow;               // Occupied price levels outside the window, by tick
+};
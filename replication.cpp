@@ -0,0 +1,602 @@
+/*replication.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the ReplicationPrimary and ReplicationSecondary classes
+ *     Hot-standby replication of the sequenced order stream over TCP, so that a secondary
+ *     engine holds an identical order book and can take over from the primary
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#endif
+
+#include "replication.h"
+#include "logger.h"
+
+using namespace Replication;
+
+namespace {
+    const int FIFOCHOICE = 1;
+    const uint64_t STREAM_MAGIC = 0x4f4d455245504c31ULL;   // "OMEREPL1"
+    const int SPINS_BEFORE_YIELD = 256;                     // Polls of the ring before giving up the core to other threads
+    const int CONNECT_RETRIES = 100;                        // Attempts to reach the primary, 100 ms apart
+
+    // First message of the stream, telling the secondary which order book it replicates
+    typedef struct StreamHeader
+    {
+        uint64_t magic;
+        int32_t algorithm;
+        char ticker[32];
+    } StreamHeader;
+
+    /**--------------------------------------------------------------------------------------
+     * sendAll()
+     * 
+     * Writes a whole buffer to a socket
+     * 
+     * @param[in] socketFD  Connected socket
+     * @param[in] buffer    Bytes to be sent
+     * @param[in] size      Number of bytes
+     * @return true if every byte was sent, false if the connection is broken
+     * --------------------------------------------------------------------------------------
+    */
+    bool sendAll(int socketFD, const void* buffer, size_t size)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;     // A broken connection is reported through the return value, not SIGPIPE
+#else
+        const int flags = 0;
+#endif
+        const char* bytes = static_cast<const char*>(buffer);
+
+        while(size > 0)
+        {
+            ssize_t numSent = send(socketFD, bytes, size, flags);
+            if(numSent < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if(numSent <= 0)
+            {
+                return false;
+            }
+
+            bytes += numSent;
+            size -= numSent;
+        }
+
+        return true;
+#else
+        (void)socketFD; (void)buffer; (void)size;
+        return false;
+#endif
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * receiveAll()
+     * 
+     * Reads a whole buffer from a socket
+     * 
+     * @param[in]   socketFD    Connected socket
+     * @param[out]  buffer      Bytes received
+     * @param[in]   size        Number of bytes
+     * @return true if every byte was received, false if the connection was closed or broken
+     * --------------------------------------------------------------------------------------
+    */
+    bool receiveAll(int socketFD, void* buffer, size_t size)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        char* bytes = static_cast<char*>(buffer);
+
+        while(size > 0)
+        {
+            ssize_t numReceived = recv(socketFD, bytes, size, 0);
+            if(numReceived < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if(numReceived <= 0)
+            {
+                return false;
+            }
+
+            bytes += numReceived;
+            size -= numReceived;
+        }
+
+        return true;
+#else
+        (void)socketFD; (void)buffer; (void)size;
+        return false;
+#endif
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * closeSocket()
+     * 
+     * Closes a socket if it is open
+     * 
+     * @param[in,out] socketFD  Socket, set to -1
+     * --------------------------------------------------------------------------------------
+    */
+    void closeSocket(int& socketFD)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        if(socketFD >= 0)
+        {
+            close(socketFD);
+        }
+#endif
+        socketFD = -1;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * disableNagle()
+     * 
+     * Sends every write to a socket right away instead of waiting to coalesce small writes,
+     * the primary already sends whole batches
+     * 
+     * @param[in] socketFD  Connected socket
+     * --------------------------------------------------------------------------------------
+    */
+    void disableNagle(int socketFD)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        int isEnabled = 1;
+        setsockopt(socketFD, IPPROTO_TCP, TCP_NODELAY, &isEnabled, sizeof(isEnabled));
+#else
+        (void)socketFD;
+#endif
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * makeAddEvent()
+ * 
+ * @param[in] sequence  Sequence number of the event
+ * @param[in] newOrder  Order to be added
+ * @return the event adding the order
+ * --------------------------------------------------------------------------------------
+*/
+ReplicatedEvent Replication::makeAddEvent(uint64_t sequence, const Order& newOrder)
+{
+    ReplicatedEvent event;
+    event.sequence = sequence;
+    event.orderID = newOrder.getID();
+    event.priceTicks = newOrder.getPriceTicks();
+    event.time = newOrder.getTime();
+    event.amount = newOrder.getAmount();
+    event.owner = newOrder.getOwner();
+    event.type = ADD_ORDER;
+    event.isBuy = newOrder.checkIsBuy();
+    event.isMarket = newOrder.checkIsMarket();
+
+    return event;
+}
+
+/**--------------------------------------------------------------------------------------
+ * applyEvent()
+ * 
+ * Applies an event to an order book: adds and then matches the order, or cancels it
+ * 
+ * @param[in]       event       Event to be applied
+ * @param[in]       ticker      Ticker of the order book
+ * @param[in,out]   orderbook   Order book the event is applied to
+ * @param[in]       matcher     Order-matching algorithm, e.g. &Orderbook::matchOrdersFIFO
+ * --------------------------------------------------------------------------------------
+*/
+void Replication::applyEvent(const ReplicatedEvent& event, const std::string& ticker, Orderbook& orderbook, void (Orderbook::*matcher)())
+{
+    if(CANCEL_ORDER == event.type)
+    {
+        orderbook.cancelOrder((int)event.orderID);
+        return;
+    }
+
+    Order newOrder(ticker, event.orderID, event.isMarket, event.isBuy, Order::ticksToPrice(event.priceTicks),
+                   event.time, event.amount, event.owner);
+
+    if(orderbook.addOrder(newOrder))
+    {
+        (orderbook.*matcher)();
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * Destructor
+ * 
+ * Sends every appended event, then stops the threads and closes the connection
+ * --------------------------------------------------------------------------------------
+*/
+ReplicationPrimary::~ReplicationPrimary()
+{
+    m_isStopping.store(true, std::memory_order_release);
+
+    if(m_sender.joinable())
+    {
+        m_sender.join();
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    // Ending the stream, the secondary closes its side once it has applied everything
+    if(m_socket >= 0)
+    {
+        shutdown(m_socket, SHUT_WR);
+    }
+#endif
+
+    if(m_acknowledgementReader.joinable())
+    {
+        m_acknowledgementReader.join();
+    }
+
+    closeSocket(m_socket);
+}
+
+/**--------------------------------------------------------------------------------------
+ * start()
+ * 
+ * Waits for a secondary to connect on a TCP port, tells it which order book it
+ * replicates, and starts the sender and acknowledgement threads
+ * 
+ * @param[in] port      TCP port to listen on
+ * @param[in] ticker    Ticker of the order book
+ * @param[in] algorithm Choice of algorithm (1 for FIFO, 2 for Pro-Rata)
+ * @return true if a secondary is connected, false on error or on platforms without
+ *         POSIX sockets
+ * --------------------------------------------------------------------------------------
+*/
+bool ReplicationPrimary::start(int port, const std::string& ticker, int algorithm)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    int listenFD = socket(AF_INET, SOCK_STREAM, 0);
+    if(listenFD < 0)
+    {
+        std::cerr << "ERROR - start(): socket failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    int isEnabled = 1;
+    setsockopt(listenFD, SOL_SOCKET, SO_REUSEADDR, &isEnabled, sizeof(isEnabled));
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons((uint16_t)port);
+
+    if(bind(listenFD, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listenFD, 1) != 0)
+    {
+        std::cerr << "ERROR - start(): could not listen on port " << port << ": " << std::strerror(errno) << std::endl;
+        closeSocket(listenFD);
+        return false;
+    }
+
+    std::cout << "Waiting for a secondary on port " << port << std::endl;
+    m_socket = accept(listenFD, nullptr, nullptr);
+    closeSocket(listenFD);
+
+    if(m_socket < 0)
+    {
+        std::cerr << "ERROR - start(): accept failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    disableNagle(m_socket);
+
+    StreamHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = STREAM_MAGIC;
+    header.algorithm = algorithm;
+    std::strncpy(header.ticker, ticker.c_str(), sizeof(header.ticker) - 1);
+
+    if(!sendAll(m_socket, &header, sizeof(header)))
+    {
+        std::cerr << "ERROR - start(): the secondary disconnected" << std::endl;
+        closeSocket(m_socket);
+        return false;
+    }
+
+    m_ring.resize(RING_SIZE);
+    m_sender = std::thread(&ReplicationPrimary::runSender, this);
+    m_acknowledgementReader = std::thread(&ReplicationPrimary::runAcknowledgementReader, this);
+
+    return true;
+#else
+    (void)port; (void)ticker; (void)algorithm;
+    std::cerr << "ERROR - start(): replication is not supported on this platform" << std::endl;
+    return false;
+#endif
+}
+
+/**--------------------------------------------------------------------------------------
+ * append()
+ * 
+ * Queues an event for the secondary, only waiting if RING_SIZE events are not sent yet
+ * 
+ * @param[in] event Event to be replicated, with the next sequence number
+ * --------------------------------------------------------------------------------------
+*/
+void ReplicationPrimary::append(const ReplicatedEvent& event)
+{
+    uint64_t position = m_appended.load(std::memory_order_relaxed);
+
+    int numSpins = 0;
+    while(position - m_sent.load(std::memory_order_acquire) >= RING_SIZE)
+    {
+        if(m_isDisconnected.load(std::memory_order_acquire))
+        {
+            return;     // Nobody left to replicate to, the primary carries on alone
+        }
+
+        if(++numSpins == SPINS_BEFORE_YIELD)
+        {
+            std::this_thread::yield();
+            numSpins = 0;
+        }
+    }
+
+    m_ring[position & (RING_SIZE - 1)] = event;
+    m_appended.store(position + 1, std::memory_order_release);
+}
+
+/**--------------------------------------------------------------------------------------
+ * waitForAcknowledgement()
+ * 
+ * Waits until the secondary has applied every event up to a sequence number
+ * 
+ * @param[in] sequence  Sequence number of the event
+ * @return true if acknowledged, false if the secondary disconnected before
+ * --------------------------------------------------------------------------------------
+*/
+bool ReplicationPrimary::waitForAcknowledgement(uint64_t sequence)
+{
+    int numSpins = 0;
+
+    while(m_acknowledged.load(std::memory_order_acquire) < sequence)
+    {
+        if(m_isDisconnected.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        if(++numSpins == SPINS_BEFORE_YIELD)
+        {
+            std::this_thread::yield();
+            numSpins = 0;
+        }
+    }
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * runSender()
+ * 
+ * Sends the appended events in batches until stopped with nothing left to send
+ * --------------------------------------------------------------------------------------
+*/
+void ReplicationPrimary::runSender()
+{
+    // One message per batch: the number of events followed by the events
+    std::vector<char> message(sizeof(uint32_t) + MAX_BATCH * sizeof(ReplicatedEvent));
+    uint64_t sent = 0;
+    int numSpins = 0;
+
+    while(true)
+    {
+        uint64_t appended = m_appended.load(std::memory_order_acquire);
+
+        if(appended == sent)
+        {
+            if(m_isStopping.load(std::memory_order_acquire) && m_appended.load(std::memory_order_acquire) == sent)
+            {
+                return;
+            }
+
+            if(++numSpins == SPINS_BEFORE_YIELD)
+            {
+                std::this_thread::yield();
+                numSpins = 0;
+            }
+            continue;
+        }
+        numSpins = 0;
+
+        uint32_t numEvents = (uint32_t)std::min<uint64_t>(appended - sent, MAX_BATCH);
+        std::memcpy(message.data(), &numEvents, sizeof(numEvents));
+        for(uint32_t i = 0; i < numEvents; i++)
+        {
+            std::memcpy(message.data() + sizeof(numEvents) + i * sizeof(ReplicatedEvent), &m_ring[(sent + i) & (RING_SIZE - 1)], sizeof(ReplicatedEvent));
+        }
+
+        // Handing the ring entries back before the system call, they are copied already
+        sent += numEvents;
+        m_sent.store(sent, std::memory_order_release);
+
+        if(!sendAll(m_socket, message.data(), sizeof(numEvents) + numEvents * sizeof(ReplicatedEvent)))
+        {
+            std::cerr << "ERROR - runSender(): the secondary disconnected, replication stopped" << std::endl;
+            m_isDisconnected.store(true, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * runAcknowledgementReader()
+ * 
+ * Records the sequence number acknowledged by the secondary until it disconnects
+ * --------------------------------------------------------------------------------------
+*/
+void ReplicationPrimary::runAcknowledgementReader()
+{
+    uint64_t acknowledged = 0;
+
+    while(receiveAll(m_socket, &acknowledged, sizeof(acknowledged)))
+    {
+        m_acknowledged.store(acknowledged, std::memory_order_release);
+    }
+
+    m_isDisconnected.store(true, std::memory_order_release);
+}
+
+/**--------------------------------------------------------------------------------------
+ * Destructor
+ * 
+ * Closes the connection
+ * --------------------------------------------------------------------------------------
+*/
+ReplicationSecondary::~ReplicationSecondary()
+{
+    closeSocket(m_socket);
+}
+
+/**--------------------------------------------------------------------------------------
+ * connectTo()
+ * 
+ * Connects to a primary, retrying until it is listening, and reads which order book it
+ * replicates
+ * 
+ * @param[in] host  Host name or address of the primary
+ * @param[in] port  TCP port of the primary
+ * @return true if connected, false on error or on platforms without POSIX sockets
+ * --------------------------------------------------------------------------------------
+*/
+bool ReplicationSecondary::connectTo(const std::string& host, int port)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* addresses = nullptr;
+    if(getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0 || addresses == nullptr)
+    {
+        std::cerr << "ERROR - connectTo(): could not resolve " << host << std::endl;
+        return false;
+    }
+
+    for(int attempt = 0; attempt < CONNECT_RETRIES && m_socket < 0; attempt++)
+    {
+        m_socket = socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol);
+        if(m_socket >= 0 && connect(m_socket, addresses->ai_addr, addresses->ai_addrlen) != 0)
+        {
+            closeSocket(m_socket);
+            usleep(100000);
+        }
+    }
+    freeaddrinfo(addresses);
+
+    if(m_socket < 0)
+    {
+        std::cerr << "ERROR - connectTo(): could not connect to " << host << ":" << port << std::endl;
+        return false;
+    }
+    disableNagle(m_socket);
+
+    StreamHeader header;
+    if(!receiveAll(m_socket, &header, sizeof(header)) || header.magic != STREAM_MAGIC)
+    {
+        std::cerr << "ERROR - connectTo(): " << host << ":" << port << " is not a replicating primary" << std::endl;
+        closeSocket(m_socket);
+        return false;
+    }
+
+    header.ticker[sizeof(header.ticker) - 1] = '\0';
+    m_ticker = header.ticker;
+    m_algorithm = header.algorithm;
+
+    return true;
+#else
+    (void)host; (void)port;
+    std::cerr << "ERROR - connectTo(): replication is not supported on this platform" << std::endl;
+    return false;
+#endif
+}
+
+/**--------------------------------------------------------------------------------------
+ * applyUntilDisconnected()
+ * 
+ * Applies the events of the primary to an order book until the primary disconnects, at
+ * which point the order book is the primary's as of the last event received
+ * 
+ * @param[in,out] orderbook Order book of the secondary, created with getTicker()
+ * @return the sequence number of the last event applied
+ * --------------------------------------------------------------------------------------
+*/
+uint64_t ReplicationSecondary::applyUntilDisconnected(Orderbook& orderbook)
+{
+    void (Orderbook::*matcher)() = (FIFOCHOICE == m_algorithm) ? &Orderbook::matchOrdersFIFO : &Orderbook::matchOrdersProRata;
+    std::vector<ReplicatedEvent> batch(ReplicationPrimary::MAX_BATCH);
+    uint64_t lastSequence = 0;
+    uint32_t numEvents = 0;
+
+    while(receiveAll(m_socket, &numEvents, sizeof(numEvents)))
+    {
+        if(numEvents > batch.size() || !receiveAll(m_socket, batch.data(), numEvents * sizeof(ReplicatedEvent)))
+        {
+            std::cerr << "ERROR - applyUntilDisconnected(): malformed batch from the primary" << std::endl;
+            break;
+        }
+
+        for(uint32_t i = 0; i < numEvents; i++)
+        {
+            if(batch[i].sequence != lastSequence + 1)
+            {
+                std::cerr << "ERROR - applyUntilDisconnected(): expected event " << lastSequence + 1 << ", received " << batch[i].sequence << std::endl;
+                return lastSequence;
+            }
+
+            Replication::applyEvent(batch[i], m_ticker, orderbook, matcher);
+            lastSequence = batch[i].sequence;
+        }
+
+        // The order history is not replicated, only the order book
+        orderbook.clearOrderHistory();
+
+        // Acknowledging once per batch, the primary does not wait for it
+        if(!sendAll(m_socket, &lastSequence, sizeof(lastSequence)))
+        {
+            break;
+        }
+    }
+
+    return lastSequence;
+}
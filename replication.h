@@ -0,0 +1,265 @@
+/*replication.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the ReplicationPrimary and ReplicationSecondary classes
+ *     Hot-standby replication of the sequenced order stream over TCP, so that a secondary
+ *     engine holds an identical order book and can take over from the primary
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+#include "order.h"
+#include "orderbook.h"
+
+namespace Replication
+{
+    enum EventType : uint8_t
+    {
+        ADD_ORDER,
+        CANCEL_ORDER
+    };
+
+    /**--------------------------------------------------------------------------------------
+     * ReplicatedEvent struct
+     * 
+     * Input event of the engine, sent as is (host byte order) from the primary to the
+     * secondary. Applying the same events in the same order with the same algorithm gives the
+     * same order book
+     * --------------------------------------------------------------------------------------
+    */
+    typedef struct ReplicatedEvent
+    {
+        uint64_t sequence;      // 1 for the first event, then increasing by 1
+        int64_t orderID;
+        int32_t priceTicks;
+        int32_t time;
+        int32_t amount;
+        uint32_t owner;
+        EventType type;
+        bool isBuy;
+        bool isMarket;
+    } ReplicatedEvent;
+
+    /**--------------------------------------------------------------------------------------
+     * makeAddEvent()
+     * 
+     * @param[in] sequence  Sequence number of the event
+     * @param[in] newOrder  Order to be added
+     * @return the event adding the order
+     * --------------------------------------------------------------------------------------
+    */
+    ReplicatedEvent makeAddEvent(uint64_t sequence, const Order& newOrder);
+
+    /**--------------------------------------------------------------------------------------
+     * applyEvent()
+     * 
+     * Applies an event to an order book: adds and then matches the order, or cancels it
+     * 
+     * @param[in]       event       Event to be applied
+     * @param[in]       ticker      Ticker of the order book
+     * @param[in,out]   orderbook   Order book the event is applied to
+     * @param[in]       matcher     Order-matching algorithm, e.g. &Orderbook::matchOrdersFIFO
+     * --------------------------------------------------------------------------------------
+    */
+    void applyEvent(const ReplicatedEvent& event, const std::string& ticker, Orderbook& orderbook, void (Orderbook::*matcher)());
+}
+
+/**--------------------------------------------------------------------------------------
+ * ReplicationPrimary class
+ * 
+ * Primary side of the replication. append() only copies the event onto a ring, a sender
+ * thread streams whatever is on the ring to the secondary in batches, and a second thread
+ * reads the secondary's acknowledgements, so that the primary never waits on the network
+ * while processing orders
+ * --------------------------------------------------------------------------------------
+*/
+class ReplicationPrimary
+{
+public:
+    static constexpr uint64_t RING_SIZE = 65536;    // Events appended but not yet sent (power of 2)
+    static constexpr size_t MAX_BATCH = 1024;       // Largest number of events per send()
+
+    ReplicationPrimary() = default;
+
+    /**--------------------------------------------------------------------------------------
+     * Destructor
+     * 
+     * Sends every appended event, then stops the threads and closes the connection
+     * --------------------------------------------------------------------------------------
+    */
+    ~ReplicationPrimary();
+
+    ReplicationPrimary(const ReplicationPrimary&) = delete;
+    ReplicationPrimary& operator=(const ReplicationPrimary&) = delete;
+
+    /**--------------------------------------------------------------------------------------
+     * start()
+     * 
+     * Waits for a secondary to connect on a TCP port, tells it which order book it
+     * replicates, and starts the sender and acknowledgement threads
+     * 
+     * @param[in] port      TCP port to listen on
+     * @param[in] ticker    Ticker of the order book
+     * @param[in] algorithm Choice of algorithm (1 for FIFO, 2 for Pro-Rata)
+     * @return true if a secondary is connected, false on error or on platforms without
+     *         POSIX sockets
+     * --------------------------------------------------------------------------------------
+    */
+    bool start(int port, const std::string& ticker, int algorithm);
+
+    /**--------------------------------------------------------------------------------------
+     * append()
+     * 
+     * Queues an event for the secondary, only waiting if RING_SIZE events are not sent yet
+     * 
+     * @param[in] event Event to be replicated, with the next sequence number
+     * --------------------------------------------------------------------------------------
+    */
+    void append(const Replication::ReplicatedEvent& event);
+
+    /**--------------------------------------------------------------------------------------
+     * waitForAcknowledgement()
+     * 
+     * Waits until the secondary has applied every event up to a sequence number
+     * 
+     * @param[in] sequence  Sequence number of the event
+     * @return true if acknowledged, false if the secondary disconnected before
+     * --------------------------------------------------------------------------------------
+    */
+    bool waitForAcknowledgement(uint64_t sequence);
+
+private:
+    /**--------------------------------------------------------------------------------------
+     * runSender()
+     * 
+     * Sends the appended events in batches until stopped with nothing left to send
+     * --------------------------------------------------------------------------------------
+    */
+    void runSender();
+
+    /**--------------------------------------------------------------------------------------
+     * runAcknowledgementReader()
+     * 
+     * Records the sequence number acknowledged by the secondary until it disconnects
+     * --------------------------------------------------------------------------------------
+    */
+    void runAcknowledgementReader();
+
+    int m_socket = -1;
+    std::vector<Replication::ReplicatedEvent> m_ring;
+    alignas(64) std::atomic<uint64_t> m_appended{0};        // Number of events appended, written by the caller of append()
+    alignas(64) std::atomic<uint64_t> m_sent{0};            // Number of events sent, written by the sender thread
+    alignas(64) std::atomic<uint64_t> m_acknowledged{0};    // Last sequence number applied by the secondary
+    std::atomic<bool> m_isStopping{false};
+    std::atomic<bool> m_isDisconnected{false};
+    std::thread m_sender;
+    std::thread m_acknowledgementReader;
+};
+
+/**--------------------------------------------------------------------------------------
+ * ReplicationSecondary class
+ * 
+ * Secondary side of the replication. Connects to the primary, applies every event it
+ * streams to a local order book and acknowledges them once per batch
+ * --------------------------------------------------------------------------------------
+*/
+class ReplicationSecondary
+{
+public:
+    ReplicationSecondary() = default;
+
+    /**--------------------------------------------------------------------------------------
+     * Destructor
+     * 
+     * Closes the connection
+     * --------------------------------------------------------------------------------------
+    */
+    ~ReplicationSecondary();
+
+    ReplicationSecondary(const ReplicationSecondary&) = delete;
+    ReplicationSecondary& operator=(const ReplicationSecondary&) = delete;
+
+    /**--------------------------------------------------------------------------------------
+     * connectTo()
+     * 
+     * Connects to a primary, retrying until it is listening, and reads which order book it
+     * replicates
+     * 
+     * @param[in] host  Host name or address of the primary
+     * @param[in] port  TCP port of the primary
+     * @return true if connected, false on error or on platforms without POSIX sockets
+     * --------------------------------------------------------------------------------------
+    */
+    bool connectTo(const std::string& host, int port);
+
+    /**--------------------------------------------------------------------------------------
+     * applyUntilDisconnected()
+     * 
+     * Applies the events of the primary to an order book until the primary disconnects, at
+     * which point the order book is the primary's as of the last event received
+     * 
+     * @param[in,out] orderbook Order book of the secondary, created with getTicker()
+     * @return the sequence number of the last event applied
+     * --------------------------------------------------------------------------------------
+    */
+    uint64_t applyUntilDisconnected(Orderbook& orderbook);
+
+    /**--------------------------------------------------------------------------------------
+     * getTicker()
+     * 
+     * @return the ticker of the order book replicated, once connected
+     * --------------------------------------------------------------------------------------
+    */
+    const std::string& getTicker() const
+    {
+        return m_ticker;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getAlgorithm()
+     * 
+     * @return the choice of algorithm of the primary (1 for FIFO, 2 for Pro-Rata), once
+     *         connected
+     * --------------------------------------------------------------------------------------
+    */
+    int getAlgorithm() const
+    {
+        return m_algorithm;
+    }
+
+private:
+    int m_socket = -1;
+    std::string m_ticker;
+    int m_algorithm = 0;
+};
@@ -0,0 +1,631 @@
+/*shmtransport.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the ShmOrderEntryServer and ShmOrderEntryClient classes
+ *     Order-entry channel for client processes on the same host, built on rings in a POSIX
+ *     shared-memory segment (/dev/shm) instead of sockets
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <cstring>
+#include <cerrno>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "shmtransport.h"
+#include "logger.h"
+
+namespace ShmTransport
+{
+    const uint64_t SEGMENT_MAGIC = 0x4f4d454f52444552ULL;  // "OMEORDER"
+
+    // States of a response ring, held in isClientAttached
+    const uint32_t CLIENT_FREE = 0;
+    const uint32_t CLIENT_ATTACHED = 1;
+    const uint32_t CLIENT_DETACHING = 2;   // Set by the client, the engine frees the ring once the client's orders are cancelled
+    const size_t CACHE_LINE_SIZE = 64;
+
+    // Requests are handed over through their cell's sequence: a cell holding sequence == position is free
+    // for the producer claiming that position, sequence == position + 1 means its request is ready
+    typedef struct alignas(CACHE_LINE_SIZE) RequestCell
+    {
+        std::atomic<uint64_t> sequence;
+        OrderRequest request;
+    } RequestCell;
+
+    typedef struct RequestRing
+    {
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail;    // Next position claimed by a producer
+        alignas(CACHE_LINE_SIZE) uint64_t head;                 // Next position read by the engine, only used by the engine
+        RequestCell cells[REQUEST_RING_SIZE];
+    } RequestRing;
+
+    typedef struct ResponseRing
+    {
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail;    // Written by the engine
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head;    // Written by the client
+        alignas(CACHE_LINE_SIZE) OrderResponse responses[RESPONSE_RING_SIZE];
+    } ResponseRing;
+
+    typedef struct SharedSegment
+    {
+        uint64_t magic;
+        std::atomic<uint32_t> isReady;
+        std::atomic<uint32_t> isClientAttached[MAX_CLIENTS];
+        RequestRing requests;
+        ResponseRing responses[MAX_CLIENTS];
+    } SharedSegment;
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+                  "Atomics shared between processes have to be lock-free");
+    static_assert((REQUEST_RING_SIZE & (REQUEST_RING_SIZE - 1)) == 0 && (RESPONSE_RING_SIZE & (RESPONSE_RING_SIZE - 1)) == 0,
+                  "Ring sizes have to be powers of 2");
+}
+
+using namespace ShmTransport;
+
+namespace {
+    /**--------------------------------------------------------------------------------------
+     * mapSegment()
+     * 
+     * Opens and maps a shared-memory segment the size of a SharedSegment
+     * 
+     * @param[in] segmentName   Name of the segment
+     * @param[in] isCreating    True to create (or replace) the segment, false to open an
+     *                          existing one
+     * @return the mapped segment, or nullptr on error
+     * --------------------------------------------------------------------------------------
+    */
+    SharedSegment* mapSegment(const std::string& segmentName, bool isCreating)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        if(isCreating)
+        {
+            shm_unlink(segmentName.c_str());
+        }
+
+        int fd = shm_open(segmentName.c_str(), isCreating ? (O_CREAT | O_EXCL | O_RDWR) : O_RDWR, 0600);
+        if(fd < 0)
+        {
+            std::cerr << "ERROR - mapSegment(): shm_open of " << segmentName << " failed: " << std::strerror(errno) << std::endl;
+            return nullptr;
+        }
+
+        if(isCreating && ftruncate(fd, sizeof(SharedSegment)) != 0)
+        {
+            std::cerr << "ERROR - mapSegment(): ftruncate of " << segmentName << " failed: " << std::strerror(errno) << std::endl;
+            close(fd);
+            return nullptr;
+        }
+
+        void* address = mmap(nullptr, sizeof(SharedSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if(address == MAP_FAILED)
+        {
+            std::cerr << "ERROR - mapSegment(): mmap of " << segmentName << " failed: " << std::strerror(errno) << std::endl;
+            return nullptr;
+        }
+
+        return static_cast<SharedSegment*>(address);
+#else
+        (void)isCreating;
+        std::cerr << "ERROR - mapSegment(): shared memory " << segmentName << " is not supported on this platform" << std::endl;
+        return nullptr;
+#endif
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * unmapSegment()
+     * 
+     * Unmaps a segment mapped by mapSegment()
+     * 
+     * @param[in] segment   Mapped segment
+     * --------------------------------------------------------------------------------------
+    */
+    void unmapSegment(SharedSegment* segment)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        munmap(segment, sizeof(SharedSegment));
+#else
+        (void)segment;
+#endif
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * toSession()
+     * 
+     * @param[in] clientID  Index of a client's response ring
+     * @return the ID of the session the client's orders are tagged with, never 0 as that
+     *         means an order did not come through a session
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned int toSession(uint32_t clientID)
+    {
+        return clientID + 1;
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * Constructor
+ * 
+ * Creates a server without any segment
+ * 
+ * @param[in] ticker    Ticker put on every order submitted through the channel
+ * --------------------------------------------------------------------------------------
+*/
+ShmOrderEntryServer::ShmOrderEntryServer(std::string ticker)
+    : m_ticker(ticker)
+{}
+
+/**--------------------------------------------------------------------------------------
+ * Destructor
+ * 
+ * Unmaps and removes the segment
+ * --------------------------------------------------------------------------------------
+*/
+ShmOrderEntryServer::~ShmOrderEntryServer()
+{
+    if(m_segment != nullptr)
+    {
+        unmapSegment(m_segment);
+#if defined(__unix__) || defined(__APPLE__)
+        shm_unlink(m_segmentName.c_str());
+#endif
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * create()
+ * 
+ * Creates the shared-memory segment clients attach to, replacing any left over segment
+ * of the same name
+ * 
+ * @param[in] segmentName   Name of the segment, e.g. "/orders" for /dev/shm/orders
+ * @return true if the segment was created, false on error or on platforms without
+ *         POSIX shared memory
+ * --------------------------------------------------------------------------------------
+*/
+bool ShmOrderEntryServer::create(const std::string& segmentName)
+{
+    m_segment = mapSegment(segmentName, true);
+    if(m_segment == nullptr)
+    {
+        return false;
+    }
+    m_segmentName = segmentName;
+
+    // The new mapping is zero-filled, constructing the atomics in place before any client can see them
+    new (m_segment) SharedSegment();
+    m_segment->magic = SEGMENT_MAGIC;
+    for(uint32_t i = 0; i < REQUEST_RING_SIZE; i++)
+    {
+        m_segment->requests.cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    m_segment->isReady.store(1, std::memory_order_release);
+
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * drain()
+ * 
+ * Submits the waiting requests to the order book, matching after every added order, and
+ * answers each of them, then cancels the orders of the clients that detached. The order
+ * history is cleared after the batch
+ * 
+ * @param[in,out]   orderbook   Order book the requests are submitted to
+ * @param[in]       matcher     Order-matching algorithm, e.g. &Orderbook::matchOrdersFIFO,
+ *                              or nullptr to only accept orders, e.g. between auctions
+ * @param[in]       maxBatch    Largest number of requests handled by this call
+ * @return the number of requests handled
+ * --------------------------------------------------------------------------------------
+*/
+size_t ShmOrderEntryServer::drain(Orderbook& orderbook, void (Orderbook::*matcher)(), size_t maxBatch)
+{
+    RequestRing& requests = m_segment->requests;
+    size_t numHandled = 0;
+
+    // One timestamp and one look at the queue per batch, every order of the batch is admitted against them
+    const uint64_t nowNs = m_hasRateLimits ? (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() : 0;
+    const uint64_t queuedTail = (m_queueWatermark > 0) ? requests.tail.load(std::memory_order_acquire) : 0;
+
+    // Noting detaching clients before draining, so that every request they sent before detaching is handled first
+    uint32_t detachingClients = 0;
+    for(uint32_t i = 0; i < MAX_CLIENTS; i++)
+    {
+        if(m_segment->isClientAttached[i].load(std::memory_order_acquire) == CLIENT_DETACHING)
+        {
+            detachingClients |= 1u << i;
+        }
+    }
+
+    while(numHandled < maxBatch)
+    {
+        RequestCell& curCell = requests.cells[requests.head & (REQUEST_RING_SIZE - 1)];
+        if(curCell.sequence.load(std::memory_order_acquire) != requests.head + 1)
+        {
+            break;  // Next request is not published yet
+        }
+
+        OrderRequest request = curCell.request;
+        curCell.sequence.store(requests.head + REQUEST_RING_SIZE, std::memory_order_release);
+        requests.head++;
+        numHandled++;
+
+        RejectReason rejectReason = (request.type == ADD_ORDER && (m_hasRateLimits || m_queueWatermark > 0))
+                                    ? admitOrder(request, nowNs, (queuedTail > requests.head) ? queuedTail - requests.head : 0) : NOT_REJECTED;
+
+        OrderResponse response;
+        if(rejectReason == NOT_REJECTED)
+        {
+            response = handleRequest(request, orderbook, matcher);
+        }
+        else
+        {
+            response.clientSequence = request.clientSequence;
+            response.orderID = request.orderID;
+            response.filledAmount = 0;
+            response.numCancelled = 0;
+            response.status = REJECTED;
+            response.rejectReason = rejectReason;
+        }
+
+        if(request.clientID >= MAX_CLIENTS)
+        {
+            m_numDroppedResponses++;
+            continue;
+        }
+
+        ResponseRing& clientResponses = m_segment->responses[request.clientID];
+        uint64_t tail = clientResponses.tail.load(std::memory_order_relaxed);
+        if(tail - clientResponses.head.load(std::memory_order_acquire) == RESPONSE_RING_SIZE)
+        {
+            m_numDroppedResponses++;    // Never waiting on a slow client, it would stall every other client
+            continue;
+        }
+
+        clientResponses.responses[tail & (RESPONSE_RING_SIZE - 1)] = response;
+        clientResponses.tail.store(tail + 1, std::memory_order_release);
+    }
+
+    // Only once the request ring is empty, otherwise requests of a detaching client may still be waiting in it
+    if(detachingClients != 0 && numHandled < maxBatch)
+    {
+        for(uint32_t i = 0; i < MAX_CLIENTS; i++)
+        {
+            if((detachingClients & (1u << i)) == 0)
+            {
+                continue;
+            }
+
+            // Only the orders this client entered, its owners may have others resting through other clients
+            m_numCancelledOnDetach += orderbook.cancelOrdersOfSession(toSession(i));
+            m_sessionBuckets[i] = m_sessionLimit;
+
+            m_segment->isClientAttached[i].store(CLIENT_FREE, std::memory_order_release);
+        }
+    }
+
+    if(numHandled > 0)
+    {
+        orderbook.clearOrderHistory();
+    }
+
+    m_numRequests += numHandled;
+    return numHandled;
+}
+
+/**--------------------------------------------------------------------------------------
+ * handleRequest()
+ * 
+ * Submits one request to the order book
+ * 
+ * @param[in]       request     Request read from the request ring
+ * @param[in,out]   orderbook   Order book the request is submitted to
+ * @param[in]       matcher     Order-matching algorithm, or nullptr to not match
+ * @return the response to the request
+ * --------------------------------------------------------------------------------------
+*/
+OrderResponse ShmOrderEntryServer::handleRequest(const OrderRequest& request, Orderbook& orderbook, void (Orderbook::*matcher)())
+{
+    OrderResponse response;
+    response.clientSequence = request.clientSequence;
+    response.orderID = request.orderID;
+    response.filledAmount = 0;
+    response.numCancelled = 0;
+    response.rejectReason = NOT_REJECTED;
+
+    if(CANCEL_OWNER_ORDERS == request.type)
+    {
+        response.numCancelled = (int64_t)orderbook.cancelOrdersOfOwner(request.owner);
+        response.status = CANCELLED;
+        return response;
+    }
+
+    if(CANCEL_ORDER == request.type)
+    {
+        response.status = orderbook.cancelOrder((int)request.orderID) ? CANCELLED : NOT_FOUND;
+        return response;
+    }
+
+    Order newOrder(m_ticker, request.orderID, request.isMarket, request.isBuy, Order::ticksToPrice(request.priceTicks),
+                   request.time, request.amount, request.owner, toSession(request.clientID));
+
+    size_t historyBefore = orderbook.getOrderHistory().size();
+    bool isAdded = (request.pegReference == NOT_PEGGED) ? orderbook.addOrder(newOrder)
+                                                        : orderbook.addPeggedOrder(newOrder, request.pegReference, request.priceTicks);
+    if(!isAdded)
+    {
+        response.status = REJECTED;
+        response.rejectReason = INVALID_ORDER;
+        return response;
+    }
+    if(matcher != nullptr)
+    {
+        (orderbook.*matcher)();
+    }
+
+    // Only the fills of this request are new in the history, and only those of the new order concern its client
+    const std::vector<ProcessedOrder>& orderHistory = orderbook.getOrderHistory();
+    for(size_t i = historyBefore; i < orderHistory.size(); i++)
+    {
+        if(orderHistory[i].buyID == newOrder.getID() || orderHistory[i].sellID == newOrder.getID())
+        {
+            response.filledAmount += orderHistory[i].fillAmount;
+        }
+    }
+
+    response.status = ACCEPTED;
+    return response;
+}
+
+/**--------------------------------------------------------------------------------------
+ * setRateLimits()
+ * 
+ * Limits the rate at which orders are added by each client (session) and by each owner
+ * (account), rejecting the orders over either limit before they reach the order book.
+ * Cancels are never limited. The buckets of MAX_ACCOUNTS owners are allocated here, the
+ * owners seen after them share one bucket, so admitting orders never allocates
+ * 
+ * @param[in] sessionRate   Orders per second of each client, 0 for no limit
+ * @param[in] accountRate   Orders per second of each owner, 0 for no limit
+ * @param[in] burst         Orders a client or owner may send at once after being idle
+ * --------------------------------------------------------------------------------------
+*/
+void ShmOrderEntryServer::setRateLimits(unsigned int sessionRate, unsigned int accountRate, unsigned int burst)
+{
+    m_hasRateLimits = (sessionRate > 0 || accountRate > 0);
+    m_sessionLimit = TokenBucket(sessionRate, burst);
+    m_accountLimit = TokenBucket(accountRate, burst);
+
+    std::fill(std::begin(m_sessionBuckets), std::end(m_sessionBuckets), m_sessionLimit);
+    m_accountBuckets.clear();
+    m_accountBuckets.reserve(MAX_ACCOUNTS);
+    m_accountIndex = OwnerIndex();
+    m_accountIndex.reserve(MAX_ACCOUNTS);
+    m_sharedAccountBucket = m_accountLimit;
+}
+
+/**--------------------------------------------------------------------------------------
+ * admitOrder()
+ * 
+ * Checks an added order against the watermark and the rate limits of its client and
+ * owner, taking a token from both buckets if it is admitted
+ * 
+ * @param[in] request   ADD_ORDER request
+ * @param[in] nowNs     Time the batch of the request is handled at
+ * @param[in] backlog   Number of requests waiting behind it
+ * @return NOT_REJECTED if the order may go to the order book, otherwise why not
+ * --------------------------------------------------------------------------------------
+*/
+RejectReason ShmOrderEntryServer::admitOrder(const OrderRequest& request, uint64_t nowNs, uint64_t backlog)
+{
+    // Shedding first, rejecting is much cheaper than matching and drains the queue fastest
+    if(m_queueWatermark > 0 && backlog > m_queueWatermark)
+    {
+        m_numShed++;
+        return QUEUE_WATERMARK;
+    }
+
+    if(!m_hasRateLimits)
+    {
+        return NOT_REJECTED;
+    }
+
+    TokenBucket* sessionBucket = (request.clientID < MAX_CLIENTS) ? &m_sessionBuckets[request.clientID] : nullptr;
+    if(sessionBucket != nullptr && !sessionBucket->isAllowed(nowNs))
+    {
+        m_numThrottled++;
+        return SESSION_RATE_LIMIT;
+    }
+
+    unsigned int accountSlot = m_accountIndex.find(request.owner);
+    if(accountSlot == OwnerIndex::NO_SLOT && m_accountBuckets.size() < MAX_ACCOUNTS)
+    {
+        accountSlot = (unsigned int)m_accountBuckets.size();
+        m_accountBuckets.push_back(m_accountLimit);
+        m_accountIndex.insert(request.owner, accountSlot);
+    }
+
+    // Once the table is full, new owners are limited together rather than growing it on the matching thread
+    TokenBucket& accountBucket = (accountSlot != OwnerIndex::NO_SLOT) ? m_accountBuckets[accountSlot] : m_sharedAccountBucket;
+    if(!accountBucket.isAllowed(nowNs))
+    {
+        m_numThrottled++;
+        return ACCOUNT_RATE_LIMIT;
+    }
+
+    // Only taking tokens once both limits admit the order, a rejected order costs neither bucket
+    if(sessionBucket != nullptr)
+    {
+        sessionBucket->consume(nowNs);
+    }
+    accountBucket.consume(nowNs);
+
+    return NOT_REJECTED;
+}
+
+/**--------------------------------------------------------------------------------------
+ * Destructor
+ * 
+ * Tells the engine the client is detaching, which cancels the client's resting orders
+ * and then frees its response ring, and unmaps the segment
+ * --------------------------------------------------------------------------------------
+*/
+ShmOrderEntryClient::~ShmOrderEntryClient()
+{
+    if(m_segment != nullptr)
+    {
+        m_segment->isClientAttached[m_clientID].store(CLIENT_DETACHING, std::memory_order_release);
+        unmapSegment(m_segment);
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * attach()
+ * 
+ * Maps the segment of a running engine and claims a free response ring
+ * 
+ * @param[in] segmentName   Name the engine created the segment with, e.g. "/orders"
+ * @return true if attached, false if the segment does not exist or every response ring
+ *         is taken
+ * --------------------------------------------------------------------------------------
+*/
+bool ShmOrderEntryClient::attach(const std::string& segmentName)
+{
+    SharedSegment* segment = mapSegment(segmentName, false);
+    if(segment == nullptr)
+    {
+        return false;
+    }
+
+    if(segment->isReady.load(std::memory_order_acquire) != 1 || segment->magic != SEGMENT_MAGIC)
+    {
+        std::cerr << "ERROR - attach(): " << segmentName << " is not an order-entry segment" << std::endl;
+        unmapSegment(segment);
+        return false;
+    }
+
+    for(uint32_t i = 0; i < MAX_CLIENTS; i++)
+    {
+        uint32_t isAttached = CLIENT_FREE;
+        if(segment->isClientAttached[i].compare_exchange_strong(isAttached, CLIENT_ATTACHED, std::memory_order_acq_rel))
+        {
+            // Skipping responses left over from the previous client of this ring
+            ResponseRing& clientResponses = segment->responses[i];
+            clientResponses.head.store(clientResponses.tail.load(std::memory_order_acquire), std::memory_order_release);
+
+            m_segment = segment;
+            m_clientID = i;
+            return true;
+        }
+    }
+
+    std::cerr << "ERROR - attach(): all " << MAX_CLIENTS << " clients of " << segmentName << " are attached" << std::endl;
+    unmapSegment(segment);
+    return false;
+}
+
+/**--------------------------------------------------------------------------------------
+ * submit()
+ * 
+ * Puts a request on the request ring of the engine
+ * 
+ * @param[in] request   Request to be sent, its clientID is filled in
+ * @return true if sent, false if the request ring is full
+ * --------------------------------------------------------------------------------------
+*/
+bool ShmOrderEntryClient::submit(OrderRequest request)
+{
+    RequestRing& requests = m_segment->requests;
+    request.clientID = m_clientID;
+
+    uint64_t position = requests.tail.load(std::memory_order_relaxed);
+    RequestCell* cell = nullptr;
+
+    // Claiming the next position, other clients may claim it first
+    while(true)
+    {
+        cell = &requests.cells[position & (REQUEST_RING_SIZE - 1)];
+        int64_t difference = (int64_t)(cell->sequence.load(std::memory_order_acquire) - position);
+
+        if(difference == 0)
+        {
+            if(requests.tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if(difference < 0)
+        {
+            return false;   // The engine has not read the request a full ring ago yet
+        }
+        else
+        {
+            position = requests.tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->request = request;
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+/**--------------------------------------------------------------------------------------
+ * poll()
+ * 
+ * Takes the next response of the engine, if any
+ * 
+ * @param[out] response Response received
+ * @return true if a response was received
+ * --------------------------------------------------------------------------------------
+*/
+bool ShmOrderEntryClient::poll(OrderResponse& response)
+{
+    ResponseRing& clientResponses = m_segment->responses[m_clientID];
+    uint64_t head = clientResponses.head.load(std::memory_order_relaxed);
+
+    if(head == clientResponses.tail.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    response = clientResponses.responses[head & (RESPONSE_RING_SIZE - 1)];
+    clientResponses.head.store(head + 1, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,373 @@
+/*shmtransport.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the ShmOrderEntryServer and ShmOrderEntryClient classes
+ *     Order-entry channel for client processes on the same host, built on rings in a POSIX
+ *     shared-memory segment (/dev/shm) instead of sockets
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "orderbook.h"
+#include "orderindex.h"
+#include "tokenbucket.h"
+
+namespace ShmTransport
+{
+    const uint32_t MAX_CLIENTS = 16;            // Number of clients that can be attached at the same time
+    const uint32_t REQUEST_RING_SIZE = 4096;    // Requests waiting for the engine, shared by every client (power of 2)
+    const uint32_t RESPONSE_RING_SIZE = 1024;   // Responses waiting for each client (power of 2)
+    const uint32_t MAX_ACCOUNTS = 4096;         // Owners rate limited with a bucket of their own, any further owners share one
+
+    enum RequestType : uint8_t
+    {
+        ADD_ORDER,
+        CANCEL_ORDER,
+        CANCEL_OWNER_ORDERS     // Cancels every resting order of the request's owner
+    };
+
+    enum ResponseStatus : uint8_t
+    {
+        ACCEPTED,   // Order added, filledAmount holds how much of it was filled right away
+        REJECTED,   // Order not added, e.g. price outside of the order book or duplicate ID
+        CANCELLED,
+        NOT_FOUND   // Cancelled order was not resting
+    };
+
+    enum RejectReason : uint8_t
+    {
+        NOT_REJECTED,
+        INVALID_ORDER,          // Refused by the order book, e.g. price outside of the order book or duplicate ID
+        SESSION_RATE_LIMIT,     // The client sent orders faster than its session's rate limit
+        ACCOUNT_RATE_LIMIT,     // The owner's orders came faster than its account's rate limit
+        QUEUE_WATERMARK         // More requests were waiting for the engine than its watermark
+    };
+
+    /**--------------------------------------------------------------------------------------
+     * OrderRequest struct
+     * 
+     * Message sent from a client to the engine, copied as is through shared memory
+     * --------------------------------------------------------------------------------------
+    */
+    typedef struct OrderRequest
+    {
+        uint64_t clientSequence;    // Chosen by the client, echoed in the response
+        int64_t orderID;
+        int32_t priceTicks;
+        int32_t time;
+        int32_t amount;
+        uint32_t owner;
+        uint32_t clientID;          // Set by ShmOrderEntryClient::submit()
+        RequestType type;
+        bool isBuy;
+        bool isMarket;
+        PegReference pegReference;  // NOT_PEGGED for limit and market orders, otherwise priceTicks holds the offset
+    } OrderRequest;
+
+    /**--------------------------------------------------------------------------------------
+     * OrderResponse struct
+     * 
+     * Message sent from the engine back to the client of a request
+     * --------------------------------------------------------------------------------------
+    */
+    typedef struct OrderResponse
+    {
+        uint64_t clientSequence;
+        int64_t orderID;
+        int64_t filledAmount;
+        int64_t numCancelled;       // Orders removed by a CANCEL_OWNER_ORDERS request
+        ResponseStatus status;
+        RejectReason rejectReason;  // Why a REJECTED order was not added, NOT_REJECTED otherwise
+    } OrderResponse;
+
+    struct SharedSegment;
+}
+
+/**--------------------------------------------------------------------------------------
+ * ShmOrderEntryServer class
+ * 
+ * Engine side of the channel. Creates the shared-memory segment, drains the requests of
+ * every client in batches straight into an order book, and answers each request on the
+ * response ring of its client. Requests come in through one lock-free multi-producer ring,
+ * responses go out through one single-producer ring per client, so that no message costs a
+ * system call. When a client detaches, every resting order it added is cancelled
+ * --------------------------------------------------------------------------------------
+*/
+class ShmOrderEntryServer
+{
+public:
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Creates a server without any segment
+     * 
+     * @param[in] ticker    Ticker put on every order submitted through the channel
+     * --------------------------------------------------------------------------------------
+    */
+    ShmOrderEntryServer(std::string ticker);
+
+    /**--------------------------------------------------------------------------------------
+     * Destructor
+     * 
+     * Unmaps and removes the segment
+     * --------------------------------------------------------------------------------------
+    */
+    ~ShmOrderEntryServer();
+
+    ShmOrderEntryServer(const ShmOrderEntryServer&) = delete;
+    ShmOrderEntryServer& operator=(const ShmOrderEntryServer&) = delete;
+
+    /**--------------------------------------------------------------------------------------
+     * create()
+     * 
+     * Creates the shared-memory segment clients attach to, replacing any left over segment
+     * of the same name
+     * 
+     * @param[in] segmentName   Name of the segment, e.g. "/orders" for /dev/shm/orders
+     * @return true if the segment was created, false on error or on platforms without
+     *         POSIX shared memory
+     * --------------------------------------------------------------------------------------
+    */
+    bool create(const std::string& segmentName);
+
+    /**--------------------------------------------------------------------------------------
+     * drain()
+     * 
+     * Submits the waiting requests to the order book, matching after every added order, and
+     * answers each of them, then cancels the orders of the clients that detached. The order
+     * history is cleared after the batch
+     * 
+     * @param[in,out]   orderbook   Order book the requests are submitted to
+     * @param[in]       matcher     Order-matching algorithm, e.g. &Orderbook::matchOrdersFIFO,
+     *                              or nullptr to only accept orders, e.g. between auctions
+     * @param[in]       maxBatch    Largest number of requests handled by this call
+     * @return the number of requests handled
+     * --------------------------------------------------------------------------------------
+    */
+    size_t drain(Orderbook& orderbook, void (Orderbook::*matcher)(), size_t maxBatch);
+
+    /**--------------------------------------------------------------------------------------
+     * setRateLimits()
+     * 
+     * Limits the rate at which orders are added by each client (session) and by each owner
+     * (account), rejecting the orders over either limit before they reach the order book.
+     * Cancels are never limited. The buckets of MAX_ACCOUNTS owners are allocated here, the
+     * owners seen after them share one bucket, so admitting orders never allocates
+     * 
+     * @param[in] sessionRate   Orders per second of each client, 0 for no limit
+     * @param[in] accountRate   Orders per second of each owner, 0 for no limit
+     * @param[in] burst         Orders a client or owner may send at once after being idle
+     * --------------------------------------------------------------------------------------
+    */
+    void setRateLimits(unsigned int sessionRate, unsigned int accountRate, unsigned int burst);
+
+    /**--------------------------------------------------------------------------------------
+     * setQueueWatermark()
+     * 
+     * Rejects the orders added while more requests than the watermark are waiting behind
+     * them, so that a flood of requests is shed instead of delaying every client. Cancels
+     * are always handled
+     * 
+     * @param[in] watermark Largest number of requests allowed to wait, 0 for no watermark
+     * --------------------------------------------------------------------------------------
+    */
+    void setQueueWatermark(size_t watermark)
+    {
+        m_queueWatermark = watermark;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getNumRequests()
+     * 
+     * @return the number of requests handled since the segment was created
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned long long getNumRequests() const
+    {
+        return m_numRequests;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getNumDroppedResponses()
+     * 
+     * @return the number of responses dropped because the response ring of their client
+     *         was full
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned long long getNumDroppedResponses() const
+    {
+        return m_numDroppedResponses;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getNumCancelledOnDetach()
+     * 
+     * @return the number of orders cancelled because the client that added them detached
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned long long getNumCancelledOnDetach() const
+    {
+        return m_numCancelledOnDetach;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getNumThrottled()
+     * 
+     * @return the number of orders rejected by the session and account rate limits
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned long long getNumThrottled() const
+    {
+        return m_numThrottled;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * getNumShed()
+     * 
+     * @return the number of orders rejected because the queue was above its watermark
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned long long getNumShed() const
+    {
+        return m_numShed;
+    }
+
+private:
+    /**--------------------------------------------------------------------------------------
+     * handleRequest()
+     * 
+     * Submits one request to the order book
+     * 
+     * @param[in]       request     Request read from the request ring
+     * @param[in,out]   orderbook   Order book the request is submitted to
+     * @param[in]       matcher     Order-matching algorithm, or nullptr to not match
+     * @return the response to the request
+     * --------------------------------------------------------------------------------------
+    */
+    ShmTransport::OrderResponse handleRequest(const ShmTransport::OrderRequest& request, Orderbook& orderbook, void (Orderbook::*matcher)());
+
+    /**--------------------------------------------------------------------------------------
+     * admitOrder()
+     * 
+     * Checks an added order against the watermark and the rate limits of its client and
+     * owner, taking a token from both buckets if it is admitted
+     * 
+     * @param[in] request   ADD_ORDER request
+     * @param[in] nowNs     Time the batch of the request is handled at
+     * @param[in] backlog   Number of requests waiting behind it
+     * @return NOT_REJECTED if the order may go to the order book, otherwise why not
+     * --------------------------------------------------------------------------------------
+    */
+    ShmTransport::RejectReason admitOrder(const ShmTransport::OrderRequest& request, uint64_t nowNs, uint64_t backlog);
+
+    std::string m_ticker;
+    std::string m_segmentName;
+    ShmTransport::SharedSegment* m_segment = nullptr;
+    unsigned long long m_numRequests = 0;
+    unsigned long long m_numDroppedResponses = 0;
+    unsigned long long m_numCancelledOnDetach = 0;
+
+    bool m_hasRateLimits = false;
+    TokenBucket m_sessionLimit;     // Rate limit every client starts with
+    TokenBucket m_accountLimit;     // Rate limit every owner starts with
+    TokenBucket m_sessionBuckets[ShmTransport::MAX_CLIENTS];    // Rate limit of each client, reset when it detaches
+    std::vector<TokenBucket> m_accountBuckets;  // Rate limit of each of the first MAX_ACCOUNTS owners seen, never grows past its capacity
+    OwnerIndex m_accountIndex;                  // Owner to its bucket
+    TokenBucket m_sharedAccountBucket;          // Rate limit shared by every owner seen once the table is full
+    size_t m_queueWatermark = 0;
+    unsigned long long m_numThrottled = 0;
+    unsigned long long m_numShed = 0;
+};
+
+/**--------------------------------------------------------------------------------------
+ * ShmOrderEntryClient class
+ * 
+ * Client side of the channel. Attaches to the segment of a running engine, claiming one of
+ * its response rings, then submits requests and polls for their responses without blocking
+ * --------------------------------------------------------------------------------------
+*/
+class ShmOrderEntryClient
+{
+public:
+    ShmOrderEntryClient() = default;
+
+    /**--------------------------------------------------------------------------------------
+     * Destructor
+     * 
+     * Tells the engine the client is detaching, which cancels the client's resting orders
+     * and then frees its response ring, and unmaps the segment
+     * --------------------------------------------------------------------------------------
+    */
+    ~ShmOrderEntryClient();
+
+    ShmOrderEntryClient(const ShmOrderEntryClient&) = delete;
+    ShmOrderEntryClient& operator=(const ShmOrderEntryClient&) = delete;
+
+    /**--------------------------------------------------------------------------------------
+     * attach()
+     * 
+     * Maps the segment of a running engine and claims a free response ring
+     * 
+     * @param[in] segmentName   Name the engine created the segment with, e.g. "/orders"
+     * @return true if attached, false if the segment does not exist or every response ring
+     *         is taken
+     * --------------------------------------------------------------------------------------
+    */
+    bool attach(const std::string& segmentName);
+
+    /**--------------------------------------------------------------------------------------
+     * submit()
+     * 
+     * Puts a request on the request ring of the engine
+     * 
+     * @param[in] request   Request to be sent, its clientID is filled in
+     * @return true if sent, false if the request ring is full
+     * --------------------------------------------------------------------------------------
+    */
+    bool submit(ShmTransport::OrderRequest request);
+
+    /**--------------------------------------------------------------------------------------
+     * poll()
+     * 
+     * Takes the next response of the engine, if any
+     * 
+     * @param[out] response Response received
+     * @return true if a response was received
+     * --------------------------------------------------------------------------------------
+    */
+    bool poll(ShmTransport::OrderResponse& response);
+
+private:
+    ShmTransport::SharedSegment* m_segment = nullptr;
+    uint32_t m_clientID = 0;
+};
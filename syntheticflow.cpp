@@ -0,0 +1,158 @@
+/*syntheticflow.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the SyntheticOrderFlow class
+ *     Deterministic stream of add, match and cancel operations used to drive an order book into
+ *     its steady state without any input file
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include "syntheticflow.h"
+
+namespace {
+    const int PRICE_SPREAD_TICKS = 10;      // Orders are priced within this many ticks of the mid price
+    const int ORDER_LIFETIME = 64;          // Orders still resting this many orders after being added are cancelled
+    const int DRAIN_HISTORY_EVERY = 256;    // Order history is cleared after this many orders
+    const int NUM_OWNERS = 8;               // Owners sending orders at the same time
+    const int NEW_OWNER_EVERY = 64;         // The oldest owner is replaced by a new one after this many orders
+    const int MARKET_ORDER_EVERY = 16;      // Every this many orders is a market order
+    const int PEGGED_ORDER_EVERY = 8;       // Every this many orders is pegged, unless it is a market order
+    const int QUOTE_EVERY = 32;             // The market maker requotes after this many orders
+    const int MASS_CANCEL_EVERY = 512;      // Every resting order of one owner is cancelled after this many orders
+    const unsigned int QUOTE_OWNER = 0;     // Owner of the quote, the other owners start at 1
+    const int QUOTE_ID_BASE = 1 << 30;      // IDs of the quote's two orders, far above the IDs of the flow
+    const int QUOTE_AMOUNT = 50;
+}
+
+/**--------------------------------------------------------------------------------------
+ * Constructor
+ * 
+ * Creates a flow of orders
+ * 
+ * @param[in] ticker    Ticker put on every generated order
+ * @param[in] midTicks  Price in ticks that the generated orders are spread around
+ * @param[in] seed      Seed of the generator, two flows with the same seed generate the
+ *                      exact same orders
+ * --------------------------------------------------------------------------------------
+*/
+SyntheticOrderFlow::SyntheticOrderFlow(std::string ticker, int midTicks, unsigned int seed)
+  : m_ticker(ticker), m_midTicks(midTicks), m_state(seed != 0 ? seed : 1), m_quote(2)
+{
+    m_quote[0].orderID = QUOTE_ID_BASE;
+    m_quote[0].isBuy = true;
+    m_quote[1].orderID = QUOTE_ID_BASE + 1;
+    m_quote[1].isBuy = false;
+}
+
+/**--------------------------------------------------------------------------------------
+ * run()
+ * 
+ * Adds the next numOrders orders of the flow to the order book, matching after every
+ * order with the given algorithm and cancelling the earlier orders that are still resting.
+ * Quotes and mass cancels are sent in between the orders
+ * 
+ * @param[in,out]   orderbook   Order book the flow is applied to
+ * @param[in]       matcher     Order-matching algorithm, e.g. &Orderbook::matchOrdersFIFO
+ * @param[in]       numOrders   Number of orders to be generated
+ * --------------------------------------------------------------------------------------
+*/
+void SyntheticOrderFlow::run(Orderbook& orderbook, void (Orderbook::*matcher)(), int numOrders)
+{
+    for(int i = 0; i < numOrders; i++)
+    {
+        bool isBuy = (nextRandom() & 1) != 0;
+
+        // Buy orders mostly rest below the mid price and sell orders above it, with some overlap so that orders get matched
+        int offset = (int)(nextRandom() % (PRICE_SPREAD_TICKS + 1)) - 2;
+        int priceTicks = isBuy ? m_midTicks - offset : m_midTicks + offset;
+        int amount = 1 + (int)(nextRandom() % 100);
+
+        // A window of NUM_OWNERS owners that moves on by one every NEW_OWNER_EVERY orders
+        unsigned int owner = QUOTE_OWNER + 1 + m_nextID / NEW_OWNER_EVERY + m_nextID % NUM_OWNERS;
+
+        if(m_nextID % MARKET_ORDER_EVERY == 0)
+        {
+            // Priced through the whole spread of the flow so that it takes liquidity
+            int marketTicks = isBuy ? m_midTicks + PRICE_SPREAD_TICKS : m_midTicks - PRICE_SPREAD_TICKS;
+            orderbook.addOrder(Order(m_ticker, m_nextID, true, isBuy, Order::ticksToPrice(marketTicks), m_nextTime, amount, owner));
+        }
+        else if(m_nextID % PEGGED_ORDER_EVERY == 0)
+        {
+            PegReference reference = (nextRandom() & 1) ? PEG_PRIMARY : PEG_MIDPOINT;
+            orderbook.addPeggedOrder(Order(m_ticker, m_nextID, false, isBuy, 0.0f, m_nextTime, amount, owner), reference, 0);
+        }
+        else
+        {
+            orderbook.addOrder(Order(m_ticker, m_nextID, false, isBuy, Order::ticksToPrice(priceTicks), m_nextTime, amount, owner));
+        }
+        (orderbook.*matcher)();
+
+        if(m_nextID % QUOTE_EVERY == 0)
+        {
+            int halfSpread = 1 + (int)(nextRandom() % 3);
+            m_quote[0].priceTicks = m_midTicks - halfSpread;
+            m_quote[0].amount = QUOTE_AMOUNT;
+            m_quote[1].priceTicks = m_midTicks + halfSpread;
+            m_quote[1].amount = QUOTE_AMOUNT;
+            orderbook.applyQuote(QUOTE_OWNER, m_quote, m_nextTime);
+            (orderbook.*matcher)();
+        }
+
+        if(m_nextID % MASS_CANCEL_EVERY == 0)
+        {
+            orderbook.cancelOrdersOfOwner(owner);
+        }
+
+        if(m_nextID > ORDER_LIFETIME)
+        {
+            orderbook.cancelOrder(m_nextID - ORDER_LIFETIME);
+        }
+
+        if(m_nextID % DRAIN_HISTORY_EVERY == 0)
+        {
+            orderbook.clearOrderHistory();
+        }
+
+        m_nextID++;
+        m_nextTime++;
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * nextRandom()
+ * 
+ * @return the next number of the xorshift generator
+ * --------------------------------------------------------------------------------------
+*/
+unsigned int SyntheticOrderFlow::nextRandom()
+{
+    m_state ^= m_state << 13;
+    m_state ^= m_state >> 17;
+    m_state ^= m_state << 5;
+
+    return m_state;
+}
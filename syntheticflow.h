@@ -0,0 +1,97 @@
+/*syntheticflow.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the SyntheticOrderFlow class
+ *     Deterministic stream of add, match and cancel operations used to drive an order book into
+ *     its steady state without any input file
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "orderbook.h"
+
+/**--------------------------------------------------------------------------------------
+ * SyntheticOrderFlow class
+ * 
+ * Generates a reproducible flow of orders around a mid price: limit orders, market orders
+ * priced through the book, pegged orders, a market maker's quotes, mass cancels of one
+ * owner, and owners that come and go. Every order is matched as soon as it is added,
+ * orders that are still resting a while later are cancelled, and the order history is
+ * drained periodically, so that an order book running the flow stays at a bounded size
+ * like it would during a live session
+ * --------------------------------------------------------------------------------------
+*/
+class SyntheticOrderFlow
+{
+public:
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Creates a flow of orders
+     * 
+     * @param[in] ticker    Ticker put on every generated order
+     * @param[in] midTicks  Price in ticks that the generated orders are spread around
+     * @param[in] seed      Seed of the generator, two flows with the same seed generate the
+     *                      exact same orders
+     * --------------------------------------------------------------------------------------
+    */
+    SyntheticOrderFlow(std::string ticker, int midTicks, unsigned int seed);
+
+    /**--------------------------------------------------------------------------------------
+     * run()
+     * 
+     * Adds the next numOrders orders of the flow to the order book, matching after every
+     * order with the given algorithm and cancelling the earlier orders that are still resting.
+     * Quotes and mass cancels are sent in between the orders
+     * 
+     * @param[in,out]   orderbook   Order book the flow is applied to
+     * @param[in]       matcher     Order-matching algorithm, e.g. &Orderbook::matchOrdersFIFO
+     * @param[in]       numOrders   Number of orders to be generated
+     * --------------------------------------------------------------------------------------
+    */
+    void run(Orderbook& orderbook, void (Orderbook::*matcher)(), int numOrders);
+
+private:
+    /**--------------------------------------------------------------------------------------
+     * nextRandom()
+     * 
+     * @return the next number of the xorshift generator
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned int nextRandom();
+
+    std::string m_ticker;
+    int m_midTicks;
+    unsigned int m_state;
+    std::vector<QuoteEntry> m_quote;    // Both sides of the market maker's quote, reused by every quote
+    int m_nextID = 1;
+    int m_nextTime = 0;
+};
@@ -0,0 +1,106 @@
+/*tokenbucket.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the TokenBucket class
+ *     Message-rate limit of one session or account, admitting each message with a single
+ *     timestamp compare
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+/**--------------------------------------------------------------------------------------
+ * TokenBucket class
+ * 
+ * Token bucket refilled at a fixed rate and holding up to a burst of tokens, kept as the
+ * time at which the bucket will next be full (the virtual scheduling form of the generic
+ * cell rate algorithm). A message is admitted if that time is at most the burst's worth
+ * of refills away, which is one compare against the current timestamp, and consuming its
+ * token moves that time one refill further. A rate of 0 admits every message
+ * --------------------------------------------------------------------------------------
+*/
+class TokenBucket
+{
+public:
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Creates a bucket admitting every message
+     * --------------------------------------------------------------------------------------
+    */
+    TokenBucket()
+    {}
+
+    /**--------------------------------------------------------------------------------------
+     * Constructor
+     * 
+     * Creates a full bucket
+     * 
+     * @param[in] ratePerSecond Tokens added per second, 0 for no limit
+     * @param[in] burst         Largest number of tokens the bucket holds, at least 1
+     * --------------------------------------------------------------------------------------
+    */
+    TokenBucket(uint64_t ratePerSecond, uint64_t burst)
+        : m_refillNs((ratePerSecond == 0) ? 0 : std::max<uint64_t>(NS_PER_SECOND / ratePerSecond, 1)),
+          m_toleranceNs(m_refillNs * (std::max<uint64_t>(burst, 1) - 1))
+    {}
+
+    /**--------------------------------------------------------------------------------------
+     * isAllowed()
+     * 
+     * @param[in] nowNs Current time in nanoseconds, from a monotonic clock
+     * @return true if the bucket holds a token for one more message
+     * --------------------------------------------------------------------------------------
+    */
+    bool isAllowed(uint64_t nowNs) const
+    {
+        return m_fullAtNs <= nowNs + m_toleranceNs;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * consume()
+     * 
+     * Takes the token of an admitted message
+     * 
+     * @param[in] nowNs Current time in nanoseconds, from a monotonic clock
+     * --------------------------------------------------------------------------------------
+    */
+    void consume(uint64_t nowNs)
+    {
+        m_fullAtNs = std::max(m_fullAtNs, nowNs) + m_refillNs;
+    }
+
+private:
+    static const uint64_t NS_PER_SECOND = 1000000000ULL;
+
+    uint64_t m_refillNs = 0;    // Time to refill one token
+    uint64_t m_toleranceNs = 0; // Time to refill all tokens but one
+    uint64_t m_fullAtNs = 0;    // Time at which the bucket is full again
+};
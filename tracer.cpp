@@ -0,0 +1,238 @@
+/*tracer.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the Tracer namespace and TraceScope class
+ *     Low-overhead recording of timed engine activity (parse batches, match calls, level sweeps,
+ *     output flushes) into per-thread ring buffers, exported as Chrome trace JSON
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+#include "tracer.h"
+
+namespace {
+    const size_t EVENTS_PER_THREAD = 1 << 16;  // Power of two, older events are overwritten once a thread records more
+
+    typedef struct TraceEvent
+    {
+        const char* category;
+        const char* name;
+        unsigned long long beginNanoseconds;
+        unsigned long long endNanoseconds;
+    } TraceEvent;
+
+    /**--------------------------------------------------------------------------------------
+     * TraceBuffer struct
+     * 
+     * Ring buffer of the events of a single thread, only ever written by that thread
+     * --------------------------------------------------------------------------------------
+    */
+    typedef struct TraceBuffer
+    {
+        int threadID;
+        unsigned long long numRecorded = 0;
+        std::vector<TraceEvent> events;
+
+        explicit TraceBuffer(int id)
+            : threadID(id), events(EVENTS_PER_THREAD)
+        {}
+    } TraceBuffer;
+
+    std::atomic<bool> g_isEnabled(false);
+
+    // Buffers outlive their threads so that they can be written out after the threads are joined
+    std::mutex g_buffersMutex;
+    std::vector<std::unique_ptr<TraceBuffer>> g_buffers;
+
+    thread_local TraceBuffer* t_buffer = nullptr;
+
+    /**--------------------------------------------------------------------------------------
+     * getThreadBuffer()
+     * 
+     * @return the ring buffer of the calling thread, created and registered on first use
+     * --------------------------------------------------------------------------------------
+    */
+    TraceBuffer* getThreadBuffer()
+    {
+        if(t_buffer == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(g_buffersMutex);
+            g_buffers.emplace_back(new TraceBuffer((int)g_buffers.size() + 1));
+            t_buffer = g_buffers.back().get();
+        }
+
+        return t_buffer;
+    }
+
+    /**--------------------------------------------------------------------------------------
+     * writeJsonString()
+     * 
+     * Writes a string as a JSON string literal, escaping quotes and backslashes
+     * 
+     * @param[in,out]   outfile Stream being written to
+     * @param[in]       text    String to be written
+     * --------------------------------------------------------------------------------------
+    */
+    void writeJsonString(std::ofstream& outfile, const char* text)
+    {
+        outfile << '"';
+        for(const char* curChar = text; *curChar != '\0'; curChar++)
+        {
+            if(*curChar == '"' || *curChar == '\\')
+            {
+                outfile << '\\';
+            }
+            outfile << *curChar;
+        }
+        outfile << '"';
+    }
+}
+
+/**--------------------------------------------------------------------------------------
+ * enable()
+ * 
+ * Starts recording events on every thread
+ * --------------------------------------------------------------------------------------
+*/
+void Tracer::enable()
+{
+    g_isEnabled.store(true, std::memory_order_relaxed);
+}
+
+/**--------------------------------------------------------------------------------------
+ * isEnabled()
+ * 
+ * @return true if events are being recorded
+ * --------------------------------------------------------------------------------------
+*/
+bool Tracer::isEnabled()
+{
+    return g_isEnabled.load(std::memory_order_relaxed);
+}
+
+/**--------------------------------------------------------------------------------------
+ * nowNanoseconds()
+ * 
+ * @return the current time of a monotonic clock, in nanoseconds
+ * --------------------------------------------------------------------------------------
+*/
+unsigned long long Tracer::nowNanoseconds()
+{
+    return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**--------------------------------------------------------------------------------------
+ * record()
+ * 
+ * Records a complete event into the calling thread's ring buffer, overwriting its oldest
+ * event once the buffer is full
+ * 
+ * @param[in] category      Category of the event, e.g. "match". Must be a string literal
+ * @param[in] name          Name of the event, e.g. "matchOrdersFIFO". Must be a string literal
+ * @param[in] beginNanoseconds  Time the event began, from nowNanoseconds()
+ * @param[in] endNanoseconds    Time the event ended, from nowNanoseconds()
+ * --------------------------------------------------------------------------------------
+*/
+void Tracer::record(const char* category, const char* name, unsigned long long beginNanoseconds, unsigned long long endNanoseconds)
+{
+    TraceBuffer* buffer = getThreadBuffer();
+
+    TraceEvent& curEvent = buffer->events[buffer->numRecorded & (EVENTS_PER_THREAD - 1)];
+    curEvent.category = category;
+    curEvent.name = name;
+    curEvent.beginNanoseconds = beginNanoseconds;
+    curEvent.endNanoseconds = endNanoseconds;
+
+    buffer->numRecorded++;
+}
+
+/**--------------------------------------------------------------------------------------
+ * writeChromeTrace()
+ * 
+ * Writes every recorded event of every thread as Chrome trace JSON, which can be opened
+ * in chrome://tracing or ui.perfetto.dev. Must only be called once the traced threads
+ * are done recording
+ * 
+ * @param[in] path  Path of the JSON file to be written
+ * @return true if the file was written
+ * --------------------------------------------------------------------------------------
+*/
+bool Tracer::writeChromeTrace(const std::string& path)
+{
+    std::ofstream outfile(path);
+    if(!outfile.is_open())
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(g_buffersMutex);
+
+    // Timestamps are written relative to the earliest event still held in any buffer, in microseconds
+    unsigned long long origin = ~0ULL;
+    for(const std::unique_ptr<TraceBuffer>& buffer : g_buffers)
+    {
+        size_t numHeld = (size_t)std::min<unsigned long long>(buffer->numRecorded, EVENTS_PER_THREAD);
+        for(size_t i = 0; i < numHeld; i++)
+        {
+            origin = std::min(origin, buffer->events[i].beginNanoseconds);
+        }
+    }
+
+    outfile << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    bool isFirst = true;
+    for(const std::unique_ptr<TraceBuffer>& buffer : g_buffers)
+    {
+        // Oldest event first: once the ring has wrapped, the oldest event is the one about to be overwritten
+        unsigned long long firstRecorded = (buffer->numRecorded > EVENTS_PER_THREAD) ? buffer->numRecorded - EVENTS_PER_THREAD : 0;
+        for(unsigned long long i = firstRecorded; i < buffer->numRecorded; i++)
+        {
+            const TraceEvent& curEvent = buffer->events[i & (EVENTS_PER_THREAD - 1)];
+
+            outfile << (isFirst ? "\n" : ",\n") << "{\"name\":";
+            writeJsonString(outfile, curEvent.name);
+            outfile << ",\"cat\":";
+            writeJsonString(outfile, curEvent.category);
+            outfile << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadID \
+                    << ",\"ts\":" << (curEvent.beginNanoseconds - origin) / 1000.0 \
+                    << ",\"dur\":" << (curEvent.endNanoseconds - curEvent.beginNanoseconds) / 1000.0 << "}";
+            isFirst = false;
+        }
+    }
+
+    outfile << "\n]}" << std::endl;
+
+    return outfile.good();
+}
@@ -0,0 +1,131 @@
+/*tracer.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the Tracer namespace and TraceScope class
+ *     Low-overhead recording of timed engine activity (parse batches, match calls, level sweeps,
+ *     output flushes) into per-thread ring buffers, exported as Chrome trace JSON
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+
+/**--------------------------------------------------------------------------------------
+ * TRACE_SCOPE macro
+ * 
+ * Records the time spent in the enclosing scope under the given name and category when
+ * tracing is enabled. Costs a single relaxed atomic load when it is not
+ * --------------------------------------------------------------------------------------
+*/
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(category, name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(category, name)
+
+namespace Tracer
+{
+    /**--------------------------------------------------------------------------------------
+     * enable()
+     * 
+     * Starts recording events on every thread
+     * --------------------------------------------------------------------------------------
+    */
+    void enable();
+
+    /**--------------------------------------------------------------------------------------
+     * isEnabled()
+     * 
+     * @return true if events are being recorded
+     * --------------------------------------------------------------------------------------
+    */
+    bool isEnabled();
+
+    /**--------------------------------------------------------------------------------------
+     * nowNanoseconds()
+     * 
+     * @return the current time of a monotonic clock, in nanoseconds
+     * --------------------------------------------------------------------------------------
+    */
+    unsigned long long nowNanoseconds();
+
+    /**--------------------------------------------------------------------------------------
+     * record()
+     * 
+     * Records a complete event into the calling thread's ring buffer, overwriting its oldest
+     * event once the buffer is full
+     * 
+     * @param[in] category      Category of the event, e.g. "match". Must be a string literal
+     * @param[in] name          Name of the event, e.g. "matchOrdersFIFO". Must be a string literal
+     * @param[in] beginNanoseconds  Time the event began, from nowNanoseconds()
+     * @param[in] endNanoseconds    Time the event ended, from nowNanoseconds()
+     * --------------------------------------------------------------------------------------
+    */
+    void record(const char* category, const char* name, unsigned long long beginNanoseconds, unsigned long long endNanoseconds);
+
+    /**--------------------------------------------------------------------------------------
+     * writeChromeTrace()
+     * 
+     * Writes every recorded event of every thread as Chrome trace JSON, which can be opened
+     * in chrome://tracing or ui.perfetto.dev. Must only be called once the traced threads
+     * are done recording
+     * 
+     * @param[in] path  Path of the JSON file to be written
+     * @return true if the file was written
+     * --------------------------------------------------------------------------------------
+    */
+    bool writeChromeTrace(const std::string& path);
+}
+
+/**--------------------------------------------------------------------------------------
+ * TraceScope class
+ * 
+ * Records an event spanning its own lifetime, see TRACE_SCOPE
+ * --------------------------------------------------------------------------------------
+*/
+class TraceScope
+{
+public:
+    TraceScope(const char* category, const char* name)
+      : m_category(category), m_name(name), m_beginNanoseconds(Tracer::isEnabled() ? Tracer::nowNanoseconds() : 0)
+    {}
+
+    ~TraceScope()
+    {
+        if(m_beginNanoseconds != 0)
+        {
+            Tracer::record(m_category, m_name, m_beginNanoseconds, Tracer::nowNanoseconds());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_category;
+    const char* m_name;
+    unsigned long long m_beginNanoseconds;  // 0 if tracing was disabled when the scope was entered
+};
@@ -0,0 +1,97 @@
+/*warmup.cpp*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the Warmup namespace
+ *     Startup phase that pins the engine's memory and runs a synthetic burst of orders through
+ *     the order-matching algorithms before live orders are accepted
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
+#include "warmup.h"
+#include "orderbook.h"
+#include "syntheticflow.h"
+#include "logger.h"
+
+/**--------------------------------------------------------------------------------------
+ * lockMemory()
+ * 
+ * Locks every current and future page of the process into RAM (mlockall), so that the
+ * pools preallocated at startup are faulted in once and are never paged out
+ * 
+ * @return true if the memory was locked, false if it is not permitted or not supported
+ *         on this platform
+ * --------------------------------------------------------------------------------------
+*/
+bool Warmup::lockMemory()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    // MCL_FUTURE also populates every mapping made from now on, like MAP_POPULATE would for each of them
+    if(mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+    {
+        std::cerr << "ERROR - lockMemory(): mlockall failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    return true;
+#else
+    std::cerr << "ERROR - lockMemory(): locking memory is not supported on this platform" << std::endl;
+    return false;
+#endif
+}
+
+/**--------------------------------------------------------------------------------------
+ * runSyntheticBurst()
+ * 
+ * Runs a synthetic flow of adds, matches and cancels through both order-matching
+ * algorithms on a throwaway order book, warming up the instruction caches and branch
+ * predictors of the hot path before the first live order arrives
+ * 
+ * @param[in] numOrders Number of orders run through each algorithm
+ * --------------------------------------------------------------------------------------
+*/
+void Warmup::runSyntheticBurst(int numOrders)
+{
+    Orderbook throwawayOrderbook("WARMUP");
+
+    SyntheticOrderFlow fifoFlow("WARMUP", 2000, 1);
+    fifoFlow.run(throwawayOrderbook, &Orderbook::matchOrdersFIFO, numOrders);
+    throwawayOrderbook.clear();
+    throwawayOrderbook.clearOrderHistory();
+
+    SyntheticOrderFlow proRataFlow("WARMUP", 2000, 2);
+    proRataFlow.run(throwawayOrderbook, &Orderbook::matchOrdersProRata, numOrders);
+
+    LOG_DEBUG("runSyntheticBurst(): ran " << numOrders << " synthetic orders through each order-matching algorithm");
+}
@@ -0,0 +1,61 @@
+/*warmup.h*/
+
+/**
+ * Author: Eric Fei
+ * Version 0.0.1
+ * 
+ * Defines the Warmup namespace
+ *     Startup phase that pins the engine's memory and runs a synthetic burst of orders through
+ *     the order-matching algorithms before live orders are accepted
+*/
+
+/**
+ * MIT License
+ * Copyright (c) 2023 Eric Fei
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+namespace Warmup
+{
+    /**--------------------------------------------------------------------------------------
+     * lockMemory()
+     * 
+     * Locks every current and future page of the process into RAM (mlockall), so that the
+     * pools preallocated at startup are faulted in once and are never paged out
+     * 
+     * @return true if the memory was locked, false if it is not permitted or not supported
+     *         on this platform
+     * --------------------------------------------------------------------------------------
+    */
+    bool lockMemory();
+
+    /**--------------------------------------------------------------------------------------
+     * runSyntheticBurst()
+     * 
+     * Runs a synthetic flow of adds, matches and cancels through both order-matching
+     * algorithms on a throwaway order book, warming up the instruction caches and branch
+     * predictors of the hot path before the first live order arrives
+     * 
+     * @param[in] numOrders Number of orders run through each algorithm
+     * --------------------------------------------------------------------------------------
+    */
+    void runSyntheticBurst(int numOrders);
+}